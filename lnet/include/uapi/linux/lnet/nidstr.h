@@ -105,6 +105,10 @@ char *libcfs_id2str(struct lnet_process_id id);
 void cfs_free_nidlist(struct list_head *list);
 #ifdef __KERNEL__
 int cfs_parse_nidlist(char *str, struct list_head *list);
+int cfs_nidlist_for_each_range(struct list_head *nidlist,
+			       int (*cb)(lnet_nid_t first, lnet_nid_t last,
+					 void *data),
+			       void *data);
 #else
 int cfs_parse_nidlist(char *str, int len, struct list_head *list);
 #endif
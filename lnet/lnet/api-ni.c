@@ -7655,6 +7655,31 @@ bool LNetIsPeerLocal(struct lnet_nid *nid)
 }
 EXPORT_SYMBOL(LNetIsPeerLocal);
 
+/**
+ * Get the CPT of the network device of the local NI \a nid.
+ *
+ * \param nid	nid of a local NI
+ *
+ * \retval CPT of the device, or CFS_CPT_ANY if \a nid is not a local NI
+ *	   or the NUMA node of its device is not known
+ */
+int LNetNIDevCPT(struct lnet_nid *nid)
+{
+	struct lnet_ni *ni;
+	int dev_cpt = CFS_CPT_ANY;
+	int cpt;
+
+	cpt = lnet_net_lock_current();
+	ni = lnet_nid_to_ni_locked(nid, cpt);
+	/* the loopback NI has no device */
+	if (ni && !nid_is_lo0(&ni->ni_nid))
+		dev_cpt = ni->ni_dev_cpt;
+	lnet_net_unlock(cpt);
+
+	return dev_cpt;
+}
+EXPORT_SYMBOL(LNetNIDevCPT);
+
 /**
  * Retrieve the struct lnet_process_id ID of LNet interface at \a index.
  * Note that all interfaces share a same PID, as requested by LNetNIInit().
@@ -380,6 +380,79 @@ int cfs_match_nid(struct lnet_nid *nid, struct list_head *nidlist)
 }
 EXPORT_SYMBOL(cfs_match_nid);
 
+/**
+ * Computes the bounds of the addresses of \a ar, as matched by
+ * cfs_ip_addr_match() or libcfs_num_match().
+ *
+ * An IP address is matched by one expression list per byte, most significant
+ * first, a numeric address by a single list over the whole address.
+ */
+static void
+cfs_addrrange_bounds(struct addrrange *ar, __u32 *lo, __u32 *hi)
+{
+	struct cfs_expr_list *el;
+	struct cfs_range_expr *re;
+	int shift = list_is_singular(&ar->ar_numaddr_ranges) ? 0 : 8;
+
+	*lo = 0;
+	*hi = 0;
+	list_for_each_entry(el, &ar->ar_numaddr_ranges, el_link) {
+		__u32 el_lo = MAX_NUMERIC_VALUE;
+		__u32 el_hi = 0;
+
+		list_for_each_entry(re, &el->el_exprs, re_link) {
+			el_lo = min(el_lo, re->re_lo);
+			el_hi = max(el_hi, re->re_hi);
+		}
+		/* shift of 32 bits is undefined, the list is singular then */
+		*lo = shift ? (*lo << shift) | el_lo : el_lo;
+		*hi = shift ? (*hi << shift) | el_hi : el_hi;
+	}
+}
+
+/**
+ * Calls \a cb for each range of NIDs covering a compiled list of nidranges
+ * (\a nidlist), so that any NID matched by cfs_match_nid() is within one of
+ * them. The ranges may include NIDs which are not matched, i.e. the ones
+ * skipped by strides or by ranges of a lower byte of an IP address.
+ *
+ * \see cfs_parse_nidlist()
+ *
+ * \retval 0 on success
+ * \retval the first non-zero value returned by \a cb otherwise
+ */
+int cfs_nidlist_for_each_range(struct list_head *nidlist,
+			       int (*cb)(lnet_nid_t first, lnet_nid_t last,
+					 void *data),
+			       void *data)
+{
+	struct nidrange *nr;
+	struct addrrange *ar;
+	__u32 net;
+	__u32 lo;
+	__u32 hi;
+	int rc;
+
+	list_for_each_entry(nr, nidlist, nr_link) {
+		net = LNET_MKNET(nr->nr_netstrfns->nf_type, nr->nr_netnum);
+		if (nr->nr_all) {
+			rc = cb(LNET_MKNID(net, 0),
+				LNET_MKNID(net, MAX_NUMERIC_VALUE), data);
+			if (rc)
+				return rc;
+			continue;
+		}
+		list_for_each_entry(ar, &nr->nr_addrranges, ar_link) {
+			cfs_addrrange_bounds(ar, &lo, &hi);
+			rc = cb(LNET_MKNID(net, lo), LNET_MKNID(net, hi), data);
+			if (rc)
+				return rc;
+		}
+	}
+	return 0;
+}
+EXPORT_SYMBOL(cfs_nidlist_for_each_range);
+
 /**
  * Print the network part of the nidrange \a nr into the specified \a buffer.
  *
@@ -1446,6 +1446,22 @@ AC_DEFUN([LC_HAVE_CRYPTO_ALLOC_SKCIPHER], [
 	])
 ]) # LC_HAVE_CRYPTO_ALLOC_SKCIPHER
 
+#
+# LC_HAVE_FPU_API_HEADER
+#
+# Kernel version 4.2 commit df6b35f409af0a8ff1ef62f552b8402f3fef8665
+# renamed asm/i387.h to asm/fpu/api.h
+#
+AC_DEFUN([LC_SRC_HAVE_FPU_API_HEADER], [
+	LB2_CHECK_LINUX_HEADER_SRC([asm/fpu/api.h], [-Werror])
+])
+AC_DEFUN([LC_HAVE_FPU_API_HEADER], [
+	LB2_CHECK_LINUX_HEADER_RESULT([asm/fpu/api.h], [
+		AC_DEFINE(HAVE_FPU_API_HEADER, 1,
+			[asm/fpu/api.h is present])
+	],[])
+]) # LC_HAVE_FPU_API_HEADER
+
 #
 # LC_HAVE_INTERVAL_EXP_BLK_INTEGRITY
 #
@@ -1877,6 +1893,29 @@ AC_DEFUN([LC_HAVE_DOWN_WRITE_KILLABLE], [
 	])
 ]) # LC_HAVE_DOWN_WRITE_KILLABLE
 
+#
+# LC_HAVE_KMEM_CACHE_ALLOC_BULK
+#
+# 4.6 kmem_cache_alloc_bulk() returns the number of objects allocated
+# (it was added in 4.3 returning bool, which is not used here)
+#
+AC_DEFUN([LC_SRC_HAVE_KMEM_CACHE_ALLOC_BULK], [
+	LB2_LINUX_TEST_SRC([kmem_cache_alloc_bulk], [
+		#include <linux/slab.h>
+	],[
+		void *objs[2];
+
+		kmem_cache_alloc_bulk(NULL, GFP_NOFS, 2, objs);
+	])
+])
+AC_DEFUN([LC_HAVE_KMEM_CACHE_ALLOC_BULK], [
+	LB2_MSG_LINUX_TEST_RESULT([if kmem_cache_alloc_bulk exists],
+	[kmem_cache_alloc_bulk], [
+		AC_DEFINE(HAVE_KMEM_CACHE_ALLOC_BULK, 1,
+			[kmem_cache_alloc_bulk function exists])
+	])
+]) # LC_HAVE_KMEM_CACHE_ALLOC_BULK
+
 #
 # LC_D_INIT
 #
@@ -4068,6 +4107,7 @@ AC_DEFUN([LC_PROG_LINUX_SRC], [
 	LC_SRC_SYMLINK_OPS_USE_NAMEIDATA
 	LC_SRC_ACCOUNT_PAGE_DIRTIED_3ARGS
 	LC_SRC_HAVE_CRYPTO_ALLOC_SKCIPHER
+	LC_SRC_HAVE_FPU_API_HEADER
 
 	# 4.3
 	LC_SRC_HAVE_INTERVAL_EXP_BLK_INTEGRITY
@@ -4094,6 +4134,7 @@ AC_DEFUN([LC_PROG_LINUX_SRC], [
 	LC_SRC_HAVE_XATTR_HANDLER_INODE_PARAM
 	LC_SRC_LOCK_PAGE_MEMCG
 	LC_SRC_HAVE_DOWN_WRITE_KILLABLE
+	LC_SRC_HAVE_KMEM_CACHE_ALLOC_BULK
 
 	# 4.7
 	LC_SRC_D_IN_LOOKUP
@@ -4335,6 +4376,7 @@ AC_DEFUN([LC_PROG_LINUX_RESULTS], [
 	LC_SYMLINK_OPS_USE_NAMEIDATA
 	LC_ACCOUNT_PAGE_DIRTIED_3ARGS
 	LC_HAVE_CRYPTO_ALLOC_SKCIPHER
+	LC_HAVE_FPU_API_HEADER
 
 	# 4.3
 	LC_HAVE_INTERVAL_EXP_BLK_INTEGRITY
@@ -4362,6 +4404,7 @@ AC_DEFUN([LC_PROG_LINUX_RESULTS], [
 	LC_HAVE_XATTR_HANDLER_INODE_PARAM
 	LC_LOCK_PAGE_MEMCG
 	LC_HAVE_DOWN_WRITE_KILLABLE
+	LC_HAVE_KMEM_CACHE_ALLOC_BULK
 
 	# 4.7
 	LC_D_IN_LOOKUP
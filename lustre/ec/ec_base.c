@@ -29,9 +29,11 @@
  */
 
 #include <linux/limits.h>
+#include <linux/random.h>
 #include <linux/string.h>	/* for memset */
 #include <libcfs/libcfs.h>
 #include "erasure_code.h"
+#include "ec_internal.h"
 
 /* Global GF(256) tables */
 static const unsigned char gff_base[] = {
@@ -315,26 +317,173 @@ void gf_vect_mul_init(unsigned char c, unsigned char *tbl)
 #endif /* BITS_PER_LONG == 64 */
 }
 
-void ec_encode_data(int len, int srcs, int dests, unsigned char *v,
-		    unsigned char **src, unsigned char **dest)
+/* Compute bytes [off, off + len) of each output row, one source at a time
+ * so that every row and source vector is streamed through sequentially.
+ */
+void ec_encode_data_range(int off, int len, int srcs, int dests,
+			  unsigned char *v, unsigned char **src,
+			  unsigned char **dest)
 {
 	int i, j, l;
-	unsigned char s;
 
 	for (l = 0; l < dests; l++) {
-		for (i = 0; i < len; i++) {
-			s = 0;
-			for (j = 0; j < srcs; j++)
-				s ^= gf_mul(src[j][i], v[j * 32 + l * srcs * 32 + 1]);
-
-			dest[l][i] = s;
+		unsigned char *tbl = &v[l * srcs * 32];
+		unsigned char *d = dest[l] + off;
+		unsigned char *s = src[0] + off;
+
+		for (i = 0; i < len; i++)
+			d[i] = ec_gf_mul_tbl(tbl, s[i]);
+
+		for (j = 1; j < srcs; j++) {
+			tbl += 32;
+			s = src[j] + off;
+			for (i = 0; i < len; i++)
+				d[i] ^= ec_gf_mul_tbl(tbl, s[i]);
 		}
 	}
 }
+
+void ec_encode_data_base(int len, int srcs, int dests, unsigned char *v,
+			 unsigned char **src, unsigned char **dest)
+{
+	ec_encode_data_range(0, len, srcs, dests, v, src, dest);
+}
+
+struct ec_encode_variant {
+	const char	*eev_name;
+	ec_encode_fn_t	 eev_encode;
+	bool		(*eev_usable)(void);
+	/* encode speed in MB/s, or negative errno if the test failed */
+	int		 eev_speed;
+};
+
+static struct ec_encode_variant ec_encode_variants[] = {
+	{ .eev_name = "base", .eev_encode = ec_encode_data_base },
+#ifdef CONFIG_X86_64
+	{ .eev_name = "ssse3", .eev_encode = ec_encode_data_ssse3,
+	  .eev_usable = ec_ssse3_usable },
+	{ .eev_name = "avx2", .eev_encode = ec_encode_data_avx2,
+	  .eev_usable = ec_avx2_usable },
+#endif
+};
+
+static ec_encode_fn_t ec_encode_fn = ec_encode_data_base;
+
+void ec_encode_data(int len, int srcs, int dests, unsigned char *v,
+		    unsigned char **src, unsigned char **dest)
+{
+	ec_encode_fn(len, srcs, dests, v, src, dest);
+}
 EXPORT_SYMBOL(ec_encode_data);
 
+/* The self test encodes an 8+2 stripe with 64KiB chunks, a typical RPC
+ * sized stripe row, so the speeds are those of real parity generation.
+ */
+#define EC_TEST_DATA	8
+#define EC_TEST_CODE	2
+#define EC_TEST_LEN	65536
+
+/**
+ * Compute the speed of every usable ec_encode_data() variant
+ *
+ * Each variant is run for 1/8 second on the same data. Its parity must match
+ * the one computed by the base variant, or it will never be selected.
+ * The speed is that of the data consumed, which is the rate the parity of a
+ * client write can be generated.
+ *
+ * \retval	0 on success
+ * \retval	-ENOMEM if the test buffers cannot be allocated
+ */
+static int ec_encode_performance_test(void)
+{
+	unsigned char *src[EC_TEST_DATA], *dest[EC_TEST_CODE];
+	unsigned char *check[EC_TEST_CODE];
+	unsigned char matrix[(EC_TEST_DATA + EC_TEST_CODE) * EC_TEST_DATA];
+	unsigned char *tbls;
+	struct ec_encode_variant *eev;
+	struct ec_encode_variant *best = &ec_encode_variants[0];
+	const int buf_len = (EC_TEST_DATA + 2 * EC_TEST_CODE) * EC_TEST_LEN;
+	unsigned char *buf;
+	int i;
+
+	LIBCFS_ALLOC(buf, buf_len);
+	if (!buf)
+		return -ENOMEM;
+	LIBCFS_ALLOC(tbls, EC_TEST_DATA * EC_TEST_CODE * 32);
+	if (!tbls) {
+		LIBCFS_FREE(buf, buf_len);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < EC_TEST_DATA; i++)
+		src[i] = buf + i * EC_TEST_LEN;
+	for (i = 0; i < EC_TEST_CODE; i++) {
+		dest[i] = buf + (EC_TEST_DATA + i) * EC_TEST_LEN;
+		check[i] = dest[i] + EC_TEST_CODE * EC_TEST_LEN;
+	}
+	get_random_bytes(buf, EC_TEST_DATA * EC_TEST_LEN);
+
+	gf_gen_cauchy1_matrix(matrix, EC_TEST_DATA + EC_TEST_CODE,
+			      EC_TEST_DATA);
+	ec_init_tables(EC_TEST_DATA, EC_TEST_CODE,
+		       &matrix[EC_TEST_DATA * EC_TEST_DATA], tbls);
+	ec_encode_data_base(EC_TEST_LEN, EC_TEST_DATA, EC_TEST_CODE, tbls,
+			    src, check);
+
+	for (i = 0; i < ARRAY_SIZE(ec_encode_variants); i++) {
+		unsigned long start, end, bcount;
+
+		eev = &ec_encode_variants[i];
+		if (eev->eev_usable && !eev->eev_usable()) {
+			eev->eev_speed = -EOPNOTSUPP;
+			continue;
+		}
+
+		for (start = jiffies, end = start + cfs_time_seconds(1) / 8,
+		     bcount = 0; time_before(jiffies, end); bcount++) {
+			eev->eev_encode(EC_TEST_LEN, EC_TEST_DATA,
+					EC_TEST_CODE, tbls, src, dest);
+			cond_resched();
+		}
+		end = jiffies;
+
+		if (memcmp(dest[0], check[0],
+			   EC_TEST_CODE * EC_TEST_LEN) != 0) {
+			eev->eev_speed = -EIO;
+			CWARN("ec: %s encoder computed bad parity, not used\n",
+			      eev->eev_name);
+			continue;
+		}
+
+		eev->eev_speed = ((bcount * EC_TEST_DATA * EC_TEST_LEN /
+				   max(jiffies_to_msecs(end - start), 1U)) *
+				  1000) / (1024 * 1024);
+		CDEBUG(D_CONFIG, "ec: %s encoder speed = %d MB/s\n",
+		       eev->eev_name, eev->eev_speed);
+		if (eev->eev_speed > best->eev_speed)
+			best = eev;
+	}
+
+	ec_encode_fn = best->eev_encode;
+	CDEBUG(D_CONFIG, "ec: using %s encoder, %d MB/s for %u+%u\n",
+	       best->eev_name, best->eev_speed, EC_TEST_DATA, EC_TEST_CODE);
+
+	LIBCFS_FREE(tbls, EC_TEST_DATA * EC_TEST_CODE * 32);
+	LIBCFS_FREE(buf, buf_len);
+
+	return 0;
+}
+
 static int __init ec_init(void)
 {
+	int rc;
+
+	/* base encoder is always usable, a failed test only costs speed */
+	rc = ec_encode_performance_test();
+	if (rc)
+		CWARN("ec: encoder self test failed, using base encoder: rc = %d\n",
+		      rc);
+
 	return 0;
 }
 
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/ec/ec_internal.h
+ *
+ * Erasure code encoder variants, one of them is selected at module load
+ * time by ec_encode_data().
+ */
+
+#ifndef _EC_INTERNAL_H
+#define _EC_INTERNAL_H
+
+typedef void (*ec_encode_fn_t)(int len, int srcs, int dests,
+			       unsigned char *v, unsigned char **src,
+			       unsigned char **dest);
+
+/* vector kernels leave preemption disabled for at most this many bytes */
+#define EC_SIMD_BLOCK	4096
+
+/*
+ * Multiply \a b by the constant the 32 byte table \a tbl was built for with
+ * gf_vect_mul_init(): the low and high nibble products XORed together.
+ */
+static inline unsigned char ec_gf_mul_tbl(const unsigned char *tbl,
+					  unsigned char b)
+{
+	return tbl[b & 0x0f] ^ tbl[16 + (b >> 4)];
+}
+
+void ec_encode_data_range(int off, int len, int srcs, int dests,
+			  unsigned char *v, unsigned char **src,
+			  unsigned char **dest);
+void ec_encode_data_base(int len, int srcs, int dests, unsigned char *v,
+			 unsigned char **src, unsigned char **dest);
+
+#ifdef CONFIG_X86_64
+bool ec_ssse3_usable(void);
+void ec_encode_data_ssse3(int len, int srcs, int dests, unsigned char *v,
+			  unsigned char **src, unsigned char **dest);
+bool ec_avx2_usable(void);
+void ec_encode_data_avx2(int len, int srcs, int dests, unsigned char *v,
+			 unsigned char **src, unsigned char **dest);
+#endif /* CONFIG_X86_64 */
+
+#endif /* _EC_INTERNAL_H */
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/ec/ec_x86.c
+ *
+ * SSSE3 and AVX2 GF(2^8) dot product kernels for ec_encode_data().
+ *
+ * Every byte of a source vector is split into its low and high nibble, which
+ * index the two 16 byte halves of the gf_vect_mul_init() table of the
+ * coefficient with PSHUFB. The two lookups XORed together give the product,
+ * which is accumulated into the output row. This is the same technique as
+ * the RAID6 recovery code in lib/raid6/recov_{ssse3,avx2}.c.
+ *
+ * The vector registers are only used between kernel_fpu_begin() and
+ * kernel_fpu_end(), at most EC_SIMD_BLOCK bytes of every row are computed in
+ * one such section to bound the time spent with preemption disabled.
+ */
+
+#ifdef CONFIG_X86_64
+
+#include <linux/kernel.h>
+#include <asm/cpufeature.h>
+#ifdef HAVE_FPU_API_HEADER
+#include <asm/fpu/api.h>
+#else
+#include <asm/i387.h>
+#endif
+#include <libcfs/libcfs.h>
+#include "ec_internal.h"
+
+static const u8 ec_x0f[16] __aligned(16) = {
+	0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+	0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+};
+
+bool ec_ssse3_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_XMM2) &&
+	       boot_cpu_has(X86_FEATURE_SSSE3);
+}
+
+void ec_encode_data_ssse3(int len, int srcs, int dests, unsigned char *v,
+			  unsigned char **src, unsigned char **dest)
+{
+	int vlen = len & ~15;
+	int off, end, i, j, l;
+
+	if (!irq_fpu_usable()) {
+		ec_encode_data_base(len, srcs, dests, v, src, dest);
+		return;
+	}
+
+	for (off = 0; off < vlen; off = end) {
+		end = min(off + EC_SIMD_BLOCK, vlen);
+
+		kernel_fpu_begin();
+		asm volatile("movdqa %0, %%xmm7" : : "m" (ec_x0f[0]));
+
+		for (l = 0; l < dests; l++) {
+			unsigned char *tbl = &v[l * srcs * 32];
+
+			for (i = off; i < end; i += 16) {
+				asm volatile("pxor %xmm0, %xmm0");
+				for (j = 0; j < srcs; j++) {
+					asm volatile("movdqu %0, %%xmm1"
+						     : : "m" (tbl[j * 32]));
+					asm volatile("movdqu %0, %%xmm2"
+						     : : "m" (tbl[j * 32 + 16]));
+					asm volatile("movdqu %0, %%xmm3"
+						     : : "m" (src[j][i]));
+					asm volatile("movdqa %xmm3, %xmm4");
+					asm volatile("psraw $4, %xmm4");
+					asm volatile("pand %xmm7, %xmm3");
+					asm volatile("pand %xmm7, %xmm4");
+					asm volatile("pshufb %xmm3, %xmm1");
+					asm volatile("pshufb %xmm4, %xmm2");
+					asm volatile("pxor %xmm1, %xmm0");
+					asm volatile("pxor %xmm2, %xmm0");
+				}
+				asm volatile("movdqu %%xmm0, %0"
+					     : "=m" (dest[l][i]));
+			}
+		}
+
+		kernel_fpu_end();
+	}
+
+	if (vlen < len)
+		ec_encode_data_range(vlen, len - vlen, srcs, dests, v, src,
+				     dest);
+}
+
+bool ec_avx2_usable(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX) &&
+	       boot_cpu_has(X86_FEATURE_AVX2);
+}
+
+void ec_encode_data_avx2(int len, int srcs, int dests, unsigned char *v,
+			 unsigned char **src, unsigned char **dest)
+{
+	int vlen = len & ~31;
+	int off, end, i, j, l;
+
+	if (!irq_fpu_usable()) {
+		ec_encode_data_base(len, srcs, dests, v, src, dest);
+		return;
+	}
+
+	for (off = 0; off < vlen; off = end) {
+		end = min(off + EC_SIMD_BLOCK, vlen);
+
+		kernel_fpu_begin();
+		asm volatile("vpbroadcastb %0, %%ymm7" : : "m" (ec_x0f[0]));
+
+		for (l = 0; l < dests; l++) {
+			unsigned char *tbl = &v[l * srcs * 32];
+
+			for (i = off; i < end; i += 32) {
+				asm volatile("vpxor %ymm0, %ymm0, %ymm0");
+				for (j = 0; j < srcs; j++) {
+					/* same table in both 128 bit lanes */
+					asm volatile("vbroadcasti128 %0, %%ymm1"
+						     : : "m" (tbl[j * 32]));
+					asm volatile("vbroadcasti128 %0, %%ymm2"
+						     : : "m" (tbl[j * 32 + 16]));
+					asm volatile("vmovdqu %0, %%ymm3"
+						     : : "m" (src[j][i]));
+					asm volatile("vpsraw $4, %ymm3, %ymm4");
+					asm volatile("vpand %ymm7, %ymm3, %ymm3");
+					asm volatile("vpand %ymm7, %ymm4, %ymm4");
+					asm volatile("vpshufb %ymm3, %ymm1, %ymm1");
+					asm volatile("vpshufb %ymm4, %ymm2, %ymm2");
+					asm volatile("vpxor %ymm1, %ymm0, %ymm0");
+					asm volatile("vpxor %ymm2, %ymm0, %ymm0");
+				}
+				asm volatile("vmovdqu %%ymm0, %0"
+					     : "=m" (dest[l][i]));
+			}
+		}
+
+		kernel_fpu_end();
+	}
+
+	if (vlen < len)
+		ec_encode_data_range(vlen, len - vlen, srcs, dests, v, src,
+				     dest);
+}
+
+#endif /* CONFIG_X86_64 */
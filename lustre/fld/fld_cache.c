@@ -41,10 +41,95 @@
 #include <libcfs/libcfs.h>
 #include <linux/module.h>
 #include <linux/math64.h>
+#include <linux/percpu_counter.h>
+#include <linux/seq_file.h>
 #include <obd_support.h>
 #include <lustre_fld.h>
 #include "fld_internal.h"
 
+static int fld_stats_init(struct fld_stats *stats)
+{
+	int rc;
+
+#ifdef HAVE_PERCPU_COUNTER_INIT_GFP_FLAG
+	rc = percpu_counter_init(&stats->fst_count, 0, GFP_NOFS);
+	if (!rc)
+		rc = percpu_counter_init(&stats->fst_cache, 0, GFP_NOFS);
+	if (!rc)
+		rc = percpu_counter_init(&stats->fst_probes, 0, GFP_NOFS);
+#else
+	rc = percpu_counter_init(&stats->fst_count, 0);
+	if (!rc)
+		rc = percpu_counter_init(&stats->fst_cache, 0);
+	if (!rc)
+		rc = percpu_counter_init(&stats->fst_probes, 0);
+#endif
+	if (rc) {
+		/* destroying a counter which failed to init is harmless */
+		percpu_counter_destroy(&stats->fst_count);
+		percpu_counter_destroy(&stats->fst_cache);
+		percpu_counter_destroy(&stats->fst_probes);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void fld_stats_fini(struct fld_stats *stats)
+{
+	percpu_counter_destroy(&stats->fst_count);
+	percpu_counter_destroy(&stats->fst_cache);
+	percpu_counter_destroy(&stats->fst_probes);
+}
+
+static inline size_t fld_cache_array_size(int count)
+{
+	return offsetof(struct fld_cache_array, fca_slots[count]);
+}
+
+static void fld_cache_array_free(struct rcu_head *head)
+{
+	struct fld_cache_array *array;
+
+	array = container_of(head, struct fld_cache_array, fca_rcu);
+	OBD_FREE_LARGE(array, fld_cache_array_size(array->fca_count));
+}
+
+/**
+ * Replace the array searched by fld_cache_lookup() with a copy of the
+ * current entries. Called with fci_lock held after every update.
+ */
+static void fld_cache_publish(struct fld_cache *cache)
+{
+	struct fld_cache_array *array;
+	struct fld_cache_array *old;
+	struct fld_cache_entry *flde;
+	u64 max_end = 0;
+	int i = 0;
+
+	OBD_ALLOC_LARGE(array, fld_cache_array_size(cache->fci_cache_count));
+	if (array != NULL) {
+		array->fca_count = cache->fci_cache_count;
+		list_for_each_entry(flde, &cache->fci_entries_head, fce_list) {
+			LASSERT(i < array->fca_count);
+			max_end = max(max_end, flde->fce_range.lsr_end);
+			array->fca_slots[i].fcs_range = flde->fce_range;
+			array->fca_slots[i].fcs_max_end = max_end;
+			i++;
+		}
+		LASSERT(i == array->fca_count);
+	} else {
+		CDEBUG(D_INFO, "%s: no memory for %d entries, lookups will lock\n",
+		       cache->fci_name, cache->fci_cache_count);
+	}
+
+	old = rcu_dereference_protected(cache->fci_array,
+					lockdep_is_held(&cache->fci_lock));
+	rcu_assign_pointer(cache->fci_array, array);
+	if (old != NULL)
+		call_rcu(&old->fca_rcu, fld_cache_array_free);
+}
+
 /**
  * create fld cache.
  */
@@ -52,6 +137,7 @@ struct fld_cache *fld_cache_init(const char *name, int cache_size,
 				 int cache_threshold)
 {
 	struct fld_cache *cache;
+	int rc;
 
 	ENTRY;
 
@@ -66,7 +152,7 @@ struct fld_cache *fld_cache_init(const char *name, int cache_size,
 	INIT_LIST_HEAD(&cache->fci_lru);
 
 	cache->fci_cache_count = 0;
-	rwlock_init(&cache->fci_lock);
+	mutex_init(&cache->fci_lock);
 
 	strlcpy(cache->fci_name, name, sizeof(cache->fci_name));
 
@@ -74,7 +160,16 @@ struct fld_cache *fld_cache_init(const char *name, int cache_size,
 	cache->fci_threshold = cache_threshold;
 
 	/* Init fld cache info. */
-	memset(&cache->fci_stat, 0, sizeof(cache->fci_stat));
+	rc = fld_stats_init(&cache->fci_stat);
+	if (rc) {
+		OBD_FREE_PTR(cache);
+		RETURN(ERR_PTR(rc));
+	}
+
+	/* an empty array, so that lookups do not fall back to the list */
+	mutex_lock(&cache->fci_lock);
+	fld_cache_publish(cache);
+	mutex_unlock(&cache->fci_lock);
 
 	CDEBUG(D_INFO, "%s: FLD cache - Size: %d, Threshold: %d\n",
 	       cache->fci_name, cache_size, cache_threshold);
@@ -87,13 +182,23 @@ struct fld_cache *fld_cache_init(const char *name, int cache_size,
  */
 void fld_cache_fini(struct fld_cache *cache)
 {
+	struct fld_cache_array *array;
+
 	LASSERT(cache != NULL);
 	fld_cache_flush(cache);
 
 	CDEBUG(D_INFO, "FLD cache statistics (%s):\n", cache->fci_name);
-	CDEBUG(D_INFO, "  Cache reqs: %llu\n", cache->fci_stat.fst_cache);
-	CDEBUG(D_INFO, "  Total reqs: %llu\n", cache->fci_stat.fst_count);
-
+	CDEBUG(D_INFO, "  Cache reqs: %lld\n",
+	       percpu_counter_sum(&cache->fci_stat.fst_cache));
+	CDEBUG(D_INFO, "  Total reqs: %lld\n",
+	       percpu_counter_sum(&cache->fci_stat.fst_count));
+
+	/* wait for the arrays replaced by the flush */
+	rcu_barrier();
+	array = rcu_dereference_protected(cache->fci_array, 1);
+	if (array != NULL)
+		OBD_FREE_LARGE(array, fld_cache_array_size(array->fca_count));
+	fld_stats_fini(&cache->fci_stat);
 	OBD_FREE_PTR(cache);
 }
 
@@ -231,10 +336,11 @@ void fld_cache_flush(struct fld_cache *cache)
 {
 	ENTRY;
 
-	write_lock(&cache->fci_lock);
+	mutex_lock(&cache->fci_lock);
 	cache->fci_cache_size = 0;
 	fld_cache_shrink(cache);
-	write_unlock(&cache->fci_lock);
+	fld_cache_publish(cache);
+	mutex_unlock(&cache->fci_lock);
 
 	EXIT;
 }
@@ -254,7 +360,7 @@ static void fld_cache_punch_hole(struct fld_cache *cache,
 	struct fld_cache_entry *fldt;
 
 	ENTRY;
-	OBD_ALLOC_GFP(fldt, sizeof(*fldt), GFP_ATOMIC);
+	OBD_ALLOC_PTR(fldt);
 	if (!fldt) {
 		OBD_FREE_PTR(f_new);
 		EXIT;
@@ -414,6 +520,7 @@ int fld_cache_insert_nolock(struct fld_cache *cache,
 	/* Add new entry to cache and lru list. */
 	fld_cache_entry_add(cache, f_new, prev);
 out:
+	fld_cache_publish(cache);
 	RETURN(0);
 }
 
@@ -427,9 +534,9 @@ int fld_cache_insert(struct fld_cache *cache,
 	if (IS_ERR(flde))
 		RETURN(PTR_ERR(flde));
 
-	write_lock(&cache->fci_lock);
+	mutex_lock(&cache->fci_lock);
 	rc = fld_cache_insert_nolock(cache, flde);
-	write_unlock(&cache->fci_lock);
+	mutex_unlock(&cache->fci_lock);
 	if (rc)
 		OBD_FREE_PTR(flde);
 
@@ -450,28 +557,24 @@ void fld_cache_delete_nolock(struct fld_cache *cache,
 		   (range->lsr_end == flde->fce_range.lsr_end &&
 		    range->lsr_flags == flde->fce_range.lsr_flags)) {
 			fld_cache_entry_delete(cache, flde);
+			fld_cache_publish(cache);
 			break;
 		}
 	}
 }
 
-/**
- * lookup \a seq sequence for range in fld cache.
- */
-int fld_cache_lookup(struct fld_cache *cache,
-		     const u64 seq, struct lu_seq_range *range)
+/* lookup \a seq in the entry list, for when no array could be published */
+static int fld_cache_lookup_list(struct fld_cache *cache,
+				 const u64 seq, struct lu_seq_range *range,
+				 s64 *probes)
 {
 	struct fld_cache_entry *flde;
 	struct fld_cache_entry *prev = NULL;
-	struct list_head *head;
+	int rc = -ENOENT;
 
-	ENTRY;
-
-	read_lock(&cache->fci_lock);
-	head = &cache->fci_entries_head;
-
-	cache->fci_stat.fst_count++;
-	list_for_each_entry(flde, head, fce_list) {
+	mutex_lock(&cache->fci_lock);
+	list_for_each_entry(flde, &cache->fci_entries_head, fce_list) {
+		(*probes)++;
 		if (flde->fce_range.lsr_start > seq) {
 			if (prev != NULL)
 				*range = prev->fce_range;
@@ -481,12 +584,97 @@ int fld_cache_lookup(struct fld_cache *cache,
 		prev = flde;
 		if (lu_seq_range_within(&flde->fce_range, seq)) {
 			*range = flde->fce_range;
-
-			cache->fci_stat.fst_cache++;
-			read_unlock(&cache->fci_lock);
-			RETURN(0);
+			rc = 0;
+			break;
 		}
 	}
-	read_unlock(&cache->fci_lock);
-	RETURN(-ENOENT);
+	mutex_unlock(&cache->fci_lock);
+
+	return rc;
+}
+
+/**
+ * lookup \a seq sequence for range in fld cache.
+ *
+ * The entries are sorted by lsr_start and only ranges of different types
+ * may overlap, so the match is found by a binary search for the last entry
+ * starting at or before \a seq and by looking back while the earlier entries
+ * may still cover \a seq. As with the list walk it replaces, the leftmost
+ * covering entry wins, and on a miss \a range is set to the entry on the
+ * left of \a seq, if any.
+ */
+int fld_cache_lookup(struct fld_cache *cache,
+		     const u64 seq, struct lu_seq_range *range)
+{
+	struct fld_cache_array *array;
+	struct fld_cache_slot *slots;
+	s64 probes = 0;
+	int found = -1;
+	int lo;
+	int hi;
+	int rc = -ENOENT;
+
+	ENTRY;
+
+	rcu_read_lock();
+	array = rcu_dereference(cache->fci_array);
+	if (unlikely(array == NULL)) {
+		rcu_read_unlock();
+		rc = fld_cache_lookup_list(cache, seq, range, &probes);
+		GOTO(out, rc);
+	}
+
+	/* find the first slot starting after seq */
+	slots = array->fca_slots;
+	lo = 0;
+	hi = array->fca_count;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		probes++;
+		if (slots[mid].fcs_range.lsr_start > seq)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	for (hi = lo - 1; hi >= 0 && slots[hi].fcs_max_end > seq; hi--) {
+		probes++;
+		if (lu_seq_range_within(&slots[hi].fcs_range, seq))
+			found = hi;
+	}
+
+	if (found >= 0) {
+		*range = slots[found].fcs_range;
+		rc = 0;
+	} else if (lo > 0) {
+		*range = slots[lo - 1].fcs_range;
+	}
+	rcu_read_unlock();
+out:
+	percpu_counter_inc(&cache->fci_stat.fst_count);
+	percpu_counter_add(&cache->fci_stat.fst_probes, probes);
+	if (rc == 0)
+		percpu_counter_inc(&cache->fci_stat.fst_cache);
+
+	RETURN(rc);
+}
+
+void fld_cache_stats_seq_show(struct fld_cache *cache, struct seq_file *m)
+{
+	s64 count = percpu_counter_sum_positive(&cache->fci_stat.fst_count);
+	s64 hits = percpu_counter_sum_positive(&cache->fci_stat.fst_cache);
+	s64 probes = percpu_counter_sum_positive(&cache->fci_stat.fst_probes);
+	int entries;
+
+	mutex_lock(&cache->fci_lock);
+	entries = cache->fci_cache_count;
+	mutex_unlock(&cache->fci_lock);
+
+	seq_printf(m, "lookups: %lld\n", count);
+	seq_printf(m, "hits: %lld\n", hits);
+	seq_printf(m, "misses: %lld\n", max_t(s64, count - hits, 0));
+	seq_printf(m, "entries: %d\n", entries);
+	seq_printf(m, "avg_search_length: %lld\n",
+		   count ? div64_s64(probes, count) : 0);
 }
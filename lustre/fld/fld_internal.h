@@ -59,8 +59,12 @@
 #include <lustre_fld.h>
 
 struct fld_stats {
-        __u64   fst_count;
-        __u64   fst_cache;
+	/* lookups */
+	struct percpu_counter	fst_count;
+	/* lookups found in the cache */
+	struct percpu_counter	fst_cache;
+	/* entries compared by the lookups */
+	struct percpu_counter	fst_probes;
 };
 
 struct lu_fld_hash {
@@ -79,12 +83,32 @@ struct fld_cache_entry {
 	struct lu_seq_range	fce_range;
 };
 
+/**
+ * Read-only copy of the sorted fld cache entries, searched locklessly.
+ */
+struct fld_cache_array {
+	struct rcu_head		fca_rcu;
+	int			fca_count;
+	struct fld_cache_slot {
+		struct lu_seq_range	fcs_range;
+		/* largest lsr_end of the slots up to this one */
+		u64			fcs_max_end;
+	}			fca_slots[];
+};
+
 struct fld_cache {
 	/**
-	 * Cache guard, protects fci_hash mostly because others immutable after
-	 * init is finished.
+	 * Cache guard, serializes the updates of the entry lists and of
+	 * \a fci_array. Lookups do not take it.
+	 */
+	struct mutex		 fci_lock;
+
+	/**
+	 * Copy of fci_entries_head for lookups, replaced under RCU on every
+	 * update. NULL if it could not be allocated, lookups then walk the
+	 * list under fci_lock.
 	 */
-	rwlock_t		 fci_lock;
+	struct fld_cache_array __rcu *fci_array;
 
         /**
          * Cache shrink threshold */
@@ -199,6 +223,7 @@ void fld_cache_delete_nolock(struct fld_cache *cache,
 			     const struct lu_seq_range *range);
 int fld_cache_lookup(struct fld_cache *cache,
 		     const u64 seq, struct lu_seq_range *range);
+void fld_cache_stats_seq_show(struct fld_cache *cache, struct seq_file *m);
 
 static inline const char *
 fld_target_name(const struct lu_fld_target *tar)
@@ -130,7 +130,19 @@ static ssize_t ldebugfs_cache_flush_seq_write(struct file *file,
         RETURN(count);
 }
 
+static int
+fld_debugfs_cache_stats_seq_show(struct seq_file *m, void *unused)
+{
+	struct lu_client_fld *fld = (struct lu_client_fld *)m->private;
+
+	ENTRY;
+	fld_cache_stats_seq_show(fld->lcf_cache, m);
+
+	RETURN(0);
+}
+
 LDEBUGFS_SEQ_FOPS_RO(fld_debugfs_targets);
+LDEBUGFS_SEQ_FOPS_RO(fld_debugfs_cache_stats);
 LDEBUGFS_SEQ_FOPS(fld_debugfs_hash);
 LDEBUGFS_FOPS_WR_ONLY(fld, cache_flush);
 
@@ -141,6 +153,8 @@ struct ldebugfs_vars fld_client_debugfs_list[] = {
 	  .fops	=	&fld_debugfs_hash_fops	},
 	{ .name	=	"cache_flush",
 	  .fops	=	&fld_cache_flush_fops	},
+	{ .name	=	"cache_stats",
+	  .fops	=	&fld_debugfs_cache_stats_fops	},
 	{ NULL }
 };
 
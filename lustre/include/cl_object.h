@@ -876,6 +876,17 @@ struct cl_page_operations {
         void (*cpo_discard)(const struct lu_env *env,
                             const struct cl_page_slice *slice,
                             struct cl_io *io);
+	/**
+	 * Called when a clean page is kept in cache after the lock covering
+	 * it is cancelled. The page must not be used before it is read or
+	 * revalidated again. Optional.
+	 *
+	 * \see cl_page_stale()
+	 * \see vvp_page_stale()
+	 */
+	void (*cpo_stale)(const struct lu_env *env,
+			  const struct cl_page_slice *slice,
+			  struct cl_io *io);
         /**
          * Called when page is removed from the cache, and is about to being
          * destroyed. Optional.
@@ -1947,7 +1958,12 @@ struct cl_io {
 	 * this DIO is at least partly unaligned, and so the unaligned DIO
 	 * path is being used for this entire IO
 	 */
-			     ci_unaligned_dio:1;
+			     ci_unaligned_dio:1,
+	/**
+	 * This buffered IO was switched to direct IO by llite because it is
+	 * large and streaming, see ll_hybrid_io_switch()
+	 */
+			     ci_hybrid_switched:1;
 	/**
 	 * Bypass quota check
 	 */
@@ -2216,6 +2232,10 @@ struct cl_page *cl_page_alloc       (const struct lu_env *env,
 				     struct cl_object *o, pgoff_t ind,
 				     struct page *vmpage,
 				     enum cl_page_type type);
+void		cl_page_stash_fill  (const struct lu_env *env,
+				     struct cl_object *obj,
+				     unsigned int count);
+void		cl_page_stash_drain (const struct lu_env *env);
 void            cl_page_get         (struct cl_page *page);
 void            cl_page_put         (const struct lu_env *env,
                                      struct cl_page *page);
@@ -2281,6 +2301,8 @@ int  cl_page_flush      (const struct lu_env *env, struct cl_io *io,
 /** @{ */
 void    cl_page_discard(const struct lu_env *env, struct cl_io *io,
 			struct cl_page *pg);
+bool	cl_page_stale(const struct lu_env *env, struct cl_io *io,
+		      struct cl_page *pg);
 void    cl_page_delete(const struct lu_env *env, struct cl_page *pg);
 void	cl_page_touch(const struct lu_env *env, const struct cl_page *pg,
 		      size_t to);
@@ -2601,6 +2623,11 @@ struct cl_sub_dio {
 void ll_release_user_pages(struct page **pages, int npages);
 int ll_allocate_dio_buffer(struct ll_dio_pages *pvec, size_t io_size);
 void ll_free_dio_buffer(struct ll_dio_pages *pvec);
+int cl_dio_pool_get_pages(struct page **pages, unsigned int count);
+void cl_dio_pool_put_pages(struct page **pages, unsigned int count);
+int cl_dio_pool_seq_show(struct seq_file *m, void *v);
+int cl_dio_pool_init(void);
+void cl_dio_pool_fini(void);
 ssize_t ll_dio_user_copy(struct cl_sub_dio *sdio, struct iov_iter *write_iov);
 
 #ifndef HAVE_KTHREAD_USE_MM
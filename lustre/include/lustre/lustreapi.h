@@ -403,7 +403,8 @@ struct find_param {
 	unsigned long		 fp_got_uuids:1,
 				 fp_obds_printed:1,
 				 fp_no_follow:1,
-				 fp_hex_idx:1;
+				 fp_hex_idx:1,
+				 fp_parallel:1; /* internal, see llapi_find() */
 	unsigned int		 fp_depth;
 	unsigned int		 fp_hash_type;
 	unsigned int		 fp_time_margin; /* time margin in seconds */
@@ -426,6 +427,8 @@ struct find_param {
 	nlink_t			 fp_nlink;
 	__u64			 fp_attrs;
 	__u64			 fp_neg_attrs;
+	/* threads to walk the directory tree with, lfs find -j */
+	unsigned int		 fp_thread_count;
 };
 
 int llapi_ostlist(char *path, struct find_param *param);
@@ -953,6 +956,34 @@ int llapi_layout_pattern_get(const struct llapi_layout *layout,
  */
 int llapi_layout_pattern_set(struct llapi_layout *layout, uint64_t pattern);
 
+/**
+ * Store the compression algorithm (enum ll_compr_type), level and chunk size
+ * in bytes of the current component of \a layout in \a type, \a level and
+ * \a chunk_size. \a type is LL_COMPR_TYPE_NONE for uncompressed components.
+ *
+ * \retval  0 Success.
+ * \retval -1 Error with status code in errno.
+ */
+int llapi_layout_compress_get(const struct llapi_layout *layout,
+			      unsigned int *type, unsigned int *level,
+			      uint32_t *chunk_size);
+
+/**
+ * Make the client compress the data of the current component of \a layout
+ * with algorithm \a type at \a level, in chunks of \a chunk_size bytes.
+ * \a chunk_size must be a power of two between 64KiB and 4MiB, or 0 for
+ * 64KiB.
+ *
+ * \retval  0 Success.
+ * \retval -1 Invalid argument, errno set to EINVAL.
+ */
+int llapi_layout_compress_set(struct llapi_layout *layout, unsigned int type,
+			      unsigned int level, uint32_t chunk_size);
+
+/** Convert between compression algorithm names and enum ll_compr_type. */
+int llapi_compress_name2type(const char *name);
+const char *llapi_compress_type2name(unsigned int type);
+
 /******************** OST Index ********************/
 
 /**
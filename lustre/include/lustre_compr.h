@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/include/lustre_compr.h
+ *
+ * Chunk compression of BRW bulk data for LOV_PATTERN_COMPRESS components,
+ * see struct ll_compr_hdr for the bulk format. Only the bulk of writes is
+ * compressed, the OST stores and reads back the data uncompressed.
+ */
+
+#ifndef _LUSTRE_COMPR_H
+#define _LUSTRE_COMPR_H
+
+#include <linux/mm.h>
+#include <uapi/linux/lustre/lustre_idl.h>
+#include <uapi/linux/lustre/lustre_user.h>
+
+/* mask of (1 << ll_compr_type) this node can decompress, for ocd_compr_type */
+__u64 lustre_compr_types_supported(void);
+
+int lustre_compr_chunk(enum ll_compr_type type, unsigned int lvl,
+		       unsigned int chunk_bits, struct page **src,
+		       struct page **dst, unsigned int *bulk_size);
+int lustre_decompr_chunk(const struct ll_compr_hdr *hdr, unsigned int avail,
+			 struct page **dst, unsigned int dst_count);
+
+void lustre_compr_fini(void);
+
+#endif /* _LUSTRE_COMPR_H */
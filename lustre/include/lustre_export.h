@@ -496,6 +496,19 @@ static inline int exp_connect_lseek(struct obd_export *exp)
 	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_LSEEK);
 }
 
+/* mask of (1 << ll_compr_type) both ends of the import can handle */
+static inline __u64 imp_connect_compr_types(struct obd_import *imp)
+{
+	struct obd_connect_data *ocd = &imp->imp_connect_data;
+
+	return OCD_HAS_FLAG2(ocd, COMPRESS) ? ocd->ocd_compr_type : 0;
+}
+
+static inline int exp_connect_compress(struct obd_export *exp)
+{
+	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_COMPRESS);
+}
+
 static inline int exp_connect_dom_lvb(struct obd_export *exp)
 {
 	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_DOM_LVB);
@@ -529,6 +542,16 @@ static inline bool exp_connect_unaligned_dio(struct obd_export *exp)
 	return (exp_connect_flags2(exp) & OBD_CONNECT2_UNALIGNED_DIO);
 }
 
+static inline bool exp_connect_batch_reint(struct obd_export *exp)
+{
+	return (exp_connect_flags2(exp) & OBD_CONNECT2_BATCH_REINT);
+}
+
+static inline bool exp_connect_xattr_prefetch(struct obd_export *exp)
+{
+	return (exp_connect_flags2(exp) & OBD_CONNECT2_XATTR_PREFETCH);
+}
+
 enum {
 	/* archive_ids in array format */
 	KKUC_CT_DATA_ARRAY_MAGIC	= 0x092013cea,
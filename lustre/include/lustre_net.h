@@ -50,6 +50,7 @@
  * @{
  */
 #include <linux/kobject.h>
+#include <linux/llist.h>
 #include <linux/rhashtable.h>
 #include <linux/uio.h>
 #include <libcfs/libcfs.h>
@@ -536,6 +537,8 @@ struct ptlrpc_connection {
 	struct rhash_head	c_hash;
 	/** Our own lnet nid for this connection */
 	struct lnet_nid		c_self;
+	/** CPT of the network device of c_self, or CFS_CPT_ANY */
+	int			c_dev_cpt;
 	/** Remote side nid for this connection */
 	struct lnet_processid	c_peer;
 	/** UUID of the other side */
@@ -699,6 +702,18 @@ struct ptlrpc_reply_state {
 	 * of no network encryption we jus set \a rs_repbuf to \a rs_msg
 	 */
 	struct lustre_msg	*rs_msg;	/* reply message */
+	/**
+	 * If set, the reply is sent from these pages rather than from
+	 * \a rs_repbuf: pages the packed reply buffer is copied to, followed
+	 * by the pages holding the content of the last buffer of the reply
+	 * message, see req_capsule_server_kiov_set(). A page reference is
+	 * held for each entry.
+	 */
+	struct bio_vec		*rs_kiov;
+	/** Number of entries in \a rs_kiov */
+	int			rs_kiov_count;
+	/** Number of entries of the reply buffer at the start of \a rs_kiov */
+	int			rs_kiov_head;
 
 	/** Handles of locks awaiting client reply ACK */
 	struct lustre_handle	rs_locks[RS_MAX_LOCKS];
@@ -923,6 +938,8 @@ struct ptlrpc_srv_req {
 	struct ptlrpc_hpreq_ops		*sr_ops;
 	/** incoming request buffer */
 	struct ptlrpc_request_buffer_desc *sr_rqbd;
+	/** link on ptlrpc_service_part::scp_intake until preprocessed */
+	struct llist_node		 sr_intake;
 };
 
 /** server request member alias */
@@ -1556,7 +1573,8 @@ struct ptlrpc_request_buffer_desc {
 	struct ptlrpc_service_part	*rqbd_svcpt;
 	/** LNet descriptor */
 	struct lnet_handle_md		rqbd_md_h;
-	int				rqbd_refcount;
+	/** # requests using the buffer, +1 while it is posted */
+	atomic_t			rqbd_refcount;
 	/** The buffer itself */
 	char				*rqbd_buffer;
 	struct ptlrpc_cb_id		rqbd_cbid;
@@ -1698,6 +1716,50 @@ struct ptlrpc_service {
  * We don't have any use-case to take two or more locks at the same time
  * for now, so there is no lock order issue.
  */
+/**
+ * One multi-producer queue of struct ptlrpc_intake, on its own cache line.
+ * Producers add to piq_head without any lock, consumers move it over to
+ * piq_ready in arrival order and take entries off there under piq_lock.
+ */
+struct ptlrpc_intake_queue {
+	struct llist_head		piq_head;
+	spinlock_t			piq_lock;
+	/** entries of piq_head in arrival order, not taken yet */
+	struct llist_node		*piq_ready;
+} ____cacheline_aligned_in_smp;
+
+/**
+ * Incoming requests of a service partition waiting for preprocessing.
+ *
+ * Requests are added from request_in_callback() to the queue of the
+ * current CPU without taking any lock, and a service thread takes up to
+ * PTLRPC_REQ_IN_BATCH of them at once, see ptlrpc_intake_take().
+ */
+struct ptlrpc_intake {
+	/** # queued entries */
+	atomic_t			pi_count;
+	/** queue the next ptlrpc_intake_take() starts from */
+	atomic_t			pi_next;
+	/** # queues, usually the number of CPUs of the partition */
+	int				pi_nqueues;
+	struct ptlrpc_intake_queue	*pi_queues;
+};
+
+/** # of requests a service thread takes and preprocesses at once */
+#define PTLRPC_REQ_IN_BATCH	16
+
+int ptlrpc_intake_init(struct ptlrpc_intake *pi,
+		       struct cfs_cpt_table *cptab, int cpt);
+void ptlrpc_intake_fini(struct ptlrpc_intake *pi);
+void ptlrpc_intake_add(struct ptlrpc_intake *pi, struct llist_node *node);
+struct llist_node *ptlrpc_intake_take(struct ptlrpc_intake *pi, int max);
+
+/** # entries in \a pi, the caller of ptlrpc_intake_take() may see fewer */
+static inline int ptlrpc_intake_count(struct ptlrpc_intake *pi)
+{
+	return atomic_read(&pi->pi_count);
+}
+
 struct ptlrpc_service_part {
 	/** back reference to owner */
 	struct ptlrpc_service		*scp_service __cfs_cacheline_aligned;
@@ -1714,8 +1776,8 @@ struct ptlrpc_service_part {
 
 	/**
 	 * serialize the following fields, used for protecting
-	 * rqbd list and incoming requests waiting for preprocess,
-	 * threads starting & stopping are also protected by this lock.
+	 * rqbd list and request history, threads starting & stopping
+	 * are also protected by this lock.
 	 */
 	spinlock_t			scp_lock  __cfs_cacheline_aligned;
 	/** userland serialization */
@@ -1726,14 +1788,12 @@ struct ptlrpc_service_part {
 	int				scp_nrqbds_posted;
 	/** in progress of allocating rqbd */
 	int				scp_rqbd_allocating;
-	/** # incoming reqs */
-	int				scp_nreqs_incoming;
 	/** request buffers to be reposted */
 	struct list_head		scp_rqbd_idle;
 	/** req buffers receiving */
 	struct list_head		scp_rqbd_posted;
-	/** incoming reqs */
-	struct list_head		scp_req_incoming;
+	/** incoming reqs, not protected by scp_lock */
+	struct ptlrpc_intake		scp_intake;
 	/** timeout before re-posting reqs, in jiffies */
 	long				scp_rqbd_timeout;
 	/**
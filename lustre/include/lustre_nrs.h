@@ -703,6 +703,7 @@ struct binheap_node {
 #include <lustre_nrs_tbf.h>
 #include <lustre_nrs_crr.h>
 #include <lustre_nrs_orr.h>
+#include <lustre_nrs_wfq.h>
 #endif /* HAVE_SERVER_SUPPORT */
 #include <lustre_nrs_delay.h>
 
@@ -752,6 +753,10 @@ struct ptlrpc_nrs_request {
 		 * TBF request definition
 		 */
 		struct nrs_tbf_req	tbf;
+		/**
+		 * WFQ request definition
+		 */
+		struct nrs_wfq_req	wfq;
 #endif /* HAVE_SERVER_SUPPORT */
 		/**
 		 * Fields for the delay policy
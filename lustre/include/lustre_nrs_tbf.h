@@ -185,6 +185,15 @@ struct nrs_tbf_rule {
 	atomic_t			 tr_ref;
 	/** Generation of the rule. */
 	__u64				 tr_generation;
+	/** Position of the rule in nrs_tbf_head::th_list, 0 is the newest. */
+	__u32				 tr_rank;
+	/** Entries of the rule in the rule index, nrs_tbf_index_entry. */
+	struct list_head		 tr_index;
+	/**
+	 * Linkage to nrs_tbf_head::th_index_scan, if the rule could not be
+	 * indexed and is checked for each client.
+	 */
+	struct list_head		 tr_scan;
 };
 
 struct nrs_tbf_ops {
@@ -203,6 +212,11 @@ struct nrs_tbf_ops {
 	int (*o_rule_match)(struct nrs_tbf_rule *,
 			    struct nrs_tbf_client *);
 	void (*o_rule_fini)(struct nrs_tbf_rule *);
+	/**
+	 * Add to nrs_tbf_rule::tr_index the entries covering all clients the
+	 * rule may match, or fail if it cannot, e.g. for wildcard jobids.
+	 */
+	int (*o_rule_index)(struct nrs_tbf_rule *);
 };
 
 #define NRS_TBF_TYPE_JOBID	"jobid"
@@ -227,6 +241,9 @@ struct nrs_tbf_bucket {
 	struct list_head	ntb_lru;
 };
 
+#define NRS_TBF_INDEX_HASH_BITS	8
+#define NRS_TBF_INDEX_HASH_SIZE	(1 << NRS_TBF_INDEX_HASH_BITS)
+
 /**
  * Private data structure for the TBF policy
  */
@@ -287,6 +304,24 @@ struct nrs_tbf_head {
 	 * Index of bucket on hash table while purging.
 	 */
 	int				 th_purge_start;
+	/**
+	 * Rule index entries by jobid, UID, GID or opcode. The rule index is
+	 * protected by th_rule_lock.
+	 */
+	struct hlist_head		 th_index_hash[NRS_TBF_INDEX_HASH_SIZE];
+	/**
+	 * Interval tree of the rule index entries by range of NIDs.
+	 */
+	struct interval_tree_root	 th_index_nids;
+	/**
+	 * Rules which could not be indexed, by rank.
+	 */
+	struct list_head		 th_index_scan;
+	/**
+	 * Number of clients classified, and of rules checked for them.
+	 */
+	__u64				 th_index_lookups;
+	__u64				 th_index_checks;
 };
 
 enum nrs_tbf_cmd_type {
@@ -330,6 +365,32 @@ enum nrs_tbf_field {
 	NRS_TBF_FIELD_MAX
 };
 
+/**
+ * Entry of the rule index of a TBF policy instance, telling that a rule may
+ * match the clients with a given jobid, UID, GID or opcode, hashed in
+ * nrs_tbf_head::th_index_hash, or with a NID in a range, in
+ * nrs_tbf_head::th_index_nids.
+ *
+ * The entries only select the rules to check with nrs_tbf_ops::o_rule_match()
+ * so a client is classified without walking the whole rule list.
+ */
+struct nrs_tbf_index_entry {
+	/** Linkage to nrs_tbf_rule::tr_index. */
+	struct list_head		 tie_linkage;
+	struct nrs_tbf_rule		*tie_rule;
+	enum nrs_tbf_field		 tie_field;
+	/** Node in nrs_tbf_head::th_index_hash. */
+	struct hlist_node		 tie_hnode;
+	/** UID, GID or opcode. */
+	__u32				 tie_id;
+	char				 tie_jobid[LUSTRE_JOBID_SIZE];
+	/** Node in nrs_tbf_head::th_index_nids. */
+	struct rb_node			 tie_rb;
+	lnet_nid_t			 tie_first;
+	lnet_nid_t			 tie_last;
+	lnet_nid_t			 tie_subtree_last;
+};
+
 struct nrs_tbf_expression {
 	enum nrs_tbf_field	 te_field;
 	struct list_head	 te_cond;
@@ -374,6 +435,10 @@ struct nrs_tbf_req {
  * Read the TBF policy type preset by proc entry "nrs_policies".
  */
 #define NRS_CTL_TBF_RD_TYPE_FLAG PTLRPC_NRS_CTL_POL_SPEC_03
+/**
+ * Read the counters of client classifications of a TBF policy.
+ */
+#define NRS_CTL_TBF_RD_INDEX_STATS PTLRPC_NRS_CTL_POL_SPEC_04
 
 /** @} tbf */
 #endif
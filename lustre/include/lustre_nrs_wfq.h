@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/include/lustre_nrs_wfq.h
+ *
+ * Network Request Scheduler (NRS) Weighted Fair Queuing (WFQ) policy
+ */
+
+#ifndef _LUSTRE_NRS_WFQ_H
+#define _LUSTRE_NRS_WFQ_H
+
+/**
+ * \name WFQ
+ *
+ * WFQ, Weighted Fair Queuing of requests by jobid, UID, GID or project,
+ * using Deficit Round Robin over the classes with queued requests.
+ * @{
+ */
+#include <libcfs/linux/linux-hash.h>
+
+/**
+ * Request attribute that classes are keyed by, chosen when starting the
+ * policy, i.e. "wfq jobid", "wfq uid", "wfq gid" or "wfq projid".
+ */
+enum nrs_wfq_key_type {
+	NRS_WFQ_KEY_JOBID	= 0,
+	NRS_WFQ_KEY_UID,
+	NRS_WFQ_KEY_GID,
+	NRS_WFQ_KEY_PROJID,
+};
+
+/** class keys are jobids, or IDs printed in decimal */
+#define NRS_WFQ_KEY_LEN		LUSTRE_JOBID_SIZE
+/** name used to set the weight of classes without a weight of their own */
+#define NRS_WFQ_KEY_DEFAULT	"default"
+#define NRS_WFQ_WEIGHT_DEFAULT	1
+
+/**
+ * Private data structure for the WFQ policy
+ */
+struct nrs_wfq_head {
+	struct ptlrpc_nrs_resource	wh_res;
+	/** classes by nrs_wfq_class::wc_key */
+	struct rhashtable		wh_cls_hash;
+	/**
+	 * Classes with queued requests, in the order they are served in the
+	 * current round; protected by ptlrpc_service_part::scp_req_lock.
+	 */
+	struct list_head		wh_active;
+	/**
+	 * Protects nrs_wfq_head::wh_weights, nrs_wfq_head::wh_weights_gen and
+	 * nrs_wfq_head::wh_weight_default.
+	 */
+	spinlock_t			wh_lock;
+	/** weights set for classes, list of nrs_wfq_weight */
+	struct list_head		wh_weights;
+	/** bumped on each weight change, for classes to pick it up */
+	__u32				wh_weights_gen;
+	/** weight of classes that have none set in wh_weights */
+	__u16				wh_weight_default;
+	enum nrs_wfq_key_type		wh_key_type;
+};
+
+/**
+ * Weight set for a class
+ */
+struct nrs_wfq_weight {
+	struct list_head		ww_list;
+	char				ww_key[NRS_WFQ_KEY_LEN];
+	__u16				ww_weight;
+};
+
+/**
+ * Object representing a class of requests in WFQ, i.e. a job, user, group or
+ * project.
+ */
+struct nrs_wfq_class {
+	struct ptlrpc_nrs_resource	wc_res;
+	struct rhash_head		wc_rhead;
+	struct rcu_head			wc_rcu;
+	char				wc_key[NRS_WFQ_KEY_LEN];
+	/** linkage on nrs_wfq_head::wh_active while requests are queued */
+	struct list_head		wc_list;
+	/** queued requests, in arrival order */
+	struct list_head		wc_reqs;
+	/** # requests holding the class, it is freed on the last put */
+	atomic_t			wc_ref;
+	/** nrs_wfq_head::wh_weights_gen wc_weight was computed for */
+	__u32				wc_weights_gen;
+	/**
+	 * The weight of the class; the number of requests it may have handled
+	 * in each round while it has requests queued.
+	 */
+	__u16				wc_weight;
+	/** # requests the class may still have handled in this round */
+	__u16				wc_deficit;
+};
+
+/**
+ * WFQ NRS request definition
+ */
+struct nrs_wfq_req {
+	/** linkage on nrs_wfq_class::wc_reqs */
+	struct list_head		wr_list;
+};
+
+/**
+ * Argument of NRS_CTL_WFQ_WR_WEIGHT.
+ */
+struct nrs_wfq_weight_cmd {
+	char				wwc_key[NRS_WFQ_KEY_LEN];
+	/** 0 to drop the weight of class wwc_key */
+	__u16				wwc_weight;
+};
+
+/**
+ * WFQ policy operations.
+ *
+ * Print the weights of a WFQ policy in a seq_file.
+ */
+#define NRS_CTL_WFQ_RD_WEIGHTS	PTLRPC_NRS_CTL_POL_SPEC_01
+/**
+ * Set the weight of a class of a WFQ policy.
+ */
+#define NRS_CTL_WFQ_WR_WEIGHT	PTLRPC_NRS_CTL_POL_SPEC_02
+
+/** @} WFQ */
+#endif
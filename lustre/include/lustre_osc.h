@@ -106,6 +106,9 @@ struct osc_device {
 		ktime_t		os_init;
 		uint64_t	os_lockless_writes;    /* by bytes */
 		uint64_t	os_lockless_reads;     /* by bytes */
+		/* bytes written by compressed BRW RPCs, and sent for them */
+		uint64_t	os_compr_write_bytes;
+		uint64_t	os_compr_bulk_bytes;
 	} osc_stats;
 
 	/* configuration item(s) */
@@ -169,6 +172,7 @@ struct osc_thread_info {
 	pgoff_t			oti_next_index;
 	pgoff_t			oti_fn_index; /* first non-overlapped index */
 	pgoff_t			oti_ng_index; /* negative lock caching */
+	bool			oti_stale_keep; /* keep clean pages stale */
 	struct cl_sync_io	oti_anchor;
 	struct cl_req_attr	oti_req_attr;
 	struct lu_buf		oti_ladvise_buf;
@@ -300,6 +304,19 @@ struct osc_object {
 	spinlock_t		oo_tree_lock;
 	struct radix_tree_root	oo_tree;
 	unsigned long		oo_npages;
+	/**
+	 * Number of pages kept stale after their lock was cancelled, and the
+	 * data version of the object when they were kept, see
+	 * osc_page::ops_stale. oo_stale_dv is protected by oo_lock.
+	 */
+	atomic_t		oo_nr_stale;
+	__u32			oo_stale_dv;
+	/**
+	 * Latest data version received in the LVB of a lock or glimpse, the
+	 * low 32 bits of it only, 0 if the OST does not send it. Protected
+	 * by the attribute lock.
+	 */
+	__u32			oo_lvb_dv;
 
 	/* Protect osc_lock this osc_object has */
 	struct list_head	oo_ol_list;
@@ -527,12 +544,47 @@ struct osc_page {
 	 * If the page is in osc_object::oo_tree.
 	 */
 				ops_intree:1;
+	/**
+	 * CPU partition of the LRU sublist ops_lru is on.
+	 */
+	__u16			ops_lru_cpt;
+	/**
+	 * Set if the page was kept in cache after the lock covering it was
+	 * cancelled. The page is not up to date, but the data it holds are
+	 * still valid if the data version of the object did not change. It is
+	 * protected by the page lock.
+	 */
+	bool			ops_stale;
 	/**
 	 * lru page list. See osc_lru_{del|use}() in osc_page.c for usage.
 	 */
 	struct list_head	ops_lru;
 };
 
+/* bulk of a BRW write with compressed chunks, see osc_brw_compress() */
+struct osc_brw_compr {
+	struct brw_page		**obc_pga;	/* pages sent in the bulk */
+	u32			  obc_page_count;
+	int			  obc_nob;	/* bytes sent in the bulk */
+	struct brw_page		 *obc_bpg;	/* compressed chunk pages */
+	struct page		**obc_bounce;	/* pool pages of obc_bpg */
+	u32			  obc_bounce_count;
+};
+
+/**
+ * Per-RPC state of a BRW built by osc_build_rpc(), allocated as one unit and
+ * recycled through the cl_rpc_arenas of the client_obd.
+ */
+struct osc_rpc_buf {
+	struct list_head	 orb_link;
+	struct obdo		 orb_oa;
+	/* CPT the buffer was allocated on and is returned to */
+	int			 orb_cpt;
+	/* # of entries in orb_pga */
+	u32			 orb_pages;
+	struct brw_page		*orb_pga[];
+};
+
 struct osc_brw_async_args {
 	struct obdo		*aa_oa;
 	int			 aa_requested_nob;
@@ -543,6 +595,9 @@ struct osc_brw_async_args {
 	struct client_obd	*aa_cli;
 	struct list_head	 aa_oaps;
 	struct list_head	 aa_exts;
+	struct osc_brw_compr	*aa_compr;
+	/* holds aa_oa and aa_ppga if the RPC was built by osc_build_rpc() */
+	struct osc_rpc_buf	*aa_rpc_buf;
 };
 
 extern struct kmem_cache *osc_lock_kmem;
@@ -568,6 +623,8 @@ void osc_page_submit(const struct lu_env *env, struct osc_page *opg,
 int lru_queue_work(const struct lu_env *env, void *data);
 long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		    long target, bool force);
+int osc_lru_sublists_init(struct client_obd *cli);
+void osc_lru_sublists_fini(struct client_obd *cli);
 
 /* osc_cache.c */
 int osc_set_async_flags(struct osc_object *obj, struct osc_page *opg,
@@ -141,6 +141,11 @@ void req_capsule_shrink(struct req_capsule *pill,
 int req_capsule_server_grow(struct req_capsule *pill,
 			    const struct req_msg_field *field,
 			    __u32 newlen);
+bool req_capsule_server_kiov_ok(const struct req_capsule *pill,
+				const struct req_msg_field *field);
+int req_capsule_server_kiov_set(struct req_capsule *pill,
+				const struct req_msg_field *field,
+				struct bio_vec *kiov, int count, __u32 len);
 bool req_capsule_need_swab(struct req_capsule *pill, enum req_location loc,
 			   __u32 index);
 void req_capsule_set_swabbed(struct req_capsule *pill, enum req_location loc,
@@ -313,6 +318,7 @@ extern struct req_format RQF_LFSCK_QUERY;
 
 /* Batch UpdaTe req_format */
 extern struct req_format RQF_BUT_GETATTR;
+extern struct req_format RQF_BUT_UNLINK;
 extern struct req_format RQF_MDS_BATCH;
 
 extern struct req_msg_field RMF_GENERIC_DATA;
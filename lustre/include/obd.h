@@ -64,6 +64,10 @@ struct lov_oinfo {                 /* per-stripe data structure */
 	__u64 loi_kms;             /* known minimum size */
 	struct ost_lvb loi_lvb;
 	struct osc_async_rc     loi_ar;
+	/* compression of an LOV_PATTERN_COMPRESS component, see ll_compr_hdr */
+	__u8 loi_compr_type;       /* ll_compr_type, 0 if not compressed */
+	__u8 loi_compr_lvl;
+	__u8 loi_compr_chunk_bits; /* log2 of the chunk size */
 };
 
 void lov_fix_ea_for_replay(void *lovea);
@@ -159,6 +163,15 @@ enum tgt_sync_lock_cancel {
  */
 #define OBD_MAX_EA_SIZE		XATTR_SIZE_MAX
 
+/*
+ * Reply buffer sizes for all xattrs of a file piggybacked on getattr and
+ * open intent replies. Files with more xattrs than fit in these buffers
+ * are not prefetched, and the client falls back to IT_GETXATTR.
+ */
+#define OBD_XATTR_PREFETCH_NAME_SIZE	256
+#define OBD_XATTR_PREFETCH_VAL_SIZE	2048
+#define OBD_XATTR_PREFETCH_NUM		16
+
 
 enum obd_cl_sem_lock_class {
 	OBD_CLI_SEM_NORMAL,
@@ -167,6 +180,22 @@ enum obd_cl_sem_lock_class {
 };
 
 struct obd_import;
+/* LRU pages of a client_obd added on one CPU partition */
+struct cl_lru_sublist {
+	spinlock_t		ls_lock;
+	struct list_head	ls_list;
+	/* # of pages in ls_list */
+	long			ls_nr;
+};
+
+/* BRW RPC buffers of a client_obd cached on one CPU partition */
+struct cl_rpc_arena {
+	spinlock_t		ra_lock;
+	struct list_head	ra_free;
+	/* # of buffers in ra_free */
+	int			ra_nr;
+};
+
 struct client_obd {
 	struct rw_semaphore	 cl_sem;
 	struct obd_uuid		 cl_target_uuid;
@@ -208,6 +237,8 @@ struct client_obd {
 				 cl_checksum_dump:1, /* same */
 				 cl_ocd_grant_param:1,
 				 cl_lsom_update:1, /* send LSOM updates */
+				 /* keep clean pages after lock cancel */
+				 cl_keep_stale_pages:1,
 				 cl_root_squash:1, /* if root squash enabled*/
 				 /* check prj quota for root */
 				 cl_root_prjquota:1;
@@ -272,6 +303,25 @@ struct client_obd {
 	u32			cl_max_pages_per_rpc;
 	u32			cl_max_rpcs_in_flight;
 	u32			cl_max_short_io_bytes;
+	/* limit of RPCs in flight adapted to the RPC latency, no more than
+	 * cl_max_rpcs_in_flight, see osc_rpc_window_update(). Protected by
+	 * cl_loi_list_lock, like the other fields of the RPC window.
+	 */
+	u32			cl_rpc_window;
+	/* # of RPCs completed in this round, # of them with a latency
+	 * sample, and the total latency of the samples
+	 */
+	u32			cl_rpc_window_count;
+	u32			cl_rpc_window_samples;
+	u64			cl_rpc_window_lat_us;
+	/* lowest RPC latency seen recently, and when it was seen */
+	u64			cl_rpc_lat_min_us;
+	time64_t		cl_rpc_lat_min_stamp;
+	unsigned int		cl_rpc_window_auto:1, /* adapt cl_rpc_window */
+				cl_rpc_window_full:1, /* window was filled */
+				cl_rpc_window_busy:1; /* OST was congested */
+	/* recycled obdo + page array buffers of BRW RPCs, per CPT */
+	struct cl_rpc_arena	**cl_rpc_arenas;
 	ktime_t			cl_stats_init;
 	struct obd_histogram	cl_read_rpc_hist;
 	struct obd_histogram	cl_write_rpc_hist;
@@ -306,10 +356,11 @@ struct client_obd {
 	 * reclaim is sync, initiated by IO thread when the LRU slots are
 	 * in shortage. */
 	__u64                    cl_lru_reclaim;
-	/** List of LRU pages for this client_obd */
-	struct list_head         cl_lru_list;
-	/** Lock for LRU page list */
-	spinlock_t		 cl_lru_list_lock;
+	/** LRU pages of this client_obd, one list per CPU partition so
+	 * that concurrent I/O threads do not share one list lock */
+	struct cl_lru_sublist	**cl_lru_sublists;
+	/** sublist the next LRU shrink starts from */
+	unsigned int		 cl_lru_shrink_cpt;
 	/** # of unstable pages in this client_obd.
 	 * An unstable page is a page state that WRITE RPC has finished but
 	 * the transaction has NOT yet committed. */
@@ -895,6 +946,7 @@ enum md_cli_flags {
 	CLI_MIGRATE	= BIT(4),
 	CLI_DIRTY_DATA	= BIT(5),
 	CLI_NO_SLOT     = BIT(6),
+	CLI_XATTR_PREFETCH = BIT(7),
 };
 
 enum md_op_code {
@@ -1010,6 +1062,7 @@ typedef int (*md_op_item_cb_t)(struct md_op_item *item, int rc);
 enum md_item_opcode {
 	MD_OP_NONE	= 0,
 	MD_OP_GETATTR	= 1,
+	MD_OP_UNLINK	= 2,
 	MD_OP_MAX,
 };
 
@@ -1071,6 +1124,8 @@ struct object_update_callback {
 	object_update_interpret_t	 ouc_interpret;
 	struct batch_update_head	*ouc_head;
 	void				*ouc_data;
+	/* the sub request in the RPC kept for replay, set on interpret */
+	struct lustre_msg		*ouc_reqmsg;
 };
 
 typedef int (*md_update_pack_t)(struct batch_update_head *head,
@@ -875,6 +875,8 @@ struct ptlrpc_body_v2 {
 /* only ZFS servers require a change to support unaligned DIO, so this flag is
  * ignored for ldiskfs servers */
 #define OBD_CONNECT2_UNALIGNED_DIO	0x400000000ULL /* unaligned DIO */
+#define OBD_CONNECT2_BATCH_REINT	0x800000000ULL /* batched modifications */
+#define OBD_CONNECT2_XATTR_PREFETCH    0x1000000000ULL /* xattrs in intents */
 /* XXX README XXX README XXX README XXX README XXX README XXX README XXX
  * Please DO NOT add OBD_CONNECT flags before first ensuring that this value
  * is not in use by some other branch/patch.  Email adilger@whamcloud.com
@@ -941,6 +943,8 @@ struct ptlrpc_body_v2 {
 				OBD_CONNECT2_REP_MBITS | \
 				OBD_CONNECT2_ATOMIC_OPEN_LOCK | \
 				OBD_CONNECT2_BATCH_RPC | \
+				OBD_CONNECT2_BATCH_REINT | \
+				OBD_CONNECT2_XATTR_PREFETCH | \
 				OBD_CONNECT2_ENCRYPT_NAME | \
 				OBD_CONNECT2_ENCRYPT_FID2PATH | \
 				OBD_CONNECT2_DMV_IMP_INHERIT)
@@ -967,7 +971,8 @@ struct ptlrpc_body_v2 {
 #define OST_CONNECT_SUPPORTED2 (OBD_CONNECT2_LOCKAHEAD | OBD_CONNECT2_INC_XID |\
 				OBD_CONNECT2_ENCRYPT | OBD_CONNECT2_LSEEK |\
 				OBD_CONNECT2_REP_MBITS |\
-				OBD_CONNECT2_REPLAY_CREATE)
+				OBD_CONNECT2_REPLAY_CREATE |\
+				OBD_CONNECT2_COMPRESS)
 
 #define ECHO_CONNECT_SUPPORTED (OBD_CONNECT_FID | OBD_CONNECT_FLAGS2)
 #define ECHO_CONNECT_SUPPORTED2 OBD_CONNECT2_REP_MBITS
@@ -1488,6 +1493,24 @@ struct niobuf_remote {
 	__u32	rnb_flags;
 };
 
+/*
+ * An OBD_BRW_COMPRESSED niobuf covers whole compression chunks of the file,
+ * rnb_offset and rnb_len describe the uncompressed data. In the bulk every
+ * chunk is sent as this header followed by the compressed data, padded up to
+ * llch_bulk_size bytes. All fields are little-endian.
+ */
+struct ll_compr_hdr {
+	__u32	llch_magic;		/* LLCH_MAGIC */
+	__u8	llch_compr_type;	/* enum ll_compr_type */
+	__u8	llch_compr_lvl;		/* level the chunk was compressed at */
+	__u8	llch_chunk_bits;	/* log2 of the uncompressed chunk size */
+	__u8	llch_hdr_size;		/* bytes before the compressed data */
+	__u32	llch_compr_size;	/* bytes of compressed data */
+	__u32	llch_bulk_size;		/* bytes of this chunk in the bulk */
+};
+
+#define LLCH_MAGIC	0x4c4c4348	/* "LLCH" */
+
 /* lock value block communicated between the filter and llite */
 
 /* OST_LVB_ERR_INIT is needed because the return code in rc is
@@ -1517,7 +1540,8 @@ struct ost_lvb {
 	__u32	lvb_mtime_ns;
 	__u32	lvb_atime_ns;
 	__u32	lvb_ctime_ns;
-	__u32	lvb_padding;
+	__u32	lvb_data_version; /* low 32 bits of the data version of the
+				   * object, 0 if unknown */
 };
 
 /*
@@ -1907,8 +1931,9 @@ struct mdt_body {
 	__u64	mbo_dom_size; /* size of DOM component */
 	__u64	mbo_dom_blocks; /* blocks consumed by DOM component */
 	__u64	mbo_btime;
-	__u64	mbo_padding_9; /* also fix lustre_swab_mdt_body */
-	__u64	mbo_padding_10;
+	__u64	mbo_pre_versions[2]; /* of a batched unlink, see
+				  * mdt_rec_unlink::ul_pre_versions
+				  */
 }; /* 216 */
 
 struct mdt_ioepoch {
@@ -2099,8 +2124,11 @@ struct mdt_rec_unlink {
         struct lu_fid   ul_fid1;
         struct lu_fid   ul_fid2;
 	__s64		ul_time;
-        __u64           ul_padding_2;   /* rr_atime */
-        __u64           ul_padding_3;   /* rr_ctime */
+	__u64		ul_pre_versions[2]; /* rr_atime, rr_ctime, parent and
+					     * child versions of a batched
+					     * unlink for VBR, copied from
+					     * mdt_body::mbo_pre_versions
+					     */
         __u64           ul_padding_4;   /* rr_size */
         __u64           ul_padding_5;   /* rr_blocks */
         __u32           ul_bias;
@@ -3166,8 +3194,9 @@ struct obdo {
 						 * brw: grant space consumed on
 						 * the client for the write */
 	__u32			o_projid;
-	__u32			o_padding_4;	/* also fix
-						 * lustre_swab_obdo() */
+	__u32			o_compr_nob;	/* brw: bytes in the bulk if
+						 * any niobuf is
+						 * OBD_BRW_COMPRESSED */
 	__u64			o_padding_5;
 	__u64			o_padding_6;
 };
@@ -3624,6 +3653,7 @@ struct batch_update_reply {
  */
 enum batch_update_cmd {
 	BUT_GETATTR	= 1,
+	BUT_UNLINK	= 2,	/* REINT_UNLINK */
 	BUT_LAST_OPC,
 	BUT_FIRST_OPC	= BUT_GETATTR,
 };
@@ -739,6 +739,9 @@ static inline bool lov_pattern_supported(__u32 pattern)
 
 	return pattern_base == LOV_PATTERN_RAID0 ||
 	       pattern_base == (LOV_PATTERN_RAID0 | LOV_PATTERN_OVERSTRIPING) ||
+	       pattern_base == (LOV_PATTERN_RAID0 | LOV_PATTERN_COMPRESS) ||
+	       pattern_base == (LOV_PATTERN_RAID0 | LOV_PATTERN_OVERSTRIPING |
+				LOV_PATTERN_COMPRESS) ||
 	       pattern_base == LOV_PATTERN_MDT;
 }
 
@@ -748,9 +751,34 @@ static inline bool lov_pattern_supported(__u32 pattern)
  */
 static inline bool lov_pattern_supported_normal_comp(__u32 pattern)
 {
-	return pattern == LOV_PATTERN_RAID0 ||
-	       pattern == (LOV_PATTERN_RAID0 | LOV_PATTERN_OVERSTRIPING);
+	__u32 pattern_base = pattern & ~LOV_PATTERN_COMPRESS;
 
+	return pattern_base == LOV_PATTERN_RAID0 ||
+	       pattern_base == (LOV_PATTERN_RAID0 | LOV_PATTERN_OVERSTRIPING);
+
+}
+
+/* Compression algorithm of an LOV_PATTERN_COMPRESS component, kept in
+ * lcme_compr_type. The connect data advertises (1 << type) for every
+ * algorithm a node supports in ocd_compr_type.
+ */
+enum ll_compr_type {
+	LL_COMPR_TYPE_NONE	= 0,
+	LL_COMPR_TYPE_LZ4	= 1,	/* lz4, or lz4hc for level > 0 */
+	LL_COMPR_TYPE_ZSTD	= 2,
+	LL_COMPR_TYPE_MAX,
+};
+
+/* lcme_compr_chunk_log_bits is relative to the minimum chunk size */
+#define COMPR_CHUNK_MIN_BITS	16	/* 64KiB */
+#define COMPR_CHUNK_MAX_BITS	22	/* 4MiB, must fit in one BRW RPC */
+#define COMPR_LEVEL_MAX		15	/* lcme_compr_lvl is 4 bits */
+
+static inline bool lov_compr_params_valid(__u8 type, __u8 lvl, __u8 log_bits)
+{
+	return type > LL_COMPR_TYPE_NONE && type < LL_COMPR_TYPE_MAX &&
+	       lvl <= COMPR_LEVEL_MAX &&
+	       log_bits <= COMPR_CHUNK_MAX_BITS - COMPR_CHUNK_MIN_BITS;
 }
 
 #define LOV_MAXPOOLNAME 15
@@ -1647,6 +1675,7 @@ enum la_valid {
 #define MDS_OPEN_DEFAULT_LMV  040000000000000ULL /* open fetches default LMV,
 						  * or mkdir with default LMV
 						  */
+#define MDS_OPEN_XATTRS      0100000000000000ULL /* open fetches all xattrs */
 
 /* lustre internal open flags, which should not be set from user space */
 #define MDS_OPEN_FL_INTERNAL (MDS_OPEN_HAS_EA | MDS_OPEN_HAS_OBJS |	\
@@ -1654,7 +1683,7 @@ enum la_valid {
 			      MDS_OPEN_BY_FID | MDS_OPEN_LEASE |	\
 			      MDS_OPEN_RELEASE | MDS_OPEN_RESYNC |	\
 			      MDS_OPEN_PCC | MDS_OP_WITH_FID |		\
-			      MDS_OPEN_DEFAULT_LMV)
+			      MDS_OPEN_DEFAULT_LMV | MDS_OPEN_XATTRS)
 
 /* mkdir fetches LMV, reuse bit of MDS_OPEN_RESYNC */
 #define MDS_MKDIR_LMV	MDS_OPEN_RESYNC
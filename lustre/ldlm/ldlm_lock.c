@@ -1615,6 +1615,7 @@ int ldlm_fill_lvb(struct ldlm_lock *lock, struct req_capsule *pill,
 			olvb->lvb_mtime_ns = 0;
 			olvb->lvb_atime_ns = 0;
 			olvb->lvb_ctime_ns = 0;
+			olvb->lvb_data_version = 0;
 		} else {
 			LDLM_ERROR(lock, "Replied unexpected ost LVB size %d",
 				   size);
@@ -273,6 +273,7 @@ int ll_revalidate_it_finish(struct ptlrpc_request *request,
 
 	ll_set_lock_data(ll_i2sbi(inode)->ll_md_exp, inode, it,
 			 &bits);
+	ll_xattr_cache_prefill(inode, &request->rq_pill, bits);
 	if (bits & MDS_INODELOCK_LOOKUP) {
 		if (!ll_d_setup(de, true))
 			RETURN(-ENOMEM);
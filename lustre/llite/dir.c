@@ -43,6 +43,8 @@
 #include <linux/uaccess.h>
 #include <linux/buffer_head.h>   // for wait_on_buffer
 #include <linux/pagevec.h>
+#include <linux/hash.h>
+#include <linux/jhash.h>
 
 #define DEBUG_SUBSYSTEM S_LLITE
 
@@ -309,6 +311,315 @@ int ll_dir_read(struct inode *inode, __u64 *ppos, struct md_op_data *op_data,
 	RETURN(rc);
 }
 
+/*
+ * Name index of a directory, built from its pages so that lookups of names
+ * which are not in the dcache are answered without an RPC as long as the
+ * UPDATE lock of the directory is cached. It is dropped together with the
+ * pages when that lock is cancelled, see ll_lock_cancel_bits().
+ *
+ * Indexes are built by ll_dir_index_work() on ll_readahead_wq, not in the
+ * lookup path, and the memory of all the indexes of a mount is limited by
+ * dir_index_max_mb.
+ */
+struct ll_dir_name {
+	struct hlist_node	ldn_hash;
+	struct lu_fid		ldn_fid;
+	__u32			ldn_hashval;
+	int			ldn_namelen;
+	char			ldn_name[];
+};
+
+struct ll_dir_index {
+	unsigned int		ldi_bits;
+	size_t			ldi_bytes;	/* of the index and its names */
+	struct hlist_head	ldi_hash[];
+};
+
+struct ll_dir_index_work {
+	struct work_struct	ldiw_work;
+	struct inode	       *ldiw_dir;
+	unsigned int		ldiw_gen;
+};
+
+#define LL_DIR_NAME_SIZE(namelen) offsetof(struct ll_dir_name, \
+					   ldn_name[namelen])
+#define LL_DIR_INDEX_SIZE(bits)	offsetof(struct ll_dir_index, \
+					 ldi_hash[1 << (bits)])
+
+/* free @ldi, and take its memory out of ll_dir_index_bytes */
+static void ll_dir_index_free(struct ll_sb_info *sbi, struct ll_dir_index *ldi)
+{
+	struct ll_dir_name *ldn;
+	struct hlist_node *tmp;
+	int i;
+
+	for (i = 0; i < (1 << ldi->ldi_bits); i++) {
+		hlist_for_each_entry_safe(ldn, tmp, &ldi->ldi_hash[i],
+					  ldn_hash) {
+			hlist_del(&ldn->ldn_hash);
+			OBD_FREE(ldn, LL_DIR_NAME_SIZE(ldn->ldn_namelen));
+		}
+	}
+	atomic_long_sub(ldi->ldi_bytes, &sbi->ll_dir_index_bytes);
+	OBD_FREE_LARGE(ldi, LL_DIR_INDEX_SIZE(ldi->ldi_bits));
+}
+
+/* read all pages of @dir and index its names, -EFBIG if more than @max */
+static struct ll_dir_index *ll_dir_index_build(struct inode *dir,
+					       unsigned int max)
+{
+	HLIST_HEAD(names);
+	struct ll_dir_index *ldi = NULL;
+	struct ll_dir_name *ldn;
+	struct hlist_node *tmp;
+	struct md_op_data *op_data;
+	struct page *page;
+	unsigned int count = 0;
+	unsigned int bits;
+	size_t bytes = 0;
+	__u64 pos = 0;
+	int rc = 0;
+
+	ENTRY;
+
+	op_data = ll_prep_md_op_data(NULL, dir, dir, NULL, 0, 0,
+				     LUSTRE_OPC_ANY, dir);
+	if (IS_ERR(op_data))
+		RETURN(ERR_CAST(op_data));
+
+	page = ll_get_dir_page(dir, op_data, pos, NULL);
+	while (1) {
+		struct lu_dirpage *dp;
+		struct lu_dirent *ent;
+		__u64 next;
+
+		if (IS_ERR(page)) {
+			rc = PTR_ERR(page);
+			break;
+		}
+
+		dp = page_address(page);
+		for (ent = lu_dirent_start(dp); ent != NULL && rc == 0;
+		     ent = lu_dirent_next(ent)) {
+			int namelen = le16_to_cpu(ent->lde_namelen);
+
+			/* skip entries before @pos, and dummy records */
+			if (le64_to_cpu(ent->lde_hash) < pos || namelen == 0)
+				continue;
+
+			if (++count > max) {
+				rc = -EFBIG;
+				break;
+			}
+
+			OBD_ALLOC(ldn, LL_DIR_NAME_SIZE(namelen));
+			if (!ldn) {
+				rc = -ENOMEM;
+				break;
+			}
+			fid_le_to_cpu(&ldn->ldn_fid, &ent->lde_fid);
+			ldn->ldn_namelen = namelen;
+			memcpy(ldn->ldn_name, ent->lde_name, namelen);
+			ldn->ldn_hashval = jhash(ldn->ldn_name, namelen, 0);
+			hlist_add_head(&ldn->ldn_hash, &names);
+			bytes += LL_DIR_NAME_SIZE(namelen);
+		}
+
+		next = le64_to_cpu(dp->ldp_hash_end);
+		if (rc || next == MDS_DIR_END_OFF) {
+			ll_release_page(dir, page, false);
+			break;
+		}
+		ll_release_page(dir, page,
+				le32_to_cpu(dp->ldp_flags) & LDF_COLLIDE);
+		pos = next;
+		page = ll_get_dir_page(dir, op_data, pos, NULL);
+	}
+	ll_finish_md_op_data(op_data);
+
+	bits = ilog2(roundup_pow_of_two(max_t(unsigned int, count, 2)));
+	if (rc == 0) {
+		OBD_ALLOC_LARGE(ldi, LL_DIR_INDEX_SIZE(bits));
+		if (!ldi)
+			rc = -ENOMEM;
+	}
+	if (ldi) {
+		ldi->ldi_bits = bits;
+		ldi->ldi_bytes = bytes + LL_DIR_INDEX_SIZE(bits);
+	}
+
+	hlist_for_each_entry_safe(ldn, tmp, &names, ldn_hash) {
+		hlist_del(&ldn->ldn_hash);
+		if (ldi)
+			hlist_add_head(&ldn->ldn_hash,
+				       &ldi->ldi_hash[hash_32(ldn->ldn_hashval,
+							      bits)]);
+		else
+			OBD_FREE(ldn, LL_DIR_NAME_SIZE(ldn->ldn_namelen));
+	}
+
+	CDEBUG(D_INODE, "%s: index "DFID" with %u names: rc = %d\n",
+	       ll_i2sbi(dir)->ll_fsname, PFID(ll_inode2fid(dir)), count, rc);
+
+	RETURN(rc ? ERR_PTR(rc) : ldi);
+}
+
+/*
+ * Build the name index of a directory and install it, unless the pages were
+ * invalidated meanwhile, or it does not fit in dir_index_max_mb with the
+ * indexes of the other directories.
+ */
+static void ll_dir_index_work(struct work_struct *work)
+{
+	struct ll_dir_index_work *ldiw = container_of(work,
+						      struct ll_dir_index_work,
+						      ldiw_work);
+	struct inode *dir = ldiw->ldiw_dir;
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_sb_info *sbi = ll_i2sbi(dir);
+	unsigned long limit = (unsigned long)READ_ONCE(sbi->ll_dir_index_max_mb)
+			      << 20;
+	struct ll_dir_index *ldi;
+	bool full = false;
+
+	ldi = ll_dir_index_build(dir, READ_ONCE(sbi->ll_dir_index_max));
+	if (IS_ERR(ldi)) {
+		full = PTR_ERR(ldi) == -EFBIG;
+		ldi = NULL;
+	} else if (atomic_long_add_return(ldi->ldi_bytes,
+					  &sbi->ll_dir_index_bytes) > limit) {
+		CDEBUG(D_INODE, "%s: no room for index of "DFID", %zu bytes\n",
+		       sbi->ll_fsname, PFID(ll_inode2fid(dir)), ldi->ldi_bytes);
+		ll_dir_index_free(sbi, ldi);
+		full = true;
+		ldi = NULL;
+	}
+
+	spin_lock(&lli->lli_dir_index_lock);
+	lli->lli_dir_index_busy = 0;
+	/* unless pages were invalidated while they were being read */
+	if (ldiw->ldiw_gen == lli->lli_dir_index_gen) {
+		if (ldi)
+			lli->lli_dir_index = ldi;
+		else if (full)
+			lli->lli_dir_index_full = 1;
+		ldi = NULL;
+	}
+	spin_unlock(&lli->lli_dir_index_lock);
+
+	if (ldi)
+		ll_dir_index_free(sbi, ldi);
+	iput(dir);
+	OBD_FREE_PTR(ldiw);
+}
+
+/* have the name index of @dir built, lli_dir_index_busy is set */
+static void ll_dir_index_build_async(struct inode *dir, unsigned int gen)
+{
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_dir_index_work *ldiw;
+
+	OBD_ALLOC_PTR(ldiw);
+	if (ldiw) {
+		ldiw->ldiw_dir = igrab(dir);
+		if (ldiw->ldiw_dir) {
+			ldiw->ldiw_gen = gen;
+			INIT_WORK(&ldiw->ldiw_work, ll_dir_index_work);
+			queue_work(ll_i2sbi(dir)->ll_ra_info.ll_readahead_wq,
+				   &ldiw->ldiw_work);
+			return;
+		}
+		OBD_FREE_PTR(ldiw);
+	}
+
+	spin_lock(&lli->lli_dir_index_lock);
+	lli->lli_dir_index_busy = 0;
+	spin_unlock(&lli->lli_dir_index_lock);
+}
+
+/**
+ * Look up \a name in the name index of \a dir. If there is no index yet, and
+ * the directory pages are cached or enough lookups missed the dcache in this
+ * directory to make reading it worthwhile, have it built in the background.
+ *
+ * The caller must hold the UPDATE lock of \a dir, so that the index is not
+ * invalidated while the result is used.
+ *
+ * \param[in] dir	directory, neither striped nor encrypted
+ * \param[in] name	name to look up
+ * \param[out] fid	FID of \a name if it is found
+ *
+ * \retval 1		\a name is in \a dir
+ * \retval 0		\a name is not in \a dir
+ * \retval -EAGAIN	no index yet, the MDT has to be asked
+ */
+int ll_dir_index_lookup(struct inode *dir, const struct qstr *name,
+			struct lu_fid *fid)
+{
+	struct ll_inode_info *lli = ll_i2info(dir);
+	unsigned int max = ll_i2sbi(dir)->ll_dir_index_max;
+	struct ll_dir_index *ldi;
+	struct ll_dir_name *ldn;
+	unsigned int gen;
+	__u32 hashval;
+	int rc = 0;
+
+	if (max == 0)
+		return -EAGAIN;
+
+	spin_lock(&lli->lli_dir_index_lock);
+	if (!lli->lli_dir_index) {
+		/* the directory is read once, lookups ask the MDT meanwhile */
+		if (lli->lli_dir_index_full || lli->lli_dir_index_busy ||
+		    (dir->i_mapping->nrpages == 0 &&
+		     ++lli->lli_dir_index_misses < LL_DIR_INDEX_MISSES)) {
+			spin_unlock(&lli->lli_dir_index_lock);
+			return -EAGAIN;
+		}
+		lli->lli_dir_index_busy = 1;
+		gen = lli->lli_dir_index_gen;
+		spin_unlock(&lli->lli_dir_index_lock);
+
+		ll_dir_index_build_async(dir, gen);
+		return -EAGAIN;
+	}
+
+	ldi = lli->lli_dir_index;
+	hashval = jhash(name->name, name->len, 0);
+	hlist_for_each_entry(ldn, &ldi->ldi_hash[hash_32(hashval,
+							 ldi->ldi_bits)],
+			     ldn_hash) {
+		if (ldn->ldn_hashval == hashval &&
+		    ldn->ldn_namelen == name->len &&
+		    memcmp(ldn->ldn_name, name->name, name->len) == 0) {
+			*fid = ldn->ldn_fid;
+			rc = 1;
+			break;
+		}
+	}
+	spin_unlock(&lli->lli_dir_index_lock);
+
+	return rc;
+}
+
+/* drop the name index of @dir, its pages are no longer protected by a lock */
+void ll_dir_index_invalidate(struct inode *dir)
+{
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_dir_index *ldi;
+
+	spin_lock(&lli->lli_dir_index_lock);
+	ldi = lli->lli_dir_index;
+	lli->lli_dir_index = NULL;
+	lli->lli_dir_index_gen++;
+	lli->lli_dir_index_misses = 0;
+	lli->lli_dir_index_full = 0;
+	spin_unlock(&lli->lli_dir_index_lock);
+
+	if (ldi)
+		ll_dir_index_free(ll_i2sbi(dir), ldi);
+}
+
 #ifdef HAVE_DIR_CONTEXT
 static int ll_iterate(struct file *filp, struct dir_context *ctx)
 #else
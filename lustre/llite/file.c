@@ -81,6 +81,8 @@ static struct ll_file_data *ll_file_data_get(void)
 		return NULL;
 
 	fd->fd_write_failed = false;
+	/* no I/O yet, so the first one is not taken for streaming */
+	fd->fd_last_io_end = -1;
 	pcc_file_init(&fd->fd_pcc_file);
 
 	return fd;
@@ -675,6 +677,8 @@ retry:
 	}
 	op_data->op_data = lmm;
 	op_data->op_data_size = lmmsize;
+	if (!(itp->it_op & IT_CREAT) && ll_sbi_has_xattr_prefetch(sbi))
+		op_data->op_cli_flags |= CLI_XATTR_PREFETCH;
 
 	CFS_FAIL_TIMEOUT(OBD_FAIL_LLITE_OPEN_DELAY, cfs_fail_val);
 
@@ -713,6 +717,7 @@ retry:
 		 * of kernel will deal with that later.
 		 */
 		ll_set_lock_data(sbi->ll_md_exp, de->d_inode, itp, &bits);
+		ll_xattr_cache_prefill(de->d_inode, &req->rq_pill, bits);
 		if (bits & MDS_INODELOCK_LOOKUP)
 			d_lustre_revalidate(de);
 
@@ -785,7 +790,7 @@ static int ll_local_open(struct file *file, struct lookup_intent *it,
 	}
 
 	file->private_data = fd;
-	ll_readahead_init(inode, &fd->fd_ras);
+	ll_readahead_init(inode, fd);
 	fd->fd_omode = it->it_flags & (FMODE_READ | FMODE_WRITE | FMODE_EXEC);
 
 	RETURN(0);
@@ -1704,6 +1709,68 @@ static void ll_heat_add(struct inode *inode, enum cl_io_type iot,
 	spin_unlock(&lli->lli_heat_lock);
 }
 
+/**
+ * Check whether a buffered read or write should be done as direct I/O.
+ *
+ * Large streaming I/O gains little from the page cache: its data is seldom
+ * read again, while copying it through cached pages costs CPU time and
+ * evicts pages which may be used again. Such I/O is switched to direct I/O
+ * if it is page aligned, at least hybrid_io_{read,write}_threshold_bytes,
+ * and either continues a previous I/O on this file descriptor or finds
+ * the client cache short of free pages, the same test as
+ * osc_cache_too_much(). The first I/O on a file descriptor is only
+ * switched for the latter.
+ *
+ * The kernel decides between the buffered and the direct path on
+ * IOCB_DIRECT, so the switch is only supported where that flag exists.
+ *
+ * \retval true		\a iocb is marked for direct I/O
+ * \retval false	\a iocb is left alone
+ */
+static bool ll_hybrid_io_switch(struct file *file, struct vvp_io_args *args,
+				enum cl_io_type iot, loff_t pos, size_t count)
+{
+#ifdef IOCB_DIRECT
+	struct ll_file_data *fd = file->private_data;
+	struct inode *inode = file_inode(file);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct cl_client_cache *cache = sbi->ll_cache;
+	struct kiocb *iocb = args->u.normal.via_iocb;
+	unsigned long threshold;
+
+	threshold = iot == CIT_READ ? sbi->ll_hybrid_io_read_threshold :
+				      sbi->ll_hybrid_io_write_threshold;
+	if (threshold == 0 || count < threshold)
+		return false;
+
+	if ((pos | count) & ~PAGE_MASK)
+		return false;
+
+	/* AIO and splice have their own rules for direct I/O, appends need
+	 * the file size under lock, and mmapped pages must stay coherent
+	 */
+	if (file->f_flags & (O_DIRECT | O_APPEND) || ll_file_nolock(file) ||
+	    !is_sync_kiocb(iocb) ||
+	    iov_iter_is_pipe(args->u.normal.via_iter) ||
+	    mapping_mapped(inode->i_mapping))
+		return false;
+
+	if (pos != fd->fd_last_io_end &&
+	    atomic_long_read(&cache->ccc_lru_left) >= cache->ccc_lru_max >> 2)
+		return false;
+
+	CDEBUG(D_VFSTRACE, "%s: %s %zu bytes at %lld as direct I/O\n",
+	       file_dentry(file)->d_name.name,
+	       iot == CIT_READ ? "read" : "write", count, pos);
+	iocb->ki_flags |= IOCB_DIRECT;
+	ll_stats_ops_tally(sbi, iot == CIT_READ ? LPROC_LL_HYBRID_READ :
+						  LPROC_LL_HYBRID_WRITE, 1);
+	return true;
+#else
+	return false;
+#endif
+}
+
 static ssize_t
 ll_file_io_generic(const struct lu_env *env, struct vvp_io_args *args,
 		   struct file *file, enum cl_io_type iot,
@@ -1724,6 +1791,8 @@ ll_file_io_generic(const struct lu_env *env, struct vvp_io_args *args,
 	unsigned int retried = 0, dio_lock = 0;
 	bool is_aio = false;
 	bool is_parallel_dio = false;
+	bool is_dio = file->f_flags & O_DIRECT;
+	bool hybrid = false;
 	struct cl_dio_aio *ci_dio_aio = NULL;
 	size_t per_bytes, max_io_bytes;
 	bool partial_io;
@@ -1738,7 +1807,10 @@ ll_file_io_generic(const struct lu_env *env, struct vvp_io_args *args,
 			     sbi->ll_cache->ccc_lru_max >> 2) << PAGE_SHIFT;
 
 	io = vvp_env_thread_io(env);
-	if (file->f_flags & O_DIRECT) {
+	if (!is_dio && ll_hybrid_io_switch(file, args, iot, *ppos, bytes))
+		is_dio = hybrid = true;
+
+	if (is_dio) {
 		if (file->f_flags & O_APPEND)
 			dio_lock = 1;
 		if (!is_sync_kiocb(args->u.normal.via_iocb))
@@ -1766,7 +1838,7 @@ restart:
 	 * if we have small max_cached_mb but large block IO issued, io
 	 * could not be finished and blocked whole client.
 	 */
-	if (file->f_flags & O_DIRECT || bytes < max_io_bytes) {
+	if (is_dio || bytes < max_io_bytes) {
 		per_bytes = bytes;
 		partial_io = false;
 	} else {
@@ -1779,6 +1851,9 @@ restart:
 	io->ci_dio_lock = dio_lock;
 	io->ci_ndelay_tried = retried;
 	io->ci_parallel_dio = is_parallel_dio;
+	io->ci_hybrid_switched = hybrid;
+	if (hybrid && iot == CIT_WRITE)
+		io->u.ci_wr.wr_sync = 1;
 
 	if (cl_io_rw_init(env, io, iot, *ppos, per_bytes) == 0) {
 		if (file->f_flags & O_APPEND)
@@ -1794,7 +1869,7 @@ restart:
 		 * See LU-6227 for details.
 		 */
 		if (((iot == CIT_WRITE) ||
-		    (iot == CIT_READ && (file->f_flags & O_DIRECT))) &&
+		    (iot == CIT_READ && is_dio)) &&
 		    !(vio->vui_fd->fd_flags & LL_FILE_GROUP_LOCKED)) {
 			CDEBUG(D_VFSTRACE, "Range lock "RL_FMT"\n",
 			       RL_PARA(&range));
@@ -1944,6 +2019,13 @@ out:
 		}
 	}
 
+#ifdef IOCB_DIRECT
+	if (hybrid)
+		args->u.normal.via_iocb->ki_flags &= ~IOCB_DIRECT;
+#endif
+	if (result > 0)
+		fd->fd_last_io_end = *ppos;
+
 	CDEBUG(D_VFSTRACE, "iot: %d, result: %zd\n", iot, result);
 	if (result > 0)
 		ll_heat_add(inode, iot, result);
@@ -5410,6 +5492,8 @@ static int ll_inode_revalidate(struct dentry *dentry, enum ldlm_intent_flags op)
 	/* Call getattr by fid */
 	if (exp_connect_flags2(exp) & OBD_CONNECT2_GETATTR_PFID)
 		op_data->op_flags = MF_GETATTR_BY_FID;
+	if (op == IT_GETATTR && ll_sbi_has_xattr_prefetch(ll_i2sbi(inode)))
+		op_data->op_cli_flags |= CLI_XATTR_PREFETCH;
 	rc = md_intent_lock(exp, op_data, &oit, &req, &ll_md_blocking_ast, 0);
 	ll_finish_md_op_data(op_data);
 	if (rc < 0) {
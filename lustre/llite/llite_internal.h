@@ -125,6 +125,8 @@ enum ll_sa_pattern {
 	LSA_PATTERN_MAX,
 };
 
+struct ll_dir_index;
+
 struct ll_inode_info {
 	__u32				lli_inode_magic;
 	rwlock_t			lli_lock;
@@ -205,12 +207,25 @@ struct ll_inode_info {
 			unsigned int			lli_sa_generation;
 			/* access pattern for statahead */
 			enum ll_sa_pattern		lli_sa_pattern;
+			/* last name with a numeric suffix looked up in this
+			 * dir, see ll_statahead_detect() */
+			__u32				lli_sa_fname_hash;
+			unsigned int			lli_sa_fname_hits;
+			__u64				lli_sa_fname_index;
 			/* rw lock protects lli_lsm_md */
 			struct rw_semaphore		lli_lsm_sem;
 			/* directory stripe information */
 			struct lmv_stripe_object	*lli_lsm_obj;
 			/* directory default LMV */
 			struct lmv_stripe_object	*lli_def_lsm_obj;
+			/* name index of the cached dir pages, valid while the
+			 * UPDATE lock is cached, see ll_dir_index_lookup() */
+			spinlock_t			lli_dir_index_lock;
+			struct ll_dir_index	       *lli_dir_index;
+			unsigned int			lli_dir_index_gen;
+			unsigned int			lli_dir_index_misses;
+			unsigned int			lli_dir_index_full:1,
+							lli_dir_index_busy:1;
 		};
 
 		/* for non-directory */
@@ -301,6 +316,11 @@ struct ll_inode_info {
 	struct rw_semaphore		lli_xattrs_list_rwsem;
 	struct mutex			lli_xattrs_enq_lock;
 	struct list_head		lli_xattrs; /* ll_xattr_entry->xe_list */
+	/* xattrs filled from an MDT reply, protected by
+	 * lli_xattrs_list_rwsem
+	 */
+	void				*lli_xattrs_arena;
+	size_t				lli_xattrs_arena_size;
 	struct list_head		lli_lccs; /* list of ll_cl_context */
 	seqlock_t			lli_page_inv_lock;
 
@@ -481,6 +501,9 @@ int ll_xattr_cache_insert(struct inode *inode,
 			  char *buffer,
 			  size_t size);
 
+void ll_xattr_cache_prefill(struct inode *inode, struct req_capsule *pill,
+			    __u64 bits);
+
 static inline bool obd_connect_has_secctx(struct obd_connect_data *data)
 {
 #ifdef CONFIG_SECURITY
@@ -668,6 +691,7 @@ enum ra_stat {
 	RA_STAT_FAILED_FAST_READ,
 	RA_STAT_MMAP_RANGE_READ,
 	RA_STAT_READAHEAD_PAGES,
+	RA_STAT_NEW_STREAM,
 	_NR_RA_STAT,
 };
 
@@ -816,6 +840,7 @@ struct ll_sb_info {
 	DECLARE_BITMAP(ll_flags, LL_SBI_NUM_FLAGS); /* enum ll_sbi_flags */
 	unsigned int		 ll_xattr_cache_enabled:1,
 				 ll_xattr_cache_set:1, /* already set to 0/1 */
+				 ll_xattr_prefetch:1, /* xattrs on open/stat */
 				 ll_client_common_fill_super_succeeded:1,
 				 ll_checksum_set:1,
 				 ll_inode_cache_enabled:1;
@@ -857,6 +882,10 @@ struct ll_sb_info {
 	unsigned int		  ll_sa_batch_max;/* max SUB request count in
 						   * a batch PTLRPC request */
 	unsigned int		  ll_sa_max;     /* max statahead RPCs */
+	unsigned int		  ll_sa_shard_max;/* max statahead workers
+						   * of striped dirs */
+	/* lookups of sequential names to start statahead by name */
+	unsigned int		  ll_sa_fname_hits;
 	atomic_t		  ll_sa_total;   /* statahead thread started
 						  * count */
 	atomic_t		  ll_sa_wrong;   /* statahead thread stopped for
@@ -866,6 +895,29 @@ struct ll_sb_info {
 	atomic_t		  ll_agl_total;  /* AGL thread started count */
 	atomic_t		  ll_sa_hit_total;  /* total hit count */
 	atomic_t		  ll_sa_miss_total; /* total miss count */
+	atomic_t		  ll_sa_stripe_total; /* stripes prefetched
+						       * by stripe workers */
+	atomic_t		  ll_sa_shard_running; /* running stripe
+							* workers */
+
+	/* max names in the lookup index of a dir, 0 disables */
+	unsigned int		  ll_dir_index_max;
+	/* max memory of the lookup indexes of all dirs, and memory used */
+	unsigned int		  ll_dir_index_max_mb;
+	atomic_long_t		  ll_dir_index_bytes;
+
+	/* batched unlink, see ll_unlink_batch() */
+	unsigned int		  ll_unlink_batch_max; /* max unlinks in a
+							* batch, 0 disables */
+	struct mutex		  ll_unlink_mutex;
+	struct lu_batch		 *ll_unlink_bh;	/* unlinks to be sent */
+	bool			  ll_unlink_sending; /* a batch in flight */
+	wait_queue_head_t	  ll_unlink_waitq;
+
+	/* buffered I/O at least this large may be done as direct I/O, see
+	 * ll_hybrid_io_switch(), 0 disables */
+	unsigned long		  ll_hybrid_io_read_threshold;
+	unsigned long		  ll_hybrid_io_write_threshold;
 
 	dev_t			  ll_sdev_orig; /* save s_dev before assign for
 						 * clustred nfs */
@@ -931,7 +983,11 @@ struct ll_sb_info {
 /*
  * per file-descriptor read-ahead data.
  */
+/* number of concurrent read streams tracked per file descriptor */
+#define LL_RA_STREAMS	4
+
 struct ll_readahead_state {
+	/* must stay first, the rest is copied by ras_fork() */
 	spinlock_t	ras_lock;
 	/* End byte that read(2) try to read.  */
 	loff_t		ras_last_read_end_bytes;
@@ -1017,11 +1073,15 @@ struct ll_readahead_state {
 	bool		ras_need_increase_window;
 	/* whether ra miss check should be skipped */
 	bool		ras_no_miss_check;
+	/* fd_ras_clock at the last read(2) of this stream */
+	unsigned long	ras_last_use;
 };
 
 struct ll_readahead_work {
 	/** File to readahead */
 	struct file			*lrw_file;
+	/** Read stream of lrw_file which triggered the readahead */
+	struct ll_readahead_state	*lrw_ras;
 	pgoff_t				 lrw_start_idx;
 	pgoff_t				 lrw_end_idx;
 	pid_t				 lrw_user_pid;
@@ -1034,9 +1094,16 @@ struct ll_readahead_work {
 extern struct kmem_cache *ll_file_data_slab;
 struct lustre_handle;
 struct ll_file_data {
-	struct ll_readahead_state fd_ras;
+	/* readahead state of each read stream, see ll_ras_select() */
+	struct ll_readahead_state fd_ras[LL_RA_STREAMS];
+	spinlock_t fd_ras_lock; /* protects fd_ras_mru and fd_ras_clock */
+	unsigned int fd_ras_mru; /* stream of the last read(2) */
+	unsigned long fd_ras_clock;
 	struct ll_grouplock fd_grouplock;
 	__u64 lfd_pos;
+	/* end of the last read or write, to detect streaming I/O, -1 before
+	 * the first one */
+	loff_t fd_last_io_end;
 	__u32 fd_flags;
 	fmode_t fd_omode;
 	/* openhandle if lease exists for this file.
@@ -1123,6 +1190,17 @@ static inline bool ll_sbi_has_parallel_dio(struct ll_sb_info *sbi)
 	return test_bit(LL_SBI_PARALLEL_DIO, sbi->ll_flags);
 }
 
+/*
+ * Ask for all xattrs with open and getattr intents only if enabled with
+ * xattr_prefetch, and the MDT packs them into intent replies, otherwise the
+ * reply buffers reserved for them are wasted.
+ */
+static inline bool ll_sbi_has_xattr_prefetch(struct ll_sb_info *sbi)
+{
+	return sbi->ll_xattr_cache_enabled && sbi->ll_xattr_prefetch &&
+	       exp_connect_xattr_prefetch(sbi->ll_md_exp);
+}
+
 void ll_ras_enter(struct file *f, loff_t pos, size_t bytes);
 
 /* llite/lcommon_misc.c */
@@ -1172,6 +1250,8 @@ enum {
 	LPROC_LL_REMOVEXATTR,
 	LPROC_LL_INODE_PERM,
 	LPROC_LL_FALLOCATE,
+	LPROC_LL_HYBRID_READ,
+	LPROC_LL_HYBRID_WRITE,
 	LPROC_LL_INODE_OCOUNT,
 	LPROC_LL_INODE_OPCLTM,
 	LPROC_LL_FILE_OPCODES
@@ -1196,6 +1276,9 @@ int ll_get_mdt_idx_by_fid(struct ll_sb_info *sbi, const struct lu_fid *fid);
 struct page *ll_get_dir_page(struct inode *dir, struct md_op_data *op_data,
 			      __u64 offset, int *partial_readdir_rc);
 void ll_release_page(struct inode *inode, struct page *page, bool remove);
+int ll_dir_index_lookup(struct inode *dir, const struct qstr *name,
+			struct lu_fid *fid);
+void ll_dir_index_invalidate(struct inode *dir);
 int quotactl_ioctl(struct super_block *sb, struct if_quotactl *qctl);
 
 /* llite/namei.c */
@@ -1219,7 +1302,7 @@ int ll_read_folio(struct file *file, struct folio *folio);
 #endif
 int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 			   struct cl_page *page, struct file *file);
-void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras);
+void ll_readahead_init(struct inode *inode, struct ll_file_data *fd);
 int vvp_io_write_commit(const struct lu_env *env, struct cl_io *io);
 
 enum lcc_type;
@@ -1631,6 +1714,34 @@ void ll_ra_stats_inc(struct inode *inode, enum ra_stat which);
 #define LL_SA_BATCH_MAX		1024
 #define LL_SA_BATCH_DEF		64
 
+/* statahead workers for the stripes of all striped directories of a mount,
+ * 0 disables them
+ */
+#define LL_SA_SHARD_MAX		128
+#define LL_SA_SHARD_DEF		0
+
+/* lookups of names with an incrementing numeric suffix to start statahead
+ * by file name, 0 disables */
+#define LL_SA_FNAME_HITS_MAX	1024
+#define LL_SA_FNAME_HITS_DEF	4
+
+/* names in the lookup index of a directory built from its cached pages */
+#define LL_DIR_INDEX_MAX	(1 << 20)
+#define LL_DIR_INDEX_DEF	16384
+/* memory of the lookup indexes of all dirs of a mount, in MiB */
+#define LL_DIR_INDEX_MB_DEF	64
+/* uncached lookups in a directory whose pages are not cached to read them */
+#define LL_DIR_INDEX_MISSES	8
+
+/* batched unlink is disabled by default */
+#define LL_UNLINK_BATCH_MAX	1024
+#define LL_UNLINK_BATCH_DEF	0
+
+/* switching buffered I/O to direct I/O is disabled by default, 8MiB reads
+ * and 2MiB writes are reasonable thresholds to enable it with */
+#define LL_HYBRID_IO_READ_THRESHOLD_DEF		0
+#define LL_HYBRID_IO_WRITE_THRESHOLD_DEF	0
+
 #define LL_SA_CACHE_BIT         6
 #define LL_SA_CACHE_SIZE        (1 << LL_SA_CACHE_BIT)
 #define LL_SA_CACHE_MASK        (LL_SA_CACHE_SIZE - 1)
@@ -1661,8 +1772,10 @@ struct ll_statahead_info {
 						 * is not a hidden one */
 	unsigned int            sai_skip_hidden;/* skipped hidden dentry count
 						 */
-	unsigned int            sai_ls_all:1;   /* "ls -al", do stat-ahead for
+	unsigned int            sai_ls_all:1,   /* "ls -al", do stat-ahead for
 						 * hidden entries */
+				sai_fname_auto:1; /* started by lookup name
+						   * pattern */
 	wait_queue_head_t	sai_waitq;	/* stat-ahead wait queue */
 	struct task_struct	*sai_task;	/* stat-ahead thread */
 	struct task_struct	*sai_agl_task;	/* AGL thread */
@@ -1675,7 +1788,34 @@ struct ll_statahead_info {
 
 	__u64			sai_fstart;
 	__u64			sai_fend;
+	int			sai_fwidth;	/* suffix width */
+	/* hit + miss count at sai_fused_time, see sa_fname_idle() */
+	__u64			sai_fused;
+	time64_t		sai_fused_time;
 	char			sai_fname[NAME_MAX];
+
+	/* workers scanning the stripes of a striped dir in parallel */
+	struct ll_sa_shard	*sai_shards;
+	int			sai_shard_count;
+	struct inode		**sai_stripes;	/* stripe inodes */
+	int			sai_stripe_count;
+	/* entry being looked up when statahead by list started */
+	char			sai_first_name[NAME_MAX + 1];
+	int			sai_first_len;
+};
+
+/*
+ * Statahead worker for a striped directory. Worker i scans stripes i,
+ * i + sai_shard_count, ... and sends the getattr of their entries in its own
+ * batch, so that each MDT is fed by a different thread.
+ */
+struct ll_sa_shard {
+	struct ll_statahead_info *ss_sai;
+	struct task_struct	*ss_task;
+	struct lu_batch		*ss_bh;
+	atomic_t		 ss_cache_count; /* entries in cache */
+	int			 ss_index;	 /* first stripe */
+	unsigned int		 ss_sent;	 /* entries prefetched */
 };
 
 /* Per inode statahead information */
@@ -1690,6 +1830,7 @@ struct ll_statahead_context {
 int ll_revalidate_statahead(struct inode *dir, struct dentry **dentry,
 			    bool unplug);
 int ll_start_statahead(struct inode *dir, struct dentry *dentry, bool agl);
+void ll_statahead_detect(struct dentry *dentry);
 void ll_authorize_statahead(struct inode *dir, void *key);
 void ll_deauthorize_statahead(struct inode *dir, void *key);
 
@@ -1876,9 +2017,6 @@ int ll_layout_restore(struct inode *inode, loff_t start, __u64 length);
 int ll_layout_write_intent(struct inode *inode, enum layout_intent_opc opc,
 			   struct lu_extent *ext);
 
-int ll_xattr_init(void);
-void ll_xattr_fini(void);
-
 int ll_page_sync_io(const struct lu_env *env, struct cl_io *io,
 		    struct cl_page *page, enum cl_req_type crt);
 
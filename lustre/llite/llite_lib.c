@@ -72,6 +72,7 @@
 #include <lustre_log.h>
 #include <cl_object.h>
 #include <obd_cksum.h>
+#include <lustre_compr.h>
 #include "llite_internal.h"
 
 struct kmem_cache *ll_file_data_slab;
@@ -184,12 +185,29 @@ static struct ll_sb_info *ll_init_sbi(struct lustre_sb_info *lsi)
 	sbi->ll_sa_running_max = LL_SA_RUNNING_DEF;
 	sbi->ll_sa_batch_max = LL_SA_BATCH_DEF;
 	sbi->ll_sa_max = LL_SA_RPC_DEF;
+	sbi->ll_sa_shard_max = LL_SA_SHARD_DEF;
+	sbi->ll_sa_fname_hits = LL_SA_FNAME_HITS_DEF;
 	atomic_set(&sbi->ll_sa_total, 0);
 	atomic_set(&sbi->ll_sa_wrong, 0);
 	atomic_set(&sbi->ll_sa_running, 0);
 	atomic_set(&sbi->ll_agl_total, 0);
 	atomic_set(&sbi->ll_sa_hit_total, 0);
 	atomic_set(&sbi->ll_sa_miss_total, 0);
+	atomic_set(&sbi->ll_sa_stripe_total, 0);
+	atomic_set(&sbi->ll_sa_shard_running, 0);
+
+	/* unlinks are not batched by default */
+	sbi->ll_unlink_batch_max = LL_UNLINK_BATCH_DEF;
+	sbi->ll_dir_index_max = LL_DIR_INDEX_DEF;
+	sbi->ll_dir_index_max_mb = LL_DIR_INDEX_MB_DEF;
+	atomic_long_set(&sbi->ll_dir_index_bytes, 0);
+	/* xattrs are not prefetched with intents by default */
+	sbi->ll_xattr_prefetch = 0;
+	mutex_init(&sbi->ll_unlink_mutex);
+	init_waitqueue_head(&sbi->ll_unlink_waitq);
+
+	sbi->ll_hybrid_io_read_threshold = LL_HYBRID_IO_READ_THRESHOLD_DEF;
+	sbi->ll_hybrid_io_write_threshold = LL_HYBRID_IO_WRITE_THRESHOLD_DEF;
 	set_bit(LL_SBI_AGL_ENABLED, sbi->ll_flags);
 	set_bit(LL_SBI_FAST_READ, sbi->ll_flags);
 	set_bit(LL_SBI_TINY_WRITE, sbi->ll_flags);
@@ -355,6 +373,8 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt)
 				   OBD_CONNECT2_REP_MBITS |
 				   OBD_CONNECT2_ATOMIC_OPEN_LOCK |
 				   OBD_CONNECT2_BATCH_RPC |
+				   OBD_CONNECT2_BATCH_REINT |
+				   OBD_CONNECT2_XATTR_PREFETCH |
 				   OBD_CONNECT2_DMV_IMP_INHERIT;
 
 #ifdef HAVE_LRU_RESIZE_SUPPORT
@@ -580,7 +600,9 @@ retry_connect:
 				  OBD_CONNECT_FLAGS2 | OBD_CONNECT_GRANT_SHRINK;
 	data->ocd_connect_flags2 = OBD_CONNECT2_LOCKAHEAD |
 				   OBD_CONNECT2_INC_XID | OBD_CONNECT2_LSEEK |
-				   OBD_CONNECT2_REP_MBITS;
+				   OBD_CONNECT2_REP_MBITS | OBD_CONNECT2_COMPRESS;
+	/* compression types the client can send, the OST masks its own */
+	data->ocd_compr_type = lustre_compr_types_supported();
 
 	if (!CFS_FAIL_CHECK(OBD_FAIL_OSC_CONNECT_GRANT_PARAM))
 		data->ocd_connect_flags |= OBD_CONNECT_GRANT_PARAM;
@@ -961,6 +983,9 @@ void ll_kill_super(struct super_block *sb)
 		while (atomic_read(&sbi->ll_sa_running) > 0)
 			schedule_timeout_uninterruptible(
 				cfs_time_seconds(1) >> 3);
+
+		/* dir index builds hold references on their directories */
+		flush_workqueue(sbi->ll_ra_info.ll_readahead_wq);
 	}
 
 	EXIT;
@@ -1238,6 +1263,7 @@ void ll_lli_init(struct ll_inode_info *lli)
 
 	init_rwsem(&lli->lli_xattrs_list_rwsem);
 	mutex_init(&lli->lli_xattrs_enq_lock);
+	lli->lli_xattrs_arena = NULL;
 
 	LASSERT(lli->lli_vfs_inode.i_mode != 0);
 	if (S_ISDIR(lli->lli_vfs_inode.i_mode)) {
@@ -1247,6 +1273,8 @@ void ll_lli_init(struct ll_inode_info *lli)
 		lli->lli_opendir_pid = 0;
 		lli->lli_sa_enabled = 0;
 		init_rwsem(&lli->lli_lsm_sem);
+		spin_lock_init(&lli->lli_dir_index_lock);
+		lli->lli_dir_index = NULL;
 	} else {
 		mutex_init(&lli->lli_size_mutex);
 		mutex_init(&lli->lli_setattr_mutex);
@@ -1895,6 +1923,7 @@ void ll_clear_inode(struct inode *inode)
 		LASSERT(lli->lli_opendir_key == NULL);
 		LASSERT(lli->lli_sai == NULL);
 		LASSERT(lli->lli_opendir_pid == 0);
+		ll_dir_index_invalidate(inode);
 	} else {
 		pcc_inode_free(inode);
 	}
@@ -810,6 +810,248 @@ static ssize_t statahead_batch_max_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(statahead_batch_max);
 
+static ssize_t statahead_shard_max_show(struct kobject *kobj,
+					struct attribute *attr,
+					char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return snprintf(buf, 16, "%u\n", sbi->ll_sa_shard_max);
+}
+
+static ssize_t statahead_shard_max_store(struct kobject *kobj,
+					 struct attribute *attr,
+					 const char *buffer,
+					 size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned long val;
+	int rc;
+
+	rc = kstrtoul(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > LL_SA_SHARD_MAX) {
+		CWARN("%s: statahead_shard_max value %lu limited to maximum %d\n",
+		      sbi->ll_fsname, val, LL_SA_SHARD_MAX);
+		val = LL_SA_SHARD_MAX;
+	}
+
+	sbi->ll_sa_shard_max = val;
+	return count;
+}
+LUSTRE_RW_ATTR(statahead_shard_max);
+
+static ssize_t statahead_fname_hits_show(struct kobject *kobj,
+					 struct attribute *attr,
+					 char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return snprintf(buf, 16, "%u\n", sbi->ll_sa_fname_hits);
+}
+
+static ssize_t statahead_fname_hits_store(struct kobject *kobj,
+					  struct attribute *attr,
+					  const char *buffer,
+					  size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned long val;
+	int rc;
+
+	rc = kstrtoul(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > LL_SA_FNAME_HITS_MAX) {
+		CWARN("%s: statahead_fname_hits value %lu limited to maximum %d\n",
+		      sbi->ll_fsname, val, LL_SA_FNAME_HITS_MAX);
+		val = LL_SA_FNAME_HITS_MAX;
+	}
+
+	sbi->ll_sa_fname_hits = val;
+	return count;
+}
+LUSTRE_RW_ATTR(statahead_fname_hits);
+
+static ssize_t dir_index_max_show(struct kobject *kobj,
+				  struct attribute *attr,
+				  char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return snprintf(buf, 16, "%u\n", sbi->ll_dir_index_max);
+}
+
+static ssize_t dir_index_max_store(struct kobject *kobj,
+				   struct attribute *attr,
+				   const char *buffer,
+				   size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned long val;
+	int rc;
+
+	rc = kstrtoul(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > LL_DIR_INDEX_MAX) {
+		CWARN("%s: dir_index_max value %lu limited to maximum %d\n",
+		      sbi->ll_fsname, val, LL_DIR_INDEX_MAX);
+		val = LL_DIR_INDEX_MAX;
+	}
+
+	sbi->ll_dir_index_max = val;
+	return count;
+}
+LUSTRE_RW_ATTR(dir_index_max);
+
+static ssize_t dir_index_max_mb_show(struct kobject *kobj,
+				     struct attribute *attr,
+				     char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", sbi->ll_dir_index_max_mb);
+}
+
+/*
+ * The indexes already built are not dropped when the limit is lowered, they
+ * go away with the UPDATE locks of their directories.
+ */
+static ssize_t dir_index_max_mb_store(struct kobject *kobj,
+				      struct attribute *attr,
+				      const char *buffer,
+				      size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned long max = PAGES_TO_MiB(cfs_totalram_pages() / 2);
+	unsigned long val;
+	int rc;
+
+	rc = kstrtoul(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > max) {
+		CWARN("%s: dir_index_max_mb value %lu limited to maximum %lu\n",
+		      sbi->ll_fsname, val, max);
+		val = max;
+	}
+
+	sbi->ll_dir_index_max_mb = val;
+	return count;
+}
+LUSTRE_RW_ATTR(dir_index_max_mb);
+
+static ssize_t unlink_batch_max_show(struct kobject *kobj,
+				     struct attribute *attr,
+				     char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return snprintf(buf, 16, "%u\n", sbi->ll_unlink_batch_max);
+}
+
+static ssize_t unlink_batch_max_store(struct kobject *kobj,
+				      struct attribute *attr,
+				      const char *buffer,
+				      size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned long val;
+	int rc;
+
+	rc = kstrtoul(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > LL_UNLINK_BATCH_MAX) {
+		CWARN("%s: unlink_batch_max value %lu limited to maximum %d\n",
+		      sbi->ll_fsname, val, LL_UNLINK_BATCH_MAX);
+		val = LL_UNLINK_BATCH_MAX;
+	}
+
+	sbi->ll_unlink_batch_max = val;
+	return count;
+}
+LUSTRE_RW_ATTR(unlink_batch_max);
+
+static ssize_t hybrid_io_read_threshold_bytes_show(struct kobject *kobj,
+						   struct attribute *attr,
+						   char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return snprintf(buf, PAGE_SIZE, "%lu\n",
+			sbi->ll_hybrid_io_read_threshold);
+}
+
+/* accepts a size with a unit, like "8M", 0 disables switching reads */
+static ssize_t hybrid_io_read_threshold_bytes_store(struct kobject *kobj,
+						    struct attribute *attr,
+						    const char *buffer,
+						    size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	u64 val;
+	int rc;
+
+	rc = sysfs_memparse(buffer, count, &val, "B");
+	if (rc)
+		return rc;
+
+	sbi->ll_hybrid_io_read_threshold = val;
+	return count;
+}
+LUSTRE_RW_ATTR(hybrid_io_read_threshold_bytes);
+
+static ssize_t hybrid_io_write_threshold_bytes_show(struct kobject *kobj,
+						    struct attribute *attr,
+						    char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return snprintf(buf, PAGE_SIZE, "%lu\n",
+			sbi->ll_hybrid_io_write_threshold);
+}
+
+/* accepts a size with a unit, like "8M", 0 disables switching writes */
+static ssize_t hybrid_io_write_threshold_bytes_store(struct kobject *kobj,
+						     struct attribute *attr,
+						     const char *buffer,
+						     size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	u64 val;
+	int rc;
+
+	rc = sysfs_memparse(buffer, count, &val, "B");
+	if (rc)
+		return rc;
+
+	sbi->ll_hybrid_io_write_threshold = val;
+	return count;
+}
+LUSTRE_RW_ATTR(hybrid_io_write_threshold_bytes);
+
 static ssize_t statahead_max_show(struct kobject *kobj,
 				  struct attribute *attr,
 				  char *buf)
@@ -888,12 +1130,14 @@ static int ll_statahead_stats_seq_show(struct seq_file *m, void *v)
 		      "statahead wrong: %u\n"
 		      "agl total: %u\n"
 		      "hit_total: %u\n"
-		      "miss_total: %u\n",
+		      "miss_total: %u\n"
+		      "stripe_total: %u\n",
 		   atomic_read(&sbi->ll_sa_total),
 		   atomic_read(&sbi->ll_sa_wrong),
 		   atomic_read(&sbi->ll_agl_total),
 		   atomic_read(&sbi->ll_sa_hit_total),
-		   atomic_read(&sbi->ll_sa_miss_total));
+		   atomic_read(&sbi->ll_sa_miss_total),
+		   atomic_read(&sbi->ll_sa_stripe_total));
 	return 0;
 }
 
@@ -910,6 +1154,7 @@ static ssize_t ll_statahead_stats_seq_write(struct file *file,
 	atomic_set(&sbi->ll_agl_total, 0);
 	atomic_set(&sbi->ll_sa_hit_total, 0);
 	atomic_set(&sbi->ll_sa_miss_total, 0);
+	atomic_set(&sbi->ll_sa_stripe_total, 0);
 
 	return count;
 }
@@ -1104,6 +1349,36 @@ static ssize_t xattr_cache_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(xattr_cache);
 
+static ssize_t xattr_prefetch_show(struct kobject *kobj,
+				   struct attribute *attr,
+				   char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return sprintf(buf, "%u\n", sbi->ll_xattr_prefetch);
+}
+
+static ssize_t xattr_prefetch_store(struct kobject *kobj,
+				    struct attribute *attr,
+				    const char *buffer,
+				    size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	sbi->ll_xattr_prefetch = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(xattr_prefetch);
+
 static ssize_t tiny_write_show(struct kobject *kobj,
 			       struct attribute *attr,
 			       char *buf)
@@ -1882,13 +2157,21 @@ static struct attribute *llite_attrs[] = {
 	&lustre_attr_stats_track_gid.attr,
 	&lustre_attr_statahead_running_max.attr,
 	&lustre_attr_statahead_batch_max.attr,
+	&lustre_attr_statahead_shard_max.attr,
+	&lustre_attr_statahead_fname_hits.attr,
 	&lustre_attr_statahead_max.attr,
 	&lustre_attr_statahead_agl.attr,
+	&lustre_attr_unlink_batch_max.attr,
+	&lustre_attr_dir_index_max.attr,
+	&lustre_attr_dir_index_max_mb.attr,
+	&lustre_attr_hybrid_io_read_threshold_bytes.attr,
+	&lustre_attr_hybrid_io_write_threshold_bytes.attr,
 	&lustre_attr_lazystatfs.attr,
 	&lustre_attr_statfs_max_age.attr,
 	&lustre_attr_max_easize.attr,
 	&lustre_attr_default_easize.attr,
 	&lustre_attr_xattr_cache.attr,
+	&lustre_attr_xattr_prefetch.attr,
 	&lustre_attr_fast_read.attr,
 	&lustre_attr_tiny_write.attr,
 	&lustre_attr_parallel_dio.attr,
@@ -1951,6 +2234,8 @@ static const struct llite_file_opcode {
 	{ LPROC_LL_FLOCK,	LPROCFS_TYPE_LATENCY,	"flock" },
 	{ LPROC_LL_GETATTR,	LPROCFS_TYPE_LATENCY,	"getattr" },
 	{ LPROC_LL_FALLOCATE,	LPROCFS_TYPE_LATENCY,	"fallocate"},
+	{ LPROC_LL_HYBRID_READ,	LPROCFS_TYPE_REQS,	"hybrid_read_switch" },
+	{ LPROC_LL_HYBRID_WRITE, LPROCFS_TYPE_REQS,	"hybrid_write_switch" },
 	/* dir inode operation */
 	{ LPROC_LL_CREATE,	LPROCFS_TYPE_LATENCY,	"create" },
 	{ LPROC_LL_LINK,	LPROCFS_TYPE_LATENCY,	"link" },
@@ -2007,7 +2292,8 @@ static const char *const ra_stat_string[] = {
 	[RA_STAT_ASYNC]			= "async_readahead",
 	[RA_STAT_FAILED_FAST_READ]	= "failed_to_fast_read",
 	[RA_STAT_MMAP_RANGE_READ]	= "mmap_range_read",
-	[RA_STAT_READAHEAD_PAGES]	= "readahead_pages"
+	[RA_STAT_READAHEAD_PAGES]	= "readahead_pages",
+	[RA_STAT_NEW_STREAM]		= "new_read_stream",
 };
 
 int ll_debugfs_register_super(struct super_block *sb, const char *name)
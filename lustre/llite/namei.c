@@ -339,6 +339,7 @@ static void ll_lock_cancel_bits(struct ldlm_lock *lock, __u64 to_cancel)
 		       "pfid  = "DFID"\n", PFID(ll_inode2fid(inode)),
 		       lli, PFID(&lli->lli_pfid));
 		truncate_inode_pages(inode->i_mapping, 0);
+		ll_dir_index_invalidate(inode);
 
 		if (unlikely(!fid_is_zero(&lli->lli_pfid))) {
 			struct inode *master_inode = NULL;
@@ -705,6 +706,7 @@ static int ll_lookup_it_finish(struct ptlrpc_request *request,
 		}
 
 		ll_set_lock_data(ll_i2sbi(parent)->ll_md_exp, inode, it, &bits);
+		ll_xattr_cache_prefill(inode, &request->rq_pill, bits);
 		/* OPEN can return data if lock has DoM+LAYOUT bits set */
 		if (it->it_op & IT_OPEN &&
 		    bits & MDS_INODELOCK_DOM && bits & MDS_INODELOCK_LAYOUT)
@@ -810,6 +812,81 @@ out:
 	return rc;
 }
 
+/* instantiate @dentry with the cached inode of @fid, if its LOOKUP lock is
+ * cached too */
+static struct dentry *ll_lookup_index_inode(struct inode *parent,
+					    struct dentry *dentry,
+					    struct lu_fid *fid)
+{
+	struct lookup_intent it = { .it_op = IT_LOOKUP };
+	struct ll_sb_info *sbi = ll_i2sbi(parent);
+	struct dentry *alias;
+	struct inode *inode;
+
+	inode = ilookup5(parent->i_sb,
+			 cl_fid_build_ino(fid, ll_need_32bit_api(sbi)),
+			 ll_test_inode_by_fid, fid);
+	if (!inode)
+		return ERR_PTR(-EAGAIN);
+
+	if (!md_revalidate_lock(ll_i2mdexp(parent), &it, fid, NULL)) {
+		iput(inode);
+		return ERR_PTR(-EAGAIN);
+	}
+
+	alias = ll_splice_alias(inode, dentry);
+	if (IS_ERR(alias)) {
+		iput(inode);
+	} else {
+		d_lustre_revalidate(alias);
+		if (S_ISDIR(alias->d_inode->i_mode))
+			ll_update_dir_depth_dmv(parent, alias);
+	}
+	ll_intent_release(&it);
+
+	return alias;
+}
+
+/*
+ * Answer the lookup of @dentry from the name index of the cached pages of
+ * @parent, see ll_dir_index_lookup(). A name missing from the directory gets
+ * a negative dentry, a name whose inode and LOOKUP lock are cached gets that
+ * inode, without any RPC. Return ERR_PTR(-EAGAIN) if the MDT must be asked.
+ */
+static struct dentry *ll_lookup_index(struct inode *parent,
+				      struct dentry *dentry,
+				      struct lookup_intent *it)
+{
+	struct lookup_intent parent_it = { .it_op = IT_READDIR };
+	struct dentry *alias = ERR_PTR(-EAGAIN);
+	struct lu_fid fid;
+	int rc;
+
+	if (ll_i2sbi(parent)->ll_dir_index_max == 0 ||
+	    it->it_op & IT_CREAT || ll_dir_striped(parent) ||
+	    IS_ENCRYPTED(parent))
+		return alias;
+
+	/* the index is only valid while the UPDATE lock is held */
+	if (!md_revalidate_lock(ll_i2mdexp(parent), &parent_it,
+				ll_inode2fid(parent), NULL))
+		return alias;
+
+	rc = ll_dir_index_lookup(parent, &dentry->d_name, &fid);
+	if (rc == 0) {
+		alias = ll_splice_alias(NULL, dentry);
+		if (!IS_ERR(alias))
+			d_lustre_revalidate(alias);
+		CDEBUG(D_DENTRY, "%pd: negative from dir index\n", dentry);
+	} else if (rc == 1 && !(it->it_op & IT_OPEN)) {
+		/* open needs its RPC anyway */
+		alias = ll_lookup_index_inode(parent, dentry, &fid);
+	}
+	ll_intent_release(&parent_it);
+
+	return alias;
+}
+
 static struct dentry *ll_lookup_it(struct inode *parent, struct dentry *dentry,
 				   struct lookup_intent *it,
 				   void **secctx, __u32 *secctxlen,
@@ -849,10 +926,18 @@ static struct dentry *ll_lookup_it(struct inode *parent, struct dentry *dentry,
 			RETURN(dentry == save ? NULL : dentry);
 	}
 
+	/* name may belong to a sequence that statahead can predict */
+	if (!(it->it_op & IT_CREAT))
+		ll_statahead_detect(dentry);
+
 	if (it->it_op & IT_OPEN && it->it_flags & FMODE_WRITE &&
 	    dentry->d_sb->s_flags & SB_RDONLY)
 		RETURN(ERR_PTR(-EROFS));
 
+	retval = ll_lookup_index(parent, dentry, it);
+	if (PTR_ERR(retval) != -EAGAIN)
+		RETURN(retval == save ? NULL : retval);
+
 	if (it->it_op & IT_CREAT)
 		opc = LUSTRE_OPC_CREATE;
 	else
@@ -992,6 +1077,11 @@ inherit:
 		op_data->op_file_secctx_name_size =
 			ll_secctx_name_get(sbi, &op_data->op_file_secctx_name);
 
+	/* fetch all xattrs along with the XATTR lock, if granted */
+	if (it->it_op & (IT_GETATTR | IT_OPEN) && !(it->it_op & IT_CREAT) &&
+	    ll_sbi_has_xattr_prefetch(sbi))
+		op_data->op_cli_flags |= CLI_XATTR_PREFETCH;
+
 	if (pca && pca->pca_dataset) {
 		OBD_ALLOC_PTR(lum);
 		if (lum == NULL)
@@ -1474,12 +1564,8 @@ static int ll_create_it(struct inode *dir, struct dentry *dentry,
 	RETURN(0);
 }
 
-void ll_update_times(struct ptlrpc_request *request, struct inode *inode)
+static void ll_update_times_body(struct mdt_body *body, struct inode *inode)
 {
-	struct mdt_body *body = req_capsule_server_get(&request->rq_pill,
-						       &RMF_MDT_BODY);
-
-	LASSERT(body);
 	if (body->mbo_valid & OBD_MD_FLMTIME &&
 	    body->mbo_mtime > inode->i_mtime.tv_sec) {
 		CDEBUG(D_INODE,
@@ -1494,6 +1580,15 @@ void ll_update_times(struct ptlrpc_request *request, struct inode *inode)
 		inode->i_ctime.tv_sec = body->mbo_ctime;
 }
 
+void ll_update_times(struct ptlrpc_request *request, struct inode *inode)
+{
+	struct mdt_body *body = req_capsule_server_get(&request->rq_pill,
+						       &RMF_MDT_BODY);
+
+	LASSERT(body);
+	ll_update_times_body(body, inode);
+}
+
 /* once default LMV (space balanced) is set on ROOT, it should take effect if
  * default LMV is not set on parent directory.
  */
@@ -2097,6 +2192,154 @@ int ll_rmdir_entry(struct inode *dir, char *name, int namelen)
 	RETURN(rc);
 }
 
+/*
+ * Batched unlink.
+ *
+ * With llite.*.unlink_batch_max set, concurrent unlinks of non-directories
+ * are sent together in one MDS_BATCH RPC, and each of them still waits for
+ * and returns its own result. Like a journal group commit, an unlink which
+ * finds no batch in flight sends its batch at once, so a single thread does
+ * not wait longer than with md_unlink(). The unlinks which come while a batch
+ * is in flight are queued into the next one, which is sent by one of them
+ * once the previous one is done.
+ */
+struct ll_unlink_waiter {
+	struct md_op_item	 luw_item;
+	struct ll_sb_info	*luw_sbi;
+	struct mdt_body		 luw_body;	/* reply body if luw_rc == 0 */
+	int			 luw_rc;
+	bool			 luw_done;
+};
+
+static int ll_unlink_batch_interpret(struct md_op_item *item, int rc)
+{
+	struct ll_unlink_waiter *luw = container_of(item,
+						    struct ll_unlink_waiter,
+						    luw_item);
+	struct ll_sb_info *sbi = luw->luw_sbi;
+	struct mdt_body *body;
+
+	if (rc == 0) {
+		body = req_capsule_server_get(item->mop_pill, &RMF_MDT_BODY);
+		luw->luw_body = *body;
+	}
+	if (item->mop_subpill_allocated) {
+		OBD_FREE_PTR(item->mop_pill);
+		item->mop_subpill_allocated = 0;
+	}
+
+	luw->luw_rc = rc;
+	/* @luw may be freed as soon as it is seen done */
+	smp_store_release(&luw->luw_done, true);
+	wake_up_all(&sbi->ll_unlink_waitq);
+
+	return rc;
+}
+
+/* the unlink is done, or there is a batch to send and nothing in flight */
+static bool ll_unlink_batch_ready(struct ll_sb_info *sbi,
+				  struct ll_unlink_waiter *luw)
+{
+	return smp_load_acquire(&luw->luw_done) ||
+	       (!READ_ONCE(sbi->ll_unlink_sending) &&
+		READ_ONCE(sbi->ll_unlink_bh) != NULL);
+}
+
+/**
+ * Unlink \a dchild with the concurrent unlinks of the same mount.
+ *
+ * \param[in] dir	parent directory
+ * \param[in] dchild	dentry to unlink, not a directory
+ * \param[in] op_data	unlink request, still owned by the caller
+ *
+ * \retval 0		the name is unlinked
+ * \retval -EOPNOTSUPP	the unlink cannot be batched, use md_unlink()
+ * \retval negative	errno of the failed unlink
+ */
+static int ll_unlink_batch(struct inode *dir, struct dentry *dchild,
+			   struct md_op_data *op_data)
+{
+	struct ll_sb_info *sbi = ll_i2sbi(dir);
+	struct ll_unlink_waiter *luw;
+	struct md_op_item *item;
+	struct lu_batch *bh;
+	int rc;
+
+	if (!sbi->ll_unlink_batch_max || S_ISDIR(dchild->d_inode->i_mode) ||
+	    !exp_connect_batch_reint(sbi->ll_md_exp))
+		return -EOPNOTSUPP;
+
+	OBD_ALLOC_PTR(luw);
+	if (luw == NULL)
+		return -EOPNOTSUPP;
+
+	luw->luw_sbi = sbi;
+	item = &luw->luw_item;
+	item->mop_opc = MD_OP_UNLINK;
+	/* the references of @op_data are released by the caller */
+	item->mop_data = *op_data;
+	item->mop_cb = ll_unlink_batch_interpret;
+	item->mop_dir = dir;
+
+	mutex_lock(&sbi->ll_unlink_mutex);
+	if (sbi->ll_unlink_bh == NULL) {
+		bh = md_batch_create(sbi->ll_md_exp, BATCH_FL_SYNC,
+				     sbi->ll_unlink_batch_max);
+		if (IS_ERR(bh)) {
+			mutex_unlock(&sbi->ll_unlink_mutex);
+			GOTO(out_free, rc = -EOPNOTSUPP);
+		}
+		WRITE_ONCE(sbi->ll_unlink_bh, bh);
+	}
+
+	rc = md_batch_add(sbi->ll_md_exp, sbi->ll_unlink_bh, item);
+	if (rc) {
+		mutex_unlock(&sbi->ll_unlink_mutex);
+		CDEBUG(D_INODE, "%s: cannot batch unlink of "DFID": rc = %d\n",
+		       sbi->ll_fsname, PFID(&op_data->op_fid3), rc);
+		if (item->mop_subpill_allocated)
+			OBD_FREE_PTR(item->mop_pill);
+		GOTO(out_free, rc = -EOPNOTSUPP);
+	}
+
+	while (!smp_load_acquire(&luw->luw_done)) {
+		if (!sbi->ll_unlink_sending && sbi->ll_unlink_bh != NULL) {
+			/* lead: send the batch and wait for its results */
+			bh = sbi->ll_unlink_bh;
+			WRITE_ONCE(sbi->ll_unlink_bh, NULL);
+			WRITE_ONCE(sbi->ll_unlink_sending, true);
+			mutex_unlock(&sbi->ll_unlink_mutex);
+
+			md_batch_stop(sbi->ll_md_exp, bh);
+
+			mutex_lock(&sbi->ll_unlink_mutex);
+			WRITE_ONCE(sbi->ll_unlink_sending, false);
+			wake_up_all(&sbi->ll_unlink_waitq);
+			continue;
+		}
+
+		/* follow: the batch in flight has this unlink or blocks it */
+		mutex_unlock(&sbi->ll_unlink_mutex);
+		wait_event_idle(sbi->ll_unlink_waitq,
+				ll_unlink_batch_ready(sbi, luw));
+		mutex_lock(&sbi->ll_unlink_mutex);
+	}
+	mutex_unlock(&sbi->ll_unlink_mutex);
+
+	rc = luw->luw_rc;
+	if (rc == 0) {
+		if (luw->luw_body.mbo_valid & OBD_MD_FLNLINK) {
+			spin_lock(&dchild->d_inode->i_lock);
+			set_nlink(dchild->d_inode, luw->luw_body.mbo_nlink);
+			spin_unlock(&dchild->d_inode->i_lock);
+		}
+		ll_update_times_body(&luw->luw_body, dir);
+	}
+out_free:
+	OBD_FREE_PTR(luw);
+	return rc;
+}
+
 static int ll_unlink(struct inode *dir, struct dentry *dchild)
 {
 	struct qstr *name = &dchild->d_name;
@@ -2139,6 +2382,13 @@ static int ll_unlink(struct inode *dir, struct dentry *dchild)
 		op_data->op_cli_flags |= CLI_DIRTY_DATA;
 	if (fid_is_zero(&op_data->op_fid2))
 		op_data->op_fid2 = op_data->op_fid3;
+
+	rc = ll_unlink_batch(dir, dchild, op_data);
+	if (rc != -EOPNOTSUPP) {
+		ll_finish_md_op_data(op_data);
+		GOTO(out, rc);
+	}
+
 	rc = md_unlink(ll_i2sbi(dir)->ll_md_exp, op_data, &request);
 	ll_finish_md_op_data(op_data);
 	if (rc)
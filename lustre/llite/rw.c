@@ -493,6 +493,9 @@ ll_read_ahead_pages(const struct lu_env *env, struct cl_io *io,
 				break;
 
 			/* If the page is inside the read-ahead window */
+			cl_page_stash_fill(env, io->ci_obj,
+				min_t(unsigned long, ria->ria_reserved,
+				      ria->ria_end_idx - page_idx + 1));
 			rc = ll_read_ahead_page(env, io, queue, page_idx,
 						MAYNEED);
 			if (rc < 0 && rc != -EBUSY)
@@ -541,6 +544,7 @@ ll_read_ahead_pages(const struct lu_env *env, struct cl_io *io,
 	}
 
 	cl_read_ahead_release(env, &ra);
+	cl_page_stash_drain(env);
 
 	if (count)
 		ll_ra_stats_add(vvp_object_inode(io->ci_obj),
@@ -608,7 +612,7 @@ static void ll_readahead_handle_work(struct work_struct *wq)
 	work = container_of(wq, struct ll_readahead_work,
 			    lrw_readahead_work);
 	fd = work->lrw_file->private_data;
-	ras = &fd->fd_ras;
+	ras = work->lrw_ras;
 	file = work->lrw_file;
 	inode = file_inode(file);
 	sbi = ll_i2sbi(inode);
@@ -954,7 +958,7 @@ static void ras_stride_reset(struct ll_readahead_state *ras)
         RAS_CDEBUG(ras);
 }
 
-void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras)
+static void ras_init(struct ll_readahead_state *ras)
 {
 	spin_lock_init(&ras->ras_lock);
 	ras->ras_rpc_pages = PTLRPC_MAX_BRW_PAGES;
@@ -965,6 +969,18 @@ void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras)
 	ras->ras_range_max_end_idx = 0;
 	ras->ras_range_requests = 0;
 	ras->ras_last_range_pages = 0;
+	ras->ras_last_use = 0;
+}
+
+void ll_readahead_init(struct inode *inode, struct ll_file_data *fd)
+{
+	int i;
+
+	for (i = 0; i < LL_RA_STREAMS; i++)
+		ras_init(&fd->fd_ras[i]);
+	spin_lock_init(&fd->fd_ras_lock);
+	fd->fd_ras_mru = 0;
+	fd->fd_ras_clock = 0;
 }
 
 /*
@@ -1242,13 +1258,134 @@ static void ras_detect_read_pattern(struct ll_readahead_state *ras,
 	ras->ras_last_read_end_bytes = pos + bytes - 1;
 }
 
+/* copy the state of stream \a src to \a dst, except the lock */
+static void ras_fork(struct ll_readahead_state *dst,
+		     struct ll_readahead_state *src)
+{
+	const size_t off = offsetof(struct ll_readahead_state,
+				    ras_last_read_end_bytes);
+	struct ll_readahead_state tmp;
+
+	spin_lock(&src->ras_lock);
+	memcpy((char *)&tmp + off, (char *)src + off, sizeof(tmp) - off);
+	spin_unlock(&src->ras_lock);
+
+	spin_lock(&dst->ras_lock);
+	memcpy((char *)dst + off, (char *)&tmp + off, sizeof(tmp) - off);
+	spin_unlock(&dst->ras_lock);
+}
+
+/* whether a read of \a bytes at \a pos continues the stream \a ras */
+static bool ras_match_read(struct ll_readahead_state *ras, loff_t pos,
+			   size_t bytes)
+{
+	return ras->ras_requests > 0 &&
+	       (is_loose_seq_read(ras, pos) ||
+		read_in_stride_window(ras, pos, bytes));
+}
+
+/*
+ * Select the read stream of a read(2) of \a bytes at \a pos.
+ *
+ * Several threads may read distinct regions of a file through one file
+ * descriptor, like MPI N-1 reads do. With a single readahead state they
+ * would reset each other's window on every read, so up to LL_RA_STREAMS
+ * streams are tracked per file descriptor.
+ *
+ * A read continuing a stream, sequentially or with its stride, uses that
+ * stream. Any other read starts a new stream in the least recently used
+ * slot, forked from the stream of the previous read(2): the new stream sees
+ * the seek as a single readahead state would, so stride detection and the
+ * small file heuristic still work, while the previous stream is kept for
+ * its reader to come back to.
+ */
+static struct ll_readahead_state *ll_ras_select(struct ll_file_data *fd,
+						struct ll_sb_info *sbi,
+						loff_t pos, size_t bytes)
+{
+	struct ll_readahead_state *mru;
+	struct ll_readahead_state *lru = NULL;
+	struct ll_readahead_state *ras;
+	int i;
+
+	spin_lock(&fd->fd_ras_lock);
+	mru = &fd->fd_ras[fd->fd_ras_mru];
+	if (mru->ras_requests == 0 || ras_match_read(mru, pos, bytes))
+		GOTO(out, ras = mru);
+
+	for (i = 0; i < LL_RA_STREAMS; i++) {
+		ras = &fd->fd_ras[i];
+		if (ras == mru)
+			continue;
+		if (ras_match_read(ras, pos, bytes))
+			GOTO(out, ras);
+		if (lru == NULL || ras->ras_last_use < lru->ras_last_use)
+			lru = ras;
+	}
+
+	if (lru == NULL)
+		GOTO(out, ras = mru);
+
+	ras = lru;
+	ras_fork(ras, mru);
+	ll_ra_stats_inc_sbi(sbi, RA_STAT_NEW_STREAM);
+out:
+	ras->ras_last_use = ++fd->fd_ras_clock;
+	WRITE_ONCE(fd->fd_ras_mru, ras - fd->fd_ras);
+	spin_unlock(&fd->fd_ras_lock);
+
+	return ras;
+}
+
+/* whether the last read(2) or the readahead window of \a ras covers \a idx */
+static bool ras_cover_index(struct ll_readahead_state *ras, pgoff_t idx)
+{
+	loff_t start = ras->ras_last_read_end_bytes + 1 -
+		       ras->ras_consecutive_bytes;
+
+	if (ras->ras_requests == 0)
+		return false;
+
+	if (idx >= (max_t(loff_t, start, 0) >> PAGE_SHIFT) &&
+	    idx <= ras->ras_last_read_end_bytes >> PAGE_SHIFT)
+		return true;
+
+	return ras->ras_window_pages > 0 &&
+	       pos_in_window(idx, ras->ras_window_start_idx, 0,
+			     ras->ras_window_pages);
+}
+
+/*
+ * Find the read stream a page read at \a idx belongs to, that of the last
+ * read(2) if no stream covers it, see ll_ras_select().
+ */
+static struct ll_readahead_state *ll_ras_find(struct ll_file_data *fd,
+					      pgoff_t idx)
+{
+	struct ll_readahead_state *mru;
+	struct ll_readahead_state *ras;
+	int i;
+
+	mru = &fd->fd_ras[READ_ONCE(fd->fd_ras_mru)];
+	if (ras_cover_index(mru, idx))
+		return mru;
+
+	for (i = 0; i < LL_RA_STREAMS; i++) {
+		ras = &fd->fd_ras[i];
+		if (ras != mru && ras_cover_index(ras, idx))
+			return ras;
+	}
+
+	return mru;
+}
+
 void ll_ras_enter(struct file *f, loff_t pos, size_t bytes)
 {
 	struct ll_file_data *fd = f->private_data;
-	struct ll_readahead_state *ras = &fd->fd_ras;
 	struct inode *inode = file_inode(f);
 	unsigned long index = pos >> PAGE_SHIFT;
 	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct ll_readahead_state *ras = ll_ras_select(fd, sbi, pos, bytes);
 
 	spin_lock(&ras->ras_lock);
 	ras->ras_requests++;
@@ -1693,7 +1830,7 @@ int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 
 	if (file) {
 		fd = file->private_data;
-		ras = &fd->fd_ras;
+		ras = ll_ras_find(fd, cl_page_index(page));
 	}
 
 	/* PagePrivate2 is set in ll_io_zero_page() to tell us the vmpage
@@ -1806,13 +1943,13 @@ int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
  * 2 async readahead triggered and fast read could be used too.
  * < 0 on error.
  */
-static int kickoff_async_readahead(struct file *file, unsigned long pages)
+static int kickoff_async_readahead(struct file *file,
+				   struct ll_readahead_state *ras,
+				   unsigned long pages)
 {
 	struct ll_readahead_work *lrw;
 	struct inode *inode = file_inode(file);
 	struct ll_sb_info *sbi = ll_i2sbi(inode);
-	struct ll_file_data *fd = file->private_data;
-	struct ll_readahead_state *ras = &fd->fd_ras;
 	struct ll_ra_info *ra = &sbi->ll_ra_info;
 	unsigned long throttle;
 	pgoff_t start_idx = ras_align(ras, ras->ras_next_readahead_idx);
@@ -1850,6 +1987,7 @@ static int kickoff_async_readahead(struct file *file, unsigned long pages)
 	if (lrw) {
 		atomic_inc(&sbi->ll_ra_info.ra_async_inflight);
 		lrw->lrw_file = get_file(file);
+		lrw->lrw_ras = ras;
 		lrw->lrw_start_idx = start_idx;
 		lrw->lrw_end_idx = end_idx;
 		lrw->lrw_user_pid = current->pid;
@@ -1892,7 +2030,7 @@ static bool ll_use_fast_io(struct file *file,
 
 	if (ras->ras_window_start_idx + ras->ras_window_pages <
 	    ras->ras_next_readahead_idx + skip_pages ||
-	    kickoff_async_readahead(file, fast_read_pages) > 0)
+	    kickoff_async_readahead(file, ras, fast_read_pages) > 0)
 		return true;
 
 	return false;
@@ -1955,7 +2093,7 @@ int ll_readpage(struct file *file, struct page *vmpage)
 	if (io == NULL) { /* fast read */
 		struct inode *inode = file_inode(file);
 		struct ll_file_data *fd = file->private_data;
-		struct ll_readahead_state *ras = &fd->fd_ras;
+		struct ll_readahead_state *ras = ll_ras_find(fd, vmpage->index);
 		struct lu_env  *local_env = NULL;
 
 		CDEBUG(D_VFSTRACE, "fast read pgno: %ld\n", vmpage->index);
@@ -2056,7 +2194,7 @@ int ll_readpage(struct file *file, struct page *vmpage)
 	 * with lockless i/o, and buffered requires LDLM locking, so in
 	 * this case we must restart without lockless.
 	 */
-	if (file->f_flags & O_DIRECT &&
+	if ((file->f_flags & O_DIRECT || io->ci_hybrid_switched) &&
 	    lcc && lcc->lcc_type == LCC_RW &&
 	    !io->ci_dio_lock) {
 		unlock_page(vmpage);
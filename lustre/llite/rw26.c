@@ -382,6 +382,8 @@ ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io, size_t size,
 		size_t from = offset & ~PAGE_MASK;
 		size_t to = min(from + size, PAGE_SIZE);
 
+		/* allocate the transient cl_pages in batches */
+		cl_page_stash_fill(env, obj, pv->ldp_count - i);
 		page = cl_page_find(env, obj, offset >> PAGE_SHIFT,
 				    pv->ldp_pages[i], CPT_TRANSIENT);
 		if (IS_ERR(page)) {
@@ -424,6 +426,7 @@ ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io, size_t size,
 		offset += to - from;
 		size -= to - from;
 	}
+	cl_page_stash_drain(env);
 	/* on success, we should hit every page in the pvec and have no bytes
 	 * left in 'size'
 	 */
@@ -816,7 +819,7 @@ static int ll_write_begin(struct file *file, struct address_space *mapping,
 	env = lcc->lcc_env;
 	io  = lcc->lcc_io;
 
-	if (file->f_flags & O_DIRECT) {
+	if (file->f_flags & O_DIRECT || io->ci_hybrid_switched) {
 		/* direct IO failed because it couldn't clean up cached pages,
 		 * this causes a problem for mirror write because the cached
 		 * page may belong to another mirror, which will result in
@@ -880,6 +883,15 @@ again:
 		goto again;
 	}
 
+	/* a new page needs a cl_page, batch that for the rest of the write */
+	if (!PagePrivate(vmpage)) {
+		loff_t end = io->u.ci_wr.wr.crw_pos + io->u.ci_wr.wr.crw_bytes;
+
+		if (end > pos)
+			cl_page_stash_fill(env, clob,
+				DIV_ROUND_UP(end, PAGE_SIZE) - index);
+	}
+
 	page = cl_page_find(env, clob, vmpage->index, vmpage, CPT_CACHEABLE);
 	if (IS_ERR(page))
 		GOTO(out, result = PTR_ERR(page));
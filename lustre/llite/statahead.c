@@ -35,6 +35,7 @@
 #include <linux/mm.h>
 #include <linux/highmem.h>
 #include <linux/pagemap.h>
+#include <linux/ctype.h>
 #include <linux/delay.h>
 
 #define DEBUG_SUBSYSTEM S_LLITE
@@ -75,6 +76,8 @@ struct sa_entry {
 	struct inode			*se_inode;
 	/* pointer to @sai per process struct */
 	struct ll_statahead_info	*se_sai;
+	/* stripe worker which sent the stat, if any */
+	struct ll_sa_shard		*se_shard;
 	/* entry name */
 	struct qstr			 se_qstr;
 	/* entry fid */
@@ -144,18 +147,45 @@ static inline int sa_sent_full(struct ll_statahead_info *sai)
 	return atomic_read(&sai->sai_cache_count) >= sai->sai_max;
 }
 
+/* statahead window of a stripe worker, or of the whole directory, is full */
+static inline int sa_window_full(struct ll_statahead_info *sai,
+				 struct ll_sa_shard *shard)
+{
+	if (shard && atomic_read(&shard->ss_cache_count) >=
+		     max_t(int, sai->sai_max / sai->sai_shard_count, 1))
+		return 1;
+
+	return sa_sent_full(sai);
+}
+
 /* Batch metadata handle */
-static inline bool sa_has_batch_handle(struct ll_statahead_info *sai)
+static inline struct lu_batch *sa_batch(struct ll_statahead_info *sai,
+					struct ll_sa_shard *shard)
 {
-	return sai->sai_bh != NULL;
+	return shard ? shard->ss_bh : sai->sai_bh;
 }
 
-static inline void ll_statahead_flush_nowait(struct ll_statahead_info *sai)
+static inline void ll_statahead_flush_nowait(struct ll_statahead_info *sai,
+					     struct ll_sa_shard *shard)
 {
-	if (sa_has_batch_handle(sai)) {
+	struct lu_batch *bh = sa_batch(sai, shard);
+
+	if (bh) {
 		sai->sai_index_end = sai->sai_index - 1;
 		(void) md_batch_flush(ll_i2mdexp(sai->sai_dentry->d_inode),
-				      sai->sai_bh, false);
+				      bh, false);
+	}
+}
+
+/* wake up the statahead thread and its stripe workers */
+static inline void sa_wakeup(struct ll_statahead_info *sai)
+{
+	int i;
+
+	wake_up_process(sai->sai_task);
+	for (i = 0; i < sai->sai_shard_count; i++) {
+		if (sai->sai_shards[i].ss_task)
+			wake_up_process(sai->sai_shards[i].ss_task);
 	}
 }
 
@@ -176,6 +206,26 @@ static inline int sa_low_hit(struct ll_statahead_info *sai)
 		(sai->sai_consecutive_miss > 8));
 }
 
+/* seconds without lookup of its entries to stop statahead by name pattern */
+#define SA_FNAME_IDLE	5
+
+/*
+ * statahead started by ll_statahead_detect() is not bound to a file handle,
+ * it stops once lookups no longer consume its entries.
+ */
+static bool sa_fname_idle(struct ll_statahead_info *sai)
+{
+	__u64 used = sai->sai_hit + sai->sai_miss;
+
+	if (used != sai->sai_fused) {
+		sai->sai_fused = used;
+		sai->sai_fused_time = ktime_get_seconds();
+		return false;
+	}
+
+	return ktime_get_seconds() - sai->sai_fused_time > SA_FNAME_IDLE;
+}
+
 /*
  * if the given index is behind of statahead window more than
  * SA_OMITTED_ENTRY_MAX, then it is old.
@@ -188,8 +238,9 @@ static inline int is_omitted_entry(struct ll_statahead_info *sai, __u64 index)
 
 /* allocate sa_entry and hash it to allow scanner process to find it */
 static struct sa_entry *
-sa_alloc(struct dentry *parent, struct ll_statahead_info *sai, __u64 index,
-	 const char *name, int len, const struct lu_fid *fid)
+sa_alloc(struct dentry *parent, struct ll_statahead_info *sai,
+	 struct ll_sa_shard *shard, const char *name, int len,
+	 const struct lu_fid *fid)
 {
 	struct ll_inode_info *lli;
 	struct sa_entry *entry;
@@ -204,11 +255,8 @@ sa_alloc(struct dentry *parent, struct ll_statahead_info *sai, __u64 index,
 	if (unlikely(!entry))
 		RETURN(ERR_PTR(-ENOMEM));
 
-	CDEBUG(D_READA, "alloc sa entry %.*s(%p) index %llu\n",
-	       len, name, entry, index);
-
-	entry->se_index = index;
 	entry->se_sai = sai;
+	entry->se_shard = shard;
 
 	entry->se_state = SA_ENTRY_INIT;
 	entry->se_size = entry_size;
@@ -224,11 +272,18 @@ sa_alloc(struct dentry *parent, struct ll_statahead_info *sai, __u64 index,
 
 	lli = ll_i2info(sai->sai_dentry->d_inode);
 	spin_lock(&lli->lli_sa_lock);
+	/* stripe workers allocate entries concurrently */
+	entry->se_index = sai->sai_index++;
 	INIT_LIST_HEAD(&entry->se_list);
 	sa_rehash(lli->lli_sax, entry);
 	spin_unlock(&lli->lli_sa_lock);
 
+	CDEBUG(D_READA, "alloc sa entry %.*s(%p) index %llu\n",
+	       len, name, entry, entry->se_index);
+
 	atomic_inc(&sai->sai_cache_count);
+	if (shard)
+		atomic_inc(&shard->ss_cache_count);
 
 	RETURN(entry);
 }
@@ -290,6 +345,8 @@ sa_kill(struct ll_statahead_info *sai, struct sa_entry *entry, bool locked)
 
 	iput(entry->se_inode);
 	atomic_dec(&sai->sai_cache_count);
+	if (entry->se_shard)
+		atomic_dec(&entry->se_shard->ss_cache_count);
 	sa_free(ctx, entry);
 	if (locked)
 		spin_lock(&lli->lli_sa_lock);
@@ -350,7 +407,7 @@ sa_put(struct inode *dir, struct ll_statahead_info *sai, struct sa_entry *entry)
 
 	spin_lock(&lli->lli_sa_lock);
 	if (wakeup && sai->sai_task)
-		wake_up_process(sai->sai_task);
+		sa_wakeup(sai);
 	spin_unlock(&lli->lli_sa_lock);
 }
 
@@ -596,6 +653,8 @@ static struct ll_statahead_info *ll_sai_alloc(struct dentry *dentry)
 static inline void ll_sai_free(struct ll_statahead_info *sai)
 {
 	LASSERT(sai->sai_dentry != NULL);
+	if (sai->sai_shards)
+		OBD_FREE_PTR_ARRAY(sai->sai_shards, sai->sai_shard_count);
 	dput(sai->sai_dentry);
 	OBD_FREE_PTR(sai);
 }
@@ -920,13 +979,14 @@ out:
 	RETURN(rc);
 }
 
-static inline int sa_getattr(struct ll_statahead_info *sai, struct inode *dir,
+static inline int sa_getattr(struct sa_entry *entry, struct inode *dir,
 			     struct md_op_item *item)
 {
+	struct lu_batch *bh = sa_batch(entry->se_sai, entry->se_shard);
 	int rc;
 
-	if (sa_has_batch_handle(sai))
-		rc = md_batch_add(ll_i2mdexp(dir), sai->sai_bh, item);
+	if (bh)
+		rc = md_batch_add(ll_i2mdexp(dir), bh, item);
 	else
 		rc = md_intent_getattr_async(ll_i2mdexp(dir), item);
 
@@ -945,7 +1005,7 @@ static int sa_lookup(struct inode *dir, struct sa_entry *entry)
 	if (IS_ERR(item))
 		RETURN(PTR_ERR(item));
 
-	rc = sa_getattr(entry->se_sai, dir, item);
+	rc = sa_getattr(entry, dir, item);
 	if (rc < 0)
 		sa_fini_data(item);
 
@@ -990,7 +1050,7 @@ static int sa_revalidate(struct inode *dir, struct sa_entry *entry,
 		RETURN(1);
 	}
 
-	rc = sa_getattr(entry->se_sai, dir, item);
+	rc = sa_getattr(entry, dir, item);
 	if (rc < 0) {
 		entry->se_inode = NULL;
 		iput(inode);
@@ -1001,17 +1061,19 @@ static int sa_revalidate(struct inode *dir, struct sa_entry *entry,
 }
 
 /* async stat for file with @name */
-static void sa_statahead(struct ll_statahead_info *sai, struct dentry *parent,
+static void sa_statahead(struct ll_statahead_info *sai,
+			 struct ll_sa_shard *shard, struct dentry *parent,
 			 const char *name, int len, const struct lu_fid *fid)
 {
 	struct inode *dir = parent->d_inode;
+	struct ll_inode_info *lli = ll_i2info(dir);
 	struct dentry *dentry = NULL;
 	struct sa_entry *entry;
 	int rc;
 
 	ENTRY;
 
-	entry = sa_alloc(parent, sai, sai->sai_index, name, len, fid);
+	entry = sa_alloc(parent, sai, shard, name, len, fid);
 	if (IS_ERR(entry))
 		RETURN_EXIT;
 
@@ -1027,15 +1089,19 @@ static void sa_statahead(struct ll_statahead_info *sai, struct dentry *parent,
 	if (dentry)
 		dput(dentry);
 
-	if (rc != 0)
+	if (rc != 0) {
 		sa_make_ready(sai, entry, rc);
-	else
+	} else {
+		spin_lock(&lli->lli_sa_lock);
 		sai->sai_sent++;
+		spin_unlock(&lli->lli_sa_lock);
+		/* only the worker of the shard runs this */
+		if (shard)
+			shard->ss_sent++;
+	}
 
-	sai->sai_index++;
-
-	if (sa_sent_full(sai))
-		ll_statahead_flush_nowait(sai);
+	if (sa_window_full(sai, shard))
+		ll_statahead_flush_nowait(sai, shard);
 
 	EXIT;
 }
@@ -1142,9 +1208,16 @@ static void ll_start_agl(struct dentry *parent, struct ll_statahead_info *sai)
 	EXIT;
 }
 
-static int ll_statahead_by_list(struct dentry *parent)
+/*
+ * Stat ahead the entries of @parent in readdir order. A stripe worker only
+ * scans the @stripe it is given, and reads its pages directly from the MDT of
+ * that stripe.
+ */
+static int ll_statahead_by_list(struct dentry *parent,
+				struct ll_sa_shard *shard, struct inode *stripe)
 {
 	struct inode *dir = parent->d_inode;
+	struct inode *inode = stripe ?: dir;
 	struct ll_inode_info *lli = ll_i2info(dir);
 	struct ll_statahead_info *sai = lli->lli_sai;
 	struct ll_sb_info *sbi = ll_i2sbi(dir);
@@ -1158,6 +1231,12 @@ static int ll_statahead_by_list(struct dentry *parent)
 
 	CDEBUG(D_READA, "statahead thread starting: sai %p, parent %pd\n",
 	       sai, parent);
+	/*
+	 * the first entry of a stripe is usually not the one being looked up,
+	 * that is skipped by name below
+	 */
+	if (shard)
+		first = 1;
 
 	OBD_ALLOC_PTR(op_data);
 	if (!op_data)
@@ -1168,14 +1247,14 @@ static int ll_statahead_by_list(struct dentry *parent)
 		struct lu_dirpage *dp;
 		struct lu_dirent  *ent;
 
-		op_data = ll_prep_md_op_data(op_data, dir, dir, NULL, 0, 0,
-					     LUSTRE_OPC_ANY, dir);
+		op_data = ll_prep_md_op_data(op_data, inode, inode, NULL, 0, 0,
+					     LUSTRE_OPC_ANY, inode);
 		if (IS_ERR(op_data)) {
 			rc = PTR_ERR(op_data);
 			break;
 		}
 
-		page = ll_get_dir_page(dir, op_data, pos, NULL);
+		page = ll_get_dir_page(inode, op_data, pos, NULL);
 		ll_unlock_md_op_lsm(op_data);
 		if (IS_ERR(page)) {
 			rc = PTR_ERR(page);
@@ -1246,7 +1325,7 @@ static int ll_statahead_by_list(struct dentry *parent)
 				  * ll_deauthorize_statahead() */
 				 smp_load_acquire(&sai->sai_task); })) {
 				spin_lock(&lli->lli_agl_lock);
-				while (sa_sent_full(sai) &&
+				while (sa_window_full(sai, shard) &&
 				       !agl_list_empty(sai)) {
 					struct ll_inode_info *clli;
 
@@ -1262,7 +1341,7 @@ static int ll_statahead_by_list(struct dentry *parent)
 				}
 				spin_unlock(&lli->lli_agl_lock);
 
-				if (!sa_sent_full(sai))
+				if (!sa_window_full(sai, shard))
 					break;
 				schedule();
 			}
@@ -1289,12 +1368,19 @@ static int ll_statahead_by_list(struct dentry *parent)
 				namelen = lltr.len;
 			}
 
-			sa_statahead(sai, parent, name, namelen, &fid);
+			/* in lookup already, see start_statahead_thread() */
+			if (shard && namelen == sai->sai_first_len &&
+			    !memcmp(name, sai->sai_first_name, namelen)) {
+				llcrypt_fname_free_buffer(&lltr);
+				continue;
+			}
+
+			sa_statahead(sai, shard, parent, name, namelen, &fid);
 			llcrypt_fname_free_buffer(&lltr);
 		}
 
 		pos = le64_to_cpu(dp->ldp_hash_end);
-		ll_release_page(dir, page,
+		ll_release_page(inode, page,
 				le32_to_cpu(dp->ldp_flags) & LDF_COLLIDE);
 
 		if (sa_low_hit(sai)) {
@@ -1323,6 +1409,7 @@ static int ll_statahead_by_fname(struct ll_statahead_info *sai,
 	size_t len;
 	char *fname;
 	char *ptr;
+	bool idle = false;
 	int rc = 0;
 	__u64 i = 0;
 
@@ -1344,7 +1431,7 @@ static int ll_statahead_by_fname(struct ll_statahead_info *sai,
 	while (smp_load_acquire(&sai->sai_task)) {
 		size_t numlen;
 
-		numlen = snprintf(ptr, max_len, "%llu",
+		numlen = snprintf(ptr, max_len, "%0*llu", sai->sai_fwidth,
 				  sai->sai_fstart + i);
 
 		while (({set_current_state(TASK_IDLE);
@@ -1370,19 +1457,243 @@ static int ll_statahead_by_fname(struct ll_statahead_info *sai,
 
 			if (!sa_sent_full(sai))
 				break;
-			schedule();
+			if (!sai->sai_fname_auto) {
+				schedule();
+			} else if (!schedule_timeout(cfs_time_seconds(1)) &&
+				   sa_fname_idle(sai)) {
+				idle = true;
+				break;
+			}
 		}
 		__set_current_state(TASK_RUNNING);
 
-		sa_statahead(sai, parent, fname, len + numlen, NULL);
+		if (idle)
+			break;
+
+		sa_statahead(sai, NULL, parent, fname, len + numlen, NULL);
 		if (++i >= sai->sai_fend)
 			break;
+
+		if (sai->sai_fname_auto && sa_low_hit(sai)) {
+			atomic_inc(&sbi->ll_sa_wrong);
+			CDEBUG(D_READA,
+			       "%s: FNAME statahead for %pd hit ratio too low: hit/miss %llu/%llu\n",
+			       sbi->ll_fsname, parent, sai->sai_hit,
+			       sai->sai_miss);
+			break;
+		}
 	}
 
 	OBD_FREE(fname, NAME_MAX);
 	RETURN(rc);
 }
 
+/* stripe worker main function, see struct ll_sa_shard */
+static int ll_statahead_shard_thread(void *arg)
+{
+	struct ll_sa_shard *shard = arg;
+	struct ll_statahead_info *sai = shard->ss_sai;
+	struct dentry *parent = sai->sai_dentry;
+	struct ll_inode_info *lli = ll_i2info(parent->d_inode);
+	struct ll_sb_info *sbi = ll_i2sbi(parent->d_inode);
+	unsigned int sent;
+	int rc = 0;
+	int i;
+
+	ENTRY;
+
+	/* matches smp_store_release() in ll_deauthorize_statahead() */
+	for (i = shard->ss_index;
+	     i < sai->sai_stripe_count && smp_load_acquire(&sai->sai_task);
+	     i += sai->sai_shard_count) {
+		if (!sai->sai_stripes[i])
+			continue;
+
+		sent = shard->ss_sent;
+		rc = ll_statahead_by_list(parent, shard, sai->sai_stripes[i]);
+		if (shard->ss_sent != sent)
+			atomic_inc(&sbi->ll_sa_stripe_total);
+		if (rc < 0)
+			break;
+	}
+
+	ll_statahead_flush_nowait(sai, shard);
+
+	if (rc < 0) {
+		/* stop the other workers, and wake up the statahead thread
+		 * as ll_deauthorize_statahead() would */
+		spin_lock(&lli->lli_sa_lock);
+		if (sai->sai_task) {
+			struct task_struct *task = sai->sai_task;
+
+			smp_store_release(&sai->sai_task, NULL);
+			lli->lli_sa_enabled = 0;
+			wake_up_process(task);
+		}
+		spin_unlock(&lli->lli_sa_lock);
+	}
+
+	/* entries are still cached, wait for ll_statahead_thread() to stop */
+	while (({set_current_state(TASK_IDLE);
+		 !kthread_should_stop(); }))
+		schedule();
+	__set_current_state(TASK_RUNNING);
+
+	RETURN(rc);
+}
+
+/*
+ * Start the stripe workers of a striped directory. statahead_shard_max limits
+ * the workers of all the striped directories of the mount together, so a
+ * directory gets fewer workers, or none, while others are being scanned.
+ *
+ * \retval	number of workers started, 0 if the statahead thread has to
+ *		scan the directory itself
+ */
+static int ll_statahead_shards_start(struct ll_statahead_info *sai)
+{
+	int node = cfs_cpt_spread_node(cfs_cpt_tab, CFS_CPT_ANY);
+	struct inode *dir = sai->sai_dentry->d_inode;
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_sb_info *sbi = ll_i2sbi(dir);
+	struct lmv_stripe_object *lso;
+	struct ll_sa_shard *shard;
+	struct task_struct *task;
+	struct lu_batch *bh;
+	int reserved;
+	int excess;
+	int count = 0;
+	int max;
+	int nr;
+	int i;
+
+	ENTRY;
+
+	if (!sbi->ll_sa_shard_max)
+		RETURN(0);
+
+	down_read(&lli->lli_lsm_sem);
+	lso = lli->lli_lsm_obj;
+	if (lso && lmv_dir_striped(lso) && !lmv_dir_layout_changing(lso))
+		count = lso->lso_lsm.lsm_md_stripe_count;
+	if (count > 1)
+		OBD_ALLOC_PTR_ARRAY(sai->sai_stripes, count);
+	if (sai->sai_stripes) {
+		struct lmv_oinfo *oinfo = lso->lso_lsm.lsm_md_oinfo;
+
+		for (i = 0; i < count; i++) {
+			if (oinfo[i].lmo_root)
+				sai->sai_stripes[i] = igrab(oinfo[i].lmo_root);
+		}
+		sai->sai_stripe_count = count;
+	}
+	up_read(&lli->lli_lsm_sem);
+
+	if (!sai->sai_stripes)
+		RETURN(0);
+
+	max = READ_ONCE(sbi->ll_sa_shard_max);
+	nr = min(count, max);
+	excess = atomic_add_return(nr, &sbi->ll_sa_shard_running) - max;
+	if (excess > 0) {
+		excess = min(excess, nr);
+		atomic_sub(excess, &sbi->ll_sa_shard_running);
+		nr -= excess;
+	}
+	if (nr <= 0)
+		GOTO(out, nr = 0);
+	reserved = nr;
+
+	OBD_ALLOC_PTR_ARRAY(sai->sai_shards, nr);
+	if (!sai->sai_shards)
+		GOTO(out_running, nr = 0);
+
+	for (i = 0; i < nr; i++) {
+		shard = &sai->sai_shards[i];
+		shard->ss_sai = sai;
+		shard->ss_index = i;
+		atomic_set(&shard->ss_cache_count, 0);
+
+		if (sai->sai_max_batch_count) {
+			bh = md_batch_create(ll_i2mdexp(dir), BATCH_FL_RDONLY,
+					     sai->sai_max_batch_count);
+			if (IS_ERR(bh))
+				break;
+			shard->ss_bh = bh;
+		}
+
+		task = kthread_create_on_node(ll_statahead_shard_thread, shard,
+					      node, "ll_sa_%u_%d",
+					      lli->lli_opendir_pid, i);
+		if (IS_ERR(task))
+			break;
+		shard->ss_task = task;
+	}
+
+	if (i < nr) {
+		/* workers not started yet do not run their function */
+		for (i = 0; i < nr; i++) {
+			shard = &sai->sai_shards[i];
+			if (shard->ss_task)
+				kthread_stop(shard->ss_task);
+			if (shard->ss_bh)
+				md_batch_stop(ll_i2mdexp(dir), shard->ss_bh);
+		}
+		OBD_FREE_PTR_ARRAY(sai->sai_shards, nr);
+		sai->sai_shards = NULL;
+		GOTO(out_running, nr = 0);
+	}
+
+	spin_lock(&lli->lli_sa_lock);
+	sai->sai_shard_count = nr;
+	spin_unlock(&lli->lli_sa_lock);
+
+	for (i = 0; i < nr; i++)
+		wake_up_process(sai->sai_shards[i].ss_task);
+
+	CDEBUG(D_READA, "%s: %d statahead workers for %d stripes of "DFID"\n",
+	       sbi->ll_fsname, nr, count, PFID(&lli->lli_fid));
+	RETURN(nr);
+
+out_running:
+	atomic_sub(reserved, &sbi->ll_sa_shard_running);
+out:
+	RETURN(nr);
+}
+
+/* stop the stripe workers, and release the stripes they scanned */
+static void ll_statahead_shards_stop(struct ll_statahead_info *sai)
+{
+	struct inode *dir = sai->sai_dentry->d_inode;
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_sa_shard *shard;
+	struct task_struct *task;
+	int i;
+
+	for (i = 0; i < sai->sai_shard_count; i++) {
+		shard = &sai->sai_shards[i];
+
+		spin_lock(&lli->lli_sa_lock);
+		task = shard->ss_task;
+		shard->ss_task = NULL;
+		spin_unlock(&lli->lli_sa_lock);
+
+		kthread_stop(task);
+		if (shard->ss_bh) {
+			md_batch_stop(ll_i2mdexp(dir), shard->ss_bh);
+			shard->ss_bh = NULL;
+		}
+	}
+	atomic_sub(sai->sai_shard_count, &ll_i2sbi(dir)->ll_sa_shard_running);
+
+	if (sai->sai_stripes) {
+		for (i = 0; i < sai->sai_stripe_count; i++)
+			iput(sai->sai_stripes[i]);
+		OBD_FREE_PTR_ARRAY(sai->sai_stripes, sai->sai_stripe_count);
+		sai->sai_stripes = NULL;
+	}
+}
+
 /* statahead thread main function */
 static int ll_statahead_thread(void *arg)
 {
@@ -1411,7 +1722,10 @@ static int ll_statahead_thread(void *arg)
 
 	switch (lli->lli_sa_pattern) {
 	case LSA_PATTERN_LIST:
-		rc = ll_statahead_by_list(parent);
+		/* stripe workers scan a striped dir, wait for them below */
+		if (ll_statahead_shards_start(sai) > 0)
+			break;
+		rc = ll_statahead_by_list(parent, NULL, NULL);
 		break;
 	case LSA_PATTERN_FNAME:
 		rc = ll_statahead_by_fname(sai, parent);
@@ -1428,7 +1742,14 @@ static int ll_statahead_thread(void *arg)
 		spin_unlock(&lli->lli_sa_lock);
 	}
 
-	ll_statahead_flush_nowait(sai);
+	ll_statahead_flush_nowait(sai, NULL);
+
+	/* no closedir() will stop statahead started by name pattern */
+	if (sai->sai_fname_auto) {
+		spin_lock(&lli->lli_sa_lock);
+		smp_store_release(&sai->sai_task, NULL);
+		spin_unlock(&lli->lli_sa_lock);
+	}
 
 	/*
 	 * statahead is finished, but statahead entries need to be cached, wait
@@ -1443,6 +1764,8 @@ static int ll_statahead_thread(void *arg)
 
 	EXIT;
 
+	ll_statahead_shards_stop(sai);
+
 	if (bh) {
 		rc = md_batch_stop(ll_i2mdexp(dir), sai->sai_bh);
 		sai->sai_bh = NULL;
@@ -1482,10 +1805,12 @@ void ll_authorize_statahead(struct inode *dir, void *key)
 	struct ll_inode_info *lli = ll_i2info(dir);
 
 	spin_lock(&lli->lli_sa_lock);
-	if (!lli->lli_opendir_key && !lli->lli_sai) {
+	if (!lli->lli_opendir_key && !lli->lli_sai &&
+	    lli->lli_sa_pattern != LSA_PATTERN_FNAME) {
 		/*
 		 * if lli_sai is not NULL, it means previous statahead is not
-		 * finished yet, we'd better not start a new statahead for now.
+		 * finished yet, we'd better not start a new statahead for now,
+		 * neither while statahead by file name is running.
 		 */
 		lli->lli_opendir_key = key;
 		lli->lli_opendir_pid = current->pid;
@@ -1910,6 +2235,9 @@ static int start_statahead_thread(struct inode *dir, struct dentry *dentry,
 		GOTO(out, rc = -ENOMEM);
 
 	sai->sai_ls_all = (first == LS_FIRST_DOT_DE);
+	/* stripe workers skip this entry by name, see ll_statahead_by_list */
+	sai->sai_first_len = min_t(int, dentry->d_name.len, NAME_MAX);
+	memcpy(sai->sai_first_name, dentry->d_name.name, sai->sai_first_len);
 
 	/*
 	 * if current lli_opendir_key was deauthorized, or dir re-opened by
@@ -2066,6 +2394,150 @@ int ll_revalidate_statahead(struct inode *dir, struct dentry **dentryp,
 	return rc;
 }
 
+/*
+ * start statahead by file name for the names following @name in its numeric
+ * suffix sequence, @plen is the length of the prefix before the suffix
+ */
+static int ll_statahead_fname_start(struct dentry *parent,
+				    const struct qstr *name, int plen,
+				    __u64 index)
+{
+	int node = cfs_cpt_spread_node(cfs_cpt_tab, CFS_CPT_ANY);
+	struct inode *dir = parent->d_inode;
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_sb_info *sbi = ll_i2sbi(dir);
+	struct ll_statahead_info *sai = NULL;
+	struct ll_statahead_context *ctx = NULL;
+	struct task_struct *task;
+	int rc;
+
+	ENTRY;
+
+	if (unlikely(atomic_inc_return(&sbi->ll_sa_running) >
+				       sbi->ll_sa_running_max)) {
+		CDEBUG(D_READA,
+		       "Too many concurrent statahead instances, avoid new statahead instance temporarily.\n");
+		GOTO(out, rc = -EMFILE);
+	}
+
+	sai = ll_sai_alloc(parent);
+	if (!sai)
+		GOTO(out, rc = -ENOMEM);
+
+	ctx = ll_sax_alloc(dir);
+	if (!ctx)
+		GOTO(out, rc = -ENOMEM);
+
+	memcpy(sai->sai_fname, name->name, plen);
+	sai->sai_fstart = index + 1;
+	sai->sai_fend = ~0ULL;
+	sai->sai_fwidth = name->len - plen;
+	sai->sai_fname_auto = 1;
+	sai->sai_fused_time = ktime_get_seconds();
+
+	/* readdir driven or ladvise statahead is running, leave it alone */
+	spin_lock(&lli->lli_sa_lock);
+	if (lli->lli_sax || lli->lli_opendir_key) {
+		spin_unlock(&lli->lli_sa_lock);
+		GOTO(out, rc = -EBUSY);
+	}
+	lli->lli_sax = ctx;
+	lli->lli_sa_pattern = LSA_PATTERN_FNAME;
+	lli->lli_sa_enabled = 1;
+	spin_unlock(&lli->lli_sa_lock);
+
+	CDEBUG(D_READA,
+	       "%s: start FNAME statahead: [pid %d] [parent %pd] %.*s%0*llu\n",
+	       sbi->ll_fsname, current->pid, parent, plen, name->name,
+	       sai->sai_fwidth, sai->sai_fstart);
+
+	task = kthread_create_on_node(ll_statahead_thread, sai, node,
+				      "ll_sa_%u", current->pid);
+	if (IS_ERR(task)) {
+		rc = PTR_ERR(task);
+		CERROR("%s: cannot start ll_sa thread: rc = %d\n",
+		       sbi->ll_fsname, rc);
+		/* lookup may have taken @ctx already */
+		ll_sax_put(dir, ctx);
+		ctx = NULL;
+		GOTO(out, rc);
+	}
+
+	if (test_bit(LL_SBI_AGL_ENABLED, sbi->ll_flags))
+		ll_start_agl(parent, sai);
+
+	atomic_inc(&sbi->ll_sa_total);
+	sai->sai_task = task;
+	wake_up_process(task);
+
+	RETURN(0);
+out:
+	if (sai)
+		ll_sai_free(sai);
+
+	if (ctx)
+		ll_sax_free(ctx);
+
+	atomic_dec(&sbi->ll_sa_running);
+	RETURN(rc);
+}
+
+/**
+ * Watch the names looked up in a directory for a numeric suffix sequence,
+ * like "out.00000", "out.00001", ... which applications stat or open without
+ * reading the directory first. Once ll_sa_fname_hits lookups in a row follow
+ * the sequence, start statahead by file name for the names after @dentry, so
+ * that their attributes are fetched in batched getattr RPCs instead of one
+ * synchronous lookup per file.
+ *
+ * \param[in] dentry	dentry being looked up
+ */
+void ll_statahead_detect(struct dentry *dentry)
+{
+	struct dentry *parent = dentry->d_parent;
+	struct inode *dir = parent->d_inode;
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_sb_info *sbi = ll_i2sbi(dir);
+	const struct qstr *name = &dentry->d_name;
+	bool start = false;
+	__u64 index = 0;
+	__u32 hash;
+	int plen;
+	int i;
+
+	if (sbi->ll_sa_max == 0 || sbi->ll_sa_fname_hits == 0)
+		return;
+
+	/* at most 19 digits so that the suffix fits in __u64 */
+	for (plen = name->len; plen > 0; plen--)
+		if (!isdigit(name->name[plen - 1]))
+			break;
+	if (plen == name->len || name->len - plen > 19)
+		return;
+
+	for (i = plen; i < name->len; i++)
+		index = index * 10 + name->name[i] - '0';
+	hash = ll_full_name_hash(parent, name->name, plen);
+
+	spin_lock(&lli->lli_sa_lock);
+	if (lli->lli_sa_fname_hash == hash &&
+	    lli->lli_sa_fname_index + 1 == index) {
+		if (++lli->lli_sa_fname_hits >= sbi->ll_sa_fname_hits &&
+		    !lli->lli_sax && !lli->lli_opendir_key) {
+			lli->lli_sa_fname_hits = 0;
+			start = true;
+		}
+	} else {
+		lli->lli_sa_fname_hash = hash;
+		lli->lli_sa_fname_hits = 0;
+	}
+	lli->lli_sa_fname_index = index;
+	spin_unlock(&lli->lli_sa_lock);
+
+	if (start)
+		ll_statahead_fname_start(parent, name, plen, index);
+}
+
 int ll_ioctl_ahead(struct file *file, struct llapi_lu_ladvise2 *ladvise)
 {
 	int node = cfs_cpt_spread_node(cfs_cpt_tab, CFS_CPT_ANY);
@@ -275,18 +275,12 @@ static int __init lustre_init(void)
 
 	cl_inode_fini_env->le_ctx.lc_cookie = 0x4;
 
-	rc = ll_xattr_init();
-	if (rc != 0)
-		GOTO(out_inode_fini_env, rc);
-
 	rc = register_filesystem(&lustre_fs_type);
 	if (rc)
-		GOTO(out_xattr, rc);
+		GOTO(out_inode_fini_env, rc);
 
 	RETURN(0);
 
-out_xattr:
-	ll_xattr_fini();
 out_inode_fini_env:
 	cl_env_put(cl_inode_fini_env, &cl_inode_fini_refcheck);
 out_vvp:
@@ -306,7 +300,6 @@ static void __exit lustre_exit(void)
 
 	llite_tunables_unregister();
 
-	ll_xattr_fini();
 	cl_env_put(cl_inode_fini_env, &cl_inode_fini_refcheck);
 	vvp_global_fini();
 
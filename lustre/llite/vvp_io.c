@@ -574,8 +574,8 @@ static int vvp_io_rw_lock(const struct lu_env *env, struct cl_io *io,
 			io->ci_dio_lock = 1;
 
 		if (ll_file_nolock(vio->vui_fd->fd_file) ||
-		    (vio->vui_fd->fd_file->f_flags & O_DIRECT &&
-		     !io->ci_dio_lock))
+		    ((vio->vui_fd->fd_file->f_flags & O_DIRECT ||
+		      io->ci_hybrid_switched) && !io->ci_dio_lock))
 			ast_flags |= CEF_NEVER;
 	}
 
@@ -853,7 +853,7 @@ static int vvp_io_read_start(const struct lu_env *env,
 	if (!can_populate_pages(env, io, inode))
 		RETURN(0);
 
-	if (!(file->f_flags & O_DIRECT)) {
+	if (!(file->f_flags & O_DIRECT) && !io->ci_hybrid_switched) {
 		result = cl_io_lru_reserve(env, io, pos, crw_bytes);
 		if (result)
 			RETURN(result);
@@ -1321,7 +1321,7 @@ static int vvp_io_write_start(const struct lu_env *env,
 	if (CFS_FAIL_CHECK(OBD_FAIL_LLITE_IMUTEX_NOSEC) && lock_inode)
 		RETURN(-EINVAL);
 
-	if (!(file->f_flags & O_DIRECT)) {
+	if (!(file->f_flags & O_DIRECT) && !io->ci_hybrid_switched) {
 		result = cl_io_lru_reserve(env, io, pos, crw_bytes);
 		if (result)
 			RETURN(result);
@@ -1347,6 +1347,8 @@ static int vvp_io_write_start(const struct lu_env *env,
 		result = __generic_file_write_iter(vio->vui_iocb, &iter);
 		if (unlikely(lock_inode))
 			ll_inode_unlock(inode);
+		/* cl_pages preallocated by ll_write_begin() and not used */
+		cl_page_stash_drain(env);
 
 		written = result;
 		if (result > 0)
@@ -63,6 +63,29 @@ static void vvp_page_discard(const struct lu_env *env,
 		ll_ra_stats_inc(vmpage->mapping->host, RA_STAT_DISCARDED);
 }
 
+static void vvp_page_stale(const struct lu_env *env,
+			   const struct cl_page_slice *slice,
+			   struct cl_io *unused)
+{
+	struct cl_page *cp = slice->cpl_page;
+	struct page *vmpage = cp->cp_vmpage;
+	struct inode *inode = vmpage->mapping->host;
+
+	if (cp->cp_defer_uptodate && !cp->cp_ra_used)
+		ll_ra_stats_inc(inode, RA_STAT_DISCARDED);
+
+	/* the page has to go through ll_readpage() again, so forget that it
+	 * was read ahead, otherwise it would be made uptodate there */
+	cp->cp_defer_uptodate = 0;
+	cp->cp_ra_used = 0;
+	cp->cp_ra_updated = 0;
+
+	/* see vvp_page_delete() */
+	write_seqlock(&ll_i2info(inode)->lli_page_inv_lock);
+	ClearPageUptodate(vmpage);
+	write_sequnlock(&ll_i2info(inode)->lli_page_inv_lock);
+}
+
 static void vvp_page_delete(const struct lu_env *env,
 			    const struct cl_page_slice *slice)
 {
@@ -197,6 +220,7 @@ static void vvp_page_completion_write(const struct lu_env *env,
 static const struct cl_page_operations vvp_page_ops = {
 	.cpo_delete	   = vvp_page_delete,
 	.cpo_discard       = vvp_page_discard,
+	.cpo_stale	   = vvp_page_stale,
 	.io = {
 		[CRT_READ] = {
 			.cpo_completion = vvp_page_completion_read,
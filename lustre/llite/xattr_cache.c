@@ -41,36 +41,45 @@
 
 /* If we ever have hundreds of extended attributes, we might want to consider
  * using a hash or a tree structure instead of list for faster lookups.
+ *
+ * The name and the value are stored right after the entry. The entries
+ * filled from an MDT reply are all carved from a single per-inode arena
+ * (lli_xattrs_arena), other entries are allocated one by one.
  */
 struct ll_xattr_entry {
 	struct list_head	xe_list;    /* protected with
 					     * lli_xattrs_list_rwsem */
-	char			*xe_name;   /* xattr name, \0-terminated */
-	char			*xe_value;  /* xattr value */
-	unsigned		xe_namelen; /* strlen(xe_name) + 1 */
-	unsigned		xe_vallen;  /* xattr value length */
+	char			*xe_value;  /* xattr value, after xe_name */
+	unsigned int		xe_namelen; /* strlen(xe_name) + 1 */
+	unsigned int		xe_vallen;  /* xattr value length */
+	unsigned int		xe_arena:1; /* in lli_xattrs_arena */
+	char			xe_name[];  /* xattr name, \0-terminated */
 };
 
-static struct kmem_cache *xattr_kmem;
-static struct lu_kmem_descr xattr_caches[] = {
-	{
-		.ckd_cache = &xattr_kmem,
-		.ckd_name  = "xattr_kmem",
-		.ckd_size  = sizeof(struct ll_xattr_entry)
-	},
-	{
-		.ckd_cache = NULL
-	}
-};
+static inline size_t ll_xattr_entry_size(unsigned int namelen,
+					 unsigned int vallen)
+{
+	return ALIGN(sizeof(struct ll_xattr_entry) + namelen + vallen,
+		     sizeof(void *));
+}
 
-int ll_xattr_init(void)
+static void ll_xattr_entry_init(struct ll_xattr_entry *xattr,
+				const char *xattr_name, unsigned int namelen,
+				const char *xattr_val, unsigned int vallen)
 {
-	return lu_kmem_init(xattr_caches);
+	xattr->xe_namelen = namelen;
+	xattr->xe_vallen = vallen;
+	xattr->xe_value = xattr->xe_name + namelen;
+	memcpy(xattr->xe_name, xattr_name, namelen);
+	memcpy(xattr->xe_value, xattr_val, vallen);
 }
 
-void ll_xattr_fini(void)
+static void ll_xattr_entry_free(struct ll_xattr_entry *xattr)
 {
-	lu_kmem_fini(xattr_caches);
+	list_del(&xattr->xe_list);
+	if (!xattr->xe_arena)
+		OBD_FREE(xattr, ll_xattr_entry_size(xattr->xe_namelen,
+						    xattr->xe_vallen));
 }
 
 /**
@@ -135,6 +144,7 @@ static int ll_xattr_cache_add(struct list_head *cache,
 			      unsigned xattr_val_len)
 {
 	struct ll_xattr_entry *xattr;
+	unsigned int namelen;
 
 	ENTRY;
 
@@ -150,42 +160,21 @@ static int ll_xattr_cache_add(struct list_head *cache,
 		RETURN(-EPROTO);
 	}
 
-	OBD_SLAB_ALLOC_PTR_GFP(xattr, xattr_kmem, GFP_NOFS);
+	namelen = strlen(xattr_name) + 1;
+	OBD_ALLOC(xattr, ll_xattr_entry_size(namelen, xattr_val_len));
 	if (xattr == NULL) {
-		CDEBUG(D_CACHE, "failed to allocate xattr\n");
+		CDEBUG(D_CACHE, "failed to allocate xattr %s\n", xattr_name);
 		RETURN(-ENOMEM);
 	}
 
-	xattr->xe_namelen = strlen(xattr_name) + 1;
-
-	OBD_ALLOC(xattr->xe_name, xattr->xe_namelen);
-	if (!xattr->xe_name) {
-		CDEBUG(D_CACHE, "failed to alloc xattr name %u\n",
-		       xattr->xe_namelen);
-		goto err_name;
-	}
-	OBD_ALLOC(xattr->xe_value, xattr_val_len);
-	if (!xattr->xe_value) {
-		CDEBUG(D_CACHE, "failed to alloc xattr value %d\n",
-		       xattr_val_len);
-		goto err_value;
-	}
-
-	memcpy(xattr->xe_name, xattr_name, xattr->xe_namelen);
-	memcpy(xattr->xe_value, xattr_val, xattr_val_len);
-	xattr->xe_vallen = xattr_val_len;
+	ll_xattr_entry_init(xattr, xattr_name, namelen, xattr_val,
+			    xattr_val_len);
 	list_add(&xattr->xe_list, cache);
 
 	CDEBUG(D_CACHE, "set: [%s]=%.*s\n", xattr_name,
 		xattr_val_len, xattr_val);
 
 	RETURN(0);
-err_value:
-	OBD_FREE(xattr->xe_name, xattr->xe_namelen);
-err_name:
-	OBD_SLAB_FREE_PTR(xattr, xattr_kmem);
-
-	RETURN(-ENOMEM);
 }
 
 /**
@@ -206,10 +195,7 @@ static int ll_xattr_cache_del(struct list_head *cache,
 	CDEBUG(D_CACHE, "del xattr: %s\n", xattr_name);
 
 	if (ll_xattr_cache_find(cache, xattr_name, &xattr) == 0) {
-		list_del(&xattr->xe_list);
-		OBD_FREE(xattr->xe_name, xattr->xe_namelen);
-		OBD_FREE(xattr->xe_value, xattr->xe_vallen);
-		OBD_SLAB_FREE_PTR(xattr, xattr_kmem);
+		ll_xattr_entry_free(xattr);
 
 		RETURN(0);
 	}
@@ -278,6 +264,27 @@ static int ll_xattr_cache_filled(struct ll_inode_info *lli)
 	return test_bit(LLIF_XATTR_CACHE_FILLED, &lli->lli_flags);
 }
 
+/**
+ * Free the arena of xattrs filled from an MDT reply, and drop its
+ * entries from the cache of @lli.
+ */
+static void ll_xattr_cache_arena_free(struct ll_inode_info *lli)
+{
+	struct ll_xattr_entry *xattr, *tmp;
+
+	if (lli->lli_xattrs_arena == NULL)
+		return;
+
+	list_for_each_entry_safe(xattr, tmp, &lli->lli_xattrs, xe_list) {
+		if (xattr->xe_arena)
+			list_del(&xattr->xe_list);
+	}
+
+	OBD_FREE_LARGE(lli->lli_xattrs_arena, lli->lli_xattrs_arena_size);
+	lli->lli_xattrs_arena = NULL;
+	lli->lli_xattrs_arena_size = 0;
+}
+
 /**
  * This finalizes the xattr cache.
  *
@@ -294,6 +301,7 @@ static int ll_xattr_cache_destroy_locked(struct ll_inode_info *lli)
 
 	while (ll_xattr_cache_del(&lli->lli_xattrs, NULL) == 0)
 		/* empty loop */ ;
+	ll_xattr_cache_arena_free(lli);
 
 	clear_bit(LLIF_XATTR_CACHE_FILLED, &lli->lli_flags);
 	clear_bit(LLIF_XATTR_CACHE, &lli->lli_flags);
@@ -324,7 +332,8 @@ int ll_xattr_cache_destroy(struct inode *inode)
 int ll_xattr_cache_empty(struct inode *inode)
 {
 	struct ll_inode_info *lli = ll_i2info(inode);
-	struct ll_xattr_entry *entry, *n;
+	struct ll_xattr_entry *entry, *n, *encctx = NULL;
+	int rc;
 
 	ENTRY;
 
@@ -334,15 +343,26 @@ int ll_xattr_cache_empty(struct inode *inode)
 		GOTO(out_empty, 0);
 
 	list_for_each_entry_safe(entry, n, &lli->lli_xattrs, xe_list) {
-		if (strcmp(entry->xe_name, xattr_for_enc(inode)) == 0)
+		if (strcmp(entry->xe_name, xattr_for_enc(inode)) == 0) {
+			if (entry->xe_arena)
+				encctx = entry;
 			continue;
+		}
 
 		CDEBUG(D_CACHE, "delete: %s\n", entry->xe_name);
-		list_del(&entry->xe_list);
-		OBD_FREE(entry->xe_name, entry->xe_namelen);
-		OBD_FREE(entry->xe_value, entry->xe_vallen);
-		OBD_SLAB_FREE_PTR(entry, xattr_kmem);
+		ll_xattr_entry_free(entry);
+	}
+
+	/* move encryption context out of the arena before freeing it */
+	if (encctx != NULL) {
+		list_del(&encctx->xe_list);
+		rc = ll_xattr_cache_add(&lli->lli_xattrs, encctx->xe_name,
+					encctx->xe_value, encctx->xe_vallen);
+		if (rc)
+			CDEBUG(D_CACHE, "cannot keep %s: rc = %d\n",
+			       encctx->xe_name, rc);
 	}
+	ll_xattr_cache_arena_free(lli);
 	clear_bit(LLIF_XATTR_CACHE_FILLED, &lli->lli_flags);
 
 out_empty:
@@ -350,6 +370,119 @@ out_empty:
 	RETURN(0);
 }
 
+/**
+ * Check if the xattr @name is cached with the other xattrs of a file.
+ */
+static bool ll_xattr_cache_wanted(const char *name)
+{
+	if (!strcmp(name, XATTR_NAME_ACL_ACCESS)) {
+		/* Filter out ACL ACCESS since it's cached separately */
+		CDEBUG(D_CACHE, "not caching %s\n", XATTR_NAME_ACL_ACCESS);
+		return false;
+	}
+	if (ll_xattr_is_seclabel(name)) {
+		/* Filter out security label, it is cached in slab */
+		CDEBUG(D_CACHE, "not caching %s\n", name);
+		return false;
+	}
+	if (!strcmp(name, XATTR_NAME_SOM)) {
+		/* Filter out trusted.som, it is not cached on client */
+		CDEBUG(D_CACHE, "not caching trusted.som\n");
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Fill the xattr cache from an MDT reply.
+ *
+ * Cache the @count xattrs with names in @xdata, values in @xval and value
+ * lengths in @xsizes. All the entries are allocated in one arena attached
+ * to @lli, replacing the arena of a previous incomplete fill.
+ *
+ * \retval 0       no error occured
+ * \retval -EPROTO network protocol error
+ * \retval -ENOMEM not enough memory for the cache
+ */
+static int ll_xattr_cache_fill(struct ll_inode_info *lli,
+			       const char *xdata, int xdatalen,
+			       const char *xval, int xvallen,
+			       const __u32 *xsizes, int count)
+{
+	const char *xtail = xdata + xdatalen;
+	const char *xvtail = xval + xvallen;
+	const char *name, *val;
+	struct ll_xattr_entry *xattr;
+	size_t size = 0;
+	char *arena = NULL;
+	int i;
+
+	ENTRY;
+
+	CDEBUG(D_CACHE, "caching: xdata=%p xtail=%p\n", xdata, xtail);
+
+	/* Perform consistency checks: attr names and vals in pill */
+	for (i = 0, name = xdata, val = xval; i < count; i++) {
+		if (name >= xtail || memchr(name, 0, xtail - name) == NULL) {
+			CERROR("xattr protocol violation (names are broken)\n");
+			RETURN(-EPROTO);
+		}
+		if (xsizes[i] > xvtail - val) {
+			CERROR("xattr protocol violation (vals are broken)\n");
+			RETURN(-EPROTO);
+		}
+		if (ll_xattr_cache_wanted(name))
+			size += ll_xattr_entry_size(strlen(name) + 1,
+						    xsizes[i]);
+		name += strlen(name) + 1;
+		val += xsizes[i];
+	}
+
+	if (CFS_FAIL_CHECK(OBD_FAIL_LLITE_XATTR_ENOMEM))
+		RETURN(-ENOMEM);
+
+	ll_xattr_cache_arena_free(lli);
+	if (size > 0) {
+		OBD_ALLOC_LARGE(arena, size);
+		if (arena == NULL)
+			RETURN(-ENOMEM);
+		lli->lli_xattrs_arena = arena;
+		lli->lli_xattrs_arena_size = size;
+	}
+
+	for (i = 0, name = xdata, val = xval; i < count;
+	     name += strlen(name) + 1, val += xsizes[i], i++) {
+		unsigned int namelen = strlen(name) + 1;
+
+		CDEBUG(D_CACHE, "caching [%s]=%.*s\n", name, xsizes[i], val);
+		if (!ll_xattr_cache_wanted(name))
+			continue;
+
+		if (ll_xattr_cache_find(&lli->lli_xattrs, name, &xattr) == 0) {
+			/* encryption context was already in cache */
+			if (!strcmp(name, LL_XATTR_NAME_ENCRYPTION_CONTEXT) ||
+			    !strcmp(name, LL_XATTR_NAME_ENCRYPTION_CONTEXT_OLD))
+				continue;
+
+			CDEBUG(D_CACHE, "duplicate xattr: [%s]\n", name);
+			RETURN(-EPROTO);
+		}
+
+		xattr = (struct ll_xattr_entry *)arena;
+		arena += ll_xattr_entry_size(namelen, xsizes[i]);
+		ll_xattr_entry_init(xattr, name, namelen, val, xsizes[i]);
+		xattr->xe_arena = 1;
+		list_add(&xattr->xe_list, &lli->lli_xattrs);
+	}
+
+	if (name != xtail || val != xvtail)
+		CERROR("a hole in xattr data\n");
+	else
+		set_bit(LLIF_XATTR_CACHE_FILLED, &lli->lli_flags);
+
+	RETURN(0);
+}
+
 /**
  * Match or enqueue a PR lock.
  *
@@ -435,11 +568,11 @@ static int ll_xattr_cache_refill(struct inode *inode)
 	struct lookup_intent oit = { .it_op = IT_GETXATTR };
 	struct ll_sb_info *sbi = ll_i2sbi(inode);
 	struct ptlrpc_request *req = NULL;
-	const char *xdata, *xval, *xtail, *xvtail;
+	const char *xdata, *xval;
 	struct ll_inode_info *lli = ll_i2info(inode);
 	struct mdt_body *body;
 	__u32 *xsizes;
-	int rc = 0, i;
+	int rc = 0;
 
 	ENTRY;
 
@@ -481,56 +614,17 @@ static int ll_xattr_cache_refill(struct inode *inode)
 		GOTO(err_cancel, rc = -EPROTO);
 	}
 
-	xtail = xdata + body->mbo_eadatasize;
-	xvtail = xval + body->mbo_aclsize;
-
-	CDEBUG(D_CACHE, "caching: xdata=%p xtail=%p\n", xdata, xtail);
-
 	if (!ll_xattr_cache_valid(lli))
 		ll_xattr_cache_init(lli);
 
-	for (i = 0; i < body->mbo_max_mdsize; i++) {
-		CDEBUG(D_CACHE, "caching [%s]=%.*s\n", xdata, *xsizes, xval);
-		/* Perform consistency checks: attr names and vals in pill */
-		if (memchr(xdata, 0, xtail - xdata) == NULL) {
-			CERROR("xattr protocol violation (names are broken)\n");
-			rc = -EPROTO;
-		} else if (xval + *xsizes > xvtail) {
-			CERROR("xattr protocol violation (vals are broken)\n");
-			rc = -EPROTO;
-		} else if (CFS_FAIL_CHECK(OBD_FAIL_LLITE_XATTR_ENOMEM)) {
-			rc = -ENOMEM;
-		} else if (!strcmp(xdata, XATTR_NAME_ACL_ACCESS)) {
-			/* Filter out ACL ACCESS since it's cached separately */
-			CDEBUG(D_CACHE, "not caching %s\n",
-			       XATTR_NAME_ACL_ACCESS);
-			rc = 0;
-		} else if (ll_xattr_is_seclabel(xdata)) {
-			/* Filter out security label, it is cached in slab */
-			CDEBUG(D_CACHE, "not caching %s\n", xdata);
-			rc = 0;
-		} else if (!strcmp(xdata, XATTR_NAME_SOM)) {
-			/* Filter out trusted.som, it is not cached on client */
-			CDEBUG(D_CACHE, "not caching trusted.som\n");
-			rc = 0;
-		} else {
-			rc = ll_xattr_cache_add(&lli->lli_xattrs, xdata, xval,
-						*xsizes);
-		}
-		if (rc < 0) {
-			ll_xattr_cache_destroy_locked(lli);
-			GOTO(err_cancel, rc);
-		}
-		xdata += strlen(xdata) + 1;
-		xval  += *xsizes;
-		xsizes++;
+	rc = ll_xattr_cache_fill(lli, xdata, body->mbo_eadatasize,
+				 xval, body->mbo_aclsize,
+				 xsizes, body->mbo_max_mdsize);
+	if (rc < 0) {
+		ll_xattr_cache_destroy_locked(lli);
+		GOTO(err_cancel, rc);
 	}
 
-	if (xdata != xtail || xval != xvtail)
-		CERROR("a hole in xattr data\n");
-	else
-		set_bit(LLIF_XATTR_CACHE_FILLED, &lli->lli_flags);
-
 	ll_set_lock_data(sbi->ll_md_exp, inode, &oit, NULL);
 	ll_intent_drop_lock(&oit);
 
@@ -669,3 +763,67 @@ int ll_xattr_cache_insert(struct inode *inode,
 	up_write(&lli->lli_xattrs_list_rwsem);
 	RETURN(rc);
 }
+
+/**
+ * Prefill the xattr cache from a getattr or open intent reply.
+ *
+ * The MDT packs all xattrs of the file into the reply if the client asked
+ * for them and the XATTR ibit is granted, see mdt_pack_xattrs_in_reply().
+ * Cache them for @inode if the lock with @bits is attached to it, this
+ * saves the IT_GETXATTR RPC of the first getxattr or listxattr.
+ */
+void ll_xattr_cache_prefill(struct inode *inode, struct req_capsule *pill,
+			    __u64 bits)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	const char *xdata, *xval;
+	struct mdt_body *body;
+	__u32 *xsizes;
+	int xdatalen, xvallen, count;
+	int rc = 0;
+
+	ENTRY;
+
+	if (!(bits & MDS_INODELOCK_XATTR) ||
+	    !ll_i2sbi(inode)->ll_xattr_cache_enabled)
+		RETURN_EXIT;
+
+	body = req_capsule_server_get(pill, &RMF_MDT_BODY);
+	if (body == NULL ||
+	    (body->mbo_valid & OBD_MD_FLXATTRALL) != OBD_MD_FLXATTRALL ||
+	    !req_capsule_has_field(pill, &RMF_EAVALS_LENS, RCL_SERVER) ||
+	    !req_capsule_field_present(pill, &RMF_EAVALS_LENS, RCL_SERVER))
+		RETURN_EXIT;
+
+	xdatalen = req_capsule_get_size(pill, &RMF_EADATA, RCL_SERVER);
+	xvallen = req_capsule_get_size(pill, &RMF_EAVALS, RCL_SERVER);
+	count = req_capsule_get_size(pill, &RMF_EAVALS_LENS, RCL_SERVER) /
+		sizeof(__u32);
+	/* do not need swab xattr data */
+	xdata = req_capsule_server_sized_get(pill, &RMF_EADATA, xdatalen);
+	xval = req_capsule_server_sized_get(pill, &RMF_EAVALS, xvallen);
+	xsizes = req_capsule_server_sized_get(pill, &RMF_EAVALS_LENS,
+					      count * sizeof(__u32));
+	if (count > 0 && (xdata == NULL || xsizes == NULL ||
+			  (xvallen > 0 && xval == NULL))) {
+		CERROR("%s: wrong xattrs in reply for "DFID"\n",
+		       ll_i2sbi(inode)->ll_fsname, PFID(ll_inode2fid(inode)));
+		RETURN_EXIT;
+	}
+
+	down_write(&lli->lli_xattrs_list_rwsem);
+	if (!ll_xattr_cache_filled(lli)) {
+		if (!ll_xattr_cache_valid(lli))
+			ll_xattr_cache_init(lli);
+		rc = ll_xattr_cache_fill(lli, xdata, xdatalen, xval, xvallen,
+					 xsizes, count);
+		if (rc < 0)
+			ll_xattr_cache_destroy_locked(lli);
+	}
+	up_write(&lli->lli_xattrs_list_rwsem);
+
+	CDEBUG(D_CACHE, "%s: prefilled %d xattrs for "DFID": rc = %d\n",
+	       ll_i2sbi(inode)->ll_fsname, count, PFID(ll_inode2fid(inode)),
+	       rc);
+	EXIT;
+}
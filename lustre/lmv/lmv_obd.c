@@ -4126,6 +4126,36 @@ lmv_batch_locate_tgt(struct lmv_obd *lmv, struct md_op_item *item)
 
 		break;
 	}
+	/*
+	 * A batched unlink is neither retried nor redirected, one which may
+	 * need it is left to the synchronous md_unlink().
+	 */
+	case MD_OP_UNLINK: {
+		struct lmv_tgt_desc *ptgt;
+
+		if (lmv_dir_bad_hash(op_data->op_lso1) ||
+		    lmv_dir_layout_changing(op_data->op_lso1) ||
+		    fid_is_zero(&op_data->op_fid2))
+			RETURN(ERR_PTR(-EOPNOTSUPP));
+
+		ptgt = lmv_locate_tgt(lmv, op_data);
+		if (IS_ERR(ptgt))
+			RETURN(ptgt);
+
+		tgt = lmv_fid2tgt(lmv, &op_data->op_fid2);
+		if (IS_ERR(tgt))
+			RETURN(tgt);
+
+		/* a remote child is unlinked on both MDTs */
+		if (tgt != ptgt)
+			RETURN(ERR_PTR(-EREMOTE));
+
+		op_data->op_fsuid = from_kuid(&init_user_ns, current_fsuid());
+		op_data->op_fsgid = from_kgid(&init_user_ns, current_fsgid());
+		op_data->op_cap = current_cap();
+		op_data->op_flags |= MF_MDC_CANCEL_FID1 | MF_MDC_CANCEL_FID3;
+		break;
+	}
 	default:
 		tgt = ERR_PTR(-ENOTSUPP);
 	}
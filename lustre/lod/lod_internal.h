@@ -187,6 +187,9 @@ struct lod_layout_component {
 			__u16			  llc_stripe_offset;
 			__u16			  llc_stripe_count;
 			__u16			  llc_stripes_allocated;
+			__u8			  llc_compr_type;
+			__u8			  llc_compr_lvl;
+			__u8			  llc_compr_chunk_log_bits;
 			char			 *llc_pool;
 			/* ost list specified by LOV_USER_MAGIC_SPECIFIC lum */
 			struct lu_tgt_pool	  llc_ostlist;
@@ -651,6 +654,28 @@ lod_comp_inited(const struct lod_layout_component *entry)
 	return entry->llc_flags & LCME_FL_INIT;
 }
 
+static inline bool
+lod_comp_is_compr(const struct lod_layout_component *entry)
+{
+	return lov_pattern(entry->llc_pattern) & LOV_PATTERN_COMPRESS;
+}
+
+/**
+ * Take the compression parameters of \a entry from its composite layout
+ * entry, must be called after llc_pattern is set.
+ */
+static inline void
+lod_comp_set_compr(struct lod_layout_component *entry,
+		   const struct lov_comp_md_entry_v1 *lcme)
+{
+	if (!lod_comp_is_compr(entry))
+		return;
+
+	entry->llc_compr_type = lcme->lcme_compr_type;
+	entry->llc_compr_lvl = lcme->lcme_compr_lvl;
+	entry->llc_compr_chunk_log_bits = lcme->lcme_compr_chunk_log_bits;
+}
+
 /**
  * For a PFL file, some of its component could be un-instantiated, so
  * that their lov_ost_data_v1 array is not needed, we'd use this function
@@ -990,6 +990,12 @@ int lod_generate_lovea(const struct lu_env *env, struct lod_object *lo,
 		lcme->lcme_extent.e_end =
 			cpu_to_le64(lod_comp->llc_extent.e_end);
 		lcme->lcme_offset = cpu_to_le32(offset);
+		if (lod_comp_is_compr(lod_comp)) {
+			lcme->lcme_compr_type = lod_comp->llc_compr_type;
+			lcme->lcme_compr_lvl = lod_comp->llc_compr_lvl;
+			lcme->lcme_compr_chunk_log_bits =
+				lod_comp->llc_compr_chunk_log_bits;
+		}
 
 		sub_md = (struct lov_mds_md *)((char *)lcm + offset);
 		if (lod_comp->llc_magic == LOV_MAGIC_FOREIGN) {
@@ -1454,6 +1460,8 @@ int lod_parse_striping(const struct lu_env *env, struct lod_object *lo,
 		lod_comp->llc_stripe_size = le32_to_cpu(lmm->lmm_stripe_size);
 		lod_comp->llc_stripe_count = le16_to_cpu(lmm->lmm_stripe_count);
 		lod_comp->llc_layout_gen = le16_to_cpu(lmm->lmm_layout_gen);
+		if (comp_v1)
+			lod_comp_set_compr(lod_comp, &comp_v1->lcm_entries[i]);
 
 		if (lmm->lmm_magic == cpu_to_le32(LOV_MAGIC_V3)) {
 			struct lov_mds_md_v3 *v3 = (struct lov_mds_md_v3 *)lmm;
@@ -2135,6 +2143,13 @@ int lod_verify_striping(const struct lu_env *env, struct lod_device *d,
 			CDEBUG(D_LAYOUT, "DoM without composite layout\n");
 			RETURN(-EINVAL);
 		}
+		if (lov_pattern(le32_to_cpu(lum->lmm_pattern)) &
+		    LOV_PATTERN_COMPRESS) {
+			/* compression is kept in the component entry */
+			CDEBUG(D_LAYOUT,
+			       "compression without composite layout\n");
+			RETURN(-EINVAL);
+		}
 		RETURN(lod_verify_v1v3(d, buf, is_from_disk));
 	case LOV_USER_MAGIC_COMP_V1:
 	case LOV_USER_MAGIC_SEL:
@@ -2339,6 +2354,18 @@ recheck:
 			}
 		}
 
+		if (lov_pattern(le32_to_cpu(lum->lmm_pattern)) &
+		    LOV_PATTERN_COMPRESS &&
+		    !lov_compr_params_valid(ent->lcme_compr_type,
+					    ent->lcme_compr_lvl,
+					    ent->lcme_compr_chunk_log_bits)) {
+			CDEBUG(D_LAYOUT,
+			       "invalid compression type %u level %u chunk bits %u\n",
+			       ent->lcme_compr_type, ent->lcme_compr_lvl,
+			       ent->lcme_compr_chunk_log_bits);
+			RETURN(-EINVAL);
+		}
+
 		prev_end = le64_to_cpu(ext->e_end);
 
 		rc = lod_verify_v1v3(d, &tmp, is_from_disk);
@@ -2846,6 +2846,10 @@ static int lod_declare_layout_add(const struct lu_env *env,
 				DIV_ROUND_UP(ext->e_end - ext->e_start,
 					     lod_comp->llc_stripe_size);
 		lod_adjust_stripe_info(lod_comp, desc, 0);
+		if (lov_pattern(v1->lmm_pattern) & LOV_PATTERN_COMPRESS) {
+			lod_comp->llc_pattern = v1->lmm_pattern;
+			lod_comp_set_compr(lod_comp, &comp_v1->lcm_entries[i]);
+		}
 
 		if (v1->lmm_magic == LOV_USER_MAGIC_V3) {
 			struct lov_user_md_v3 *v3 = (typeof(*v3) *) v1;
@@ -5461,6 +5465,8 @@ static int lod_get_default_lov_striping(const struct lu_env *env,
 
 		if (append_stripe_count != 0 || append_pool != NULL)
 			llc->llc_pattern = LOV_PATTERN_RAID0;
+		else if (want_composite)
+			lod_comp_set_compr(llc, &lcm->lcm_entries[i]);
 
 		if (append_stripe_count != 0)
 			llc->llc_stripe_count = append_stripe_count;
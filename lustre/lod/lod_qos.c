@@ -2235,6 +2235,8 @@ int lod_use_defined_striping(const struct lu_env *env,
 					     lod_comp->llc_extent.e_start,
 					     lod_comp->llc_stripe_size);
 		lod_comp->llc_layout_gen = le16_to_cpu(v1->lmm_layout_gen);
+		if (mo->ldo_is_composite)
+			lod_comp_set_compr(lod_comp, &comp_v1->lcm_entries[i]);
 		/**
 		 * The stripe_offset of an uninit-ed component is stored in
 		 * the lmm_layout_gen
@@ -2538,6 +2540,8 @@ int lod_qos_parse_config(const struct lu_env *env, struct lod_object *lo,
 				DIV_ROUND_UP(lod_comp->llc_extent.e_end -
 					     lod_comp->llc_extent.e_start,
 					     lod_comp->llc_stripe_size);
+		if (lo->ldo_is_composite)
+			lod_comp_set_compr(lod_comp, &comp_v1->lcm_entries[i]);
 
 		lod_comp->llc_stripe_offset = v1->lmm_stripe_offset;
 		lod_qos_set_pool(lo, i, pool_name, v1);
@@ -161,6 +161,24 @@ static void lsme_free(struct lov_stripe_md_entry *lsme)
 	OBD_FREE_LARGE(lsme, lsme_size);
 }
 
+/* OSC compresses the writes of an object by its lov_oinfo */
+static void lsme_set_compr(struct lov_stripe_md_entry *lsme)
+{
+	unsigned int i;
+
+	if (!lsme_inited(lsme) || lsme->lsme_pattern & LOV_PATTERN_F_RELEASED)
+		return;
+
+	for (i = 0; i < lsme->lsme_stripe_count; i++) {
+		struct lov_oinfo *loi = lsme->lsme_oinfo[i];
+
+		loi->loi_compr_type = lsme->lsme_compr_type;
+		loi->loi_compr_lvl = lsme->lsme_compr_lvl;
+		loi->loi_compr_chunk_bits = COMPR_CHUNK_MIN_BITS +
+					    lsme->lsme_compr_chunk_log_bits;
+	}
+}
+
 void lsm_free(struct lov_stripe_md *lsm)
 {
 	unsigned int entry_count = lsm->lsm_entry_count;
@@ -572,6 +590,25 @@ lsm_unpackmd_comp_md_v1(struct lov_obd *lov, void *buf, size_t buf_size)
 				le64_to_cpu(lcme->lcme_timestamp);
 		lu_extent_le_to_cpu(&lsme->lsme_extent, &lcme->lcme_extent);
 
+		if (lsme_is_compr(lsme)) {
+			lsme->lsme_compr_type = lcme->lcme_compr_type;
+			lsme->lsme_compr_lvl = lcme->lcme_compr_lvl;
+			lsme->lsme_compr_chunk_log_bits =
+				lcme->lcme_compr_chunk_log_bits;
+			if (!lov_compr_params_valid(lsme->lsme_compr_type,
+					lsme->lsme_compr_lvl,
+					lsme->lsme_compr_chunk_log_bits)) {
+				CERROR("%s: bad compression type %u level %u chunk bits %u in LCM entry %u\n",
+				       (char *)lov->desc.ld_uuid.uuid,
+				       lsme->lsme_compr_type,
+				       lsme->lsme_compr_lvl,
+				       lsme->lsme_compr_chunk_log_bits,
+				       lsme->lsme_id);
+				GOTO(out_lsm, rc = -EINVAL);
+			}
+			lsme_set_compr(lsme);
+		}
+
 		if (i == entry_count - 1) {
 			lsm->lsm_maxbytes = (loff_t)lsme->lsme_extent.e_start +
 					    maxbytes;
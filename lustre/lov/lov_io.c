@@ -981,6 +981,15 @@ static int lov_io_rw_iter_init(const struct lu_env *env,
 	if (lse->lsme_stripe_count > 1) {
 		unsigned long ssize = lse->lsme_stripe_size;
 
+		/*
+		 * Direct I/O is submitted without waiting, so one iteration
+		 * covers a whole stripe round: the locks of all stripes are
+		 * enqueued together and each OSC gets its RPCs at once,
+		 * instead of filling the stripes one after the other.
+		 */
+		if (io->ci_dio_aio != NULL && !lsme_is_compr(lse))
+			ssize *= lse->lsme_stripe_count;
+
 		start = div64_u64(start, ssize);
 		next = (start + 1) * ssize;
 		if (next <= start * ssize)
@@ -1003,8 +1012,9 @@ static int lov_io_rw_iter_init(const struct lu_env *env,
 	       (__u64)lio->lis_io_endpos, io->u.ci_rw.crw_bytes);
 
 	/*
-	 * XXX The following call should be optimized: we know, that
-	 * [lio->lis_pos, lio->lis_endpos) intersects with exactly one stripe.
+	 * [lio->lis_pos, lio->lis_endpos) intersects with one stripe, or with
+	 * every stripe of one round for direct I/O, lov_io_iter_init() only
+	 * sets up the sub-I/Os of the stripes that it intersects.
 	 */
 	RETURN(lov_io_iter_init(env, ios));
 }
@@ -1352,17 +1362,16 @@ static int lov_io_submit(const struct lu_env *env,
 		cl_page_list_move(&cl2q->c2_qin, qin, page);
 
 		index = page->cp_lov_index;
-		/* DIO is already split by stripe */
-		if (!dio) {
-			cl_page_list_for_each_safe(page, tmp, qin) {
-				/* this page is not on this stripe */
-				if (index != page->cp_lov_index)
-					continue;
-
-				cl_page_list_move(&cl2q->c2_qin, qin, page);
+		/* DIO pages are in file order, take the run on this stripe */
+		cl_page_list_for_each_safe(page, tmp, qin) {
+			/* this page is not on this stripe */
+			if (index != page->cp_lov_index) {
+				if (dio)
+					break;
+				continue;
 			}
-		} else {
-			cl_page_list_splice(qin, &cl2q->c2_qin);
+
+			cl_page_list_move(&cl2q->c2_qin, qin, page);
 		}
 
 		sub = lov_sub_get(env, lio, index);
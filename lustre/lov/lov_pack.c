@@ -236,6 +236,12 @@ ssize_t lov_lsm_pack(const struct lov_stripe_md *lsm, void *buf,
 		lcme->lcme_extent.e_end =
 			cpu_to_le64(lsme->lsme_extent.e_end);
 		lcme->lcme_offset = cpu_to_le32(offset);
+		if (lsme_is_compr(lsme)) {
+			lcme->lcme_compr_type = lsme->lsme_compr_type;
+			lcme->lcme_compr_lvl = lsme->lsme_compr_lvl;
+			lcme->lcme_compr_chunk_log_bits =
+				lsme->lsme_compr_chunk_log_bits;
+		}
 
 		lmm = (struct lov_mds_md *)((char *)lcmv1 + offset);
 		lmm->lmm_magic = cpu_to_le32(lsme->lsme_magic);
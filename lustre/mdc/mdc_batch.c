@@ -171,8 +171,64 @@ static int mdc_batch_getattr_pack(struct batch_update_head *head,
 	RETURN(rc);
 }
 
+/*
+ * The reint sub requests are packed like their MDS_REINT counterparts, but
+ * the early lock cancels are sent asynchronously by mdc_batch_add() rather
+ * than in their RMF_DLM_REQ, and no SELinux policy is sent for them.
+ */
+static int mdc_batch_reint_size(struct req_capsule *pill,
+				size_t *max_pack_size)
+{
+	__u32 size;
+
+	req_capsule_set_size(pill, &RMF_DLM_REQ, RCL_CLIENT, 0);
+	req_capsule_set_size(pill, &RMF_SELINUX_POL, RCL_CLIENT, 0);
+
+	size = req_capsule_msg_size(pill, RCL_CLIENT);
+	if (unlikely(size >= *max_pack_size)) {
+		*max_pack_size = size;
+		return -E2BIG;
+	}
+
+	*max_pack_size = size;
+	return 0;
+}
+
+static int mdc_batch_unlink_pack(struct batch_update_head *head,
+				 struct lustre_msg *reqmsg,
+				 size_t *max_pack_size,
+				 struct md_op_item *item)
+{
+	struct obd_export *exp = head->buh_exp;
+	struct md_op_data *op_data = &item->mop_data;
+	struct req_capsule pill;
+	int rc;
+
+	ENTRY;
+
+	req_capsule_subreq_init(&pill, &RQF_BUT_UNLINK, NULL,
+				reqmsg, NULL, RCL_CLIENT);
+
+	req_capsule_set_size(&pill, &RMF_NAME, RCL_CLIENT,
+			     op_data->op_namelen + 1);
+
+	rc = mdc_batch_reint_size(&pill, max_pack_size);
+	if (rc)
+		RETURN(rc);
+
+	req_capsule_client_pack(&pill);
+	mdc_unlink_pack(&pill, op_data);
+
+	req_capsule_set_size(&pill, &RMF_MDT_MD, RCL_SERVER,
+			     exp->exp_obd->u.cli.cl_default_mds_easize);
+	req_capsule_set_replen(&pill);
+	reqmsg->lm_opc = BUT_UNLINK;
+	RETURN(0);
+}
+
 static md_update_pack_t mdc_update_packers[MD_OP_MAX] = {
 	[MD_OP_GETATTR]	= mdc_batch_getattr_pack,
+	[MD_OP_UNLINK]	= mdc_batch_unlink_pack,
 };
 
 static int mdc_batch_getattr_interpret(struct ptlrpc_request *req,
@@ -200,14 +256,91 @@ out:
 	return item->mop_cb(item, rc);
 }
 
+static int mdc_batch_unlink_interpret(struct ptlrpc_request *req,
+				      struct lustre_msg *repmsg,
+				      struct object_update_callback *ouc,
+				      int rc)
+{
+	struct md_op_item *item = (struct md_op_item *)ouc->ouc_data;
+	struct req_capsule *pill = item->mop_pill;
+	struct mdt_rec_unlink *rec;
+	struct mdt_body *body;
+	struct req_capsule subpill;
+
+	/* the callback gets the reply body through @item->mop_pill */
+	if (repmsg == NULL || rc != 0)
+		GOTO(out, rc);
+
+	req_capsule_subreq_init(pill, &RQF_BUT_UNLINK, req, NULL, repmsg,
+				RCL_CLIENT);
+	body = req_capsule_server_get(pill, &RMF_MDT_BODY);
+	if (body == NULL)
+		GOTO(out, rc = -EPROTO);
+
+	/*
+	 * Keep the pre-versions in the sub request kept for replay, like
+	 * ptlrpc_save_versions() does for a whole RPC.
+	 */
+	if (ouc->ouc_reqmsg != NULL) {
+		req_capsule_subreq_init(&subpill, &RQF_BUT_UNLINK, req,
+					ouc->ouc_reqmsg, NULL, RCL_CLIENT);
+		rec = req_capsule_client_get(&subpill, &RMF_REC_REINT);
+		if (rec != NULL)
+			memcpy(rec->ul_pre_versions, body->mbo_pre_versions,
+			       sizeof(rec->ul_pre_versions));
+	}
+out:
+	return item->mop_cb(item, rc);
+}
+
 object_update_interpret_t mdc_update_interpreters[MD_OP_MAX] = {
 	[MD_OP_GETATTR]	= mdc_batch_getattr_interpret,
+	[MD_OP_UNLINK]	= mdc_batch_unlink_interpret,
 };
 
+/* Early cancel of the locks a batched modification would conflict with. */
+static void mdc_batch_cancel_unused(struct obd_export *exp,
+				    const struct lu_fid *fid, __u64 bits)
+{
+	LIST_HEAD(cancels);
+	int count;
+
+	if (!fid_is_sane(fid))
+		return;
+
+	count = mdc_resource_get_unused(exp, fid, &cancels, LCK_EX, bits);
+	if (count > 0)
+		ldlm_cli_cancel_list(&cancels, count, NULL, LCF_ASYNC);
+}
+
+static int mdc_batch_prep(struct obd_export *exp, struct md_op_item *item)
+{
+	struct md_op_data *op_data = &item->mop_data;
+
+	switch (item->mop_opc) {
+	case MD_OP_UNLINK:
+		if (op_data->op_flags & MF_MDC_CANCEL_FID1)
+			mdc_batch_cancel_unused(exp, &op_data->op_fid1,
+						MDS_INODELOCK_UPDATE);
+		if (op_data->op_flags & MF_MDC_CANCEL_FID3)
+			mdc_batch_cancel_unused(exp, &op_data->op_fid3,
+						op_data->op_cli_flags &
+						CLI_DIRTY_DATA ?
+						MDS_INODELOCK_ELC :
+						MDS_INODELOCK_FULL);
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
 int mdc_batch_add(struct obd_export *exp, struct lu_batch *bh,
 		  struct md_op_item *item)
 {
 	enum md_item_opcode opc = item->mop_opc;
+	int rc;
 
 	ENTRY;
 
@@ -218,6 +351,10 @@ int mdc_batch_add(struct obd_export *exp, struct lu_batch *bh,
 		RETURN(-EFAULT);
 	}
 
+	rc = mdc_batch_prep(exp, item);
+	if (rc)
+		RETURN(rc);
+
 	OBD_ALLOC_PTR(item->mop_pill);
 	if (item->mop_pill == NULL)
 		RETURN(-ENOMEM);
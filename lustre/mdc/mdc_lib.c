@@ -168,7 +168,8 @@ void mdc_file_sepol_pack(struct req_capsule *pill)
 	size_t buf_size;
 	struct ptlrpc_request *req = pill->rc_req;
 
-	if (strlen(req->rq_sepol) == 0)
+	/* batched sub requests are packed without a ptlrpc_request */
+	if (req == NULL || strlen(req->rq_sepol) == 0)
 		return;
 
 	buf = req_capsule_client_get(pill, &RMF_SELINUX_POL);
@@ -318,6 +319,8 @@ void mdc_open_pack(struct req_capsule *pill, struct md_op_data *op_data,
 		rec->cr_suppgid2   = op_data->op_suppgids[1];
 		rec->cr_bias       = op_data->op_bias;
 		rec->cr_open_handle_old = op_data->op_open_handle;
+		if (op_data->op_cli_flags & CLI_XATTR_PREFETCH)
+			cr_flags |= MDS_OPEN_XATTRS;
 
 		if (op_data->op_name) {
 			mdc_pack_name(pill, &RMF_NAME, op_data->op_name,
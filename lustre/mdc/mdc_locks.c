@@ -244,6 +244,20 @@ int mdc_save_lmm(struct ptlrpc_request *req, void *data, u32 size)
 	return rc;
 }
 
+/* reply buffers for all xattrs piggybacked on getattr and open intents */
+static void mdc_xattrs_set_size(struct req_capsule *pill,
+				struct md_op_data *op_data)
+{
+	bool want = op_data->op_cli_flags & CLI_XATTR_PREFETCH;
+
+	req_capsule_set_size(pill, &RMF_EADATA, RCL_SERVER,
+			     want ? OBD_XATTR_PREFETCH_NAME_SIZE : 0);
+	req_capsule_set_size(pill, &RMF_EAVALS, RCL_SERVER,
+			     want ? OBD_XATTR_PREFETCH_VAL_SIZE : 0);
+	req_capsule_set_size(pill, &RMF_EAVALS_LENS, RCL_SERVER,
+			     want ? OBD_XATTR_PREFETCH_NUM * sizeof(__u32) : 0);
+}
+
 static struct ptlrpc_request *
 mdc_intent_open_pack(struct obd_export *exp, struct lookup_intent *it,
 		     struct md_op_data *op_data, __u32 acl_bufsize)
@@ -398,6 +412,7 @@ mdc_intent_open_pack(struct obd_export *exp, struct lookup_intent *it,
 			     sizeof(struct niobuf_remote));
 	req_capsule_set_size(&req->rq_pill, &RMF_DEFAULT_MDT_MD, RCL_SERVER,
 			     sizeof(struct lmv_user_md));
+	mdc_xattrs_set_size(&req->rq_pill, op_data);
 	ptlrpc_request_set_replen(req);
 
 	/* Get real repbuf allocated size as rounded up power of 2 */
@@ -566,6 +581,9 @@ mdc_intent_getattr_pack(struct obd_export *exp, struct lookup_intent *it,
 	else
 		easize = obd->u.cli.cl_max_mds_easize;
 
+	if (op_data->op_cli_flags & CLI_XATTR_PREFETCH)
+		valid |= OBD_MD_FLXATTRALL;
+
 	/* pack the intended request */
 	mdc_getattr_pack(&req->rq_pill, valid, it->it_flags, op_data, easize);
 
@@ -600,6 +618,7 @@ mdc_intent_getattr_pack(struct obd_export *exp, struct lookup_intent *it,
 		req_capsule_set_size(&req->rq_pill, &RMF_FILE_ENCCTX,
 				     RCL_SERVER, 0);
 
+	mdc_xattrs_set_size(&req->rq_pill, op_data);
 	ptlrpc_request_set_replen(req);
 	RETURN(req);
 }
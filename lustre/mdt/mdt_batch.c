@@ -57,6 +57,9 @@ static int mdt_batch_unpack(struct mdt_thread_info *info, __u32 opc)
 		if (info->mti_dlm_req == NULL)
 			RETURN(-EFAULT);
 		break;
+	case BUT_UNLINK:
+		/* the reint record is unpacked by mdt_reint_internal() */
+		break;
 	default:
 		rc = -EOPNOTSUPP;
 		CERROR("%s: Unexpected opcode %d: rc = %d\n",
@@ -72,9 +75,46 @@ static int mdt_batch_pack_repmsg(struct mdt_thread_info *info)
 	return 0;
 }
 
+/*
+ * Unpack a reint sub request and pack its reply the same way as
+ * mdt_reint_internal() does, without executing it again.
+ */
+static int mdt_batch_reint_prep(struct mdt_thread_info *info, __u32 op)
+{
+	struct req_capsule *pill = info->mti_pill;
+	int rc;
+
+	rc = mdt_reint_unpack(info, op);
+	if (rc)
+		return err_serious(rc);
+
+	if (req_capsule_has_field(pill, &RMF_MDT_MD, RCL_SERVER))
+		req_capsule_set_size(pill, &RMF_MDT_MD, RCL_SERVER, 0);
+	if (req_capsule_has_field(pill, &RMF_LOGCOOKIES, RCL_SERVER))
+		req_capsule_set_size(pill, &RMF_LOGCOOKIES, RCL_SERVER, 0);
+	if (req_capsule_has_field(pill, &RMF_ACL, RCL_SERVER))
+		req_capsule_set_size(pill, &RMF_ACL, RCL_SERVER, 0);
+
+	rc = req_capsule_server_pack(pill);
+	if (rc)
+		return err_serious(rc);
+
+	return 0;
+}
+
+static int mdt_batch_unlink_reconstruct(struct tgt_session_info *tsi)
+{
+	struct mdt_thread_info *info = mdt_th_info(tsi->tsi_env);
+
+	/* the name is gone, an empty reply body is all the client needs */
+	return mdt_batch_reint_prep(info, REINT_UNLINK);
+}
+
 typedef int (*mdt_batch_reconstructor)(struct tgt_session_info *tsi);
 
-static mdt_batch_reconstructor reconstructors[BUT_LAST_OPC];
+static mdt_batch_reconstructor reconstructors[BUT_LAST_OPC] = {
+	[BUT_UNLINK]	= mdt_batch_unlink_reconstruct,
+};
 
 static int mdt_batch_reconstruct(struct tgt_session_info *tsi, long opc)
 {
@@ -106,6 +146,17 @@ static int mdt_batch_getattr(struct tgt_session_info *tsi)
 	RETURN(rc);
 }
 
+static int mdt_batch_unlink(struct tgt_session_info *tsi)
+{
+	struct mdt_thread_info *info = mdt_th_info(tsi->tsi_env);
+	int rc;
+
+	ENTRY;
+
+	rc = mdt_reint_internal(info, NULL, REINT_UNLINK);
+	RETURN(rc);
+}
+
 /* Batch UpdaTe Request with a format known in advance */
 #define TGT_BUT_HDL(flags, opc, fn)			\
 [opc - BUT_FIRST_OPC] = {				\
@@ -121,6 +172,7 @@ static int mdt_batch_getattr(struct tgt_session_info *tsi)
 
 static struct tgt_handler mdt_batch_handlers[] = {
 TGT_BUT_HDL(HAS_KEY | HAS_REPLY,	BUT_GETATTR,	mdt_batch_getattr),
+TGT_BUT_HDL(IS_MUTABLE | HAS_REPLY,	BUT_UNLINK,	mdt_batch_unlink),
 };
 
 static struct tgt_handler *mdt_batch_handler_find(__u32 opc)
@@ -313,16 +365,20 @@ int mdt_batch(struct tgt_session_info *tsi)
 			    handled_update_count <=
 			    trd->trd_reply.lrd_batch_idx) {
 				rc = mdt_batch_reconstruct(tsi, reqmsg->lm_opc);
-				if (rc)
-					GOTO(out, rc);
-				GOTO(next, rc);
+			} else {
+				tsi->tsi_batch_idx = handled_update_count;
+				rc = h->th_act(tsi);
 			}
 
-			tsi->tsi_batch_idx = handled_update_count;
-			rc = h->th_act(tsi);
-			if (rc)
+			/*
+			 * A failed modification only fails its own sub
+			 * request, the client gets the error in lm_result of
+			 * its reply and the following ones are still executed.
+			 */
+			if (rc && (!(h->th_flags & IS_MUTABLE) ||
+				   is_serious(rc)))
 				GOTO(out, rc);
-next:
+
 			/*
 			 * As @repmsg may be changed if the reply buffer is
 			 * too small to grow, thus it needs to reload it here.
@@ -1366,6 +1366,30 @@ static void mdt_preset_encctx_size(struct mdt_thread_info *info)
 	EXIT;
 }
 
+/*
+ * Reserve the reply buffers for all xattrs only if the client asked for them
+ * and negotiated OBD_CONNECT2_XATTR_PREFETCH, so other intent replies do not
+ * carry them, and the XATTR ibit is not tried, see mdt_getattr_name_lock().
+ */
+static void mdt_preset_xattrs_size(struct mdt_thread_info *info, bool want)
+{
+	struct req_capsule *pill = info->mti_pill;
+
+	if (!req_capsule_has_field(pill, &RMF_EAVALS, RCL_SERVER))
+		return;
+
+	if (!exp_connect_xattr_prefetch(info->mti_exp))
+		want = false;
+
+	/* shrunk by mdt_pack_xattrs_in_reply() or mdt_fix_reply() */
+	req_capsule_set_size(pill, &RMF_EADATA, RCL_SERVER,
+			     want ? OBD_XATTR_PREFETCH_NAME_SIZE : 0);
+	req_capsule_set_size(pill, &RMF_EAVALS, RCL_SERVER,
+			     want ? OBD_XATTR_PREFETCH_VAL_SIZE : 0);
+	req_capsule_set_size(pill, &RMF_EAVALS_LENS, RCL_SERVER,
+			     want ? OBD_XATTR_PREFETCH_NUM * sizeof(__u32) : 0);
+}
+
 static int mdt_getattr_internal(struct mdt_thread_info *info,
 				struct mdt_object *o, int ma_need)
 {
@@ -2346,6 +2370,12 @@ static int mdt_getattr_name_lock(struct mdt_thread_info *info,
 				try_bits |= MDS_INODELOCK_DOM;
 		}
 
+		/* xattrs are packed into the reply only under XATTR lock */
+		if (!mdt_object_remote(child) && ldlm_rep != NULL &&
+		    req_capsule_has_field(pill, &RMF_EAVALS, RCL_SERVER) &&
+		    req_capsule_get_size(pill, &RMF_EAVALS, RCL_SERVER) != 0)
+			try_bits |= MDS_INODELOCK_XATTR;
+
 		/*
 		 * To avoid possible deadlock between batched statahead RPC
 		 * and rename()/migrate() operation, it should use trylock to
@@ -2421,6 +2451,8 @@ static int mdt_getattr_name_lock(struct mdt_thread_info *info,
 		GOTO(out_child, rc);
 	}
 
+	mdt_pack_xattrs_in_reply(info, child, child_bits);
+
 	lock = ldlm_handle2lock(&lhc->mlh_reg_lh);
 	if (lock) {
 		/* Debugging code. */
@@ -2970,9 +3002,8 @@ static void mdt_preset_secctx_size(struct mdt_thread_info *info)
 	}
 }
 
-static int mdt_reint_internal(struct mdt_thread_info *info,
-                              struct mdt_lock_handle *lhc,
-                              __u32 op)
+int mdt_reint_internal(struct mdt_thread_info *info,
+		       struct mdt_lock_handle *lhc, __u32 op)
 {
 	struct req_capsule	*pill = info->mti_pill;
 	struct mdt_body		*repbody;
@@ -3010,6 +3041,8 @@ static int mdt_reint_internal(struct mdt_thread_info *info,
 
 	mdt_preset_secctx_size(info);
 	mdt_preset_encctx_size(info);
+	mdt_preset_xattrs_size(info, op == REINT_OPEN &&
+			       info->mti_spec.sp_cr_flags & MDS_OPEN_XATTRS);
 
 	rc = req_capsule_server_pack(pill);
 	if (rc != 0) {
@@ -3039,7 +3072,9 @@ static int mdt_reint_internal(struct mdt_thread_info *info,
 	if (rc != 0)
 		GOTO(out_ucred, rc = err_serious(rc));
 
-	rc = mdt_check_resent(info, mdt_reconstruct, lhc);
+	/* a resent batch is reconstructed per sub request by mdt_batch() */
+	if (!info->mti_batch_env)
+		rc = mdt_check_resent(info, mdt_reconstruct, lhc);
 	if (rc < 0) {
 		GOTO(out_ucred, rc);
 	} else if (rc == 1) {
@@ -4390,6 +4425,9 @@ static int mdt_unpack_req_pack_rep(struct mdt_thread_info *info,
 
 		mdt_preset_secctx_size(info);
 		mdt_preset_encctx_size(info);
+		mdt_preset_xattrs_size(info, info->mti_body != NULL &&
+			(info->mti_body->mbo_valid & OBD_MD_FLXATTRALL) ==
+			OBD_MD_FLXATTRALL);
 
 		rc = req_capsule_server_pack(pill);
 		if (rc)
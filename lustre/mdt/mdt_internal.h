@@ -895,6 +895,8 @@ int mdt_name_unpack(struct req_capsule *pill,
 		    enum mdt_name_flags flags);
 int mdt_close_unpack(struct mdt_thread_info *info);
 int mdt_reint_unpack(struct mdt_thread_info *info, __u32 op);
+int mdt_reint_internal(struct mdt_thread_info *info,
+		       struct mdt_lock_handle *lhc, __u32 op);
 void mdt_fix_lov_magic(struct mdt_thread_info *info, void *eadata);
 int mdt_reint_rec(struct mdt_thread_info *, struct mdt_lock_handle *);
 #ifdef CONFIG_LUSTRE_FS_POSIX_ACL
@@ -906,6 +908,8 @@ void mdt_pack_attr2body(struct mdt_thread_info *info, struct mdt_body *b,
 int mdt_pack_size2body(struct mdt_thread_info *info,
 			const struct lu_fid *fid,  struct lustre_handle *lh);
 int mdt_getxattr(struct mdt_thread_info *info);
+void mdt_pack_xattrs_in_reply(struct mdt_thread_info *info,
+			      struct mdt_object *obj, __u64 ibits);
 int mdt_reint_setxattr(struct mdt_thread_info *info,
                        struct mdt_lock_handle *lh);
 
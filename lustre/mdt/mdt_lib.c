@@ -818,6 +818,15 @@ int mdt_fix_reply(struct mdt_thread_info *info)
 	    !(body->mbo_valid & OBD_MD_ENCCTX))
 		req_capsule_shrink(pill, &RMF_FILE_ENCCTX, 0, RCL_SERVER);
 
+	/* Shrink optional xattrs buffers if they are not used */
+	if (req_capsule_has_field(pill, &RMF_EAVALS, RCL_SERVER) &&
+	    req_capsule_get_size(pill, &RMF_EAVALS, RCL_SERVER) != 0 &&
+	    (body->mbo_valid & OBD_MD_FLXATTRALL) != OBD_MD_FLXATTRALL) {
+		req_capsule_shrink(pill, &RMF_EAVALS, 0, RCL_SERVER);
+		req_capsule_shrink(pill, &RMF_EAVALS_LENS, 0, RCL_SERVER);
+		req_capsule_shrink(pill, &RMF_EADATA, 0, RCL_SERVER);
+	}
+
 	/* Shrink optional default LMV buffer if it is not used */
 	if (req_capsule_has_field(pill, &RMF_DEFAULT_MDT_MD, RCL_SERVER) &&
 	    req_capsule_get_size(pill, &RMF_DEFAULT_MDT_MD, RCL_SERVER) != 0 &&
@@ -829,7 +838,12 @@ int mdt_fix_reply(struct mdt_thread_info *info)
 	 * This should be done by those who added fields to reply message.
 	 */
 
-	/* Grow MD buffer if needed finally */
+	/*
+	 * Grow MD buffer if needed finally. It is copied into the reply, not
+	 * sent from pages with req_capsule_server_kiov_set() as large xattrs
+	 * are: that only handles the last reply buffer, and RMF_MDT_MD is
+	 * followed by RMF_ACL and others in every getattr and intent reply.
+	 */
 	if (info->mti_big_lmm_used) {
                 void *lmm;
 
@@ -916,6 +916,15 @@ static int mdt_object_open_lock(struct mdt_thread_info *info,
 			trybits |= MDS_INODELOCK_UPDATE | MDS_INODELOCK_PERM;
 	}
 
+	/* Return XATTR lock together with all xattrs in the reply, if the
+	 * client asked for them and keeps the lock, see
+	 * mdt_open_pack_xattrs().
+	 */
+	if (open_flags & MDS_OPEN_XATTRS && lm == LCK_PR &&
+	    exp_connect_xattr_prefetch(info->mti_exp) &&
+	    (*ibits | trybits) & (MDS_INODELOCK_OPEN | MDS_INODELOCK_LAYOUT))
+		trybits |= MDS_INODELOCK_XATTR;
+
 	if (*ibits | trybits)
 		rc = mdt_object_lock_try(info, obj, lhc, ibits, trybits, lm);
 
@@ -1043,6 +1052,21 @@ static void mdt_object_open_unlock(struct mdt_thread_info *info,
 	RETURN_EXIT;
 }
 
+/*
+ * The open lock is returned to the client only if OPEN, LAYOUT or DOM ibits
+ * are granted, see mdt_object_open_unlock(), and the xattrs packed into the
+ * reply are valid only under that lock.
+ */
+static void mdt_open_pack_xattrs(struct mdt_thread_info *info,
+				 struct mdt_object *obj, __u64 ibits)
+{
+	if (!(info->mti_spec.sp_cr_flags & MDS_OPEN_LOCK) &&
+	    !(ibits & (MDS_INODELOCK_LAYOUT | MDS_INODELOCK_DOM)))
+		ibits = 0;
+
+	mdt_pack_xattrs_in_reply(info, obj, ibits);
+}
+
 /**
  * Check release is permitted for the current HSM flags.
  */
@@ -1195,6 +1219,8 @@ static int mdt_open_by_fid_lock(struct mdt_thread_info *info,
 	if (open_flags & MDS_OPEN_LEASE)
 		mdt_set_disposition(info, rep, DISP_OPEN_LEASE);
 
+	mdt_open_pack_xattrs(info, o, ibits);
+
 	/*
 	 * if layout lock is granted, then we should re-fetch LOVEA
 	 * which was originally taken w/o the lock
@@ -1713,6 +1739,8 @@ again_pw:
 		GOTO(out_child_unlock, result);
 	}
 
+	mdt_open_pack_xattrs(info, child, ibits);
+
 	/*
 	 * if layout lock is granted, then we should re-fetch LOVEA
 	 * which was originally taken w/o the lock.
@@ -72,21 +72,63 @@ static void mdt_obj_version_get(struct mdt_thread_info *info,
 	       PFID(mdt_object_fid(o)), *version);
 }
 
+/**
+ * Pre-versions of a batched sub request.
+ *
+ * The versions in ptlrpc_body are per RPC, those of a sub request are kept
+ * in its unlink record by the client, which copies them from the reply body.
+ * Only BUT_UNLINK modifies the namespace in a batch, other sub requests have
+ * no versions.
+ *
+ * \param[in] info	thread info of the sub request
+ * \param[in] loc	RCL_CLIENT for the replayed record, RCL_SERVER for the
+ *			reply body
+ * \param[in] idx	index of the version to be used
+ *
+ * \retval pointer	to the parent and child versions
+ * \retval NULL		if the sub request has no version \a idx
+ */
+static __u64 *mdt_batch_versions(struct mdt_thread_info *info,
+				 enum req_location loc, int idx)
+{
+	struct req_capsule *pill = info->mti_pill;
+	struct mdt_rec_unlink *rec;
+	struct mdt_body *body;
+
+	if (info->mti_rr.rr_opcode != REINT_UNLINK ||
+	    idx >= ARRAY_SIZE(rec->ul_pre_versions))
+		return NULL;
+
+	if (loc == RCL_SERVER) {
+		body = req_capsule_server_get(pill, &RMF_MDT_BODY);
+		return body != NULL ? body->mbo_pre_versions : NULL;
+	}
+
+	rec = req_capsule_client_get(pill, &RMF_REC_REINT);
+	return rec != NULL ? rec->ul_pre_versions : NULL;
+}
+
 /**
  * Check version is correct.
  *
  * Should be called only during replay.
  */
-static int mdt_version_check(struct ptlrpc_request *req,
+static int mdt_version_check(struct mdt_thread_info *info,
 			     __u64 version, int idx)
 {
-	__u64 *pre_ver = lustre_msg_get_versions(req->rq_reqmsg);
+	struct ptlrpc_request *req = mdt_info_req(info);
+	__u64 *pre_ver;
 
 	ENTRY;
 	if (!exp_connect_vbr(req->rq_export))
 		RETURN(0);
 
 	LASSERT(req_is_replay(req));
+	if (info->mti_batch_env)
+		pre_ver = mdt_batch_versions(info, RCL_CLIENT, idx);
+	else
+		pre_ver = lustre_msg_get_versions(req->rq_reqmsg);
+
 	/** VBR: version is checked always because costs nothing */
 	LASSERT(idx < PTLRPC_NUM_VERSIONS);
 	/** Sanity check for malformed buffers */
@@ -110,17 +152,22 @@ static int mdt_version_check(struct ptlrpc_request *req,
 /**
  * Save pre-versions in reply.
  */
-static void mdt_version_save(struct ptlrpc_request *req, __u64 version,
+static void mdt_version_save(struct mdt_thread_info *info, __u64 version,
 			     int idx)
 {
+	struct ptlrpc_request *req = mdt_info_req(info);
 	__u64 *reply_ver;
 
 	if (!exp_connect_vbr(req->rq_export))
 		return;
 
 	LASSERT(!req_is_replay(req));
-	LASSERT(req->rq_repmsg != NULL);
-	reply_ver = lustre_msg_get_versions(req->rq_repmsg);
+	if (info->mti_batch_env) {
+		reply_ver = mdt_batch_versions(info, RCL_SERVER, idx);
+	} else {
+		LASSERT(req->rq_repmsg != NULL);
+		reply_ver = lustre_msg_get_versions(req->rq_repmsg);
+	}
 	if (reply_ver)
 		reply_ver[idx] = version;
 }
@@ -134,7 +181,7 @@ static void mdt_enoent_version_save(struct mdt_thread_info *info, int idx)
 	/* save version of file name for replay, it must be ENOENT here */
 	if (!req_is_replay(mdt_info_req(info))) {
 		info->mti_ver[idx] = ENOENT_VERSION;
-		mdt_version_save(mdt_info_req(info), info->mti_ver[idx], idx);
+		mdt_version_save(info, info->mti_ver[idx], idx);
 	}
 }
 
@@ -149,7 +196,7 @@ void mdt_version_get_save(struct mdt_thread_info *info,
 	/* don't save versions during replay */
 	if (!req_is_replay(mdt_info_req(info))) {
 		mdt_obj_version_get(info, mto, &info->mti_ver[idx]);
-		mdt_version_save(mdt_info_req(info), info->mti_ver[idx], idx);
+		mdt_version_save(info, info->mti_ver[idx], idx);
 	}
 }
 
@@ -164,7 +211,7 @@ int mdt_version_get_check(struct mdt_thread_info *info,
 		return 0;
 
 	mdt_obj_version_get(info, mto, &info->mti_ver[idx]);
-	return mdt_version_check(mdt_info_req(info), info->mti_ver[idx], idx);
+	return mdt_version_check(info, info->mti_ver[idx], idx);
 }
 
 /**
@@ -177,10 +224,10 @@ int mdt_version_get_check_save(struct mdt_thread_info *info,
 
 	mdt_obj_version_get(info, mto, &info->mti_ver[idx]);
 	if (req_is_replay(mdt_info_req(info)))
-		rc = mdt_version_check(mdt_info_req(info), info->mti_ver[idx],
+		rc = mdt_version_check(info, info->mti_ver[idx],
 				       idx);
 	else
-		mdt_version_save(mdt_info_req(info), info->mti_ver[idx], idx);
+		mdt_version_save(info, info->mti_ver[idx], idx);
 	return rc;
 }
 
@@ -213,7 +260,7 @@ int mdt_lookup_version_check(struct mdt_thread_info *info,
 			mdt_object_put(info->mti_env, child);
 		}
 	}
-	vbrc = mdt_version_check(mdt_info_req(info), info->mti_ver[idx], idx);
+	vbrc = mdt_version_check(info, info->mti_ver[idx], idx);
 	return vbrc ? vbrc : rc;
 
 }
@@ -614,7 +661,7 @@ static int mdt_create(struct mdt_thread_info *info)
 
 	if (unlikely(info->mti_spec.sp_replay)) {
 		/* check version only during replay */
-		rc = mdt_version_check(mdt_info_req(info), ENOENT_VERSION, 1);
+		rc = mdt_version_check(info, ENOENT_VERSION, 1);
 		if (rc)
 			GOTO(put_parent, rc);
 	} else {
@@ -1443,7 +1490,7 @@ static int mdt_reint_link(struct mdt_thread_info *info,
 			GOTO(unlock_source, rc = -EEXIST);
 		}
 		info->mti_ver[2] = ENOENT_VERSION;
-		mdt_version_save(mdt_info_req(info), info->mti_ver[2], 2);
+		mdt_version_save(info, info->mti_ver[2], 2);
 	}
 
 	rc = mdo_link(info->mti_env, mdt_object_child(mp),
@@ -40,6 +40,7 @@
 
 #define DEBUG_SUBSYSTEM S_MDS
 
+#include <linux/vmalloc.h>
 #include <linux/xattr.h>
 #include <obd_class.h>
 #include <lustre_nodemap.h>
@@ -125,8 +126,12 @@ static int mdt_getxattr_pack_reply(struct mdt_thread_info *info)
 		req_capsule_set_size(pill, &RMF_ACL, RCL_SERVER,
 				     LUSTRE_POSIX_ACL_MAX_SIZE_OLD);
 
-	req_capsule_set_size(pill, &RMF_EADATA, RCL_SERVER,
-			     info->mti_body->mbo_eadatasize == 0 ? 0 : size);
+	/* large values are sent from pages, see mdt_getxattr_send_pages() */
+	if (info->mti_body->mbo_eadatasize == 0 ||
+	    (size > PAGE_SIZE && req_capsule_server_kiov_ok(pill, &RMF_EADATA)))
+		req_capsule_set_size(pill, &RMF_EADATA, RCL_SERVER, 0);
+	else
+		req_capsule_set_size(pill, &RMF_EADATA, RCL_SERVER, size);
 
 	rc2 = req_capsule_server_pack(pill);
 	if (rc2 < 0)
@@ -138,6 +143,90 @@ static int mdt_getxattr_pack_reply(struct mdt_thread_info *info)
 	RETURN(rc < 0 ? rc : size);
 }
 
+static void mdt_xattr_pages_free(struct page **pages, int npages, void *addr)
+{
+	int i;
+
+	if (addr != NULL)
+		vunmap(addr);
+	for (i = 0; i < npages && pages[i] != NULL; i++)
+		__free_page(pages[i]);
+	OBD_FREE_PTR_ARRAY(pages, npages);
+}
+
+/* allocate \a npages pages for xattr data, mapped contiguously at \a addr */
+static struct page **mdt_xattr_pages_alloc(int npages, void **addr)
+{
+	struct page **pages;
+	int i;
+
+	OBD_ALLOC_PTR_ARRAY(pages, npages);
+	if (pages == NULL)
+		return NULL;
+
+	for (i = 0; i < npages; i++) {
+		pages[i] = alloc_page(GFP_NOFS);
+		if (pages[i] == NULL)
+			goto failed;
+	}
+
+	*addr = vmap(pages, npages, VM_MAP, PAGE_KERNEL);
+	if (*addr == NULL)
+		goto failed;
+
+	return pages;
+failed:
+	mdt_xattr_pages_free(pages, npages, NULL);
+	return NULL;
+}
+
+/*
+ * Send the \a len bytes of xattr data at \a addr, mapped from \a pages, in
+ * EADATA packed empty by mdt_getxattr_pack_reply(). The reply is sent from
+ * the pages, or the data is copied into the reply if that fails.
+ *
+ * This is not zero-copy: the OSD still copies the value into these pages,
+ * it only saves the large reply buffer and copying the value into it.
+ */
+static int mdt_getxattr_send_pages(struct mdt_thread_info *info,
+				   struct page **pages, void *addr, int len)
+{
+	struct req_capsule *pill = info->mti_pill;
+	struct bio_vec *kiov;
+	int npages = DIV_ROUND_UP(len, PAGE_SIZE);
+	int rc = -ENOMEM;
+	int i;
+
+	ENTRY;
+
+	if (len == 0)
+		RETURN(0);
+
+	OBD_ALLOC_PTR_ARRAY(kiov, npages);
+	if (kiov != NULL) {
+		for (i = 0; i < npages; i++) {
+			kiov[i].bv_page = pages[i];
+			kiov[i].bv_offset = 0;
+			kiov[i].bv_len = min_t(int, len - i * PAGE_SIZE,
+					       PAGE_SIZE);
+		}
+		rc = req_capsule_server_kiov_set(pill, &RMF_EADATA, kiov,
+						 npages, len);
+		OBD_FREE_PTR_ARRAY(kiov, npages);
+		if (rc == 0)
+			RETURN(0);
+	}
+
+	CDEBUG(D_INFO, "%s: copying %d bytes into reply: rc = %d\n",
+	       mdt_obd_name(info->mti_mdt), len, rc);
+	rc = req_capsule_server_grow(pill, &RMF_EADATA, len);
+	if (rc)
+		RETURN(rc);
+
+	memcpy(req_capsule_server_get(pill, &RMF_EADATA), addr, len);
+	RETURN(0);
+}
+
 static int mdt_nodemap_map_acl(struct mdt_thread_info *info, void *buf,
 			       size_t size, const char *name,
 			       enum nodemap_tree_type tree_type)
@@ -168,54 +257,81 @@ out:
 	RETURN(rc);
 }
 
-static int mdt_getxattr_all(struct mdt_thread_info *info,
-			    struct mdt_body *reqbody, struct mdt_body *repbody,
-			    struct lu_buf *buf, struct md_object *next)
+/*
+ * Fill EADATA (in \a buf) with the names of all xattrs of \a next, and
+ * EAVALS and EAVALS_LENS with their values and value lengths, using at
+ * most \a vallen bytes for the values.
+ *
+ * The format of the pill is the following:
+ * EADATA:      attr1\0attr2\0...attrn\0
+ * EAVALS:      val1val2...valn
+ * EAVALS_LENS: 4,4,...4
+ *
+ * \retval	length of the names in EADATA, total length and count of
+ *		values are returned in \a eavallen and \a eavallens
+ * \retval	negative errno on failure
+ */
+static int mdt_getxattr_fill(struct mdt_thread_info *info,
+			     struct md_object *next, struct lu_buf *buf,
+			     int vallen, int *eavallen, int *eavallens)
 {
 	const struct lu_env *env = info->mti_env;
 	char *v, *b, *eadatahead, *eadatatail;
 	__u32 *sizes;
-	int eadatasize, eavallen = 0, eavallens = 0, rc;
+	int eadatasize, maxlens, rc;
 
 	ENTRY;
 
-	/*
-	 * The format of the pill is the following:
-	 * EADATA:      attr1\0attr2\0...attrn\0
-	 * EAVALS:      val1val2...valn
-	 * EAVALS_LENS: 4,4,...4
-	 */
-
+	*eavallen = 0;
+	*eavallens = 0;
 	eadatahead = buf->lb_buf;
 
 	/* Fill out EADATA first */
 	rc = mo_xattr_list(env, next, buf);
 	if (rc < 0)
-		GOTO(out_shrink, rc);
+		RETURN(rc);
 
 	eadatasize = rc;
 	eadatatail = eadatahead + eadatasize;
 
 	v = req_capsule_server_get(info->mti_pill, &RMF_EAVALS);
 	sizes = req_capsule_server_get(info->mti_pill, &RMF_EAVALS_LENS);
+	maxlens = req_capsule_get_size(info->mti_pill, &RMF_EAVALS_LENS,
+				       RCL_SERVER) / sizeof(__u32);
 
 	/* Fill out EAVALS and EAVALS_LENS */
 	for (b = eadatahead; b < eadatatail; b += strlen(b) + 1, v += rc) {
+		if (*eavallens >= maxlens)
+			RETURN(-ERANGE);
+
 		buf->lb_buf = v;
-		buf->lb_len = reqbody->mbo_eadatasize - eavallen;
+		buf->lb_len = vallen - *eavallen;
 		rc = mo_xattr_get(env, next, buf, b);
 		if (rc < 0)
-			GOTO(out_shrink, rc);
+			RETURN(rc);
 		rc = mdt_nodemap_map_acl(info, buf->lb_buf, rc, b,
 					 NODEMAP_FS_TO_CLIENT);
 		if (rc < 0)
-			GOTO(out_shrink, rc);
-		sizes[eavallens] = rc;
-		eavallens++;
-		eavallen += rc;
+			RETURN(rc);
+		sizes[*eavallens] = rc;
+		(*eavallens)++;
+		*eavallen += rc;
 	}
 
-out_shrink:
+	RETURN(eadatasize);
+}
+
+static int mdt_getxattr_all(struct mdt_thread_info *info,
+			    struct mdt_body *reqbody, struct mdt_body *repbody,
+			    struct lu_buf *buf, struct md_object *next)
+{
+	int eadatasize, eavallen, eavallens, rc;
+
+	ENTRY;
+
+	rc = mdt_getxattr_fill(info, next, buf, reqbody->mbo_eadatasize,
+			       &eavallen, &eavallens);
+	eadatasize = rc;
 	if (rc < 0) {
 		eadatasize = 0;
 		eavallens = 0;
@@ -234,6 +350,60 @@ out_shrink:
 	return rc;
 }
 
+/**
+ * Pack all xattrs of \a obj into a getattr or open intent reply.
+ *
+ * This is done only if the client asked for the xattrs, so the reply has
+ * room for them, and the XATTR ibit is granted in \a ibits together with
+ * the reply, since the client xattr cache is only valid under that lock.
+ * Failing to pack the xattrs is not an error, the client just falls back
+ * to an IT_GETXATTR request later.
+ */
+void mdt_pack_xattrs_in_reply(struct mdt_thread_info *info,
+			      struct mdt_object *obj, __u64 ibits)
+{
+	struct req_capsule *pill = info->mti_pill;
+	struct mdt_body *repbody;
+	struct lu_buf buf;
+	int eadatasize, eavallen, eavallens;
+
+	ENTRY;
+
+	if (!req_capsule_has_field(pill, &RMF_EAVALS, RCL_SERVER) ||
+	    req_capsule_get_size(pill, &RMF_EAVALS, RCL_SERVER) == 0)
+		RETURN_EXIT;
+
+	if (!(ibits & MDS_INODELOCK_XATTR) || mdt_object_remote(obj) ||
+	    req_check_sepol(pill))
+		RETURN_EXIT;
+
+	buf.lb_buf = req_capsule_server_get(pill, &RMF_EADATA);
+	buf.lb_len = req_capsule_get_size(pill, &RMF_EADATA, RCL_SERVER);
+	eadatasize = mdt_getxattr_fill(info, mdt_object_child(obj), &buf,
+				       req_capsule_get_size(pill, &RMF_EAVALS,
+							    RCL_SERVER),
+				       &eavallen, &eavallens);
+	if (eadatasize < 0) {
+		/* unused buffers are shrunk by mdt_fix_reply() */
+		CDEBUG(D_INODE, "%s: cannot pack xattrs of "DFID": rc = %d\n",
+		       mdt_obd_name(info->mti_mdt), PFID(mdt_object_fid(obj)),
+		       eadatasize);
+		RETURN_EXIT;
+	}
+
+	req_capsule_shrink(pill, &RMF_EAVALS, eavallen, RCL_SERVER);
+	req_capsule_shrink(pill, &RMF_EAVALS_LENS,
+			   eavallens * sizeof(__u32), RCL_SERVER);
+	req_capsule_shrink(pill, &RMF_EADATA, eadatasize, RCL_SERVER);
+
+	repbody = req_capsule_server_get(pill, &RMF_MDT_BODY);
+	repbody->mbo_valid |= OBD_MD_FLXATTRALL;
+	CDEBUG(D_INODE, "%s: packed %d xattrs of "DFID"\n",
+	       mdt_obd_name(info->mti_mdt), eavallens,
+	       PFID(mdt_object_fid(obj)));
+	EXIT;
+}
+
 int mdt_getxattr(struct mdt_thread_info *info)
 {
 	struct ptlrpc_request  *req = mdt_info_req(info);
@@ -241,6 +411,9 @@ int mdt_getxattr(struct mdt_thread_info *info)
 	struct mdt_body        *repbody = NULL;
 	struct md_object       *next;
 	struct lu_buf          *buf;
+	struct page	      **pages = NULL;
+	void		       *addr = NULL;
+	int			npages = 0;
 	int                     easize, rc;
 	u64			valid;
 	ktime_t			kstart = ktime_get();
@@ -278,7 +451,17 @@ int mdt_getxattr(struct mdt_thread_info *info)
 		GOTO(out, rc = easize);
 
 	buf = &info->mti_buf;
-	buf->lb_buf = req_capsule_server_get(info->mti_pill, &RMF_EADATA);
+	if (req_capsule_get_size(info->mti_pill, &RMF_EADATA,
+				 RCL_SERVER) == 0) {
+		npages = DIV_ROUND_UP(easize, PAGE_SIZE);
+		pages = mdt_xattr_pages_alloc(npages, &addr);
+		if (pages == NULL)
+			GOTO(out, rc = -ENOMEM);
+		buf->lb_buf = addr;
+	} else {
+		buf->lb_buf = req_capsule_server_get(info->mti_pill,
+						     &RMF_EADATA);
+	}
 	buf->lb_len = easize;
 
 	valid = info->mti_body->mbo_valid & (OBD_MD_FLXATTR | OBD_MD_FLXATTRLS);
@@ -304,8 +487,20 @@ int mdt_getxattr(struct mdt_thread_info *info)
 	} else
 		LBUG();
 
+	if (pages != NULL && rc >= 0) {
+		int rc2 = mdt_getxattr_send_pages(info, pages, addr, rc);
+
+		if (rc2 < 0)
+			rc = rc2;
+		/* the reply state might have been reallocated */
+		repbody = req_capsule_server_get(info->mti_pill,
+						 &RMF_MDT_BODY);
+	}
+
 	EXIT;
 out:
+	if (pages != NULL)
+		mdt_xattr_pages_free(pages, npages, addr);
 	if (rc >= 0) {
 		mdt_counter_incr(req, LPROC_MDT_GETXATTR,
 				 ktime_us_delta(ktime_get(), kstart));
@@ -0,0 +1,276 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/obdclass/cl_dio_pool.c
+ *
+ * Bounce page pool of unaligned direct I/O.
+ *
+ * Unaligned direct I/O is copied through kernel pages which are sent with
+ * the same RPC path as aligned direct I/O. Allocating and freeing those
+ * pages for every I/O is costly for applications doing many small unaligned
+ * I/Os, so freed pages are kept for the next I/O. As with the bulk
+ * encryption pools of sec_bulk.c, the pool grows on demand, is bounded and
+ * is given back to the kernel by a shrinker. The free pages are kept per
+ * CPU partition so that the pool lock is not shared by all CPUs.
+ */
+
+#define DEBUG_SUBSYSTEM S_CLASS
+
+#include <linux/module.h>
+#include <linux/seq_file.h>
+#include <libcfs/libcfs.h>
+#include <obd_support.h>
+#include <cl_object.h>
+
+static int dio_pool_max_memory_mb;
+module_param(dio_pool_max_memory_mb, int, 0444);
+MODULE_PARM_DESC(dio_pool_max_memory_mb,
+		 "Unaligned direct I/O page pool max memory (MB), 1/64 of total physical memory by default, -1 disables the pool");
+
+struct cl_dio_pool {
+	spinlock_t	  dp_lock;	/* protects the following fields */
+	unsigned long	  dp_max_pages;	/* size of dp_pages, const */
+	unsigned long	  dp_free_pages; /* pages in dp_pages */
+	struct page	**dp_pages;	/* free pages, used as a stack */
+
+	/* statistics */
+	unsigned long	  dp_st_access;	  /* # of pages asked for */
+	unsigned long	  dp_st_missings; /* # of pages allocated */
+	unsigned long	  dp_st_shrinks;  /* # of pages released */
+	unsigned long	  dp_st_outofmem; /* # of failed allocations */
+};
+
+/* one pool per CPU partition */
+static struct cl_dio_pool **dio_pools;
+
+/**
+ * Get \a count pages for an unaligned direct I/O buffer, from the pool of
+ * the current CPU partition first.
+ *
+ * \retval 0		\a pages are filled
+ * \retval -ENOMEM	no page is taken
+ */
+int cl_dio_pool_get_pages(struct page **pages, unsigned int count)
+{
+	struct cl_dio_pool *pool = NULL;
+	unsigned int i = 0;
+
+	if (dio_pools != NULL) {
+		pool = dio_pools[cfs_cpt_current(cfs_cpt_tab, 0)];
+
+		spin_lock(&pool->dp_lock);
+		while (i < count && pool->dp_free_pages > 0)
+			pages[i++] = pool->dp_pages[--pool->dp_free_pages];
+		pool->dp_st_access += count;
+		pool->dp_st_missings += count - i;
+		spin_unlock(&pool->dp_lock);
+	}
+
+	for (; i < count; i++) {
+		pages[i] = alloc_page(GFP_NOFS);
+		if (pages[i] == NULL) {
+			if (pool != NULL) {
+				spin_lock(&pool->dp_lock);
+				pool->dp_st_outofmem++;
+				spin_unlock(&pool->dp_lock);
+			}
+			cl_dio_pool_put_pages(pages, i);
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(cl_dio_pool_get_pages);
+
+/**
+ * Give back \a count pages of an unaligned direct I/O buffer. The pages
+ * which do not fit in the pool of the current CPU partition are freed.
+ */
+void cl_dio_pool_put_pages(struct page **pages, unsigned int count)
+{
+	struct cl_dio_pool *pool;
+	unsigned int i = 0;
+
+	if (dio_pools != NULL) {
+		pool = dio_pools[cfs_cpt_current(cfs_cpt_tab, 0)];
+
+		spin_lock(&pool->dp_lock);
+		while (i < count && pool->dp_free_pages < pool->dp_max_pages)
+			pool->dp_pages[pool->dp_free_pages++] = pages[i++];
+		spin_unlock(&pool->dp_lock);
+	}
+
+	for (; i < count; i++)
+		__free_page(pages[i]);
+}
+EXPORT_SYMBOL(cl_dio_pool_put_pages);
+
+static unsigned long dio_pools_shrink_count(struct shrinker *s,
+					    struct shrink_control *sc)
+{
+	struct cl_dio_pool *pool;
+	unsigned long count = 0;
+	int i;
+
+	/* a little race here is fine */
+	cfs_percpt_for_each(pool, i, dio_pools)
+		count += pool->dp_free_pages;
+
+	return count;
+}
+
+static unsigned long dio_pools_shrink_scan(struct shrinker *s,
+					   struct shrink_control *sc)
+{
+	struct cl_dio_pool *pool;
+	unsigned long freed = 0;
+	int i;
+
+	cfs_percpt_for_each(pool, i, dio_pools) {
+		unsigned long nr;
+
+		if (freed >= sc->nr_to_scan)
+			break;
+
+		spin_lock(&pool->dp_lock);
+		nr = min(sc->nr_to_scan - freed, pool->dp_free_pages);
+		pool->dp_free_pages -= nr;
+		pool->dp_st_shrinks += nr;
+		freed += nr;
+		while (nr-- > 0)
+			__free_page(pool->dp_pages[pool->dp_free_pages + nr]);
+		spin_unlock(&pool->dp_lock);
+	}
+
+	return freed;
+}
+
+#ifdef HAVE_SHRINKER_COUNT
+static struct shrinker dio_pools_shrinker = {
+	.count_objects	= dio_pools_shrink_count,
+	.scan_objects	= dio_pools_shrink_scan,
+	.seeks		= DEFAULT_SEEKS,
+};
+#else
+static int dio_pools_shrink(struct shrinker *shrinker,
+			    struct shrink_control *sc)
+{
+	if (sc->nr_to_scan > 0)
+		dio_pools_shrink_scan(shrinker, sc);
+
+	return dio_pools_shrink_count(shrinker, sc);
+}
+
+static struct shrinker dio_pools_shrinker = {
+	.shrink  = dio_pools_shrink,
+	.seeks   = DEFAULT_SEEKS,
+};
+#endif /* HAVE_SHRINKER_COUNT */
+
+/*
+ * /sys/kernel/debug/lustre/dio_page_pools
+ */
+int cl_dio_pool_seq_show(struct seq_file *m, void *v)
+{
+	struct cl_dio_pool *pool;
+	int i;
+
+	if (dio_pools == NULL) {
+		seq_puts(m, "disabled\n");
+		return 0;
+	}
+
+	seq_printf(m, "%-8s %10s %10s %12s %12s %10s %10s\n", "cpt",
+		   "max_pages", "free_pages", "access", "missing", "shrinks",
+		   "out_of_mem");
+	cfs_percpt_for_each(pool, i, dio_pools) {
+		spin_lock(&pool->dp_lock);
+		seq_printf(m, "%-8d %10lu %10lu %12lu %12lu %10lu %10lu\n", i,
+			   pool->dp_max_pages, pool->dp_free_pages,
+			   pool->dp_st_access, pool->dp_st_missings,
+			   pool->dp_st_shrinks, pool->dp_st_outofmem);
+		spin_unlock(&pool->dp_lock);
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(cl_dio_pool_seq_show);
+
+static void dio_pools_free(void)
+{
+	struct cl_dio_pool *pool;
+	int i;
+
+	cfs_percpt_for_each(pool, i, dio_pools) {
+		if (pool->dp_pages == NULL)
+			continue;
+
+		while (pool->dp_free_pages > 0)
+			__free_page(pool->dp_pages[--pool->dp_free_pages]);
+		OBD_FREE_PTR_ARRAY_LARGE(pool->dp_pages, pool->dp_max_pages);
+	}
+	cfs_percpt_free(dio_pools);
+	dio_pools = NULL;
+}
+
+int cl_dio_pool_init(void)
+{
+	struct cl_dio_pool *pool;
+	unsigned long max_pages;
+	int ncpts = cfs_cpt_number(cfs_cpt_tab);
+	int rc;
+	int i;
+
+	if (dio_pool_max_memory_mb < 0)
+		return 0;
+
+	max_pages = cfs_totalram_pages() / 64;
+	if (dio_pool_max_memory_mb > 0 &&
+	    dio_pool_max_memory_mb <= (cfs_totalram_pages() >>
+				       (20 - PAGE_SHIFT)))
+		max_pages = (unsigned long)dio_pool_max_memory_mb <<
+			    (20 - PAGE_SHIFT);
+	max_pages = max_t(unsigned long, max_pages / ncpts, 1);
+
+	dio_pools = cfs_percpt_alloc(cfs_cpt_tab, sizeof(*pool));
+	if (dio_pools == NULL)
+		return -ENOMEM;
+
+	cfs_percpt_for_each(pool, i, dio_pools) {
+		spin_lock_init(&pool->dp_lock);
+		pool->dp_max_pages = max_pages;
+		OBD_CPT_ALLOC_LARGE(pool->dp_pages, cfs_cpt_tab, i,
+				    max_pages * sizeof(*pool->dp_pages));
+		if (pool->dp_pages == NULL)
+			GOTO(out, rc = -ENOMEM);
+	}
+
+	rc = register_shrinker(&dio_pools_shrinker);
+out:
+	if (rc)
+		dio_pools_free();
+
+	return rc;
+}
+
+void cl_dio_pool_fini(void)
+{
+	struct cl_dio_pool *pool;
+	int i;
+
+	if (dio_pools == NULL)
+		return;
+
+	unregister_shrinker(&dio_pools_shrinker);
+
+	cfs_percpt_for_each(pool, i, dio_pools) {
+		if (pool->dp_st_access > 0)
+			CDEBUG(D_CACHE,
+			       "cpt %d: access %lu, missing %lu, shrinks %lu, out of mem %lu\n",
+			       i, pool->dp_st_access, pool->dp_st_missings,
+			       pool->dp_st_shrinks, pool->dp_st_outofmem);
+	}
+	dio_pools_free();
+}
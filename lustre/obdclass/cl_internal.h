@@ -35,6 +35,11 @@
 #ifndef _CL_INTERNAL_H
 #define _CL_INTERNAL_H
 
+/**
+ * Maximal number of transient cl_pages preallocated per thread.
+ */
+#define CL_PAGE_STASH_MAX	64
+
 /**
  * Thread local state internal for generic cl-code.
  */
@@ -43,6 +48,14 @@ struct cl_thread_info {
 	 * Used for submitting a sync I/O.
 	 */
 	struct cl_sync_io clt_anchor;
+	/**
+	 * Transient cl_pages allocated in bulk by cl_page_stash_fill(), all
+	 * from cl_page_kmem_array[clt_page_stash_index]. Each one still
+	 * describes a single PAGE_SIZE page.
+	 */
+	void		 *clt_page_stash[CL_PAGE_STASH_MAX];
+	unsigned int	  clt_page_stash_nr;
+	int		  clt_page_stash_index;
 };
 
 extern struct kmem_cache *cl_dio_aio_kmem;
@@ -52,5 +65,6 @@ extern unsigned short cl_page_kmem_size_array[16];
 
 struct cl_thread_info *cl_env_info(const struct lu_env *env);
 void __cl_page_disown(const struct lu_env *env, struct cl_page *pg);
+void cl_page_stash_release(struct cl_thread_info *info);
 
 #endif /* _CL_INTERNAL_H */
@@ -1354,12 +1354,19 @@ EXPORT_SYMBOL(cl_sub_dio_free);
  * hold it.  The pages in this buffer are aligned with pages in the file (ie,
  * they have a 1-to-1 mapping with file pages).
  */
+static void ll_dio_pages_array_free(struct ll_dio_pages *pvec)
+{
+#ifdef HAVE_DIO_ITER
+	kfree(pvec->ldp_pages);
+#else
+	OBD_FREE_PTR_ARRAY_LARGE(pvec->ldp_pages, pvec->ldp_count);
+#endif
+}
+
 int ll_allocate_dio_buffer(struct ll_dio_pages *pvec, size_t io_size)
 {
-	struct page *new_page;
 	size_t pg_offset;
 	int result = 0;
-	ssize_t i;
 
 	ENTRY;
 
@@ -1385,24 +1392,11 @@ int ll_allocate_dio_buffer(struct ll_dio_pages *pvec, size_t io_size)
 	if (pvec->ldp_pages == NULL)
 		RETURN(-ENOMEM);
 
-	for (i = 0; i < pvec->ldp_count; i++) {
-		new_page = alloc_page(GFP_NOFS);
-		if (!new_page) {
-			result = -ENOMEM;
-			pvec->ldp_count = i;
-			goto out;
-		}
-		pvec->ldp_pages[i] = new_page;
-	}
-	WARN_ON(i != pvec->ldp_count);
-
-out:
-	if (result) {
-		if (pvec->ldp_pages)
-			ll_free_dio_buffer(pvec);
-	}
-
-	if (result == 0)
+	/* the bounce pages come from the pool, see cl_dio_pool.c */
+	result = cl_dio_pool_get_pages(pvec->ldp_pages, pvec->ldp_count);
+	if (result)
+		ll_dio_pages_array_free(pvec);
+	else
 		result = pvec->ldp_count;
 
 	RETURN(result);
@@ -1411,16 +1405,8 @@ EXPORT_SYMBOL(ll_allocate_dio_buffer);
 
 void ll_free_dio_buffer(struct ll_dio_pages *pvec)
 {
-	int i;
-
-	for (i = 0; i < pvec->ldp_count; i++)
-		__free_page(pvec->ldp_pages[i]);
-
-#ifdef HAVE_DIO_ITER
-	kfree(pvec->ldp_pages);
-#else
-	OBD_FREE_PTR_ARRAY_LARGE(pvec->ldp_pages, pvec->ldp_count);
-#endif
+	cl_dio_pool_put_pages(pvec->ldp_pages, pvec->ldp_count);
+	ll_dio_pages_array_free(pvec);
 }
 EXPORT_SYMBOL(ll_free_dio_buffer);
 
@@ -1058,8 +1058,17 @@ struct cl_thread_info *cl_env_info(const struct lu_env *env)
         return lu_context_key_get(&env->le_ctx, &cl_key);
 }
 
-/* defines cl_key_{init,fini}() */
-LU_KEY_INIT_FINI(cl, struct cl_thread_info);
+/* defines cl_key_init() */
+LU_KEY_INIT(cl, struct cl_thread_info);
+
+static void cl_key_fini(const struct lu_context *ctx,
+			struct lu_context_key *key, void *data)
+{
+	struct cl_thread_info *info = data;
+
+	cl_page_stash_release(info);
+	OBD_FREE_PTR(info);
+}
 
 static struct lu_context_key cl_key = {
         .lct_tags = LCT_CL_THREAD,
@@ -1115,8 +1124,14 @@ int cl_global_init(void)
 	if (result) /* no cl_env_percpu_fini on error */
 		GOTO(out_keys, result);
 
+	result = cl_dio_pool_init();
+	if (result)
+		GOTO(out_percpu, result);
+
 	return 0;
 
+out_percpu:
+	cl_env_percpu_fini();
 out_keys:
 	lu_context_key_degister(&cl_key);
 out_kmem:
@@ -1134,14 +1149,16 @@ void cl_global_fini(void)
 {
 	int i;
 
+	cl_dio_pool_fini();
+	cl_env_percpu_fini();
+	/* cl_key_fini() may return stashed pages to cl_page_kmem_array */
+	lu_context_key_degister(&cl_key);
 	for (i = 0; i < ARRAY_SIZE(cl_page_kmem_array); i++) {
 		if (cl_page_kmem_array[i]) {
 			kmem_cache_destroy(cl_page_kmem_array[i]);
 			cl_page_kmem_array[i] = NULL;
 		}
 	}
-	cl_env_percpu_fini();
-	lu_context_key_degister(&cl_key);
 	lu_kmem_fini(cl_object_caches);
 	OBD_FREE_PTR_ARRAY(cl_envs, num_possible_cpus());
 }
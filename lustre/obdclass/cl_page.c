@@ -196,14 +196,17 @@ static void cl_page_free(const struct lu_env *env, struct cl_page *cp,
 	EXIT;
 }
 
-static struct cl_page *__cl_page_alloc(struct cl_object *o)
+/**
+ * Returns the index in cl_page_kmem_array of the slab cache used for
+ * cl_pages of \a bufsize bytes, creating that cache when needed.
+ *
+ * \retval >= 0	index of the cache
+ * \retval -ENOSPC	all cache slots are used by other sizes
+ * \retval -ENOMEM	the cache could not be created
+ */
+static int cl_page_kmem_index(unsigned short bufsize)
 {
 	int i = 0;
-	struct cl_page *cl_page = NULL;
-	unsigned short bufsize = cl_object_header(o)->coh_page_bufsize;
-
-	if (CFS_FAIL_CHECK(OBD_FAIL_LLITE_PAGE_ALLOC))
-		return NULL;
 
 check:
 	/* the number of entries in cl_page_kmem_array is expected to
@@ -211,13 +214,8 @@ check:
 	 */
 	for ( ; i < ARRAY_SIZE(cl_page_kmem_array); i++) {
 		if (smp_load_acquire(&cl_page_kmem_size_array[i])
-		    == bufsize) {
-			OBD_SLAB_ALLOC_GFP(cl_page, cl_page_kmem_array[i],
-					   bufsize, GFP_NOFS);
-			if (cl_page)
-				cl_page->cp_kmem_index = i;
-			return cl_page;
-		}
+		    == bufsize)
+			return i;
 		if (cl_page_kmem_size_array[i] == 0)
 			break;
 	}
@@ -237,13 +235,135 @@ check:
 					  0, 0, NULL);
 		if (cl_page_kmem_array[i] == NULL) {
 			mutex_unlock(&cl_page_kmem_mutex);
-			return NULL;
+			return -ENOMEM;
 		}
 		smp_store_release(&cl_page_kmem_size_array[i],
 				  bufsize);
 		mutex_unlock(&cl_page_kmem_mutex);
 		goto check;
-	} else {
+	}
+
+	return -ENOSPC;
+}
+
+/**
+ * Takes a preallocated cl_page from the per-thread stash, if the stash was
+ * filled from the cache \a index.
+ */
+static struct cl_page *cl_page_stash_get(const struct lu_env *env, int index,
+					 unsigned short bufsize)
+{
+	struct cl_thread_info *info = cl_env_info(env);
+	struct cl_page *cl_page;
+
+	if (info->clt_page_stash_nr == 0 ||
+	    info->clt_page_stash_index != index)
+		return NULL;
+
+	cl_page = info->clt_page_stash[--info->clt_page_stash_nr];
+	memset(cl_page, 0, bufsize);
+
+	return cl_page;
+}
+
+/**
+ * Preallocates up to \a count cl_pages of \a obj in the per-thread stash, so
+ * that the following cl_page_alloc() calls of a large direct I/O, buffered
+ * write or readahead take them from there instead of going to the slab
+ * allocator once per page.
+ *
+ * This only batches the slab allocations: there is still one cl_page (and
+ * one set of per-layer slices) for each PAGE_SIZE page of the I/O, and their
+ * setup and per-page processing are unchanged.
+ *
+ * Does nothing if the stash is not empty. Pages left unused must be returned
+ * with cl_page_stash_drain() before the environment is released.
+ */
+void cl_page_stash_fill(const struct lu_env *env, struct cl_object *obj,
+			unsigned int count)
+{
+#ifdef HAVE_KMEM_CACHE_ALLOC_BULK
+	struct cl_thread_info *info = cl_env_info(env);
+	unsigned short bufsize = cl_object_header(obj)->coh_page_bufsize;
+	int index;
+	int nr;
+	int i;
+
+	if (info->clt_page_stash_nr > 0 || count < 2)
+		return;
+
+	index = cl_page_kmem_index(bufsize);
+	if (index < 0)
+		return;
+
+	count = min_t(unsigned int, count, CL_PAGE_STASH_MAX);
+	nr = kmem_cache_alloc_bulk(cl_page_kmem_array[index], GFP_NOFS,
+				   count, info->clt_page_stash);
+	for (i = 0; i < nr; i++) {
+		OBD_ALLOC_POST(info->clt_page_stash[i], bufsize,
+			       "slab-alloced");
+	}
+	info->clt_page_stash_nr = nr;
+	info->clt_page_stash_index = index;
+#endif
+}
+EXPORT_SYMBOL(cl_page_stash_fill);
+
+void cl_page_stash_release(struct cl_thread_info *info)
+{
+	int index = info->clt_page_stash_index;
+#ifdef HAVE_KMEM_CACHE_ALLOC_BULK
+	int i;
+
+	if (info->clt_page_stash_nr == 0)
+		return;
+
+	for (i = 0; i < info->clt_page_stash_nr; i++)
+		OBD_FREE_PRE(info->clt_page_stash[i],
+			     cl_page_kmem_size_array[index], "slab-freed");
+	kmem_cache_free_bulk(cl_page_kmem_array[index],
+			     info->clt_page_stash_nr, info->clt_page_stash);
+	info->clt_page_stash_nr = 0;
+#else
+	void *cl_page;
+
+	while (info->clt_page_stash_nr > 0) {
+		cl_page = info->clt_page_stash[--info->clt_page_stash_nr];
+		OBD_SLAB_FREE(cl_page, cl_page_kmem_array[index],
+			      cl_page_kmem_size_array[index]);
+	}
+#endif
+}
+
+/**
+ * Frees the cl_pages left in the per-thread stash by cl_page_stash_fill().
+ */
+void cl_page_stash_drain(const struct lu_env *env)
+{
+	cl_page_stash_release(cl_env_info(env));
+}
+EXPORT_SYMBOL(cl_page_stash_drain);
+
+static struct cl_page *__cl_page_alloc(const struct lu_env *env,
+				       struct cl_object *o,
+				       enum cl_page_type type)
+{
+	struct cl_page *cl_page = NULL;
+	unsigned short bufsize = cl_object_header(o)->coh_page_bufsize;
+	int index;
+
+	if (CFS_FAIL_CHECK(OBD_FAIL_LLITE_PAGE_ALLOC))
+		return NULL;
+
+	index = cl_page_kmem_index(bufsize);
+	if (index >= 0) {
+		cl_page = cl_page_stash_get(env, index, bufsize);
+		if (cl_page == NULL)
+			OBD_SLAB_ALLOC_GFP(cl_page, cl_page_kmem_array[index],
+					   bufsize, GFP_NOFS);
+		if (cl_page)
+			cl_page->cp_kmem_index = index;
+	} else if (index == -ENOSPC) {
 		OBD_ALLOC_GFP(cl_page, bufsize, GFP_NOFS);
 		if (cl_page)
 			cl_page->cp_kmem_index = -1;
@@ -261,7 +381,7 @@ struct cl_page *cl_page_alloc(const struct lu_env *env, struct cl_object *o,
 
 	ENTRY;
 
-	cl_page = __cl_page_alloc(o);
+	cl_page = __cl_page_alloc(env, o, type);
 	if (cl_page != NULL) {
 		int result = 0;
 
@@ -798,6 +918,48 @@ void cl_page_discard(const struct lu_env *env,
 }
 EXPORT_SYMBOL(cl_page_discard);
 
+/**
+ * Keeps a clean page in the cache when the lock covering it is cancelled,
+ * instead of discarding it with cl_page_discard(). The page is no longer up
+ * to date, so it cannot be used until the next read either revalidates it or
+ * reads it again.
+ *
+ * \pre cl_page_is_owned(cp, io)
+ *
+ * \retval true if the page is kept stale
+ * \retval false if the page must be discarded
+ *
+ * \see cl_page_operations::cpo_stale()
+ */
+bool cl_page_stale(const struct lu_env *env, struct cl_io *io,
+		   struct cl_page *cp)
+{
+	const struct cl_page_slice *slice;
+	struct page *vmpage = cp->cp_vmpage;
+	int i;
+
+	PINVRNT(env, cp, cl_page_is_owned(cp, io));
+	PINVRNT(env, cp, cl_page_invariant(cp));
+
+	if (cp->cp_type != CPT_CACHEABLE)
+		return false;
+
+	LASSERT(vmpage != NULL);
+	LASSERT(PageLocked(vmpage));
+	/* mapped pages would stay readable through the page tables */
+	if (!PageUptodate(vmpage) || PageDirty(vmpage) ||
+	    PageWriteback(vmpage) || page_mapped(vmpage))
+		return false;
+
+	cl_page_slice_for_each(cp, slice, i) {
+		if (slice->cpl_ops->cpo_stale != NULL)
+			(*slice->cpl_ops->cpo_stale)(env, slice, io);
+	}
+
+	return true;
+}
+EXPORT_SYMBOL(cl_page_stale);
+
 /**
  * Version of cl_page_delete() that can be called for not fully constructed
  * cl_pages, e.g. in an error handling cl_page_find()->__cl_page_delete()
@@ -42,6 +42,7 @@
 #include <obd_class.h>
 #include <uapi/linux/lnet/lnetctl.h>
 #include <lustre_kernelcomm.h>
+#include <lustre_compr.h>
 #include <lprocfs_status.h>
 #include <cl_object.h>
 #ifdef HAVE_SERVER_SUPPORT
@@ -879,6 +880,7 @@ static void __exit obdclass_exit(void)
 	lu_global_fini();
 
 	obd_cleanup_caches();
+	lustre_compr_fini();
 
 	class_procfs_clean();
 
@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/obdclass/lustre_compr.c
+ *
+ * Chunk compression of BRW bulk data for LOV_PATTERN_COMPRESS components.
+ *
+ * The algorithms are used through the synchronous compression interface of
+ * the kernel crypto API. A transform keeps the working memory of its
+ * algorithm and can only be used by one thread at a time, so a few idle
+ * transforms are cached per algorithm instead of allocating one per chunk.
+ */
+
+#define DEBUG_SUBSYSTEM S_CLASS
+
+#include <linux/crypto.h>
+#include <linux/vmalloc.h>
+#include <obd_support.h>
+#include <lustre_compr.h>
+
+#define COMPR_TFM_CACHE		8	/* idle transforms kept per algorithm */
+
+struct compr_alg {
+	const char		*ca_name;
+	spinlock_t		 ca_lock;
+	int			 ca_nr_idle;
+	struct crypto_comp	*ca_idle[COMPR_TFM_CACHE];
+};
+
+enum compr_alg_idx {
+	CA_LZ4,
+	CA_LZ4HC,	/* LL_COMPR_TYPE_LZ4 with level > 0, same data format */
+	CA_ZSTD,
+	CA_MAX,
+};
+
+#define COMPR_ALG(idx, name)						\
+	[idx] = {							\
+		.ca_name = name,					\
+		.ca_lock = __SPIN_LOCK_UNLOCKED(compr_algs[idx].ca_lock), \
+	}
+
+static struct compr_alg compr_algs[CA_MAX] = {
+	COMPR_ALG(CA_LZ4, "lz4"),
+	COMPR_ALG(CA_LZ4HC, "lz4hc"),
+	COMPR_ALG(CA_ZSTD, "zstd"),
+};
+
+static struct compr_alg *compr_alg_find(enum ll_compr_type type,
+					unsigned int lvl)
+{
+	switch (type) {
+	case LL_COMPR_TYPE_LZ4:
+		return &compr_algs[lvl > 0 ? CA_LZ4HC : CA_LZ4];
+	case LL_COMPR_TYPE_ZSTD:
+		/* the crypto API always uses the default zstd level */
+		return &compr_algs[CA_ZSTD];
+	default:
+		return NULL;
+	}
+}
+
+static struct crypto_comp *compr_tfm_get(struct compr_alg *ca)
+{
+	struct crypto_comp *tfm = NULL;
+
+	spin_lock(&ca->ca_lock);
+	if (ca->ca_nr_idle > 0)
+		tfm = ca->ca_idle[--ca->ca_nr_idle];
+	spin_unlock(&ca->ca_lock);
+
+	if (!tfm)
+		tfm = crypto_alloc_comp(ca->ca_name, 0, 0);
+
+	return tfm;
+}
+
+static void compr_tfm_put(struct compr_alg *ca, struct crypto_comp *tfm)
+{
+	spin_lock(&ca->ca_lock);
+	if (ca->ca_nr_idle < COMPR_TFM_CACHE) {
+		ca->ca_idle[ca->ca_nr_idle++] = tfm;
+		tfm = NULL;
+	}
+	spin_unlock(&ca->ca_lock);
+
+	if (tfm)
+		crypto_free_comp(tfm);
+}
+
+__u64 lustre_compr_types_supported(void)
+{
+	__u64 types = 0;
+
+	if (crypto_has_comp(compr_algs[CA_LZ4].ca_name, 0, 0))
+		types |= BIT_ULL(LL_COMPR_TYPE_LZ4);
+	if (crypto_has_comp(compr_algs[CA_ZSTD].ca_name, 0, 0))
+		types |= BIT_ULL(LL_COMPR_TYPE_ZSTD);
+
+	return types;
+}
+EXPORT_SYMBOL(lustre_compr_types_supported);
+
+/**
+ * Compress one chunk for the bulk of a BRW write.
+ *
+ * \param[in] type	compression algorithm
+ * \param[in] lvl	compression level
+ * \param[in] chunk_bits	log2 of the chunk size
+ * \param[in] src	the (1 << chunk_bits) / PAGE_SIZE pages of the chunk
+ * \param[in] dst	one page less than \a src to compress into
+ * \param[out] bulk_size	bytes of \a dst used, header and padding included
+ *
+ * \retval 0		the chunk is compressed into \a dst
+ * \retval -E2BIG	the chunk does not save at least one page, it should
+ *			be sent uncompressed
+ * \retval negative	other errors
+ */
+int lustre_compr_chunk(enum ll_compr_type type, unsigned int lvl,
+		       unsigned int chunk_bits, struct page **src,
+		       struct page **dst, unsigned int *bulk_size)
+{
+	unsigned int npages = 1U << (chunk_bits - PAGE_SHIFT);
+	unsigned int hdr_size = sizeof(struct ll_compr_hdr);
+	unsigned int dst_len = (npages - 1) * PAGE_SIZE - hdr_size;
+	struct ll_compr_hdr *hdr;
+	struct crypto_comp *tfm;
+	struct compr_alg *ca;
+	void *src_buf;
+	void *dst_buf;
+	int rc;
+
+	if (npages < 2)
+		return -E2BIG;
+
+	ca = compr_alg_find(type, lvl);
+	if (!ca)
+		return -EOPNOTSUPP;
+
+	tfm = compr_tfm_get(ca);
+	if (IS_ERR(tfm) && ca == &compr_algs[CA_LZ4HC]) {
+		ca = &compr_algs[CA_LZ4];
+		tfm = compr_tfm_get(ca);
+	}
+	if (IS_ERR(tfm))
+		return PTR_ERR(tfm);
+
+	src_buf = vmap(src, npages, VM_MAP, PAGE_KERNEL);
+	dst_buf = vmap(dst, npages - 1, VM_MAP, PAGE_KERNEL);
+	if (!src_buf || !dst_buf)
+		GOTO(out, rc = -ENOMEM);
+
+	rc = crypto_comp_compress(tfm, src_buf, npages * PAGE_SIZE,
+				  dst_buf + hdr_size, &dst_len);
+	if (rc) {
+		/* most likely the output did not fit into dst */
+		CDEBUG(D_PAGE, "%s: chunk not compressed: rc = %d\n",
+		       ca->ca_name, rc);
+		GOTO(out, rc = -E2BIG);
+	}
+
+	*bulk_size = round_up(hdr_size + dst_len, PAGE_SIZE);
+	memset(dst_buf + hdr_size + dst_len, 0,
+	       *bulk_size - hdr_size - dst_len);
+
+	hdr = dst_buf;
+	hdr->llch_magic = cpu_to_le32(LLCH_MAGIC);
+	hdr->llch_compr_type = type;
+	hdr->llch_compr_lvl = lvl;
+	hdr->llch_chunk_bits = chunk_bits;
+	hdr->llch_hdr_size = hdr_size;
+	hdr->llch_compr_size = cpu_to_le32(dst_len);
+	hdr->llch_bulk_size = cpu_to_le32(*bulk_size);
+out:
+	if (dst_buf)
+		vunmap(dst_buf);
+	if (src_buf)
+		vunmap(src_buf);
+	compr_tfm_put(ca, tfm);
+
+	return rc;
+}
+EXPORT_SYMBOL(lustre_compr_chunk);
+
+/**
+ * Decompress one chunk received in the bulk of a BRW write.
+ *
+ * \param[in] hdr	chunk header in the received bulk, followed by the
+ *			compressed data
+ * \param[in] avail	bytes of the bulk from \a hdr to its end
+ * \param[in] dst	pages to decompress into
+ * \param[in] dst_count	number of pages in \a dst
+ *
+ * \retval positive	bytes of the bulk used by this chunk
+ * \retval negative	the chunk is malformed or cannot be decompressed
+ */
+int lustre_decompr_chunk(const struct ll_compr_hdr *hdr, unsigned int avail,
+			 struct page **dst, unsigned int dst_count)
+{
+	unsigned int compr_size;
+	unsigned int bulk_size;
+	unsigned int dst_len;
+	struct crypto_comp *tfm;
+	struct compr_alg *ca;
+	void *dst_buf;
+	int rc;
+
+	if (avail < sizeof(*hdr) || le32_to_cpu(hdr->llch_magic) != LLCH_MAGIC)
+		return -EPROTO;
+
+	compr_size = le32_to_cpu(hdr->llch_compr_size);
+	bulk_size = le32_to_cpu(hdr->llch_bulk_size);
+	if (hdr->llch_hdr_size < sizeof(*hdr) ||
+	    hdr->llch_chunk_bits < COMPR_CHUNK_MIN_BITS ||
+	    hdr->llch_chunk_bits > COMPR_CHUNK_MAX_BITS ||
+	    (1UL << hdr->llch_chunk_bits) != (unsigned long)dst_count <<
+					      PAGE_SHIFT ||
+	    bulk_size > avail || bulk_size < hdr->llch_hdr_size ||
+	    compr_size > bulk_size - hdr->llch_hdr_size)
+		return -EPROTO;
+
+	/* decompression does not depend on the level */
+	ca = compr_alg_find(hdr->llch_compr_type, 0);
+	if (!ca)
+		return -EPROTO;
+
+	tfm = compr_tfm_get(ca);
+	if (IS_ERR(tfm))
+		return PTR_ERR(tfm);
+
+	dst_buf = vmap(dst, dst_count, VM_MAP, PAGE_KERNEL);
+	if (!dst_buf)
+		GOTO(out, rc = -ENOMEM);
+
+	dst_len = dst_count << PAGE_SHIFT;
+	rc = crypto_comp_decompress(tfm, (const u8 *)hdr + hdr->llch_hdr_size,
+				    compr_size, dst_buf, &dst_len);
+	vunmap(dst_buf);
+	if (rc == 0 && dst_len != dst_count << PAGE_SHIFT)
+		rc = -EPROTO;
+	if (rc == 0)
+		rc = bulk_size;
+out:
+	compr_tfm_put(ca, tfm);
+
+	return rc;
+}
+EXPORT_SYMBOL(lustre_decompr_chunk);
+
+void lustre_compr_fini(void)
+{
+	int i;
+
+	for (i = 0; i < CA_MAX; i++) {
+		struct compr_alg *ca = &compr_algs[i];
+
+		while (ca->ca_nr_idle > 0)
+			crypto_free_comp(ca->ca_idle[--ca->ca_nr_idle]);
+	}
+}
@@ -65,6 +65,7 @@
 #include <libcfs/libcfs_crypto.h>
 #include <obd_support.h>
 #include <obd_class.h>
+#include <cl_object.h>
 #include <lprocfs_status.h>
 #include <uapi/linux/lnet/lnetctl.h>
 #include <uapi/linux/lustre/lustre_ioctl.h>
@@ -645,6 +646,12 @@ health_check_seq_show(struct seq_file *m, void *unused)
 
 LDEBUGFS_SEQ_FOPS_RO(health_check);
 
+static int dio_page_pools_seq_show(struct seq_file *m, void *v)
+{
+	return cl_dio_pool_seq_show(m, v);
+}
+LDEBUGFS_SEQ_FOPS_RO(dio_page_pools);
+
 struct kset *lustre_kset;
 EXPORT_SYMBOL_GPL(lustre_kset);
 
@@ -706,6 +713,9 @@ int class_procfs_init(void)
 	file = debugfs_create_file("checksum_speed", 0444, debugfs_lustre_root,
 				   NULL, &checksum_speed_fops);
 
+	file = debugfs_create_file("dio_page_pools", 0444, debugfs_lustre_root,
+				   NULL, &dio_page_pools_fops);
+
 	entry = lprocfs_register("fs/lustre", NULL, NULL, NULL);
 	if (IS_ERR(entry)) {
 		rc = PTR_ERR(entry);
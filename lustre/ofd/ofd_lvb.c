@@ -66,6 +66,28 @@ static int ofd_lvbo_free(struct ldlm_resource *res)
 	return 0;
 }
 
+/**
+ * Low 32 bits of the data version of \a fo to be sent in the LVB.
+ *
+ * A client keeping clean pages after its lock is cancelled uses it to check
+ * that they are still valid when it gets a new lock, see osc_page::ops_stale.
+ * The version is a transno which grows with every modification of the
+ * object, so only 2^32 modifications can bring the same value back.
+ *
+ * \retval		low 32 bits of the data version
+ * \retval 0		if the OSD does not keep object versions
+ */
+static __u32 ofd_lvb_data_version(const struct lu_env *env,
+				  struct ofd_object *fo)
+{
+	__u64 version = dt_version_get(env, ofd_object_child(fo));
+
+	if ((__s64)version == -EOPNOTSUPP)
+		return 0;
+
+	return (__u32)version;
+}
+
 static bool ofd_resync_allowed(struct ofd_device *ofd)
 {
 	struct obd_device *obd = ofd_obd(ofd);
@@ -160,6 +182,7 @@ static int ofd_lvbo_init(struct ldlm_resource *res)
 	lvb->lvb_mtime = info->fti_attr.la_mtime;
 	lvb->lvb_atime = info->fti_attr.la_atime;
 	lvb->lvb_ctime = info->fti_attr.la_ctime;
+	lvb->lvb_data_version = ofd_lvb_data_version(env, fo);
 
 	if (fo->ofo_atime_ondisk == 0)
 		fo->ofo_atime_ondisk = info->fti_attr.la_atime;
@@ -219,6 +242,7 @@ static int ofd_lvbo_update(struct ldlm_resource *res, struct ldlm_lock *lock,
 	struct ofd_object *fo;
 	struct ost_lvb	*lvb;
 	const struct lu_env *env;
+	__u32 version;
 	int rc = 0;
 
 	ENTRY;
@@ -317,7 +341,11 @@ disk_update:
 	if (rc)
 		GOTO(out_obj, rc);
 
+	version = ofd_lvb_data_version(env, fo);
+
 	lock_res(res);
+	/* the version only grows, it is never taken from a client */
+	lvb->lvb_data_version = version;
 	if (info->fti_attr.la_size > lvb->lvb_size || !increase_only) {
 		CDEBUG(D_DLMTRACE, "res: "DFID" updating lvb size from disk: "
 		       "%llu -> %llu\n", PFID(&info->fti_fid),
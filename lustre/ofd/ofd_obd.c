@@ -44,6 +44,7 @@
 
 #include "ofd_internal.h"
 #include <obd_cksum.h>
+#include <lustre_compr.h>
 #include <uapi/linux/lustre/lustre_ioctl.h>
 #include <lustre_quota.h>
 #include <lustre_lfsck.h>
@@ -201,6 +202,12 @@ static int ofd_parse_connect_data(const struct lu_env *env,
 		data->ocd_grant_max_blks = ddp->ddp_max_extent_blks;
 	}
 
+	if (OCD_HAS_FLAG2(data, COMPRESS)) {
+		data->ocd_compr_type &= lustre_compr_types_supported();
+		if (data->ocd_compr_type == 0)
+			data->ocd_connect_flags2 &= ~OBD_CONNECT2_COMPRESS;
+	}
+
 	/*
 	 * Save connect_data we have so far because tgt_grant_connect()
 	 * uses it to calculate grant, and we want to save the client
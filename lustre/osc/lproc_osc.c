@@ -136,6 +136,85 @@ static ssize_t max_rpcs_in_flight_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(max_rpcs_in_flight);
 
+static ssize_t max_rpcs_in_flight_auto_show(struct kobject *kobj,
+					    struct attribute *attr,
+					    char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &obd->u.cli;
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", cli->cl_rpc_window_auto);
+}
+
+static ssize_t max_rpcs_in_flight_auto_store(struct kobject *kobj,
+					     struct attribute *attr,
+					     const char *buffer,
+					     size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	osc_rpc_window_enable(&obd->u.cli, val);
+
+	return count;
+}
+LUSTRE_RW_ATTR(max_rpcs_in_flight_auto);
+
+static ssize_t cur_rpcs_in_flight_limit_show(struct kobject *kobj,
+					     struct attribute *attr,
+					     char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &obd->u.cli;
+	u32 limit;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	limit = rpcs_in_flight_limit(cli);
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", limit);
+}
+LUSTRE_RO_ATTR(cur_rpcs_in_flight_limit);
+
+static ssize_t keep_stale_pages_show(struct kobject *kobj,
+				     struct attribute *attr,
+				     char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 obd->u.cli.cl_keep_stale_pages);
+}
+
+static ssize_t keep_stale_pages_store(struct kobject *kobj,
+				      struct attribute *attr,
+				      const char *buffer,
+				      size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	obd->u.cli.cl_keep_stale_pages = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(keep_stale_pages);
+
 static ssize_t max_dirty_mb_show(struct kobject *kobj,
 				 struct attribute *attr,
 				 char *buf)
@@ -829,6 +908,10 @@ static int osc_stats_seq_show(struct seq_file *seq, void *v)
 		   stats->os_lockless_writes);
 	seq_printf(seq, "lockless_read_bytes\t\t%llu\n",
 		   stats->os_lockless_reads);
+	seq_printf(seq, "compr_write_bytes\t\t%llu\n",
+		   stats->os_compr_write_bytes);
+	seq_printf(seq, "compr_bulk_bytes\t\t%llu\n",
+		   stats->os_compr_bulk_bytes);
 	return 0;
 }
 
@@ -878,6 +961,9 @@ static struct attribute *osc_attrs[] = {
 	&lustre_attr_grant_shrink_interval.attr,
 	&lustre_attr_max_dirty_mb.attr,
 	&lustre_attr_max_rpcs_in_flight.attr,
+	&lustre_attr_max_rpcs_in_flight_auto.attr,
+	&lustre_attr_cur_rpcs_in_flight_limit.attr,
+	&lustre_attr_keep_stale_pages.attr,
 	&lustre_attr_short_io_bytes.attr,
 	&lustre_attr_resend_count.attr,
 	&lustre_attr_ost_conn_uuid.attr,
@@ -1627,7 +1627,13 @@ out:
 static int osc_max_rpc_in_flight(struct client_obd *cli, struct osc_object *osc)
 {
 	int hprpc = !!list_empty(&osc->oo_hp_exts);
-	return rpcs_in_flight(cli) >= cli->cl_max_rpcs_in_flight + hprpc;
+
+	if (rpcs_in_flight(cli) < rpcs_in_flight_limit(cli) + hprpc)
+		return 0;
+
+	/* more RPCs could be sent, a wider window may help */
+	cli->cl_rpc_window_full = 1;
+	return 1;
 }
 
 /* This maintains the lists of pending pages to read/write for a given object
@@ -3143,6 +3149,101 @@ bool osc_page_gang_lookup(const struct lu_env *env, struct cl_io *io,
 }
 EXPORT_SYMBOL(osc_page_gang_lookup);
 
+/**
+ * Decide whether the clean pages covered by a cancelled read lock can be kept
+ * stale instead of being discarded, see osc_page::ops_stale. Nothing can
+ * modify them while the lock is held, so they are valid for as long as the
+ * OST reports the data version received with the LVBs of the object so far.
+ * No RPC is sent here, this is called from lock cancellation.
+ *
+ * Pages kept with another data version must be gone before a new one is
+ * recorded. On success, oo_nr_stale is held until osc_stale_keep_end().
+ */
+static bool osc_stale_keep_start(struct osc_object *osc)
+{
+	__u32 dv;
+	bool keep = false;
+
+	if (!osc_cli(osc)->cl_keep_stale_pages || osc->oo_npages == 0)
+		return false;
+
+	/* the OST does not send the data version */
+	dv = READ_ONCE(osc->oo_lvb_dv);
+	if (dv == 0)
+		return false;
+
+	osc_object_lock(osc);
+	if (atomic_read(&osc->oo_nr_stale) == 0 || osc->oo_stale_dv == dv) {
+		osc->oo_stale_dv = dv;
+		atomic_inc(&osc->oo_nr_stale);
+		keep = true;
+	}
+	osc_object_unlock(osc);
+
+	return keep;
+}
+
+static void osc_stale_keep_end(struct osc_object *osc)
+{
+	atomic_dec(&osc->oo_nr_stale);
+}
+
+static bool osc_page_stale_keep(const struct lu_env *env, struct cl_io *io,
+				struct osc_object *osc, struct osc_page *ops)
+{
+	struct cl_page *page = ops->ops_cl.cpl_page;
+
+	/* already stale with the same data version */
+	if (ops->ops_stale && !PageUptodate(cl_page_vmpage(page)))
+		return true;
+
+	if (!cl_page_stale(env, io, page))
+		return false;
+
+	if (!ops->ops_stale) {
+		ops->ops_stale = true;
+		atomic_inc(&osc->oo_nr_stale);
+	}
+
+	return true;
+}
+
+void osc_page_stale_clear(struct osc_object *osc, struct osc_page *opg)
+{
+	if (opg->ops_stale) {
+		opg->ops_stale = false;
+		atomic_dec(&osc->oo_nr_stale);
+	}
+}
+
+/**
+ * Check whether the stale pages of \a osc can be used again, i.e. whether
+ * the object was not modified since they were kept. The caller holds a lock
+ * covering the pages which was granted after they were kept, and the data
+ * version in its LVB is compared, so this sends no RPC. Nothing can modify
+ * the pages after the check either.
+ *
+ * Once the check fails, the stale pages of the object will never be valid
+ * again, so the next callers do not need to check.
+ */
+int osc_stale_revalidate(struct osc_object *osc)
+{
+	__u32 dv = READ_ONCE(osc->oo_lvb_dv);
+	int rc = 0;
+
+	osc_object_lock(osc);
+	if (osc->oo_stale_dv == OSC_STALE_DV_NONE || osc->oo_stale_dv != dv) {
+		osc->oo_stale_dv = OSC_STALE_DV_NONE;
+		rc = -ESTALE;
+	}
+	osc_object_unlock(osc);
+
+	CDEBUG(D_CACHE, "object %p: stale pages %s, data version %u\n",
+	       osc, rc ? "dropped" : "revalidated", dv);
+
+	return rc;
+}
+
 /**
  * Check if page @page is covered by an extra lock or discard it.
  */
@@ -3206,7 +3307,9 @@ static bool check_and_discard_cb(const struct lu_env *env, struct cl_io *io,
 
 		if (discard) {
 			if (cl_page_own(env, io, page) == 0) {
-				cl_page_discard(env, io, page);
+				if (!info->oti_stale_keep ||
+				    !osc_page_stale_keep(env, io, osc, ops))
+					cl_page_discard(env, io, page);
 				cl_page_disown(env, io, page);
 			} else {
 				LASSERT(page->cp_state == CPS_FREEING);
@@ -3278,9 +3381,13 @@ int osc_lock_discard_pages(const struct lu_env *env, struct osc_object *osc,
 	cb = discard ? osc_discard_cb : check_and_discard_cb;
 	info->oti_fn_index = info->oti_next_index = start;
 	info->oti_ng_index = 0;
+	info->oti_stale_keep = !discard && osc_stale_keep_start(osc);
 
 	osc_page_gang_lookup(env, io, osc,
 			     info->oti_next_index, end, cb, osc);
+
+	if (info->oti_stale_keep)
+		osc_stale_keep_end(osc);
 out:
 	cl_io_fini(env, io);
 	RETURN(result);
@@ -44,12 +44,18 @@ extern struct ptlrpc_request_pool *osc_rq_pool;
 int osc_shrink_grant_to_target(struct client_obd *cli, __u64 target_bytes);
 void osc_schedule_grant_work(void);
 void osc_update_next_shrink(struct client_obd *cli);
+void osc_rpc_window_enable(struct client_obd *cli, bool enable);
 int lru_queue_work(const struct lu_env *env, void *data);
 int osc_extent_finish(const struct lu_env *env, struct osc_extent *ext,
 		      int sent, int rc);
 void osc_extent_release(const struct lu_env *env, struct osc_extent *ext);
 int osc_lock_discard_pages(const struct lu_env *env, struct osc_object *osc,
 			   pgoff_t start, pgoff_t end, bool discard);
+/* osc_object::oo_stale_dv once its stale pages are known to be invalid */
+#define OSC_STALE_DV_NONE	0
+
+int osc_stale_revalidate(struct osc_object *osc);
+void osc_page_stale_clear(struct osc_object *osc, struct osc_page *opg);
 
 void osc_lock_lvb_update(const struct lu_env *env,
 			 struct osc_object *osc,
@@ -136,6 +142,14 @@ static inline unsigned long rpcs_in_flight(struct client_obd *cli)
 	return cli->cl_r_in_flight + cli->cl_w_in_flight;
 }
 
+/* current limit of BRW RPCs in flight, called with cl_loi_list_lock held */
+static inline u32 rpcs_in_flight_limit(struct client_obd *cli)
+{
+	if (cli->cl_rpc_window_auto)
+		return min(cli->cl_rpc_window, cli->cl_max_rpcs_in_flight);
+	return cli->cl_max_rpcs_in_flight;
+}
+
 static inline char *cli_name(struct client_obd *cli)
 {
 	return cli->cl_import->imp_obd->obd_name;
@@ -139,6 +139,7 @@ int osc_io_submit(const struct lu_env *env, const struct cl_io_slice *ios,
 	unsigned int ppc_bits; /* pages per chunk bits */
 	unsigned int ppc;
 	bool sync_queue = false;
+	int stale_rc = 1;	/* stale pages not checked yet */
 
 	LASSERT(qin->pl_nr > 0);
 
@@ -198,6 +199,22 @@ int osc_io_submit(const struct lu_env *env, const struct cl_io_slice *ios,
 			continue;
                 }
 
+		if (crt == CRT_READ && opg->ops_stale) {
+			/* page kept after lock cancel, no need to read it
+			 * again if the object was not modified since */
+			if (stale_rc > 0)
+				stale_rc = osc_stale_revalidate(osc);
+			osc_page_stale_clear(osc, opg);
+			if (stale_rc == 0) {
+				if (page->cp_sync_io != NULL)
+					cl_page_list_move(qout, qin, page);
+				else
+					cl_page_list_del(env, qin, page);
+				cl_page_completion(env, page, CRT_READ, 0);
+				continue;
+			}
+		}
+
 		if (page->cp_type != CPT_TRANSIENT) {
 			oap->oap_async_flags = ASYNC_URGENT|ASYNC_READY|ASYNC_COUNT_STABLE;
 		}
@@ -165,6 +165,11 @@ void osc_lock_lvb_update(const struct lu_env *env,
 	cl_lvb2attr(attr, lvb);
 
 	cl_object_attr_lock(obj);
+	/* LVBs may arrive out of order, keep the newest data version */
+	if (lvb->lvb_data_version != 0 &&
+	    (osc->oo_lvb_dv == 0 ||
+	     (__s32)(lvb->lvb_data_version - osc->oo_lvb_dv) > 0))
+		WRITE_ONCE(osc->oo_lvb_dv, lvb->lvb_data_version);
 	if (dlmlock != NULL) {
 		__u64 size;
 
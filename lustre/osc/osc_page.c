@@ -176,6 +176,7 @@ static void osc_page_delete(const struct lu_env *env,
 	}
 
 	osc_lru_del(osc_cli(obj), opg);
+	osc_page_stale_clear(obj, opg);
 
 	if (slice->cpl_page->cp_type == CPT_CACHEABLE) {
 		void *value = NULL;
@@ -401,12 +402,54 @@ int lru_queue_work(const struct lu_env *env, void *data)
 	RETURN(0);
 }
 
+int osc_lru_sublists_init(struct client_obd *cli)
+{
+	struct cl_lru_sublist *sub;
+	int i;
+
+	cli->cl_lru_sublists = cfs_percpt_alloc(cfs_cpt_tab, sizeof(*sub));
+	if (cli->cl_lru_sublists == NULL)
+		return -ENOMEM;
+
+	cfs_percpt_for_each(sub, i, cli->cl_lru_sublists) {
+		spin_lock_init(&sub->ls_lock);
+		INIT_LIST_HEAD(&sub->ls_list);
+		sub->ls_nr = 0;
+	}
+	cli->cl_lru_shrink_cpt = 0;
+
+	return 0;
+}
+EXPORT_SYMBOL(osc_lru_sublists_init);
+
+void osc_lru_sublists_fini(struct client_obd *cli)
+{
+	struct cl_lru_sublist *sub;
+	int i;
+
+	if (cli->cl_lru_sublists == NULL)
+		return;
+
+	cfs_percpt_for_each(sub, i, cli->cl_lru_sublists)
+		LASSERT(list_empty(&sub->ls_list));
+	cfs_percpt_free(cli->cl_lru_sublists);
+	cli->cl_lru_sublists = NULL;
+}
+EXPORT_SYMBOL(osc_lru_sublists_fini);
+
+/**
+ * Add the pages of a finished transfer to the LRU sublist of the current
+ * CPU partition, taking its lock once for the whole batch.
+ */
 void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 {
 	LIST_HEAD(lru);
+	struct cl_lru_sublist *sub;
 	struct osc_async_page *oap;
 	long npages = 0;
+	int cpt;
 
+	cpt = cfs_cpt_current(cfs_cpt_tab, 0);
 	list_for_each_entry(oap, plist, oap_pending_item) {
 		struct osc_page *opg = oap2osc_page(oap);
 
@@ -415,26 +458,39 @@ void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 
 		++npages;
 		LASSERT(list_empty(&opg->ops_lru));
+		opg->ops_lru_cpt = cpt;
 		list_add(&opg->ops_lru, &lru);
 	}
 
 	if (npages > 0) {
-		spin_lock(&cli->cl_lru_list_lock);
-		list_splice_tail(&lru, &cli->cl_lru_list);
+		sub = cli->cl_lru_sublists[cpt];
+		spin_lock(&sub->ls_lock);
+		list_splice_tail(&lru, &sub->ls_list);
+		sub->ls_nr += npages;
+		spin_unlock(&sub->ls_lock);
 		atomic_long_sub(npages, &cli->cl_lru_busy);
 		atomic_long_add(npages, &cli->cl_lru_in_list);
 		cli->cl_lru_last_used = ktime_get_real_seconds();
-		spin_unlock(&cli->cl_lru_list_lock);
 
 		if (waitqueue_active(&osc_lru_waitq))
 			(void)ptlrpcd_queue_work(cli->cl_lru_work);
 	}
 }
 
-static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
+static inline struct cl_lru_sublist *osc_lru_sublist(struct client_obd *cli,
+						     struct osc_page *opg)
+{
+	return cli->cl_lru_sublists[opg->ops_lru_cpt];
+}
+
+/* called with the lock of the LRU sublist \a sub of \a opg held */
+static void __osc_lru_del(struct client_obd *cli, struct cl_lru_sublist *sub,
+			  struct osc_page *opg)
 {
 	LASSERT(atomic_long_read(&cli->cl_lru_in_list) > 0);
+	LASSERT(sub->ls_nr > 0);
 	list_del_init(&opg->ops_lru);
+	sub->ls_nr--;
 	atomic_long_dec(&cli->cl_lru_in_list);
 }
 
@@ -445,14 +501,16 @@ static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 static void osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 {
 	if (opg->ops_in_lru) {
-		spin_lock(&cli->cl_lru_list_lock);
+		struct cl_lru_sublist *sub = osc_lru_sublist(cli, opg);
+
+		spin_lock(&sub->ls_lock);
 		if (!list_empty(&opg->ops_lru)) {
-			__osc_lru_del(cli, opg);
+			__osc_lru_del(cli, sub, opg);
 		} else {
 			LASSERT(atomic_long_read(&cli->cl_lru_busy) > 0);
 			atomic_long_dec(&cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
+		spin_unlock(&sub->ls_lock);
 
 		atomic_long_inc(cli->cl_lru_left);
 		/* this is a great place to release more LRU pages if
@@ -476,14 +534,17 @@ static void osc_lru_use(struct client_obd *cli, struct osc_page *opg)
 	/* If page is being transferred for the first time,
 	 * ops_lru should be empty */
 	if (opg->ops_in_lru) {
+		struct cl_lru_sublist *sub;
+
 		if (list_empty(&opg->ops_lru))
 			return;
-		spin_lock(&cli->cl_lru_list_lock);
+		sub = osc_lru_sublist(cli, opg);
+		spin_lock(&sub->ls_lock);
 		if (!list_empty(&opg->ops_lru)) {
-			__osc_lru_del(cli, opg);
+			__osc_lru_del(cli, sub, opg);
 			atomic_long_inc(&cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
+		spin_unlock(&sub->ls_lock);
 	}
 }
 
@@ -531,6 +592,9 @@ static inline bool lru_page_busy(struct client_obd *cli, struct cl_page *page)
 
 /**
  * Drop @target of pages from LRU at most.
+ *
+ * The LRU sublists are scanned in turn, from a different one at each call
+ * so that concurrent reclaiming threads mostly work on distinct sublists.
  */
 long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		   long target, bool force)
@@ -538,11 +602,15 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 	struct cl_io *io;
 	struct cl_object *clobj = NULL;
 	struct cl_page **pvec;
+	struct cl_lru_sublist *sub;
 	struct osc_page *opg;
 	long count = 0;
 	int maxscan = 0;
 	int index = 0;
+	int ncpts;
+	int start;
 	int rc = 0;
+	int i;
 	ENTRY;
 
 	LASSERT(atomic_long_read(&cli->cl_lru_in_list) >= 0);
@@ -561,96 +629,107 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		}
 	} else {
 		atomic_inc(&cli->cl_lru_shrinkers);
+		cli->cl_lru_reclaim++;
 	}
 
 	pvec = (struct cl_page **)osc_env_info(env)->oti_pvec;
 	io = osc_env_thread_io(env);
 
-	spin_lock(&cli->cl_lru_list_lock);
-	if (force)
-		cli->cl_lru_reclaim++;
-	maxscan = min(target << 1, atomic_long_read(&cli->cl_lru_in_list));
-	while (!list_empty(&cli->cl_lru_list)) {
-		struct cl_page *page;
-		bool will_free = false;
-
-		if (!force && atomic_read(&cli->cl_lru_shrinkers) > 1)
-			break;
-
-		if (--maxscan < 0)
-			break;
+	ncpts = cfs_cpt_number(cfs_cpt_tab);
+	start = READ_ONCE(cli->cl_lru_shrink_cpt) % ncpts;
+	WRITE_ONCE(cli->cl_lru_shrink_cpt, start + 1);
 
-		opg = list_first_entry(&cli->cl_lru_list, struct osc_page,
-				       ops_lru);
-		page = opg->ops_cl.cpl_page;
-		if (lru_page_busy(cli, page)) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
+	for (i = 0; i < ncpts && count < target && rc == 0; i++) {
+		sub = cli->cl_lru_sublists[(start + i) % ncpts];
+		if (READ_ONCE(sub->ls_nr) == 0)
 			continue;
-		}
 
-		LASSERT(page->cp_obj != NULL);
-		if (clobj != page->cp_obj) {
-			struct cl_object *tmp = page->cp_obj;
+		spin_lock(&sub->ls_lock);
+		maxscan = min((target - count) << 1, sub->ls_nr);
+		while (!list_empty(&sub->ls_list)) {
+			struct cl_page *page;
+			bool will_free = false;
 
-			cl_object_get(tmp);
-			spin_unlock(&cli->cl_lru_list_lock);
+			if (!force && atomic_read(&cli->cl_lru_shrinkers) > 1)
+				break;
 
-			if (clobj != NULL) {
-				discard_pagevec(env, io, pvec, index);
-				index = 0;
+			if (--maxscan < 0)
+				break;
 
-				cl_io_fini(env, io);
-				cl_object_put(env, clobj);
-				clobj = NULL;
+			opg = list_first_entry(&sub->ls_list, struct osc_page,
+					       ops_lru);
+			page = opg->ops_cl.cpl_page;
+			if (lru_page_busy(cli, page)) {
+				list_move_tail(&opg->ops_lru, &sub->ls_list);
+				continue;
 			}
 
-			clobj = tmp;
-			io->ci_obj = clobj;
-			io->ci_ignore_layout = 1;
-			rc = cl_io_init(env, io, CIT_MISC, clobj);
+			LASSERT(page->cp_obj != NULL);
+			if (clobj != page->cp_obj) {
+				struct cl_object *tmp = page->cp_obj;
 
-			spin_lock(&cli->cl_lru_list_lock);
+				cl_object_get(tmp);
+				spin_unlock(&sub->ls_lock);
 
-			if (rc != 0)
-				break;
+				if (clobj != NULL) {
+					discard_pagevec(env, io, pvec, index);
+					index = 0;
 
-			++maxscan;
-			continue;
-		}
+					cl_io_fini(env, io);
+					cl_object_put(env, clobj);
+					clobj = NULL;
+				}
+
+				clobj = tmp;
+				io->ci_obj = clobj;
+				io->ci_ignore_layout = 1;
+				rc = cl_io_init(env, io, CIT_MISC, clobj);
+
+				spin_lock(&sub->ls_lock);
+
+				if (rc != 0)
+					break;
+
+				++maxscan;
+				continue;
+			}
 
-		if (cl_page_own_try(env, io, page) == 0) {
-			if (!lru_page_busy(cli, page)) {
-				/* remove it from lru list earlier to avoid
-				 * lock contention */
-				__osc_lru_del(cli, opg);
-				opg->ops_in_lru = 0; /* will be discarded */
-
-				cl_page_get(page);
-				will_free = true;
-			} else {
-				cl_page_disown(env, io, page);
+			if (cl_page_own_try(env, io, page) == 0) {
+				if (!lru_page_busy(cli, page)) {
+					/* remove it from lru list earlier to
+					 * avoid lock contention */
+					__osc_lru_del(cli, sub, opg);
+					/* will be discarded */
+					opg->ops_in_lru = 0;
+
+					cl_page_get(page);
+					will_free = true;
+				} else {
+					cl_page_disown(env, io, page);
+				}
 			}
-		}
 
-		if (!will_free) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
-			continue;
-		}
+			if (!will_free) {
+				list_move_tail(&opg->ops_lru, &sub->ls_list);
+				continue;
+			}
 
-		/* Don't discard and free the page with cl_lru_list held */
-		pvec[index++] = page;
-		if (unlikely(index == OTI_PVEC_SIZE)) {
-			spin_unlock(&cli->cl_lru_list_lock);
-			discard_pagevec(env, io, pvec, index);
-			index = 0;
+			/* Don't discard and free the page with the LRU
+			 * sublist lock held */
+			pvec[index++] = page;
+			if (unlikely(index == OTI_PVEC_SIZE)) {
+				spin_unlock(&sub->ls_lock);
+				discard_pagevec(env, io, pvec, index);
+				index = 0;
 
-			spin_lock(&cli->cl_lru_list_lock);
-		}
+				spin_lock(&sub->ls_lock);
+			}
 
-		if (++count >= target)
-			break;
+			if (++count >= target)
+				break;
+		}
+		spin_unlock(&sub->ls_lock);
 	}
-	spin_unlock(&cli->cl_lru_list_lock);
 
 	if (clobj != NULL) {
 		discard_pagevec(env, io, pvec, index);
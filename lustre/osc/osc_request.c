@@ -46,6 +46,7 @@
 #include <obd.h>
 #include <obd_cksum.h>
 #include <obd_class.h>
+#include <lustre_compr.h>
 
 #include "osc_internal.h"
 #include <lnet/lnet_rdma.h>
@@ -1161,7 +1162,7 @@ static inline int can_merge_pages(struct brw_page *p1, struct brw_page *p2)
 		unsigned mask = ~(OBD_BRW_FROM_GRANT | OBD_BRW_NOCACHE |
 				  OBD_BRW_SYNC       | OBD_BRW_ASYNC   |
 				  OBD_BRW_NOQUOTA    | OBD_BRW_SOFT_SYNC |
-				  OBD_BRW_SYS_RESOURCE);
+				  OBD_BRW_SYS_RESOURCE | OBD_BRW_COMPRESSED);
 
                 /* warn if we try to combine flags that we don't know to be
                  * safe to combine */
@@ -1501,6 +1502,187 @@ static inline void osc_release_bounce_pages(struct brw_page **pga,
 #endif
 }
 
+/* whether pga[0 .. chunk_pages) are the full pages of one aligned chunk */
+static bool osc_brw_chunk_full(struct brw_page **pga, u32 chunk_pages,
+			       unsigned int chunk_bits)
+{
+	u64 start = pga[0]->bp_off;
+	u32 i;
+
+	if (start & ((1ULL << chunk_bits) - 1))
+		return false;
+
+	for (i = 0; i < chunk_pages; i++) {
+		if (pga[i]->bp_off != start + ((u64)i << PAGE_SHIFT) ||
+		    pga[i]->bp_count != PAGE_SIZE ||
+		    pga[i]->bp_flag != pga[0]->bp_flag)
+			return false;
+	}
+
+	return true;
+}
+
+static void osc_release_compr(struct osc_brw_compr *compr,
+			      struct brw_page **pga, u32 page_count)
+{
+	u32 i;
+
+	if (!compr)
+		return;
+
+	for (i = 0; i < page_count; i++)
+		pga[i]->bp_flag &= ~OBD_BRW_COMPRESSED;
+
+	if (compr->obc_bounce) {
+		sptlrpc_enc_pool_put_pages_array(compr->obc_bounce,
+						 compr->obc_bounce_count);
+		OBD_FREE_PTR_ARRAY_LARGE(compr->obc_bounce,
+					 compr->obc_bounce_count);
+	}
+	if (compr->obc_bpg)
+		OBD_FREE_PTR_ARRAY_LARGE(compr->obc_bpg,
+					 compr->obc_bounce_count);
+	if (compr->obc_pga)
+		OBD_FREE_PTR_ARRAY_LARGE(compr->obc_pga, page_count);
+	OBD_FREE_PTR(compr);
+}
+
+/**
+ * Compress the whole chunks of a write to a LOV_PATTERN_COMPRESS component.
+ *
+ * Every chunk completely covered by full pages of \a pga is compressed into
+ * pages of the encryption pool, if that saves at least one page. The other
+ * pages are sent as they are. The pages of the compressed chunks are flagged
+ * OBD_BRW_COMPRESSED, so they get their own niobufs, which still describe
+ * the uncompressed range of the file, see struct ll_compr_hdr.
+ *
+ * Only the writes are compressed, and only on the wire: the OST stores the
+ * data uncompressed, and reads are sent uncompressed.
+ *
+ * \retval NULL	nothing was compressed, the bulk is made of \a pga
+ * \retval compr	the pages and size of the bulk
+ */
+static struct osc_brw_compr *osc_brw_compress(struct client_obd *cli,
+					      u32 page_count,
+					      struct brw_page **pga)
+{
+	struct lov_oinfo *loi = brw_page2oap(pga[0])->oap_obj->oo_oinfo;
+	struct osc_brw_compr *compr;
+	struct page **src = NULL;
+	unsigned int chunk_bits;
+	bool compressed = false;
+	u32 nr_chunks = 0;
+	u32 chunk_pages;
+	u32 used = 0;
+	u32 i, j;
+	int rc;
+
+	ENTRY;
+	if (loi->loi_compr_type == LL_COMPR_TYPE_NONE ||
+	    !(imp_connect_compr_types(cli->cl_import) &
+	      BIT_ULL(loi->loi_compr_type)))
+		RETURN(NULL);
+
+	chunk_bits = max_t(unsigned int, loi->loi_compr_chunk_bits,
+			   cli->cl_chunkbits);
+	chunk_pages = 1U << (chunk_bits - PAGE_SHIFT);
+	if (chunk_pages < 2)
+		RETURN(NULL);
+
+	for (i = 0; i + chunk_pages <= page_count; ) {
+		if (osc_brw_chunk_full(pga + i, chunk_pages, chunk_bits)) {
+			nr_chunks++;
+			i += chunk_pages;
+		} else {
+			i++;
+		}
+	}
+	if (nr_chunks == 0)
+		RETURN(NULL);
+
+	OBD_ALLOC_PTR(compr);
+	if (!compr)
+		RETURN(NULL);
+
+	compr->obc_bounce_count = nr_chunks * (chunk_pages - 1);
+	OBD_ALLOC_PTR_ARRAY_LARGE(compr->obc_pga, page_count);
+	OBD_ALLOC_PTR_ARRAY_LARGE(compr->obc_bpg, compr->obc_bounce_count);
+	OBD_ALLOC_PTR_ARRAY_LARGE(compr->obc_bounce, compr->obc_bounce_count);
+	OBD_ALLOC_PTR_ARRAY_LARGE(src, chunk_pages);
+	if (!compr->obc_pga || !compr->obc_bpg || !compr->obc_bounce || !src)
+		rc = -ENOMEM;
+	else
+		rc = sptlrpc_enc_pool_get_pages_array(compr->obc_bounce,
+						      compr->obc_bounce_count);
+	if (rc) {
+		/* no pool pages to give back in osc_release_compr() */
+		if (compr->obc_bounce) {
+			OBD_FREE_PTR_ARRAY_LARGE(compr->obc_bounce,
+						 compr->obc_bounce_count);
+			compr->obc_bounce = NULL;
+		}
+		GOTO(out, rc);
+	}
+
+	for (i = 0; i < page_count; ) {
+		struct brw_page *bpg;
+		unsigned int bulk_size;
+
+		if (i + chunk_pages > page_count ||
+		    !osc_brw_chunk_full(pga + i, chunk_pages, chunk_bits)) {
+			compr->obc_pga[compr->obc_page_count++] = pga[i];
+			compr->obc_nob += pga[i]->bp_count;
+			i++;
+			continue;
+		}
+
+		for (j = 0; j < chunk_pages; j++)
+			src[j] = pga[i + j]->bp_page;
+		rc = lustre_compr_chunk(loi->loi_compr_type,
+					loi->loi_compr_lvl, chunk_bits, src,
+					compr->obc_bounce + used, &bulk_size);
+		if (rc) {
+			if (rc != -E2BIG)
+				CDEBUG(D_PAGE,
+				       "%s: cannot compress chunk at %llu: rc = %d\n",
+				       cli_name(cli), pga[i]->bp_off, rc);
+			for (j = 0; j < chunk_pages; j++, i++) {
+				compr->obc_pga[compr->obc_page_count++] =
+					pga[i];
+				compr->obc_nob += pga[i]->bp_count;
+			}
+			continue;
+		}
+
+		for (j = 0; j < bulk_size >> PAGE_SHIFT; j++) {
+			bpg = &compr->obc_bpg[used + j];
+			bpg->bp_page = compr->obc_bounce[used + j];
+			bpg->bp_off = pga[i]->bp_off + ((u64)j << PAGE_SHIFT);
+			bpg->bp_count = PAGE_SIZE;
+			bpg->bp_flag = pga[i]->bp_flag | OBD_BRW_COMPRESSED;
+			compr->obc_pga[compr->obc_page_count++] = bpg;
+		}
+		compr->obc_nob += bulk_size;
+		used += chunk_pages - 1;
+
+		for (j = 0; j < chunk_pages; j++, i++)
+			pga[i]->bp_flag |= OBD_BRW_COMPRESSED;
+		compressed = true;
+	}
+	rc = compressed ? 0 : -E2BIG;
+	CDEBUG(D_PAGE, "%s: %u pages (%u chunks) sent as %u pages: rc = %d\n",
+	       cli_name(cli), page_count, nr_chunks, compr->obc_page_count, rc);
+out:
+	if (src)
+		OBD_FREE_PTR_ARRAY_LARGE(src, chunk_pages);
+	if (rc) {
+		osc_release_compr(compr, pga, page_count);
+		compr = NULL;
+	}
+
+	RETURN(compr);
+}
+
 static int
 osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 		     u32 page_count, struct brw_page **pga,
@@ -1513,6 +1695,7 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 	struct niobuf_remote *niobuf;
 	int niocount, i, requested_nob, opc, rc, short_io_size = 0;
 	struct osc_brw_async_args *aa;
+	struct osc_brw_compr *compr = NULL;
 	struct req_capsule *pill;
 	struct brw_page *pg_prev;
 	void *short_io_buf;
@@ -1691,6 +1874,19 @@ retry_encrypt:
 		}
 	}
 
+	if (opc == OST_WRITE && pga[0]->bp_page &&
+	    !(inode && IS_ENCRYPTED(inode)) &&
+	    !(brw_page2oap(pga[0])->oap_brw_flags & OBD_BRW_RDMA_ONLY))
+		compr = osc_brw_compress(cli, page_count, pga);
+	if (compr) {
+		struct osc_stats *stats =
+			&obd2osc_dev(cli->cl_import->imp_obd)->osc_stats;
+
+		for (i = 0; i < page_count; i++)
+			stats->os_compr_write_bytes += pga[i]->bp_count;
+		stats->os_compr_bulk_bytes += compr->obc_nob;
+	}
+
         for (niocount = i = 1; i < page_count; i++) {
                 if (!can_merge_pages(pga[i - 1], pga[i]))
                         niocount++;
@@ -1719,7 +1915,7 @@ retry_encrypt:
 
 	/* Check if read/write is small enough to be a short io. */
 	if (short_io_size > cli->cl_max_short_io_bytes || niocount > 1 ||
-	    !imp_connect_shortio(cli->cl_import))
+	    !imp_connect_shortio(cli->cl_import) || compr)
 		short_io_size = 0;
 
 	/* If this is an empty RPC to old server, just ignore it */
@@ -1736,6 +1932,7 @@ retry_encrypt:
 
         rc = ptlrpc_request_pack(req, LUSTRE_OST_VERSION, opc);
         if (rc) {
+		osc_release_compr(compr, pga, page_count);
                 ptlrpc_request_free(req);
                 RETURN(rc);
         }
@@ -1779,6 +1976,8 @@ no_bulk:
 	 * other process logic */
 	body->oa.o_uid = oa->o_uid;
 	body->oa.o_gid = oa->o_gid;
+	if (compr)
+		body->oa.o_compr_nob = compr->obc_nob;
 
 	obdo_to_ioobj(oa, ioobj);
 	ioobj->ioo_bufcnt = niocount;
@@ -1849,7 +2048,7 @@ no_bulk:
 			       ptr + poff,
 			       pg->bp_count);
 			kunmap_atomic(ptr);
-		} else if (short_io_size == 0) {
+		} else if (short_io_size == 0 && !compr) {
 			desc->bd_frag_ops->add_kiov_frag(desc, pg->bp_page, poff,
 							 pg->bp_count);
 		}
@@ -1871,6 +2070,15 @@ no_bulk:
                 "want %p - real %p\n", req_capsule_client_get(&req->rq_pill,
                 &RMF_NIOBUF_REMOTE), (void *)(niobuf - niocount));
 
+	/* the niobufs describe the file, the bulk the compressed chunks */
+	for (i = 0; compr && i < compr->obc_page_count; i++) {
+		struct brw_page *pg = compr->obc_pga[i];
+
+		desc->bd_frag_ops->add_kiov_frag(desc, pg->bp_page,
+						 pg->bp_off & ~PAGE_MASK,
+						 pg->bp_count);
+	}
+
         osc_announce_cached(cli, &body->oa, opc == OST_WRITE ? requested_nob:0);
         if (resend) {
                 if ((body->oa.o_valid & OBD_MD_FLFLAGS) == 0) {
@@ -1900,10 +2108,21 @@ no_bulk:
 								cksum_type);
                         body->oa.o_valid |= OBD_MD_FLCKSUM | OBD_MD_FLFLAGS;
 
-			rc = osc_checksum_bulk_rw(obd_name, cksum_type,
-						  requested_nob, page_count,
-						  pga, OST_WRITE,
-						  &body->oa.o_cksum, resend);
+			if (compr)
+				rc = osc_checksum_bulk_rw(obd_name, cksum_type,
+							  compr->obc_nob,
+							  compr->obc_page_count,
+							  compr->obc_pga,
+							  OST_WRITE,
+							  &body->oa.o_cksum,
+							  resend);
+			else
+				rc = osc_checksum_bulk_rw(obd_name, cksum_type,
+							  requested_nob,
+							  page_count, pga,
+							  OST_WRITE,
+							  &body->oa.o_cksum,
+							  resend);
 			if (rc < 0) {
 				CDEBUG(D_PAGE, "failed to checksum: rc = %d\n",
 				       rc);
@@ -1950,6 +2169,8 @@ no_bulk:
 	aa->aa_resends = 0;
 	aa->aa_ppga = pga;
 	aa->aa_cli = cli;
+	aa->aa_compr = compr;
+	aa->aa_rpc_buf = NULL;
 	INIT_LIST_HEAD(&aa->aa_oaps);
 
 	*reqp = req;
@@ -1960,6 +2181,7 @@ no_bulk:
         RETURN(0);
 
  out:
+	osc_release_compr(compr, pga, page_count);
         ptlrpc_req_finished(req);
         RETURN(rc);
 }
@@ -2032,6 +2254,9 @@ check_write_checksum(struct obdo *oa, const struct lnet_processid *peer,
 		     struct osc_brw_async_args *aa)
 {
 	const char *obd_name = aa->aa_cli->cl_import->imp_obd->obd_name;
+	struct brw_page **pga = aa->aa_ppga;
+	u32 page_count = aa->aa_page_count;
+	int nob = aa->aa_requested_nob;
 	enum cksum_types cksum_type;
 	obd_dif_csum_fn *fn = NULL;
 	int sector_size = 0;
@@ -2044,9 +2269,16 @@ check_write_checksum(struct obdo *oa, const struct lnet_processid *peer,
                 return 0;
         }
 
+	/* the checksum covers the bulk, i.e. the compressed chunks */
+	if (aa->aa_compr) {
+		pga = aa->aa_compr->obc_pga;
+		page_count = aa->aa_compr->obc_page_count;
+		nob = aa->aa_compr->obc_nob;
+	}
+
 	if (aa->aa_cli->cl_checksum_dump)
-		dump_all_bulk_pages(oa, aa->aa_page_count, aa->aa_ppga,
-				    server_cksum, client_cksum);
+		dump_all_bulk_pages(oa, page_count, pga, server_cksum,
+				    client_cksum);
 
 	cksum_type = obd_cksum_type_unpack(oa->o_valid & OBD_MD_FLFLAGS ?
 					   oa->o_flags : 0);
@@ -2073,14 +2305,12 @@ check_write_checksum(struct obdo *oa, const struct lnet_processid *peer,
 	}
 
 	if (fn)
-		rc = osc_checksum_bulk_t10pi(obd_name, aa->aa_requested_nob,
-					     aa->aa_page_count, aa->aa_ppga,
+		rc = osc_checksum_bulk_t10pi(obd_name, nob, page_count, pga,
 					     OST_WRITE, fn, sector_size,
 					     &new_cksum, true);
 	else
-		rc = osc_checksum_bulk(aa->aa_requested_nob, aa->aa_page_count,
-				       aa->aa_ppga, OST_WRITE, cksum_type,
-				       &new_cksum);
+		rc = osc_checksum_bulk(nob, page_count, pga, OST_WRITE,
+				       cksum_type, &new_cksum);
 
 	if (rc < 0)
 		msg = "failed to calculate the client write checksum";
@@ -2179,7 +2409,8 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 					 body->oa.o_cksum, aa))
 			RETURN(-EAGAIN);
 
-		rc = check_write_rcs(req, aa->aa_requested_nob,
+		rc = check_write_rcs(req, aa->aa_compr ? aa->aa_compr->obc_nob :
+						     aa->aa_requested_nob,
 				     aa->aa_nio_count, aa->aa_page_count,
 				     aa->aa_ppga);
 		GOTO(out, rc);
@@ -2404,6 +2635,7 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
 {
 	struct ptlrpc_request *new_req;
 	struct osc_brw_async_args *new_aa;
+	struct osc_brw_compr *compr;
 	struct osc_async_page *oap;
 	ENTRY;
 
@@ -2430,8 +2662,12 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
 	 * Note that copying a list_head doesn't work, need to move it...
 	 */
 	aa->aa_resends++;
+	new_aa = ptlrpc_req_async_args(new_aa, new_req);
+	compr = new_aa->aa_compr;
 	new_req->rq_interpret_reply = request->rq_interpret_reply;
 	new_req->rq_async_args = request->rq_async_args;
+	/* the new request compressed the pages again */
+	new_aa->aa_compr = compr;
 	new_req->rq_commit_cb = request->rq_commit_cb;
 	/* cap resend delay to the current request timeout, this is similar to
 	 * what ptlrpc does (see after_reply()) */
@@ -2442,8 +2678,6 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
         new_req->rq_generation_set = 1;
         new_req->rq_import_generation = request->rq_import_generation;
 
-	new_aa = ptlrpc_req_async_args(new_aa, new_req);
-
 	INIT_LIST_HEAD(&new_aa->aa_oaps);
 	list_splice_init(&aa->aa_oaps, &new_aa->aa_oaps);
 	INIT_LIST_HEAD(&new_aa->aa_exts);
@@ -2504,6 +2738,218 @@ static void osc_release_ppga(struct brw_page **ppga, size_t count)
 	OBD_FREE_PTR_ARRAY_LARGE(ppga, count);
 }
 
+/* max # of free RPC buffers cached on each CPT of a client_obd */
+#define OSC_RPC_ARENA_MAX	16
+
+static int osc_rpc_arenas_init(struct client_obd *cli)
+{
+	struct cl_rpc_arena *arena;
+	int i;
+
+	cli->cl_rpc_arenas = cfs_percpt_alloc(cfs_cpt_tab, sizeof(*arena));
+	if (cli->cl_rpc_arenas == NULL)
+		return -ENOMEM;
+
+	cfs_percpt_for_each(arena, i, cli->cl_rpc_arenas) {
+		spin_lock_init(&arena->ra_lock);
+		INIT_LIST_HEAD(&arena->ra_free);
+		arena->ra_nr = 0;
+	}
+
+	return 0;
+}
+
+static void osc_rpc_buf_free(struct osc_rpc_buf *buf)
+{
+	OBD_FREE_LARGE(buf, offsetof(struct osc_rpc_buf,
+				     orb_pga[buf->orb_pages]));
+}
+
+static void osc_rpc_arenas_fini(struct client_obd *cli)
+{
+	struct cl_rpc_arena *arena;
+	struct osc_rpc_buf *buf;
+	int i;
+
+	if (cli->cl_rpc_arenas == NULL)
+		return;
+
+	cfs_percpt_for_each(arena, i, cli->cl_rpc_arenas) {
+		while ((buf = list_first_entry_or_null(&arena->ra_free,
+						       struct osc_rpc_buf,
+						       orb_link)) != NULL) {
+			list_del(&buf->orb_link);
+			osc_rpc_buf_free(buf);
+		}
+	}
+	cfs_percpt_free(cli->cl_rpc_arenas);
+	cli->cl_rpc_arenas = NULL;
+}
+
+/**
+ * Get the obdo and brw_page array of a BRW RPC of \a page_count pages.
+ *
+ * They are allocated together, sized for max_pages_per_rpc, and cached per
+ * CPT when the RPC completes, so that building an RPC usually needs no
+ * allocation at all. The array of a large RPC is vmalloc()ed otherwise.
+ */
+static struct osc_rpc_buf *osc_rpc_buf_get(struct client_obd *cli,
+					   u32 page_count)
+{
+	struct cl_rpc_arena *arena;
+	struct osc_rpc_buf *buf;
+	u32 pages;
+	int cpt;
+
+	cpt = cfs_cpt_current(cfs_cpt_tab, 0);
+	arena = cli->cl_rpc_arenas[cpt];
+	spin_lock(&arena->ra_lock);
+	buf = list_first_entry_or_null(&arena->ra_free, struct osc_rpc_buf,
+				       orb_link);
+	if (buf != NULL) {
+		list_del(&buf->orb_link);
+		arena->ra_nr--;
+	}
+	spin_unlock(&arena->ra_lock);
+
+	if (buf != NULL) {
+		if (buf->orb_pages >= page_count) {
+			memset(&buf->orb_oa, 0, sizeof(buf->orb_oa));
+			return buf;
+		}
+		/* cached before max_pages_per_rpc was increased */
+		osc_rpc_buf_free(buf);
+	}
+
+	pages = max(page_count, cli->cl_max_pages_per_rpc);
+	OBD_CPT_ALLOC_LARGE(buf, cfs_cpt_tab, cpt,
+			    offsetof(struct osc_rpc_buf, orb_pga[pages]));
+	if (buf == NULL)
+		return NULL;
+
+	INIT_LIST_HEAD(&buf->orb_link);
+	buf->orb_cpt = cpt;
+	buf->orb_pages = pages;
+
+	return buf;
+}
+
+static void osc_rpc_buf_put(struct client_obd *cli, struct osc_rpc_buf *buf)
+{
+	struct cl_rpc_arena *arena = cli->cl_rpc_arenas[buf->orb_cpt];
+
+	/* drop buffers too small for the current RPC size */
+	if (buf->orb_pages >= cli->cl_max_pages_per_rpc) {
+		spin_lock(&arena->ra_lock);
+		if (arena->ra_nr < OSC_RPC_ARENA_MAX) {
+			list_add(&buf->orb_link, &arena->ra_free);
+			arena->ra_nr++;
+			buf = NULL;
+		}
+		spin_unlock(&arena->ra_lock);
+	}
+	if (buf != NULL)
+		osc_rpc_buf_free(buf);
+}
+
+/* average RPC latency, in % of the lowest one, above which the window
+ * shrinks and below which it may grow
+ */
+#define OSC_RPC_LAT_HIGH	200
+#define OSC_RPC_LAT_LOW		150
+/* how long the lowest RPC latency is trusted, in seconds */
+#define OSC_RPC_LAT_MIN_AGE	30
+
+static void osc_rpc_window_round(struct client_obd *cli)
+{
+	cli->cl_rpc_window_count = 0;
+	cli->cl_rpc_window_samples = 0;
+	cli->cl_rpc_window_lat_us = 0;
+	cli->cl_rpc_window_full = 0;
+	cli->cl_rpc_window_busy = 0;
+}
+
+void osc_rpc_window_enable(struct client_obd *cli, bool enable)
+{
+	spin_lock(&cli->cl_loi_list_lock);
+	if (enable && !cli->cl_rpc_window_auto) {
+		cli->cl_rpc_window = cli->cl_max_rpcs_in_flight;
+		cli->cl_rpc_lat_min_us = 0;
+		osc_rpc_window_round(cli);
+	}
+	cli->cl_rpc_window_auto = enable;
+	spin_unlock(&cli->cl_loi_list_lock);
+}
+
+/**
+ * Adapt the number of BRW RPCs in flight to the latency of the RPCs, in the
+ * way of a delay based AIMD congestion control.
+ *
+ * A round lasts as many RPCs as the window. At the end of a round:
+ * - the window is cut by a quarter if the OST sent early replies or an RPC
+ *   timed out, or if the average latency doubled compared to the lowest one
+ *   seen recently: the RPCs queue up on the OST;
+ * - the window grows by one if it was filled and the average latency stayed
+ *   close to the lowest one: more RPCs in flight still give more bandwidth.
+ * The window never exceeds max_rpcs_in_flight.
+ *
+ * Only RPCs of at least half max_pages_per_rpc are sampled, so that the
+ * latency of small RPCs does not distort the baseline.
+ *
+ * Called with cl_loi_list_lock held.
+ */
+static void osc_rpc_window_update(struct client_obd *cli,
+				  struct ptlrpc_request *req, u32 page_count,
+				  int rc)
+{
+	time64_t now = ktime_get_seconds();
+	u64 lat_us;
+	u64 avg_us = 0;
+
+	if (!cli->cl_rpc_window_auto)
+		return;
+
+	if (cli->cl_rpc_window > cli->cl_max_rpcs_in_flight)
+		cli->cl_rpc_window = cli->cl_max_rpcs_in_flight;
+
+	if (req->rq_early_count > 0 || req->rq_timedout ||
+	    rc == -ETIMEDOUT || rc == -EINPROGRESS) {
+		cli->cl_rpc_window_busy = 1;
+	} else if (rc == 0 && page_count >= cli->cl_max_pages_per_rpc / 2) {
+		lat_us = ktime_us_delta(ktime_get_real(), req->rq_sent_ns);
+		if (cli->cl_rpc_lat_min_us == 0 ||
+		    lat_us < cli->cl_rpc_lat_min_us ||
+		    now > cli->cl_rpc_lat_min_stamp + OSC_RPC_LAT_MIN_AGE) {
+			cli->cl_rpc_lat_min_us = max_t(u64, lat_us, 1);
+			cli->cl_rpc_lat_min_stamp = now;
+		}
+		cli->cl_rpc_window_lat_us += lat_us;
+		cli->cl_rpc_window_samples++;
+	}
+
+	if (++cli->cl_rpc_window_count < cli->cl_rpc_window)
+		return;
+
+	if (cli->cl_rpc_window_samples > 0)
+		avg_us = div_u64(cli->cl_rpc_window_lat_us,
+				 cli->cl_rpc_window_samples);
+
+	if (cli->cl_rpc_window_busy ||
+	    avg_us * 100 > cli->cl_rpc_lat_min_us * OSC_RPC_LAT_HIGH) {
+		cli->cl_rpc_window -= max(cli->cl_rpc_window / 4, 1U);
+		if (cli->cl_rpc_window == 0)
+			cli->cl_rpc_window = 1;
+	} else if (cli->cl_rpc_window_full && avg_us > 0 &&
+		   avg_us * 100 <= cli->cl_rpc_lat_min_us * OSC_RPC_LAT_LOW &&
+		   cli->cl_rpc_window < cli->cl_max_rpcs_in_flight) {
+		cli->cl_rpc_window++;
+	}
+	CDEBUG(D_CACHE, "%s: RPC latency %llu/%lluus%s, window %u\n",
+	       cli_name(cli), avg_us, cli->cl_rpc_lat_min_us,
+	       cli->cl_rpc_window_busy ? " busy" : "", cli->cl_rpc_window);
+	osc_rpc_window_round(cli);
+}
+
 static int brw_interpret(const struct lu_env *env,
 			 struct ptlrpc_request *req, void *args, int rc)
 {
@@ -2521,6 +2967,8 @@ static int brw_interpret(const struct lu_env *env,
 
 	/* restore clear text pages */
 	osc_release_bounce_pages(aa->aa_ppga, aa->aa_page_count);
+	osc_release_compr(aa->aa_compr, aa->aa_ppga, aa->aa_page_count);
+	aa->aa_compr = NULL;
 
 	/*
 	 * When server returns -EINPROGRESS, client should always retry
@@ -2599,7 +3047,8 @@ static int brw_interpret(const struct lu_env *env,
 			cl_object_attr_update(env, obj, attr, valid);
 		cl_object_attr_unlock(obj);
 	}
-	OBD_SLAB_FREE_PTR(aa->aa_oa, osc_obdo_kmem);
+	if (aa->aa_rpc_buf == NULL)
+		OBD_SLAB_FREE_PTR(aa->aa_oa, osc_obdo_kmem);
 	aa->aa_oa = NULL;
 
 	if (lustre_msg_get_opc(req->rq_reqmsg) == OST_WRITE && rc == 0) {
@@ -2625,7 +3074,13 @@ static int brw_interpret(const struct lu_env *env,
 		       aa->aa_requested_nob :
 		       req->rq_bulk->bd_nob_transferred);
 
-	osc_release_ppga(aa->aa_ppga, aa->aa_page_count);
+	if (aa->aa_rpc_buf != NULL) {
+		osc_rpc_buf_put(cli, aa->aa_rpc_buf);
+		aa->aa_rpc_buf = NULL;
+	} else {
+		osc_release_ppga(aa->aa_ppga, aa->aa_page_count);
+	}
+	aa->aa_ppga = NULL;
 	ptlrpc_lprocfs_brw(req, transferred);
 
 	spin_lock(&cli->cl_loi_list_lock);
@@ -2636,6 +3091,7 @@ static int brw_interpret(const struct lu_env *env,
 		cli->cl_w_in_flight--;
 	else
 		cli->cl_r_in_flight--;
+	osc_rpc_window_update(cli, req, aa->aa_page_count, rc);
 	osc_wake_cache_waiters(cli);
 	spin_unlock(&cli->cl_loi_list_lock);
 
@@ -2674,6 +3130,7 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 	struct brw_page			**pga = NULL;
 	struct osc_brw_async_args	*aa = NULL;
 	struct obdo			*oa = NULL;
+	struct osc_rpc_buf		*rpc_buf = NULL;
 	struct osc_async_page		*oap;
 	struct osc_object		*obj = NULL;
 	struct cl_req_attr		*crattr = NULL;
@@ -2709,13 +3166,11 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 	if (mem_tight)
 		mpflag = memalloc_noreclaim_save();
 
-	OBD_ALLOC_PTR_ARRAY_LARGE(pga, page_count);
-	if (pga == NULL)
-		GOTO(out, rc = -ENOMEM);
-
-	OBD_SLAB_ALLOC_PTR_GFP(oa, osc_obdo_kmem, GFP_NOFS);
-	if (oa == NULL)
+	rpc_buf = osc_rpc_buf_get(cli, page_count);
+	if (rpc_buf == NULL)
 		GOTO(out, rc = -ENOMEM);
+	pga = rpc_buf->orb_pga;
+	oa = &rpc_buf->orb_oa;
 
 	i = 0;
 	list_for_each_entry(ext, ext_list, oe_link) {
@@ -2803,6 +3258,7 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 	lustre_msg_set_jobid(req->rq_reqmsg, crattr->cra_jobid);
 
 	aa = ptlrpc_req_async_args(aa, req);
+	aa->aa_rpc_buf = rpc_buf;
 	INIT_LIST_HEAD(&aa->aa_oaps);
 	list_splice_init(&rpc_list, &aa->aa_oaps);
 	INIT_LIST_HEAD(&aa->aa_exts);
@@ -2853,11 +3309,9 @@ out:
 	if (rc != 0) {
 		LASSERT(req == NULL);
 
-		if (oa)
-			OBD_SLAB_FREE_PTR(oa, osc_obdo_kmem);
-		if (pga) {
+		if (rpc_buf) {
 			osc_release_bounce_pages(pga, page_count);
-			osc_release_ppga(pga, page_count);
+			osc_rpc_buf_put(cli, rpc_buf);
 		}
 		/* this should happen rarely and is pretty bad, it makes the
 		 * pending list not follow the dirty order
@@ -3736,6 +4190,13 @@ int osc_setup_common(struct obd_device *obd, struct lustre_cfg *lcfg)
 	if (rc)
 		GOTO(out_ptlrpcd, rc);
 
+	rc = osc_lru_sublists_init(cli);
+	if (rc)
+		GOTO(out_ptlrpcd_work, rc);
+
+	rc = osc_rpc_arenas_init(cli);
+	if (rc)
+		GOTO(out_ptlrpcd_work, rc);
 
 	handler = ptlrpcd_alloc_work(cli->cl_import, brw_queue_work, cli);
 	if (IS_ERR(handler))
@@ -3766,6 +4227,8 @@ out_ptlrpcd_work:
 		ptlrpcd_destroy_work(cli->cl_lru_work);
 		cli->cl_lru_work = NULL;
 	}
+	osc_rpc_arenas_fini(cli);
+	osc_lru_sublists_fini(cli);
 	client_obd_cleanup(obd);
 out_ptlrpcd:
 	ptlrpcd_decref();
@@ -3879,6 +4342,9 @@ int osc_cleanup_common(struct obd_device *obd)
 		cli->cl_cache = NULL;
 	}
 
+	osc_lru_sublists_fini(cli);
+	osc_rpc_arenas_fini(cli);
+
 	/* free memory of osc quota cache */
 	osc_quota_cleanup(obd);
 
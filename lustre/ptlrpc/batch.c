@@ -344,11 +344,29 @@ static void batch_update_request_destroy(struct batch_update_head *head)
 
 static void cli_batch_resend_work(struct work_struct *data);
 
+/* The sub requests packed inline into @req, which is kept for replay. */
+static struct batch_update_request *
+batch_update_inline_request(struct ptlrpc_request *req)
+{
+	struct but_update_header *buh;
+
+	if (req == NULL || req->rq_reqmsg == NULL)
+		return NULL;
+
+	buh = req_capsule_client_get(&req->rq_pill, &RMF_BUT_HEADER);
+	if (buh == NULL || buh->buh_inline_length == 0)
+		return NULL;
+
+	return (struct batch_update_request *)buh->buh_inline_data;
+}
+
 static int batch_update_request_fini(struct batch_update_head *head,
 				     struct ptlrpc_request *req,
 				     struct batch_update_reply *reply, int rc)
 {
 	struct object_update_callback *ouc, *next;
+	struct batch_update_request *bur;
+	struct lustre_msg *reqmsg = NULL;
 	struct lustre_msg *repmsg = NULL;
 	int count = 0;
 	int index = 0;
@@ -358,6 +376,8 @@ static int batch_update_request_fini(struct batch_update_head *head,
 	if (reply)
 		count = reply->burp_count;
 
+	bur = batch_update_inline_request(req);
+
 	list_for_each_entry_safe(ouc, next, &head->buh_cb_list, ouc_item) {
 		int rc1 = 0;
 
@@ -400,6 +420,11 @@ static int batch_update_request_fini(struct batch_update_head *head,
 			}
 		}
 
+		if (bur != NULL && index < bur->burq_count) {
+			reqmsg = batch_update_reqmsg_next(bur, reqmsg);
+			ouc->ouc_reqmsg = reqmsg;
+		}
+
 		list_del_init(&ouc->ouc_item);
 		if (ouc->ouc_interpret != NULL)
 			ouc->ouc_interpret(req, repmsg, ouc, rc1);
@@ -458,6 +483,11 @@ static int batch_send_update_req(const struct lu_env *env,
 	if (head == NULL)
 		RETURN(0);
 
+	if (head->buh_update_count == 0) {
+		batch_update_request_destroy(head);
+		RETURN(0);
+	}
+
 	obd = class_exp2obd(head->buh_exp);
 	bh = head->buh_batch;
 	if (bh)
@@ -503,6 +533,17 @@ static int batch_send_update_req(const struct lu_env *env,
 	RETURN(rc);
 }
 
+/*
+ * A batch with modifications is kept for replay until it is committed, but
+ * the update buffers sent in a bulk are freed once the reply is interpreted.
+ * Such a batch is thus limited to what fits inline in the request buffer.
+ */
+static inline bool batch_update_inline_only(struct batch_update_head *head)
+{
+	return head->buh_batch != NULL &&
+	       !(head->buh_batch->lbt_flags & BATCH_FL_RDONLY);
+}
+
 static int batch_update_request_add(struct batch_update_head **headp,
 				    struct md_op_item *item,
 				    md_update_pack_t packer,
@@ -521,10 +562,32 @@ static int batch_update_request_add(struct batch_update_head **headp,
 		buf = current_batch_update_buffer(head);
 		LASSERT(buf != NULL);
 		max_len = buf->bub_size - buf->bub_end;
+		if (batch_update_inline_only(head))
+			max_len = min_t(size_t, max_len,
+					OUT_UPDATE_MAX_INLINE_SIZE - 1 -
+					sizeof(struct but_update_header) -
+					buf->bub_end);
 		reqmsg = (struct lustre_msg *)((char *)buf->bub_req +
 						buf->bub_end);
 		rc = packer(head, reqmsg, &max_len, item);
-		if (rc == -E2BIG) {
+		if (rc == -E2BIG && batch_update_inline_only(head)) {
+			struct obd_export *exp = head->buh_exp;
+
+			/* it does not fit even into an empty request */
+			if (head->buh_update_count == 0)
+				break;
+
+			/* send what is packed, continue in a new request */
+			*headp = NULL;
+			rc = batch_send_update_req(NULL, head);
+			if (rc)
+				RETURN(rc);
+
+			head = batch_update_request_create(exp, bh);
+			if (IS_ERR(head))
+				RETURN(PTR_ERR(head));
+			*headp = head;
+		} else if (rc == -E2BIG) {
 			int rc2;
 
 			/* Create new batch object update buffer */
@@ -555,12 +618,17 @@ static int batch_update_request_add(struct batch_update_head **headp,
 
 	/* Unplug the batch queue if accumulated enough update requests. */
 	if (bh->lbt_max_count && head->buh_update_count >= bh->lbt_max_count) {
-		rc = batch_send_update_req(NULL, head);
+		/*
+		 * @item is owned by its callback from now on, which gets the
+		 * result of the RPC, and @head is freed once it is sent.
+		 */
 		*headp = NULL;
+		batch_send_update_req(NULL, head);
 	}
 out:
 	if (rc) {
-		batch_update_request_destroy(head);
+		/* @item is not queued, the updates packed before are */
+		batch_update_request_fini(head, NULL, NULL, rc);
 		*headp = NULL;
 	}
 
@@ -106,7 +106,6 @@ const struct ptlrpc_bulk_frag_ops ptlrpc_bulk_kiov_nopin_ops = {
 EXPORT_SYMBOL(ptlrpc_bulk_kiov_nopin_ops);
 
 static int ptlrpc_send_new_req(struct ptlrpc_request *req);
-static int ptlrpcd_check_work(struct ptlrpc_request *req);
 static int ptlrpc_unregister_reply(struct ptlrpc_request *request, int async);
 
 /**
@@ -3668,7 +3667,7 @@ static int work_interpreter(const struct lu_env *env,
 
 static int worker_format;
 
-static int ptlrpcd_check_work(struct ptlrpc_request *req)
+int ptlrpcd_check_work(struct ptlrpc_request *req)
 {
 	return req->rq_pill.rc_fmt == (void *)&worker_format;
 }
@@ -96,6 +96,7 @@ ptlrpc_connection_get(struct lnet_processid *peer_orig, struct lnet_nid *self,
 
 	conn->c_peer = peer;
 	conn->c_self = *self;
+	conn->c_dev_cpt = LNetNIDevCPT(self);
 	atomic_set(&conn->c_refcount, 1);
 	if (uuid)
 		obd_str2uuid(&conn->c_remote_uuid, uuid->uuid);
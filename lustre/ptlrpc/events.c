@@ -258,8 +258,8 @@ void client_bulk_callback(struct lnet_event *ev)
 #define REQS_USEC_SHIFT		16
 #define REQS_SEQ_SHIFT(svcpt)	REQS_CPT_BITS(svcpt)
 
-static void ptlrpc_req_add_history(struct ptlrpc_service_part *svcpt,
-				   struct ptlrpc_request *req)
+void ptlrpc_req_add_history(struct ptlrpc_service_part *svcpt,
+			    struct ptlrpc_request *req)
 {
 	u64 sec = req->rq_arrival_time.tv_sec;
 	u32 usec = req->rq_arrival_time.tv_nsec / NSEC_PER_USEC / 16; /* usec / 16 */
@@ -358,34 +358,39 @@ void request_in_callback(struct lnet_event *ev)
 	CDEBUG(D_RPCTRACE, "peer: %s (source: %s)\n",
 		libcfs_idstr(&req->rq_peer), libcfs_idstr(&req->rq_source));
 
+	if (!ev->unlinked) {
+		/* req takes a ref on rqbd, the network still holds its own
+		 * until the unlink event, so no lock is needed. The request
+		 * is added to history when taken from the intake queue.
+		 */
+		atomic_inc(&rqbd->rqbd_refcount);
+		ptlrpc_intake_add(&svcpt->scp_intake, &req->rq_srv.sr_intake);
+		wake_up(&svcpt->scp_waitq);
+		EXIT;
+		return;
+	}
+
 	spin_lock(&svcpt->scp_lock);
 
-	ptlrpc_req_add_history(svcpt, req);
+	svcpt->scp_nrqbds_posted--;
+	CDEBUG(D_INFO, "Buffer complete: %d buffers still posted\n",
+	       svcpt->scp_nrqbds_posted);
 
-	if (ev->unlinked) {
-		svcpt->scp_nrqbds_posted--;
-		CDEBUG(D_INFO, "Buffer complete: %d buffers still posted\n",
-		       svcpt->scp_nrqbds_posted);
-
-		/* Normally, don't complain about 0 buffers posted; LNET won't
-		 * drop incoming reqs since we set the portal lazy */
-		if (test_req_buffer_pressure &&
-		    ev->type != LNET_EVENT_UNLINK &&
-		    svcpt->scp_nrqbds_posted == 0)
-			CWARN("All %s request buffers busy\n",
-			      service->srv_name);
-
-		/* req takes over the network's ref on rqbd */
-	} else {
-		/* req takes a ref on rqbd */
-		rqbd->rqbd_refcount++;
-	}
+	/* Normally, don't complain about 0 buffers posted; LNET won't
+	 * drop incoming reqs since we set the portal lazy */
+	if (test_req_buffer_pressure &&
+	    ev->type != LNET_EVENT_UNLINK &&
+	    svcpt->scp_nrqbds_posted == 0)
+		CWARN("All %s request buffers busy\n",
+		      service->srv_name);
 
-	list_add_tail(&req->rq_list, &svcpt->scp_req_incoming);
-	svcpt->scp_nreqs_incoming++;
+	/* req takes over the network's ref on rqbd */
+	ptlrpc_intake_add(&svcpt->scp_intake, &req->rq_srv.sr_intake);
 
-	/* NB everything can disappear under us once the request
-	 * has been queued and we unlock, so do the wake now... */
+	/* NB everything can disappear under us once the last request
+	 * of the buffer has been queued and we unlock, so do the wake
+	 * now...
+	 */
 	wake_up(&svcpt->scp_waitq);
 
 	spin_unlock(&svcpt->scp_lock);
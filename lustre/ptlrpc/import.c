@@ -588,6 +588,7 @@ static int import_select_connection(struct obd_import *imp)
 	/* switch connection, don't mind if it's same as the current one */
 	ptlrpc_connection_put(imp->imp_connection);
 	imp->imp_connection = ptlrpc_connection_addref(imp_conn->oic_conn);
+	imp->imp_dev_cpt = imp->imp_connection->c_dev_cpt;
 
 	dlmexp = class_conn2export(&imp->imp_dlm_handle);
 	if (!dlmexp)
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/ptlrpc/intake.c
+ *
+ * Intake queues of incoming requests of a service partition.
+ *
+ * request_in_callback() runs on any CPU receiving a request for the
+ * partition. Queueing every request on a single list under
+ * ptlrpc_service_part::scp_lock made that lock the bottleneck of busy
+ * services on large nodes, so each partition has one queue per CPU of its
+ * CPT instead. Adding a request is a single cmpxchg on the queue of the
+ * current CPU, and a service thread takes a batch of requests from the
+ * queues at once, so that it also takes the locks needed to preprocess and
+ * enqueue them to NRS once per batch. The batch is bounded so that the
+ * requests of a burst are preprocessed by several threads.
+ */
+
+#define DEBUG_SUBSYSTEM S_RPC
+
+#include <linux/module.h>
+#include <libcfs/libcfs.h>
+#include <obd_support.h>
+#include <lustre_net.h>
+
+int ptlrpc_intake_init(struct ptlrpc_intake *pi,
+		       struct cfs_cpt_table *cptab, int cpt)
+{
+	int i;
+
+	atomic_set(&pi->pi_count, 0);
+	atomic_set(&pi->pi_next, 0);
+	pi->pi_nqueues = max(cfs_cpt_weight(cptab, cpt), 1);
+	OBD_CPT_ALLOC(pi->pi_queues, cptab, cpt,
+		      pi->pi_nqueues * sizeof(pi->pi_queues[0]));
+	if (pi->pi_queues == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < pi->pi_nqueues; i++) {
+		init_llist_head(&pi->pi_queues[i].piq_head);
+		spin_lock_init(&pi->pi_queues[i].piq_lock);
+		pi->pi_queues[i].piq_ready = NULL;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(ptlrpc_intake_init);
+
+void ptlrpc_intake_fini(struct ptlrpc_intake *pi)
+{
+	int i;
+
+	if (pi->pi_queues == NULL)
+		return;
+
+	for (i = 0; i < pi->pi_nqueues; i++) {
+		LASSERT(llist_empty(&pi->pi_queues[i].piq_head));
+		LASSERT(pi->pi_queues[i].piq_ready == NULL);
+	}
+
+	OBD_FREE(pi->pi_queues, pi->pi_nqueues * sizeof(pi->pi_queues[0]));
+	pi->pi_queues = NULL;
+}
+EXPORT_SYMBOL(ptlrpc_intake_fini);
+
+/**
+ * Add \a node to the queue of the current CPU, can be called from any
+ * context.
+ */
+void ptlrpc_intake_add(struct ptlrpc_intake *pi, struct llist_node *node)
+{
+	struct ptlrpc_intake_queue *piq;
+
+	/* counted first so that pi_count never goes below zero */
+	atomic_inc(&pi->pi_count);
+	piq = &pi->pi_queues[raw_smp_processor_id() % pi->pi_nqueues];
+	llist_add(node, &piq->piq_head);
+}
+EXPORT_SYMBOL(ptlrpc_intake_add);
+
+/**
+ * Take up to \a max entries of \a queue off its ready list, which is
+ * refilled from its producers first if empty.
+ *
+ * \retval	# of entries taken, linked at \a *tail
+ */
+static int ptlrpc_intake_queue_take(struct ptlrpc_intake_queue *piq,
+				    struct llist_node ***tail, int max)
+{
+	struct llist_node *node;
+	int count = 0;
+
+	spin_lock(&piq->piq_lock);
+	/* llist_add() pushes at the head, restore arrival order */
+	if (piq->piq_ready == NULL)
+		piq->piq_ready = llist_reverse_order(
+					llist_del_all(&piq->piq_head));
+
+	node = piq->piq_ready;
+	if (node != NULL) {
+		**tail = node;
+		while (++count < max && node->next != NULL)
+			node = node->next;
+		piq->piq_ready = node->next;
+		node->next = NULL;
+		*tail = &node->next;
+	}
+	spin_unlock(&piq->piq_lock);
+
+	return count;
+}
+
+/**
+ * Take up to \a max entries of \a pi, the rest is left for other threads.
+ *
+ * Entries are in arrival order for each queue, the queues are concatenated
+ * one after another. Concurrent callers start from different queues. Several
+ * threads may call this concurrently, each entry is returned only once.
+ *
+ * \retval	first entry of a NULL terminated chain
+ * \retval	NULL if \a pi is empty
+ */
+struct llist_node *ptlrpc_intake_take(struct ptlrpc_intake *pi, int max)
+{
+	struct llist_node *first = NULL;
+	struct llist_node **tail = &first;
+	struct ptlrpc_intake_queue *piq;
+	int count = 0;
+	int start;
+	int i;
+
+	if (atomic_read(&pi->pi_count) == 0)
+		return NULL;
+
+	start = atomic_inc_return(&pi->pi_next);
+	for (i = 0; i < pi->pi_nqueues && count < max; i++) {
+		piq = &pi->pi_queues[(unsigned int)(start + i) %
+				     pi->pi_nqueues];
+		if (READ_ONCE(piq->piq_ready) == NULL &&
+		    llist_empty(&piq->piq_head))
+			continue;
+
+		count += ptlrpc_intake_queue_take(piq, &tail, max - count);
+	}
+
+	if (count > 0)
+		atomic_sub(count, &pi->pi_count);
+
+	return first;
+}
+EXPORT_SYMBOL(ptlrpc_intake_take);
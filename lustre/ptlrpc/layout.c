@@ -480,6 +480,9 @@ static const struct req_msg_field *ldlm_intent_open_server[] = {
 	&RMF_FILE_SECCTX,
 	&RMF_FILE_ENCCTX,
 	&RMF_DEFAULT_MDT_MD,
+	&RMF_EADATA,
+	&RMF_EAVALS,
+	&RMF_EAVALS_LENS,
 };
 
 static const struct req_msg_field *ldlm_intent_getattr_client[] = {
@@ -502,6 +505,9 @@ static const struct req_msg_field *ldlm_intent_getattr_server[] = {
 	&RMF_FILE_SECCTX,
 	&RMF_DEFAULT_MDT_MD,
 	&RMF_FILE_ENCCTX,
+	&RMF_EADATA,
+	&RMF_EAVALS,
+	&RMF_EAVALS_LENS,
 };
 
 static const struct req_msg_field *ldlm_intent_create_client[] = {
@@ -795,6 +801,26 @@ static const struct req_msg_field *mds_batch_getattr_server[] = {
 	&RMF_FILE_ENCCTX,
 };
 
+/*
+ * The batched unlink format is the MDS_REINT_UNLINK one without the
+ * ptlrpc_body, which only the enclosing MDS_BATCH request has.
+ */
+static const struct req_msg_field *mds_batch_unlink_client[] = {
+	&RMF_REC_REINT,
+	&RMF_CAPA1,
+	&RMF_NAME,
+	&RMF_DLM_REQ,
+	&RMF_SELINUX_POL
+};
+
+static const struct req_msg_field *mds_batch_unlink_server[] = {
+	&RMF_MDT_BODY,
+	&RMF_MDT_MD,
+	&RMF_LOGCOOKIES,
+	&RMF_CAPA1,
+	&RMF_CAPA2
+};
+
 static struct req_format *req_formats[] = {
 	&RQF_OBD_PING,
 	&RQF_OBD_SET_INFO,
@@ -895,6 +921,7 @@ static struct req_format *req_formats[] = {
 	&RQF_LFSCK_NOTIFY,
 	&RQF_LFSCK_QUERY,
 	&RQF_BUT_GETATTR,
+	&RQF_BUT_UNLINK,
 	&RQF_MDS_BATCH,
 };
 
@@ -1831,6 +1858,11 @@ struct req_format RQF_BUT_GETATTR =
 			mds_batch_getattr_server);
 EXPORT_SYMBOL(RQF_BUT_GETATTR);
 
+struct req_format RQF_BUT_UNLINK =
+	DEFINE_REQ_FMT0("MDS_BATCH_UNLINK", mds_batch_unlink_client,
+			mds_batch_unlink_server);
+EXPORT_SYMBOL(RQF_BUT_UNLINK);
+
 /* Convenience macro */
 #define FMT_FIELD(fmt, i, j) (fmt)->rf_fields[(i)].d[(j)]
 
@@ -2730,6 +2762,7 @@ int req_capsule_server_grow(struct req_capsule *pill,
 	LASSERT(__req_format_is_sane(pill->rc_fmt));
 	LASSERT(req_capsule_has_field(pill, field, RCL_SERVER));
 	LASSERT(req_capsule_field_present(pill, field, RCL_SERVER));
+	LASSERT(rs->rs_kiov == NULL);
 
 	if (req_capsule_subreq(pill)) {
 		if (!req_capsule_has_field(&req->rq_pill, &RMF_BUT_REPLY,
@@ -2857,6 +2890,68 @@ int req_capsule_server_grow(struct req_capsule *pill,
 }
 EXPORT_SYMBOL(req_capsule_server_grow);
 
+/**
+ * Returns true if the content of the server \a field can be sent from pages
+ * with req_capsule_server_kiov_set(), so that it can be packed empty.
+ *
+ * This is only done for the last buffer of replies not transformed by RPC
+ * security, i.e. with the null flavor, and not for sub requests of a batched
+ * RPC.
+ */
+bool req_capsule_server_kiov_ok(const struct req_capsule *pill,
+				const struct req_msg_field *field)
+{
+	__u32 flvr = pill->rc_req->rq_flvr.sf_rpc;
+
+	LASSERT(pill->rc_fmt != NULL);
+	LASSERT(req_capsule_has_field(pill, field, RCL_SERVER));
+
+	return !req_capsule_subreq(pill) &&
+	       SPTLRPC_FLVR_POLICY(flvr) == SPTLRPC_POLICY_NULL &&
+	       __req_capsule_offset(pill, field, RCL_SERVER) ==
+	       pill->rc_fmt->rf_fields[RCL_SERVER].nr - 1;
+}
+EXPORT_SYMBOL(req_capsule_server_kiov_ok);
+
+/**
+ * Set the content of the server \a field to the \a len bytes in the \a count
+ * pages of \a kiov, and send the reply from these pages. This avoids copying
+ * large data into the reply buffer, and allocating a reply buffer that large.
+ *
+ * \a field must be packed empty, and req_capsule_server_kiov_ok() true for
+ * it. It cannot be accessed through \a pill afterwards, and the reply must
+ * not be resized.
+ *
+ * \retval 0		on success
+ * \retval negative	errno on failure, the content can still be copied
+ *			into the reply after req_capsule_server_grow()
+ */
+int req_capsule_server_kiov_set(struct req_capsule *pill,
+				const struct req_msg_field *field,
+				struct bio_vec *kiov, int count, __u32 len)
+{
+	struct ptlrpc_request *req = pill->rc_req;
+	struct ptlrpc_reply_state *rs = req->rq_reply_state;
+	__u32 offset;
+	int rc;
+
+	LASSERT(req_capsule_server_kiov_ok(pill, field));
+	LASSERT(req_capsule_field_present(pill, field, RCL_SERVER));
+
+	offset = __req_capsule_offset(pill, field, RCL_SERVER);
+	LASSERT(lustre_msg_buflen(rs->rs_msg, offset) == 0);
+
+	rc = ptlrpc_rs_kiov_set(rs, lustre_packed_msg_size(rs->rs_msg),
+				kiov, count, len);
+	if (rc)
+		return rc;
+
+	req_capsule_set_size(pill, field, RCL_SERVER, len);
+	req->rq_replen = lustre_grow_msg(rs->rs_msg, offset, len);
+	return 0;
+}
+EXPORT_SYMBOL(req_capsule_server_kiov_set);
+
 #ifdef HAVE_SERVER_SUPPORT
 static const struct req_msg_field *mds_update_client[] = {
 	&RMF_PTLRPC_BODY,
@@ -42,9 +42,11 @@
 /**
  * Helper function. Sends \a len bytes from \a base at offset \a offset
  * over \a conn connection to portal \a portal.
+ * If \a options has LNET_MD_KIOV, \a base is an array of \a len bio_vec.
  * Returns 0 on success or error code.
  */
 static int ptl_send_buf(struct lnet_handle_md *mdh, void *base, int len,
+			unsigned int options,
 			enum lnet_ack_req ack, struct ptlrpc_cb_id *cbid,
 			struct lnet_nid *self, struct lnet_processid *peer_id,
 			int portal, __u64 xid, unsigned int offset,
@@ -59,7 +61,7 @@ static int ptl_send_buf(struct lnet_handle_md *mdh, void *base, int len,
 	md.start     = base;
 	md.length    = len;
 	md.threshold = (ack == LNET_ACK_REQ) ? 2 : 1;
-	md.options   = PTLRPC_MD_OPTIONS;
+	md.options   = PTLRPC_MD_OPTIONS | options;
 	md.user_ptr  = cbid;
 	md.handler   = ptlrpc_handler;
 	LNetInvalidateMDHandle(&md.bulk_handle);
@@ -82,8 +84,9 @@ static int ptl_send_buf(struct lnet_handle_md *mdh, void *base, int len,
 		RETURN (-ENOMEM);
 	}
 
-	CDEBUG(D_NET, "Sending %d bytes to portal %d, xid %lld, offset %u\n",
-	       len, portal, xid, offset);
+	CDEBUG(D_NET, "Sending %d %s to portal %d, xid %lld, offset %u\n",
+	       len, options & LNET_MD_KIOV ? "pages" : "bytes", portal, xid,
+	       offset);
 
 	percpu_ref_get(&ptlrpc_pending);
 
@@ -576,7 +579,94 @@ static void ptlrpc_at_set_reply(struct ptlrpc_request *req, int flags)
 }
 
 /**
- * Send request reply from request \a req reply buffer.
+ * Set up \a rs to be sent from pages rather than from its reply buffer: the
+ * first \a headlen bytes of the reply buffer, followed by the \a len bytes
+ * in the \a count pages of \a kiov, padded with zeroes up to the alignment
+ * of the reply message buffers.
+ *
+ * The reply buffer is a slab or vmalloc allocation, which an LND must not
+ * send with zero-copy. Its head is copied into pages of its own by
+ * ptlrpc_send_reply(), once the reply message is complete.
+ *
+ * The reply state holds its own references on the pages of \a kiov until
+ * it is freed by lustre_free_reply_state().
+ *
+ * \retval 0		on success
+ * \retval -E2BIG	if the reply does not fit in one LNet MD
+ * \retval -ENOMEM	on allocation failure
+ */
+int ptlrpc_rs_kiov_set(struct ptlrpc_reply_state *rs, int headlen,
+		       struct bio_vec *kiov, int count, int len)
+{
+	int pad = round_up(len, 8) - len;
+	struct bio_vec *vec;
+	int nhead;
+	int total;
+	int i;
+
+	LASSERT(rs->rs_kiov == NULL);
+	LASSERT(rs->rs_msg == rs->rs_repbuf);
+
+	nhead = DIV_ROUND_UP(headlen, PAGE_SIZE);
+	total = nhead + count + (pad != 0);
+	if (total > LNET_MAX_IOV)
+		return -E2BIG;
+
+	OBD_ALLOC_PTR_ARRAY_LARGE(vec, total);
+	if (vec == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < nhead; i++) {
+		vec[i].bv_page = alloc_page(GFP_NOFS);
+		if (vec[i].bv_page == NULL) {
+			while (--i >= 0)
+				__free_page(vec[i].bv_page);
+			OBD_FREE_PTR_ARRAY_LARGE(vec, total);
+			return -ENOMEM;
+		}
+		vec[i].bv_offset = 0;
+		vec[i].bv_len = min_t(int, headlen, PAGE_SIZE);
+		headlen -= vec[i].bv_len;
+	}
+	LASSERT(headlen == 0);
+
+	for (i = 0; i < count; i++) {
+		vec[nhead + i] = kiov[i];
+		get_page(kiov[i].bv_page);
+		len -= kiov[i].bv_len;
+	}
+	LASSERTF(len == 0, "%d bytes not in pages\n", len);
+
+	if (pad != 0) {
+		vec[total - 1].bv_page = ZERO_PAGE(0);
+		vec[total - 1].bv_offset = 0;
+		vec[total - 1].bv_len = pad;
+		get_page(vec[total - 1].bv_page);
+	}
+
+	rs->rs_kiov = vec;
+	rs->rs_kiov_count = total;
+	rs->rs_kiov_head = nhead;
+
+	return 0;
+}
+
+/* Copy the complete reply head into the pages set up by ptlrpc_rs_kiov_set() */
+static void ptlrpc_rs_kiov_head_fill(struct ptlrpc_reply_state *rs)
+{
+	char *head = (char *)rs->rs_repbuf;
+	int i;
+
+	for (i = 0; i < rs->rs_kiov_head; i++) {
+		memcpy(page_address(rs->rs_kiov[i].bv_page), head,
+		       rs->rs_kiov[i].bv_len);
+		head += rs->rs_kiov[i].bv_len;
+	}
+}
+
+/**
+ * Send request reply from request \a req reply buffer, or from the pages set
+ * up by ptlrpc_rs_kiov_set().
  * \a flags defines reply types
  * Returns 0 on success or error code
  */
@@ -584,6 +674,9 @@ int ptlrpc_send_reply(struct ptlrpc_request *req, int flags)
 {
 	struct ptlrpc_reply_state *rs = req->rq_reply_state;
 	struct ptlrpc_connection  *conn;
+	unsigned int		   options;
+	void			  *base;
+	int			   len;
 	int                        rc;
 
         /* We must already have a reply buffer (only ptlrpc_error() may be
@@ -644,7 +737,18 @@ int ptlrpc_send_reply(struct ptlrpc_request *req, int flags)
 
 	req->rq_sent = ktime_get_real_seconds();
 
-	rc = ptl_send_buf(&rs->rs_md_h, rs->rs_repbuf, rs->rs_repdata_len,
+	if (rs->rs_kiov) {
+		ptlrpc_rs_kiov_head_fill(rs);
+		base = rs->rs_kiov;
+		len = rs->rs_kiov_count;
+		options = LNET_MD_KIOV;
+	} else {
+		base = rs->rs_repbuf;
+		len = rs->rs_repdata_len;
+		options = 0;
+	}
+
+	rc = ptl_send_buf(&rs->rs_md_h, base, len, options,
 			  (rs->rs_difficult && !rs->rs_no_ack) ?
 			  LNET_ACK_REQ : LNET_NOACK_REQ,
 			  &rs->rs_cb_id, &req->rq_self,
@@ -955,7 +1059,7 @@ int ptl_send_rpc(struct ptlrpc_request *request, int noreply)
 	}
 
 	rc = ptl_send_buf(&request->rq_req_md_h,
-			  request->rq_reqbuf, request->rq_reqdata_len,
+			  request->rq_reqbuf, request->rq_reqdata_len, 0,
 			  LNET_NOACK_REQ, &request->rq_req_cbid,
 			  NULL,
 			  &connection->c_peer,
@@ -1026,8 +1130,8 @@ int ptlrpc_register_rqbd(struct ptlrpc_request_buffer_desc *rqbd)
 		return PTR_ERR(me);
 	}
 
-	LASSERT(rqbd->rqbd_refcount == 0);
-	rqbd->rqbd_refcount = 1;
+	LASSERT(atomic_read(&rqbd->rqbd_refcount) == 0);
+	atomic_set(&rqbd->rqbd_refcount, 1);
 
 	md.start     = rqbd->rqbd_buffer;
 	md.length    = service->srv_buf_size;
@@ -1045,7 +1149,7 @@ int ptlrpc_register_rqbd(struct ptlrpc_request_buffer_desc *rqbd)
 
 	CERROR("%s: LNetMDAttach failed: rc = %d\n", service->srv_name, rc);
 	LASSERT(rc == -ENOMEM);
-	rqbd->rqbd_refcount = 0;
+	atomic_set(&rqbd->rqbd_refcount, 0);
 
 	return rc;
 }
@@ -1508,6 +1508,38 @@ void ptlrpc_nrs_req_add(struct ptlrpc_service_part *svcpt,
 	spin_unlock(&svcpt->scp_req_lock);
 }
 
+/**
+ * Enqueues all the requests linked through ptlrpc_request::rq_list on
+ * \a reqs on either the regular or high-priority NRS head of service
+ * partition \a svcpt, taking ptlrpc_service_part::scp_req_lock only once.
+ *
+ * \param[in] svcpt the service partition
+ * \param[in] reqs  the requests to be enqueued, emptied on return
+ * \param[in] hp    whether to enqueue the requests on the regular or
+ *		    high-priority NRS head.
+ */
+void ptlrpc_nrs_req_add_list(struct ptlrpc_service_part *svcpt,
+			     struct list_head *reqs, bool hp)
+{
+	struct ptlrpc_request *req;
+	struct ptlrpc_request *tmp;
+
+	if (list_empty(reqs))
+		return;
+
+	spin_lock(&svcpt->scp_req_lock);
+
+	list_for_each_entry_safe(req, tmp, reqs, rq_list) {
+		list_del_init(&req->rq_list);
+		if (hp)
+			ptlrpc_nrs_hpreq_add_nolock(req);
+		else
+			ptlrpc_nrs_req_add_nolock(req);
+	}
+
+	spin_unlock(&svcpt->scp_req_lock);
+}
+
 static void nrs_request_removed(struct ptlrpc_nrs_policy *policy)
 {
 	LASSERT(policy->pol_nrs->nrs_req_queued > 0);
@@ -1788,6 +1820,10 @@ int ptlrpc_nrs_init(void)
 	rc = ptlrpc_nrs_policy_register(&nrs_conf_tbf);
 	if (rc != 0)
 		GOTO(fail, rc);
+
+	rc = ptlrpc_nrs_policy_register(&nrs_conf_wfq);
+	if (rc != 0)
+		GOTO(fail, rc);
 #endif /* HAVE_SERVER_SUPPORT */
 
 	rc = ptlrpc_nrs_policy_register(&nrs_conf_delay);
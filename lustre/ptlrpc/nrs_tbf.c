@@ -37,6 +37,9 @@
  */
 
 #define DEBUG_SUBSYSTEM S_RPC
+#include <linux/hash.h>
+#include <linux/interval_tree_generic.h>
+#include <linux/jhash.h>
 #include <obd_support.h>
 #include <obd_class.h>
 #include <libcfs/libcfs.h>
@@ -80,12 +83,255 @@ static enum hrtimer_restart nrs_tbf_timer_cb(struct hrtimer *timer)
 
 #define NRS_TBF_DEFAULT_RULE "default"
 
+/**
+ * \name tbf rule index
+ *
+ * Rules are indexed when they are started, so that classifying a client only
+ * checks the rules which may match it: the ones hashed by its jobid, UID, GID
+ * or opcode, the ones with a range of NIDs including its NID, and the ones
+ * which could not be indexed. As nrs_tbf_rule::tr_rank follows the order of
+ * nrs_tbf_head::th_list, the newest rule matching the client is still the one
+ * selected.
+ * @{
+ */
+
+#define START(node)	((node)->tie_first)
+#define LAST(node)	((node)->tie_last)
+
+INTERVAL_TREE_DEFINE(struct nrs_tbf_index_entry, tie_rb, lnet_nid_t,
+		     tie_subtree_last, START, LAST, static, nrs_tbf_index_nid)
+
+static unsigned int
+nrs_tbf_index_hash(enum nrs_tbf_field field, __u32 id, const char *jobid)
+{
+	__u32 hash;
+
+	if (field == NRS_TBF_FIELD_JOBID)
+		hash = jhash(jobid, strlen(jobid), field);
+	else
+		hash = jhash_2words(id, field, 0);
+
+	return hash_32(hash, NRS_TBF_INDEX_HASH_BITS);
+}
+
+static struct nrs_tbf_index_entry *
+nrs_tbf_index_entry_add(struct nrs_tbf_rule *rule, enum nrs_tbf_field field)
+{
+	struct nrs_tbf_index_entry *tie;
+
+	OBD_ALLOC_PTR(tie);
+	if (tie == NULL)
+		return NULL;
+
+	tie->tie_rule = rule;
+	tie->tie_field = field;
+	INIT_HLIST_NODE(&tie->tie_hnode);
+	RB_CLEAR_NODE(&tie->tie_rb);
+	list_add_tail(&tie->tie_linkage, &rule->tr_index);
+	return tie;
+}
+
+static void nrs_tbf_index_free(struct nrs_tbf_rule *rule)
+{
+	struct nrs_tbf_index_entry *tie, *n;
+
+	list_for_each_entry_safe(tie, n, &rule->tr_index, tie_linkage) {
+		list_del(&tie->tie_linkage);
+		OBD_FREE_PTR(tie);
+	}
+}
+
+static int nrs_tbf_index_add_nids(lnet_nid_t first, lnet_nid_t last,
+				  void *data)
+{
+	struct nrs_tbf_index_entry *tie;
+
+	tie = nrs_tbf_index_entry_add(data, NRS_TBF_FIELD_NID);
+	if (tie == NULL)
+		return -ENOMEM;
+
+	tie->tie_first = first;
+	tie->tie_last = last;
+	return 0;
+}
+
+static int nrs_tbf_index_add_ids(struct nrs_tbf_rule *rule,
+				 struct list_head *id_list)
+{
+	struct nrs_tbf_index_entry *tie;
+	struct nrs_tbf_id *nti_id;
+
+	list_for_each_entry(nti_id, id_list, nti_linkage) {
+		if (nti_id->nti_id.ti_type & NRS_TBF_FLAG_UID) {
+			tie = nrs_tbf_index_entry_add(rule, NRS_TBF_FIELD_UID);
+			if (tie == NULL)
+				return -ENOMEM;
+			tie->tie_id = nti_id->nti_id.ti_uid;
+		}
+		if (nti_id->nti_id.ti_type & NRS_TBF_FLAG_GID) {
+			tie = nrs_tbf_index_entry_add(rule, NRS_TBF_FIELD_GID);
+			if (tie == NULL)
+				return -ENOMEM;
+			tie->tie_id = nti_id->nti_id.ti_gid;
+		}
+	}
+	return 0;
+}
+
+static int nrs_tbf_index_add_opcodes(struct nrs_tbf_rule *rule,
+				     unsigned long *opcodes)
+{
+	struct nrs_tbf_index_entry *tie;
+	unsigned int opc;
+
+	/* Default rule '*' matches no opcode */
+	if (opcodes == NULL)
+		return 0;
+
+	for_each_set_bit(opc, opcodes, LUSTRE_MAX_OPCODES) {
+		tie = nrs_tbf_index_entry_add(rule, NRS_TBF_FIELD_OPCODE);
+		if (tie == NULL)
+			return -ENOMEM;
+		tie->tie_id = opc;
+	}
+	return 0;
+}
+
+static bool nrs_tbf_jobid_list_is_full(struct list_head *jobid_list)
+{
+	struct nrs_tbf_jobid *jobid;
+
+	list_for_each_entry(jobid, jobid_list, tj_linkage) {
+		if (jobid->tj_match_flag != NRS_TBF_MATCH_FULL)
+			return false;
+	}
+	return true;
+}
+
+static int nrs_tbf_index_add_jobids(struct nrs_tbf_rule *rule,
+				    struct list_head *jobid_list)
+{
+	struct nrs_tbf_index_entry *tie;
+	struct nrs_tbf_jobid *jobid;
+
+	/* Wildcards may match any jobid */
+	if (!nrs_tbf_jobid_list_is_full(jobid_list))
+		return -EOPNOTSUPP;
+
+	list_for_each_entry(jobid, jobid_list, tj_linkage) {
+		tie = nrs_tbf_index_entry_add(rule, NRS_TBF_FIELD_JOBID);
+		if (tie == NULL)
+			return -ENOMEM;
+		strlcpy(tie->tie_jobid, jobid->tj_id, sizeof(tie->tie_jobid));
+	}
+	return 0;
+}
+
+/**
+ * Adds the entries of \a rule to the rule index, or the rule to the list of
+ * rules to scan if it could not be indexed. The ranks are to be updated by
+ * nrs_tbf_index_rank() once the rule is in nrs_tbf_head::th_list.
+ */
+static void nrs_tbf_index_insert(struct nrs_tbf_head *head,
+				 struct nrs_tbf_rule *rule, bool scan)
+{
+	struct nrs_tbf_index_entry *tie;
+	unsigned int hash;
+
+	assert_spin_locked(&head->th_rule_lock);
+	if (scan) {
+		list_add_tail(&rule->tr_scan, &head->th_index_scan);
+		return;
+	}
+
+	list_for_each_entry(tie, &rule->tr_index, tie_linkage) {
+		if (tie->tie_field == NRS_TBF_FIELD_NID) {
+			nrs_tbf_index_nid_insert(tie, &head->th_index_nids);
+			continue;
+		}
+		hash = nrs_tbf_index_hash(tie->tie_field, tie->tie_id,
+					  tie->tie_jobid);
+		hlist_add_head(&tie->tie_hnode, &head->th_index_hash[hash]);
+	}
+}
+
+static void nrs_tbf_index_remove(struct nrs_tbf_head *head,
+				 struct nrs_tbf_rule *rule)
+{
+	struct nrs_tbf_index_entry *tie;
+
+	list_for_each_entry(tie, &rule->tr_index, tie_linkage) {
+		if (tie->tie_field == NRS_TBF_FIELD_NID)
+			nrs_tbf_index_nid_remove(tie, &head->th_index_nids);
+		else
+			hlist_del_init(&tie->tie_hnode);
+	}
+	list_del_init(&rule->tr_scan);
+}
+
+/**
+ * Numbers the rules from the newest to the oldest, after any change of
+ * nrs_tbf_head::th_list, and sorts the rules to scan in the same order.
+ */
+static void nrs_tbf_index_rank(struct nrs_tbf_head *head)
+{
+	struct nrs_tbf_rule *rule;
+	__u32 rank = 0;
+
+	assert_spin_locked(&head->th_rule_lock);
+	list_for_each_entry(rule, &head->th_list, tr_linkage) {
+		rule->tr_rank = rank++;
+		if (!list_empty(&rule->tr_scan))
+			list_move_tail(&rule->tr_scan, &head->th_index_scan);
+	}
+}
+
+/**
+ * Checks \a rule against \a cli if it is newer than the rule matched so far,
+ * \a match.
+ */
+static void nrs_tbf_index_check(struct nrs_tbf_head *head,
+				struct nrs_tbf_rule *rule,
+				struct nrs_tbf_client *cli,
+				struct nrs_tbf_rule **match)
+{
+	if (*match != NULL && (*match)->tr_rank <= rule->tr_rank)
+		return;
+
+	LASSERT((rule->tr_flags & NTRS_STOPPING) == 0);
+	head->th_index_checks++;
+	if (head->th_ops->o_rule_match(rule, cli))
+		*match = rule;
+}
+
+static void nrs_tbf_index_lookup(struct nrs_tbf_head *head,
+				 struct nrs_tbf_client *cli,
+				 enum nrs_tbf_field field, __u32 id,
+				 const char *jobid, struct nrs_tbf_rule **match)
+{
+	struct nrs_tbf_index_entry *tie;
+	unsigned int hash = nrs_tbf_index_hash(field, id, jobid);
+
+	hlist_for_each_entry(tie, &head->th_index_hash[hash], tie_hnode) {
+		if (tie->tie_field != field)
+			continue;
+		if (field == NRS_TBF_FIELD_JOBID ?
+		    strcmp(tie->tie_jobid, jobid) != 0 : tie->tie_id != id)
+			continue;
+		nrs_tbf_index_check(head, tie->tie_rule, cli, match);
+	}
+}
+
+/** @} tbf rule index */
+
 static void nrs_tbf_rule_fini(struct nrs_tbf_rule *rule)
 {
 	LASSERT(atomic_read(&rule->tr_ref) == 0);
 	LASSERT(list_empty(&rule->tr_cli_list));
 	LASSERT(list_empty(&rule->tr_linkage));
+	LASSERT(list_empty(&rule->tr_scan));
 
+	nrs_tbf_index_free(rule);
 	rule->tr_head->th_ops->o_rule_fini(rule);
 	OBD_FREE_PTR(rule);
 }
@@ -226,17 +472,41 @@ static struct nrs_tbf_rule *
 nrs_tbf_rule_match(struct nrs_tbf_head *head,
 		   struct nrs_tbf_client *cli)
 {
+	struct nrs_tbf_index_entry *tie;
 	struct nrs_tbf_rule *rule = NULL;
 	struct nrs_tbf_rule *tmp_rule;
+	lnet_nid_t nid;
 
 	spin_lock(&head->th_rule_lock);
-	/* Match the newest rule in the list */
-	list_for_each_entry(tmp_rule, &head->th_list, tr_linkage) {
-		LASSERT((tmp_rule->tr_flags & NTRS_STOPPING) == 0);
-		if (head->th_ops->o_rule_match(tmp_rule, cli)) {
-			rule = tmp_rule;
+	head->th_index_lookups++;
+	/* Match the newest rule of the ones which may match */
+	if (cli->tc_jobid[0] != '\0')
+		nrs_tbf_index_lookup(head, cli, NRS_TBF_FIELD_JOBID, 0,
+				     cli->tc_jobid, &rule);
+	if (cli->tc_id.ti_type & NRS_TBF_FLAG_UID)
+		nrs_tbf_index_lookup(head, cli, NRS_TBF_FIELD_UID,
+				     cli->tc_id.ti_uid, NULL, &rule);
+	if (cli->tc_id.ti_type & NRS_TBF_FLAG_GID)
+		nrs_tbf_index_lookup(head, cli, NRS_TBF_FIELD_GID,
+				     cli->tc_id.ti_gid, NULL, &rule);
+	if (head->th_type_flag & (NRS_TBF_FLAG_OPCODE | NRS_TBF_FLAG_GENERIC))
+		nrs_tbf_index_lookup(head, cli, NRS_TBF_FIELD_OPCODE,
+				     cli->tc_opcode, NULL, &rule);
+
+	/* cfs_match_nid() only matches NIDs of 4 bytes */
+	if (nid_is_nid4(&cli->tc_nid)) {
+		nid = lnet_nid_to_nid4(&cli->tc_nid);
+		for (tie = nrs_tbf_index_nid_iter_first(&head->th_index_nids,
+							nid, nid);
+		     tie != NULL;
+		     tie = nrs_tbf_index_nid_iter_next(tie, nid, nid))
+			nrs_tbf_index_check(head, tie->tie_rule, cli, &rule);
+	}
+
+	list_for_each_entry(tmp_rule, &head->th_index_scan, tr_scan) {
+		if (rule != NULL && rule->tr_rank <= tmp_rule->tr_rank)
 			break;
-		}
+		nrs_tbf_index_check(head, tmp_rule, cli, &rule);
 	}
 
 	if (rule == NULL)
@@ -286,6 +556,7 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 	struct nrs_tbf_rule	*tmp_rule;
 	struct nrs_tbf_rule	*next_rule;
 	char			*next_name = start->u.tc_start.ts_next_name;
+	bool			 scan;
 	int			 rc;
 
 	rule = nrs_tbf_rule_find(head, start->tc_name);
@@ -307,6 +578,8 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 	INIT_LIST_HEAD(&rule->tr_cli_list);
 	INIT_LIST_HEAD(&rule->tr_nids);
 	INIT_LIST_HEAD(&rule->tr_linkage);
+	INIT_LIST_HEAD(&rule->tr_index);
+	INIT_LIST_HEAD(&rule->tr_scan);
 	spin_lock_init(&rule->tr_rule_lock);
 	rule->tr_head = head;
 
@@ -316,6 +589,11 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 		return rc;
 	}
 
+	/* Rules which cannot be indexed are checked for every client */
+	scan = head->th_ops->o_rule_index(rule) != 0;
+	if (scan)
+		nrs_tbf_index_free(rule);
+
 	/* Add as the newest rule */
 	spin_lock(&head->th_rule_lock);
 	tmp_rule = nrs_tbf_rule_find_nolock(head, start->tc_name);
@@ -340,6 +618,8 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 		/* Add on the top of the rule list */
 		list_add(&rule->tr_linkage, &head->th_list);
 	}
+	nrs_tbf_index_insert(head, rule, scan);
+	nrs_tbf_index_rank(head);
 	spin_unlock(&head->th_rule_lock);
 	atomic_inc(&head->th_rule_sequence);
 	if (start->u.tc_start.ts_rule_flags & NTRS_DEFAULT) {
@@ -348,8 +628,9 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 		head->th_rule = rule;
 	}
 
-	CDEBUG(D_RPCTRACE, "TBF starts rule@%p rate %llu gen %llu\n",
-	       rule, rule->tr_rpc_rate, rule->tr_generation);
+	CDEBUG(D_RPCTRACE, "TBF starts rule@%p rate %llu gen %llu%s\n",
+	       rule, rule->tr_rpc_rate, rule->tr_generation,
+	       scan ? " unindexed" : "");
 
 	return 0;
 }
@@ -393,6 +674,7 @@ nrs_tbf_rule_change_rank(struct ptlrpc_nrs_policy *policy,
 
 	/* rules may be adjacent in same list, so list_move() isn't safe here */
 	list_move_tail(&rule->tr_linkage, &next_rule->tr_linkage);
+	nrs_tbf_index_rank(head);
 	nrs_tbf_rule_put(next_rule);
 out_put:
 	nrs_tbf_rule_put(rule);
@@ -465,7 +747,11 @@ nrs_tbf_rule_stop(struct ptlrpc_nrs_policy *policy,
 	if (rule == NULL)
 		return -ENOENT;
 
+	spin_lock(&head->th_rule_lock);
 	list_del_init(&rule->tr_linkage);
+	nrs_tbf_index_remove(head, rule);
+	nrs_tbf_index_rank(head);
+	spin_unlock(&head->th_rule_lock);
 	rule->tr_flags |= NTRS_STOPPING;
 	nrs_tbf_rule_put(rule);
 	nrs_tbf_rule_put(rule);
@@ -1021,6 +1307,11 @@ static void nrs_tbf_jobid_rule_fini(struct nrs_tbf_rule *rule)
 	OBD_FREE(rule->tr_jobids_str, strlen(rule->tr_jobids_str) + 1);
 }
 
+static int nrs_tbf_jobid_rule_index(struct nrs_tbf_rule *rule)
+{
+	return nrs_tbf_index_add_jobids(rule, &rule->tr_jobids);
+}
+
 static struct nrs_tbf_ops nrs_tbf_jobid_ops = {
 	.o_name = NRS_TBF_TYPE_JOBID,
 	.o_startup = nrs_tbf_jobid_startup,
@@ -1032,6 +1323,7 @@ static struct nrs_tbf_ops nrs_tbf_jobid_ops = {
 	.o_rule_dump = nrs_tbf_jobid_rule_dump,
 	.o_rule_match = nrs_tbf_jobid_rule_match,
 	.o_rule_fini = nrs_tbf_jobid_rule_fini,
+	.o_rule_index = nrs_tbf_jobid_rule_index,
 };
 
 /**
@@ -1227,6 +1519,12 @@ static void nrs_tbf_nid_rule_fini(struct nrs_tbf_rule *rule)
 	OBD_FREE(rule->tr_nids_str, strlen(rule->tr_nids_str) + 1);
 }
 
+static int nrs_tbf_nid_rule_index(struct nrs_tbf_rule *rule)
+{
+	return cfs_nidlist_for_each_range(&rule->tr_nids,
+					  nrs_tbf_index_add_nids, rule);
+}
+
 static void nrs_tbf_nid_cmd_fini(struct nrs_tbf_cmd *cmd)
 {
 	if (!list_empty(&cmd->u.tc_start.ts_nids))
@@ -1271,6 +1569,7 @@ static struct nrs_tbf_ops nrs_tbf_nid_ops = {
 	.o_rule_dump = nrs_tbf_nid_rule_dump,
 	.o_rule_match = nrs_tbf_nid_rule_match,
 	.o_rule_fini = nrs_tbf_nid_rule_fini,
+	.o_rule_index = nrs_tbf_nid_rule_index,
 };
 
 static unsigned nrs_tbf_hop_hash(struct cfs_hash *hs, const void *key,
@@ -1586,8 +1885,8 @@ static int ldlm_tbf_id_cli_set(struct ptlrpc_request *req,
 	return 0;
 }
 
-static int nrs_tbf_id_cli_set(struct ptlrpc_request *req, struct tbf_id *id,
-			      enum nrs_tbf_flag ti_type)
+int nrs_tbf_id_cli_set(struct ptlrpc_request *req, struct tbf_id *id,
+		       enum nrs_tbf_flag ti_type)
 {
 	u32 opc = lustre_msg_get_opc(req->rq_reqmsg);
 	struct req_format *fmt = req_fmt(opc);
@@ -2055,6 +2354,82 @@ nrs_tbf_generic_rule_match(struct nrs_tbf_rule *rule,
 	return nrs_tbf_cond_match(rule, cli);
 }
 
+/**
+ * Gives how selective indexing a rule by expression \a expr is expected to
+ * be, the lower the fewer clients are checked, or -1 if it cannot be indexed.
+ */
+static int nrs_tbf_expression_index_cost(struct nrs_tbf_expression *expr)
+{
+	switch (expr->te_field) {
+	case NRS_TBF_FIELD_JOBID:
+		return nrs_tbf_jobid_list_is_full(&expr->te_cond) ? 0 : -1;
+	case NRS_TBF_FIELD_UID:
+	case NRS_TBF_FIELD_GID:
+		return 0;
+	case NRS_TBF_FIELD_NID:
+		return 1;
+	case NRS_TBF_FIELD_OPCODE:
+		return 2;
+	default:
+		return -1;
+	}
+}
+
+static int nrs_tbf_expression_index(struct nrs_tbf_rule *rule,
+				    struct nrs_tbf_expression *expr)
+{
+	switch (expr->te_field) {
+	case NRS_TBF_FIELD_JOBID:
+		return nrs_tbf_index_add_jobids(rule, &expr->te_cond);
+	case NRS_TBF_FIELD_UID:
+	case NRS_TBF_FIELD_GID:
+		return nrs_tbf_index_add_ids(rule, &expr->te_cond);
+	case NRS_TBF_FIELD_NID:
+		return cfs_nidlist_for_each_range(&expr->te_cond,
+						  nrs_tbf_index_add_nids,
+						  rule);
+	case NRS_TBF_FIELD_OPCODE:
+		return nrs_tbf_index_add_opcodes(rule, expr->te_opcodes);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+/**
+ * As all the expressions of a conjunction have to match, indexing one of them
+ * covers the clients matched by the conjunction. The rule is indexed by the
+ * most selective expression of each of its conjunctions.
+ */
+static int nrs_tbf_generic_rule_index(struct nrs_tbf_rule *rule)
+{
+	struct nrs_tbf_conjunction *conjunction;
+	struct nrs_tbf_expression *expr;
+	struct nrs_tbf_expression *best;
+	int best_cost;
+	int cost;
+	int rc;
+
+	list_for_each_entry(conjunction, &rule->tr_conds, tc_linkage) {
+		best = NULL;
+		best_cost = -1;
+		list_for_each_entry(expr, &conjunction->tc_expressions,
+				    te_linkage) {
+			cost = nrs_tbf_expression_index_cost(expr);
+			if (cost >= 0 && (best == NULL || cost < best_cost)) {
+				best = expr;
+				best_cost = cost;
+			}
+		}
+		if (best == NULL)
+			return -EOPNOTSUPP;
+
+		rc = nrs_tbf_expression_index(rule, best);
+		if (rc)
+			return rc;
+	}
+	return 0;
+}
+
 static struct nrs_tbf_ops nrs_tbf_generic_ops = {
 	.o_name = NRS_TBF_TYPE_GENERIC,
 	.o_startup = nrs_tbf_startup,
@@ -2066,6 +2441,7 @@ static struct nrs_tbf_ops nrs_tbf_generic_ops = {
 	.o_rule_dump = nrs_tbf_generic_rule_dump,
 	.o_rule_match = nrs_tbf_generic_rule_match,
 	.o_rule_fini = nrs_tbf_generic_rule_fini,
+	.o_rule_index = nrs_tbf_generic_rule_index,
 };
 
 static void nrs_tbf_opcode_rule_fini(struct nrs_tbf_rule *rule)
@@ -2329,6 +2705,11 @@ nrs_tbf_opcode_rule_dump(struct nrs_tbf_rule *rule, struct seq_file *m)
 	return 0;
 }
 
+static int nrs_tbf_opcode_rule_index(struct nrs_tbf_rule *rule)
+{
+	return nrs_tbf_index_add_opcodes(rule, rule->tr_opcodes);
+}
+
 
 struct nrs_tbf_ops nrs_tbf_opcode_ops = {
 	.o_name = NRS_TBF_TYPE_OPCODE,
@@ -2341,6 +2722,7 @@ struct nrs_tbf_ops nrs_tbf_opcode_ops = {
 	.o_rule_dump = nrs_tbf_opcode_rule_dump,
 	.o_rule_match = nrs_tbf_opcode_rule_match,
 	.o_rule_fini = nrs_tbf_opcode_rule_fini,
+	.o_rule_index = nrs_tbf_opcode_rule_index,
 };
 
 static unsigned nrs_tbf_id_hop_hash(struct cfs_hash *hs, const void *key,
@@ -2654,6 +3036,11 @@ static void nrs_tbf_id_rule_fini(struct nrs_tbf_rule *rule)
 		OBD_FREE(rule->tr_ids_str, strlen(rule->tr_ids_str) + 1);
 }
 
+static int nrs_tbf_id_rule_index(struct nrs_tbf_rule *rule)
+{
+	return nrs_tbf_index_add_ids(rule, &rule->tr_ids);
+}
+
 struct nrs_tbf_ops nrs_tbf_uid_ops = {
 	.o_name = NRS_TBF_TYPE_UID,
 	.o_startup = nrs_tbf_id_startup,
@@ -2665,6 +3052,7 @@ struct nrs_tbf_ops nrs_tbf_uid_ops = {
 	.o_rule_dump = nrs_tbf_id_rule_dump,
 	.o_rule_match = nrs_tbf_id_rule_match,
 	.o_rule_fini = nrs_tbf_id_rule_fini,
+	.o_rule_index = nrs_tbf_id_rule_index,
 };
 
 struct nrs_tbf_ops nrs_tbf_gid_ops = {
@@ -2678,6 +3066,7 @@ struct nrs_tbf_ops nrs_tbf_gid_ops = {
 	.o_rule_dump = nrs_tbf_id_rule_dump,
 	.o_rule_match = nrs_tbf_id_rule_match,
 	.o_rule_fini = nrs_tbf_id_rule_fini,
+	.o_rule_index = nrs_tbf_id_rule_index,
 };
 
 static struct nrs_tbf_type nrs_tbf_types[] = {
@@ -2773,6 +3162,10 @@ static int nrs_tbf_start(struct ptlrpc_nrs_policy *policy, char *arg)
 	atomic_set(&head->th_rule_sequence, 0);
 	spin_lock_init(&head->th_rule_lock);
 	INIT_LIST_HEAD(&head->th_list);
+	for (i = 0; i < NRS_TBF_INDEX_HASH_SIZE; i++)
+		INIT_HLIST_HEAD(&head->th_index_hash[i]);
+	head->th_index_nids = INTERVAL_TREE_ROOT;
+	INIT_LIST_HEAD(&head->th_index_scan);
 	hrtimer_init(&head->th_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
 	head->th_timer.function = nrs_tbf_timer_cb;
 	rc = head->th_ops->o_startup(policy, head);
@@ -2811,6 +3204,7 @@ static void nrs_tbf_stop(struct ptlrpc_nrs_policy *policy)
 	cfs_hash_putref(head->th_cli_hash);
 	list_for_each_entry_safe(rule, n, &head->th_list, tr_linkage) {
 		list_del_init(&rule->tr_linkage);
+		nrs_tbf_index_remove(head, rule);
 		nrs_tbf_rule_put(rule);
 	}
 	LASSERT(list_empty(&head->th_list));
@@ -2886,6 +3280,26 @@ static int nrs_tbf_ctl(struct ptlrpc_nrs_policy *policy,
 		*(__u32 *)arg = head->th_type_flag;
 		}
 		break;
+	/**
+	 * Read the classification counters of a policy instance.
+	 */
+	case NRS_CTL_TBF_RD_INDEX_STATS: {
+		struct nrs_tbf_head *head = policy->pol_private;
+		struct seq_file *m = arg;
+		struct ptlrpc_service_part *svcpt;
+		struct nrs_tbf_rule *rule;
+		__u32 scanned = 0;
+
+		svcpt = policy->pol_nrs->nrs_svcpt;
+		spin_lock(&head->th_rule_lock);
+		list_for_each_entry(rule, &head->th_index_scan, tr_scan)
+			scanned++;
+		seq_printf(m, "CPT %d: lookups %llu checks %llu unindexed %u\n",
+			   svcpt->scp_cpt, head->th_index_lookups,
+			   head->th_index_checks, scanned);
+		spin_unlock(&head->th_rule_lock);
+		}
+		break;
 	}
 
 	RETURN(rc);
@@ -3634,6 +4048,40 @@ out:
 
 LDEBUGFS_SEQ_FOPS(ptlrpc_lprocfs_nrs_tbf_rule);
 
+/**
+ * Prints the number of clients classified by the TBF policy instances of a
+ * service, the number of rules checked for them, and the number of rules
+ * which could not be indexed, i.e. which are checked for every client.
+ */
+static int
+ptlrpc_lprocfs_nrs_tbf_index_stats_seq_show(struct seq_file *m, void *data)
+{
+	struct ptlrpc_service *svc = m->private;
+	int rc;
+
+	seq_puts(m, "regular_requests:\n");
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_TBF,
+				       NRS_CTL_TBF_RD_INDEX_STATS,
+				       false, m);
+	/* the policy may be stopped on either NRS head */
+	if (rc != 0 && rc != -ENODEV)
+		return rc;
+
+	if (!nrs_svc_has_hp(svc))
+		return 0;
+
+	seq_puts(m, "high_priority_requests:\n");
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+				       NRS_POL_NAME_TBF,
+				       NRS_CTL_TBF_RD_INDEX_STATS,
+				       false, m);
+
+	return rc == -ENODEV ? 0 : rc;
+}
+
+LDEBUGFS_SEQ_FOPS_RO(ptlrpc_lprocfs_nrs_tbf_index_stats);
+
 /**
  * Initializes a TBF policy's lprocfs interface for service \a svc
  *
@@ -3648,6 +4096,9 @@ static int nrs_tbf_lprocfs_init(struct ptlrpc_service *svc)
 		{ .name		= "nrs_tbf_rule",
 		  .fops		= &ptlrpc_lprocfs_nrs_tbf_rule_fops,
 		  .data = svc },
+		{ .name		= "nrs_tbf_index_stats",
+		  .fops		= &ptlrpc_lprocfs_nrs_tbf_index_stats_fops,
+		  .data = svc },
 		{ NULL }
 	};
 
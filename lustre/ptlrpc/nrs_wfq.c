@@ -0,0 +1,852 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/ptlrpc/nrs_wfq.c
+ *
+ * Network Request Scheduler (NRS) WFQ policy
+ *
+ * Weighted fair queuing of requests by jobid, UID, GID or project, using
+ * Deficit Round Robin over the classes that have requests queued.
+ */
+/**
+ * \addtogoup nrs
+ * @{
+ */
+
+#define DEBUG_SUBSYSTEM S_RPC
+#include <obd_support.h>
+#include <obd_class.h>
+#include <lustre_net.h>
+#include <lustre_req_layout.h>
+#include <lprocfs_status.h>
+#include "ptlrpc_internal.h"
+
+/**
+ * \name WFQ policy
+ *
+ * Requests are sorted in classes, by the jobid, UID, GID or project ID they
+ * carry, as chosen when starting the policy. Classes with queued requests are
+ * served in turn; in each round a class may have up to its weight of requests
+ * handled, and it loses its turn as soon as it has no more requests queued.
+ * Idle classes so take no share of the service, while a busy class cannot
+ * delay the others by more than one round.
+ *
+ * @{
+ */
+
+#define NRS_POL_NAME_WFQ	"wfq"
+
+static const char *const nrs_wfq_key_names[] = {
+	[NRS_WFQ_KEY_JOBID]	= "jobid",
+	[NRS_WFQ_KEY_UID]	= "uid",
+	[NRS_WFQ_KEY_GID]	= "gid",
+	[NRS_WFQ_KEY_PROJID]	= "projid",
+};
+
+/**
+ * rhashtable operations for nrs_wfq_head::wh_cls_hash
+ *
+ * Keys are NUL-padded to NRS_WFQ_KEY_LEN, so that the default hash and compare
+ * functions can be used.
+ */
+static const struct rhashtable_params nrs_wfq_hash_params = {
+	.key_len		= NRS_WFQ_KEY_LEN,
+	.key_offset		= offsetof(struct nrs_wfq_class, wc_key),
+	.head_offset		= offsetof(struct nrs_wfq_class, wc_rhead),
+	.automatic_shrinking	= true,
+};
+
+static void nrs_wfq_exit(void *vcls, void *data)
+{
+	struct nrs_wfq_class *cls = vcls;
+
+	LASSERTF(atomic_read(&cls->wc_ref) == 0,
+		 "Busy WFQ class '%s', with %d refs\n",
+		 cls->wc_key, atomic_read(&cls->wc_ref));
+
+	OBD_FREE_PTR(cls);
+}
+
+/**
+ * Finds the project ID of request \a req in its OST or MDT body, if the client
+ * has set it there.
+ *
+ * \param[in]  req	the request
+ * \param[out] projid	the project ID of the request
+ *
+ * \retval 0	   success
+ * \retval -ENODATA the request carries no project ID
+ * \retval -EINVAL  unknown request format
+ */
+static int nrs_wfq_projid_get(struct ptlrpc_request *req, u32 *projid)
+{
+	struct req_format *fmt = req_fmt(lustre_msg_get_opc(req->rq_reqmsg));
+	struct req_capsule *pill = &req->rq_pill;
+	bool fmt_unset = false;
+	int rc = -ENODATA;
+
+	if (fmt == NULL)
+		return -EINVAL;
+
+	req_capsule_init(pill, req, RCL_SERVER);
+	if (pill->rc_fmt == NULL) {
+		req_capsule_set(pill, fmt);
+		fmt_unset = true;
+	}
+
+	if (req_capsule_has_field(pill, &RMF_OST_BODY, RCL_CLIENT)) {
+		struct ost_body *body;
+
+		body = req_capsule_client_get(pill, &RMF_OST_BODY);
+		if (body != NULL && body->oa.o_valid & OBD_MD_FLPROJID) {
+			*projid = body->oa.o_projid;
+			rc = 0;
+		}
+	} else if (req_capsule_has_field(pill, &RMF_MDT_BODY, RCL_CLIENT)) {
+		struct mdt_body *body;
+
+		body = req_capsule_client_get(pill, &RMF_MDT_BODY);
+		if (body != NULL && body->mbo_valid & OBD_MD_FLPROJID) {
+			*projid = body->mbo_projid;
+			rc = 0;
+		}
+	}
+
+	/* restore it to the initialized state */
+	if (fmt_unset)
+		pill->rc_fmt = NULL;
+	return rc;
+}
+
+/**
+ * Fills \a key with the class key of request \a req; requests that do not
+ * carry the attribute classes are keyed by all share the empty key.
+ */
+static void nrs_wfq_key_get(struct nrs_wfq_head *head,
+			    struct ptlrpc_request *req, char *key)
+{
+	const char *jobid;
+	struct tbf_id id;
+	u32 projid;
+
+	memset(key, 0, NRS_WFQ_KEY_LEN);
+
+	switch (head->wh_key_type) {
+	case NRS_WFQ_KEY_JOBID:
+		jobid = lustre_msg_get_jobid(req->rq_reqmsg);
+		if (jobid != NULL)
+			strlcpy(key, jobid, NRS_WFQ_KEY_LEN);
+		break;
+	case NRS_WFQ_KEY_UID:
+		if (nrs_tbf_id_cli_set(req, &id, NRS_TBF_FLAG_UID) == 0)
+			snprintf(key, NRS_WFQ_KEY_LEN, "%u", id.ti_uid);
+		break;
+	case NRS_WFQ_KEY_GID:
+		if (nrs_tbf_id_cli_set(req, &id, NRS_TBF_FLAG_GID) == 0)
+			snprintf(key, NRS_WFQ_KEY_LEN, "%u", id.ti_gid);
+		break;
+	case NRS_WFQ_KEY_PROJID:
+		if (nrs_wfq_projid_get(req, &projid) == 0)
+			snprintf(key, NRS_WFQ_KEY_LEN, "%u", projid);
+		break;
+	}
+}
+
+/**
+ * Refreshes the weight of class \a cls, if it has changed since it was last
+ * looked up.
+ */
+static void nrs_wfq_class_weight(struct nrs_wfq_head *head,
+				 struct nrs_wfq_class *cls)
+{
+	struct nrs_wfq_weight *weight;
+
+	if (cls->wc_weight != 0 &&
+	    cls->wc_weights_gen == READ_ONCE(head->wh_weights_gen))
+		return;
+
+	spin_lock(&head->wh_lock);
+	cls->wc_weight = head->wh_weight_default;
+	list_for_each_entry(weight, &head->wh_weights, ww_list) {
+		if (strcmp(weight->ww_key, cls->wc_key) == 0) {
+			cls->wc_weight = weight->ww_weight;
+			break;
+		}
+	}
+	cls->wc_weights_gen = head->wh_weights_gen;
+	spin_unlock(&head->wh_lock);
+}
+
+/**
+ * Called when a WFQ policy instance is started.
+ *
+ * \param[in] policy the policy
+ * \param[in] arg    the request attribute to key classes by, "jobid" if NULL
+ *
+ * \retval -ENOMEM   OOM error
+ * \retval -ENOTSUPP unknown class key
+ * \retval 0	     success
+ */
+static int nrs_wfq_start(struct ptlrpc_nrs_policy *policy, char *arg)
+{
+	struct nrs_wfq_head *head;
+	int key_type = NRS_WFQ_KEY_JOBID;
+	int rc;
+	ENTRY;
+
+	if (arg != NULL) {
+		for (key_type = 0; key_type < ARRAY_SIZE(nrs_wfq_key_names);
+		     key_type++) {
+			if (strcmp(arg, nrs_wfq_key_names[key_type]) == 0)
+				break;
+		}
+		if (key_type == ARRAY_SIZE(nrs_wfq_key_names))
+			RETURN(-ENOTSUPP);
+	}
+
+	OBD_CPT_ALLOC_PTR(head, nrs_pol2cptab(policy), nrs_pol2cptid(policy));
+	if (head == NULL)
+		RETURN(-ENOMEM);
+
+	rc = rhashtable_init(&head->wh_cls_hash, &nrs_wfq_hash_params);
+	if (rc) {
+		OBD_FREE_PTR(head);
+		RETURN(rc);
+	}
+
+	INIT_LIST_HEAD(&head->wh_active);
+	spin_lock_init(&head->wh_lock);
+	INIT_LIST_HEAD(&head->wh_weights);
+	head->wh_weight_default = NRS_WFQ_WEIGHT_DEFAULT;
+	head->wh_key_type = key_type;
+
+	policy->pol_private = head;
+
+	RETURN(0);
+}
+
+/**
+ * Called when a WFQ policy instance is stopped.
+ *
+ * Called when the policy has been instructed to transition to the
+ * ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state and has no more pending
+ * requests to serve.
+ *
+ * \param[in] policy the policy
+ */
+static void nrs_wfq_stop(struct ptlrpc_nrs_policy *policy)
+{
+	struct nrs_wfq_head *head = policy->pol_private;
+	struct nrs_wfq_weight *weight;
+	struct nrs_wfq_weight *tmp;
+	ENTRY;
+
+	LASSERT(head != NULL);
+	LASSERT(list_empty(&head->wh_active));
+
+	rhashtable_free_and_destroy(&head->wh_cls_hash, nrs_wfq_exit, NULL);
+
+	list_for_each_entry_safe(weight, tmp, &head->wh_weights, ww_list) {
+		list_del(&weight->ww_list);
+		OBD_FREE_PTR(weight);
+	}
+
+	OBD_FREE_PTR(head);
+	EXIT;
+}
+
+/**
+ * Sets, or drops if the weight is 0, the weight of a class.
+ *
+ * \param[in] policy the policy instance
+ * \param[in] cmd    the class key and weight
+ *
+ * \retval 0	   success
+ * \retval -EINVAL the default weight cannot be dropped
+ * \retval -ENOMEM OOM error
+ */
+static int nrs_wfq_weight_set(struct ptlrpc_nrs_policy *policy,
+			      struct nrs_wfq_weight_cmd *cmd)
+{
+	struct nrs_wfq_head *head = policy->pol_private;
+	struct nrs_wfq_weight *weight;
+	struct nrs_wfq_weight *new = NULL;
+	struct nrs_wfq_weight *old = NULL;
+
+	if (strcmp(cmd->wwc_key, NRS_WFQ_KEY_DEFAULT) == 0) {
+		if (cmd->wwc_weight == 0)
+			return -EINVAL;
+
+		spin_lock(&head->wh_lock);
+		head->wh_weight_default = cmd->wwc_weight;
+		head->wh_weights_gen++;
+		spin_unlock(&head->wh_lock);
+		return 0;
+	}
+
+	if (cmd->wwc_weight != 0) {
+		/* called under nrs_lock */
+		OBD_CPT_ALLOC_GFP(new, nrs_pol2cptab(policy),
+				  nrs_pol2cptid(policy), sizeof(*new),
+				  GFP_ATOMIC);
+		if (new == NULL)
+			return -ENOMEM;
+
+		memcpy(new->ww_key, cmd->wwc_key, sizeof(new->ww_key));
+		new->ww_weight = cmd->wwc_weight;
+	}
+
+	spin_lock(&head->wh_lock);
+	list_for_each_entry(weight, &head->wh_weights, ww_list) {
+		if (strcmp(weight->ww_key, cmd->wwc_key) == 0) {
+			list_del(&weight->ww_list);
+			old = weight;
+			break;
+		}
+	}
+	if (new != NULL)
+		list_add_tail(&new->ww_list, &head->wh_weights);
+	head->wh_weights_gen++;
+	spin_unlock(&head->wh_lock);
+
+	if (old != NULL)
+		OBD_FREE_PTR(old);
+
+	return 0;
+}
+
+/**
+ * Performs a policy-specific ctl function on WFQ policy instances; similar
+ * to ioctl.
+ *
+ * \param[in]	  policy the policy instance
+ * \param[in]	  opc	 the opcode
+ * \param[in,out] arg	 used for passing parameters and information
+ *
+ * \pre assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ * \post assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ *
+ * \retval 0   operation carried out successfully
+ * \retval -ve error
+ */
+static int nrs_wfq_ctl(struct ptlrpc_nrs_policy *policy,
+		       enum ptlrpc_nrs_ctl opc, void *arg)
+{
+	int rc = 0;
+	ENTRY;
+
+	assert_spin_locked(&policy->pol_nrs->nrs_lock);
+
+	switch (opc) {
+	default:
+		RETURN(-EINVAL);
+
+	/**
+	 * Print the weights of a policy instance.
+	 */
+	case NRS_CTL_WFQ_RD_WEIGHTS: {
+		struct nrs_wfq_head *head = policy->pol_private;
+		struct nrs_wfq_weight *weight;
+		struct seq_file *m = arg;
+
+		seq_printf(m, "CPT %d: %s\n", nrs_pol2cptid(policy),
+			   nrs_wfq_key_names[head->wh_key_type]);
+
+		spin_lock(&head->wh_lock);
+		seq_printf(m, "%s %u\n", NRS_WFQ_KEY_DEFAULT,
+			   head->wh_weight_default);
+		list_for_each_entry(weight, &head->wh_weights, ww_list)
+			seq_printf(m, "%s %u\n", weight->ww_key,
+				   weight->ww_weight);
+		spin_unlock(&head->wh_lock);
+		}
+		break;
+
+	/**
+	 * Set the weight of a class of a policy instance.
+	 */
+	case NRS_CTL_WFQ_WR_WEIGHT:
+		rc = nrs_wfq_weight_set(policy, arg);
+		break;
+	}
+
+	RETURN(rc);
+}
+
+/**
+ * Obtains resources from WFQ policy instances. The top-level resource lives
+ * inside \e nrs_wfq_head and the second-level resource inside
+ * \e nrs_wfq_class object instances.
+ *
+ * Classes are created by the first request of theirs, and freed when the last
+ * one releases its reference, so that the number of classes is bounded by the
+ * number of requests in the service.
+ *
+ * \param[in]  policy	  the policy for which resources are being taken for
+ *			  request \a nrq
+ * \param[in]  nrq	  the request for which resources are being taken
+ * \param[in]  parent	  parent resource, embedded in nrs_wfq_head for the
+ *			  WFQ policy
+ * \param[out] resp	  resources references are placed in this array
+ * \param[in]  moving_req signifies limited caller context; used to perform
+ *			  memory allocations in an atomic context in this
+ *			  policy
+ *
+ * \retval 0   we are returning a top-level, parent resource, one that is
+ *	       embedded in an nrs_wfq_head object
+ * \retval 1   we are returning a bottom-level resource, one that is embedded
+ *	       in an nrs_wfq_class object
+ *
+ * \see nrs_resource_get_safe()
+ */
+static int nrs_wfq_res_get(struct ptlrpc_nrs_policy *policy,
+			   struct ptlrpc_nrs_request *nrq,
+			   const struct ptlrpc_nrs_resource *parent,
+			   struct ptlrpc_nrs_resource **resp, bool moving_req)
+{
+	struct nrs_wfq_head *head;
+	struct nrs_wfq_class *cls;
+	struct nrs_wfq_class *new = NULL;
+	struct ptlrpc_request *req;
+	char key[NRS_WFQ_KEY_LEN];
+
+	if (parent == NULL) {
+		*resp = &((struct nrs_wfq_head *)policy->pol_private)->wh_res;
+		return 0;
+	}
+
+	head = container_of(parent, struct nrs_wfq_head, wh_res);
+	req = container_of(nrq, struct ptlrpc_request, rq_nrq);
+	nrs_wfq_key_get(head, req, key);
+
+again:
+	rcu_read_lock();
+	cls = rhashtable_lookup(&head->wh_cls_hash, key, nrs_wfq_hash_params);
+	if (cls != NULL && !atomic_inc_not_zero(&cls->wc_ref))
+		cls = NULL;
+	rcu_read_unlock();
+	if (cls != NULL)
+		goto out;
+
+	if (new == NULL) {
+		OBD_CPT_ALLOC_GFP(new, nrs_pol2cptab(policy),
+				  nrs_pol2cptid(policy), sizeof(*new),
+				  moving_req ? GFP_ATOMIC : GFP_NOFS);
+		if (new == NULL)
+			return -ENOMEM;
+
+		memcpy(new->wc_key, key, sizeof(new->wc_key));
+		INIT_LIST_HEAD(&new->wc_list);
+		INIT_LIST_HEAD(&new->wc_reqs);
+		atomic_set(&new->wc_ref, 1);
+	}
+
+	cls = rhashtable_lookup_get_insert_fast(&head->wh_cls_hash,
+						&new->wc_rhead,
+						nrs_wfq_hash_params);
+	if (cls == NULL) {
+		cls = new;
+	} else if (IS_ERR(cls)) {
+		OBD_FREE_PTR(new);
+		return PTR_ERR(cls);
+	} else if (!atomic_inc_not_zero(&cls->wc_ref)) {
+		/* the class is being freed by nrs_wfq_res_put() */
+		cpu_relax();
+		goto again;
+	}
+out:
+	if (new != NULL && new != cls)
+		OBD_FREE_PTR(new);
+	*resp = &cls->wc_res;
+
+	return 1;
+}
+
+/**
+ * Called when releasing references to the resource hierachy obtained for a
+ * request for scheduling using the WFQ policy.
+ *
+ * \param[in] policy   the policy the resource belongs to
+ * \param[in] res      the resource to be released
+ */
+static void nrs_wfq_res_put(struct ptlrpc_nrs_policy *policy,
+			    const struct ptlrpc_nrs_resource *res)
+{
+	struct nrs_wfq_head *head;
+	struct nrs_wfq_class *cls;
+
+	/**
+	 * Do nothing for freeing parent, nrs_wfq_head resources
+	 */
+	if (res->res_parent == NULL)
+		return;
+
+	cls = container_of(res, struct nrs_wfq_class, wc_res);
+	head = container_of(res->res_parent, struct nrs_wfq_head, wh_res);
+
+	if (!atomic_dec_and_test(&cls->wc_ref))
+		return;
+
+	LASSERT(list_empty(&cls->wc_reqs));
+	rhashtable_remove_fast(&head->wh_cls_hash, &cls->wc_rhead,
+			       nrs_wfq_hash_params);
+	OBD_FREE_PRE(cls, sizeof(*cls), "kfree_rcu");
+	kfree_rcu(cls, wc_rcu);
+}
+
+/**
+ * Takes request \a nrq off the queue of its class \a cls, moving the class to
+ * the end of the round when it has used its deficit, or off the round when it
+ * has no more requests queued.
+ *
+ * \param[in] served whether the request is taken to be handled
+ */
+static void nrs_wfq_req_unlink(struct nrs_wfq_head *head,
+			       struct nrs_wfq_class *cls,
+			       struct ptlrpc_nrs_request *nrq, bool served)
+{
+	list_del_init(&nrq->nr_u.wfq.wr_list);
+
+	if (list_empty(&cls->wc_reqs)) {
+		/* an idle class keeps no deficit */
+		list_del_init(&cls->wc_list);
+	} else if (served && --cls->wc_deficit == 0) {
+		nrs_wfq_class_weight(head, cls);
+		cls->wc_deficit = cls->wc_weight;
+		list_move_tail(&cls->wc_list, &head->wh_active);
+	}
+}
+
+/**
+ * Called when getting a request from the WFQ policy for handling, so that it
+ * can be served
+ *
+ * \param[in] policy the policy being polled
+ * \param[in] peek   when set, signifies that we just want to examine the
+ *		     request, and not handle it, so the request is not removed
+ *		     from the policy.
+ * \param[in] force  force the policy to return a request; unused in this policy
+ *
+ * \retval the request to be handled
+ * \retval NULL no request available
+ *
+ * \see ptlrpc_nrs_req_get_nolock()
+ * \see nrs_request_get()
+ */
+static
+struct ptlrpc_nrs_request *nrs_wfq_req_get(struct ptlrpc_nrs_policy *policy,
+					   bool peek, bool force)
+{
+	struct nrs_wfq_head *head = policy->pol_private;
+	struct ptlrpc_nrs_request *nrq;
+	struct nrs_wfq_class *cls;
+
+	cls = list_first_entry_or_null(&head->wh_active, struct nrs_wfq_class,
+				       wc_list);
+	if (unlikely(cls == NULL))
+		return NULL;
+
+	nrq = list_first_entry(&cls->wc_reqs, struct ptlrpc_nrs_request,
+			       nr_u.wfq.wr_list);
+
+	if (likely(!peek)) {
+		struct ptlrpc_request *req = container_of(nrq,
+							  struct ptlrpc_request,
+							  rq_nrq);
+
+		CDEBUG(D_RPCTRACE,
+		       "NRS: starting to handle %s request from %s, class '%s' with deficit %u\n",
+		       NRS_POL_NAME_WFQ, libcfs_idstr(&req->rq_peer),
+		       cls->wc_key, cls->wc_deficit);
+
+		nrs_wfq_req_unlink(head, cls, nrq, true);
+	}
+
+	return nrq;
+}
+
+/**
+ * Adds request \a nrq to a WFQ \a policy instance's set of queued requests
+ *
+ * Requests are queued in arrival order on their class. A class that had no
+ * requests queued joins the end of the current round, with a deficit of its
+ * weight.
+ *
+ * \param[in] policy the policy
+ * \param[in] nrq    the request to add
+ *
+ * \retval 0	request successfully added
+ */
+static int nrs_wfq_req_add(struct ptlrpc_nrs_policy *policy,
+			   struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_wfq_head *head;
+	struct nrs_wfq_class *cls;
+
+	cls = container_of(nrs_request_resource(nrq),
+			   struct nrs_wfq_class, wc_res);
+	head = container_of(nrs_request_resource(nrq)->res_parent,
+			    struct nrs_wfq_head, wh_res);
+
+	if (list_empty(&cls->wc_reqs)) {
+		nrs_wfq_class_weight(head, cls);
+		cls->wc_deficit = cls->wc_weight;
+		list_add_tail(&cls->wc_list, &head->wh_active);
+	}
+	list_add_tail(&nrq->nr_u.wfq.wr_list, &cls->wc_reqs);
+
+	return 0;
+}
+
+/**
+ * Removes request \a nrq from a WFQ \a policy instance's set of queued
+ * requests.
+ *
+ * \param[in] policy the policy
+ * \param[in] nrq    the request to remove
+ */
+static void nrs_wfq_req_del(struct ptlrpc_nrs_policy *policy,
+			    struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_wfq_head *head;
+	struct nrs_wfq_class *cls;
+
+	cls = container_of(nrs_request_resource(nrq),
+			   struct nrs_wfq_class, wc_res);
+	head = container_of(nrs_request_resource(nrq)->res_parent,
+			    struct nrs_wfq_head, wh_res);
+
+	nrs_wfq_req_unlink(head, cls, nrq, false);
+}
+
+/**
+ * Called right after the request \a nrq finishes being handled by WFQ policy
+ * instance \a policy.
+ *
+ * \param[in] policy the policy that handled the request
+ * \param[in] nrq    the request that was handled
+ */
+static void nrs_wfq_req_stop(struct ptlrpc_nrs_policy *policy,
+			     struct ptlrpc_nrs_request *nrq)
+{
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
+	struct nrs_wfq_class *cls = container_of(nrs_request_resource(nrq),
+						 struct nrs_wfq_class, wc_res);
+
+	CDEBUG(D_RPCTRACE,
+	       "NRS: finished handling %s request from %s, class '%s'\n",
+	       NRS_POL_NAME_WFQ, libcfs_idstr(&req->rq_peer), cls->wc_key);
+}
+
+/**
+ * debugfs interface
+ */
+
+/**
+ * Prints the weights of WFQ policy instances on both the regular and
+ * high-priority NRS head of a service, as long as a policy instance is not in
+ * the ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state.
+ *
+ * For example:
+ *
+ *	regular_requests:
+ *	CPT 0: jobid
+ *	default 1
+ *	dd.500 4
+ *	high_priority_requests:
+ *	CPT 0: jobid
+ *	default 1
+ */
+static int
+ptlrpc_lprocfs_nrs_wfq_weight_seq_show(struct seq_file *m, void *data)
+{
+	struct ptlrpc_service *svc = m->private;
+	int rc;
+
+	seq_printf(m, "regular_requests:\n");
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_WFQ,
+				       NRS_CTL_WFQ_RD_WEIGHTS,
+				       false, m);
+	/**
+	 * Ignore -ENODEV as the regular NRS head's policy may be in the
+	 * ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state.
+	 */
+	if (rc != 0 && rc != -ENODEV)
+		return rc;
+
+	if (!nrs_svc_has_hp(svc))
+		return rc;
+
+	seq_printf(m, "high_priority_requests:\n");
+	return ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+					 NRS_POL_NAME_WFQ,
+					 NRS_CTL_WFQ_RD_WEIGHTS,
+					 false, m);
+}
+
+/**
+ * The longest command "reg <key> 65535", see
+ * ptlrpc_lprocfs_nrs_wfq_weight_seq_write().
+ */
+#define LPROCFS_NRS_WFQ_WR_WEIGHT_MAX_CMD				       \
+	(sizeof("reg ") + NRS_WFQ_KEY_LEN +				       \
+	 sizeof(__stringify(LPROCFS_NRS_QUANTUM_MAX)))
+
+/**
+ * Sets the weight of a class of WFQ policy instances of a service, on the
+ * regular or high priority NRS head, or both when none is specified. A weight
+ * of 0 drops the weight set for the class, which then falls back to the
+ * default weight.
+ *
+ * For example:
+ *
+ * lctl set_param ost.OSS.ost_io.nrs_wfq_weight="dd.500 4", to have requests
+ * of job dd.500 handled 4 times as often as those of other jobs, as long as
+ * they are all busy
+ *
+ * lctl set_param ost.OSS.ost_io.nrs_wfq_weight="reg default 2", to set the
+ * weight of classes without a weight of their own, for regular requests only.
+ *
+ * policy instances in the ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state
+ * are skipped later by nrs_wfq_ctl().
+ */
+static ssize_t
+ptlrpc_lprocfs_nrs_wfq_weight_seq_write(struct file *file,
+					const char __user *buffer,
+					size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ptlrpc_service *svc = m->private;
+	enum ptlrpc_nrs_queue_type queue = PTLRPC_NRS_QUEUE_BOTH;
+	struct nrs_wfq_weight_cmd cmd = { { 0 } };
+	char kernbuf[LPROCFS_NRS_WFQ_WR_WEIGHT_MAX_CMD];
+	char *buf;
+	char *key;
+	unsigned long weight;
+	int rc = 0;
+	int rc2 = 0;
+
+	if (count > (sizeof(kernbuf) - 1))
+		return -EINVAL;
+
+	if (copy_from_user(kernbuf, buffer, count))
+		return -EFAULT;
+
+	kernbuf[count] = '\0';
+
+	buf = strim(kernbuf);
+	key = strsep(&buf, " ");
+	if (strcmp(key, "reg") == 0 || strcmp(key, "hp") == 0) {
+		queue = key[0] == 'r' ? PTLRPC_NRS_QUEUE_REG :
+					PTLRPC_NRS_QUEUE_HP;
+		if (buf == NULL)
+			return -EINVAL;
+		buf = skip_spaces(buf);
+		key = strsep(&buf, " ");
+	}
+
+	if (buf == NULL || *key == '\0' || strlen(key) >= NRS_WFQ_KEY_LEN)
+		return -EINVAL;
+
+	rc = kstrtoul(skip_spaces(buf), 10, &weight);
+	if (rc)
+		return rc;
+
+	if (weight > LPROCFS_NRS_QUANTUM_MAX)
+		return -EINVAL;
+
+	strlcpy(cmd.wwc_key, key, sizeof(cmd.wwc_key));
+	cmd.wwc_weight = weight;
+
+	if (!nrs_svc_has_hp(svc)) {
+		if (queue == PTLRPC_NRS_QUEUE_HP)
+			return -ENODEV;
+		queue = PTLRPC_NRS_QUEUE_REG;
+	}
+
+	/**
+	 * Set the weight on the regular and HP NRS heads separately, ignoring
+	 * -ENODEV from the head where the policy is not started, as long as
+	 * it is started on one of them.
+	 */
+	if ((queue & PTLRPC_NRS_QUEUE_REG) != 0) {
+		rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+					       NRS_POL_NAME_WFQ,
+					       NRS_CTL_WFQ_WR_WEIGHT, false,
+					       &cmd);
+		if ((rc < 0 && rc != -ENODEV) ||
+		    (rc == -ENODEV && queue == PTLRPC_NRS_QUEUE_REG))
+			return rc;
+	}
+
+	if ((queue & PTLRPC_NRS_QUEUE_HP) != 0) {
+		rc2 = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+						NRS_POL_NAME_WFQ,
+						NRS_CTL_WFQ_WR_WEIGHT, false,
+						&cmd);
+		if ((rc2 < 0 && rc2 != -ENODEV) ||
+		    (rc2 == -ENODEV && queue == PTLRPC_NRS_QUEUE_HP))
+			return rc2;
+	}
+
+	return rc == -ENODEV && rc2 == -ENODEV ? -ENODEV : count;
+}
+
+LDEBUGFS_SEQ_FOPS(ptlrpc_lprocfs_nrs_wfq_weight);
+
+/**
+ * Initializes a WFQ policy's lprocfs interface for service \a svc
+ *
+ * \param[in] svc the service
+ *
+ * \retval 0	success
+ * \retval != 0	error
+ */
+static int nrs_wfq_lprocfs_init(struct ptlrpc_service *svc)
+{
+	struct ldebugfs_vars nrs_wfq_lprocfs_vars[] = {
+		{ .name		= "nrs_wfq_weight",
+		  .fops		= &ptlrpc_lprocfs_nrs_wfq_weight_fops,
+		  .data		= svc },
+		{ NULL }
+	};
+
+	if (!svc->srv_debugfs_entry)
+		return 0;
+
+	ldebugfs_add_vars(svc->srv_debugfs_entry, nrs_wfq_lprocfs_vars, NULL);
+
+	return 0;
+}
+
+/**
+ * WFQ policy operations
+ */
+static const struct ptlrpc_nrs_pol_ops nrs_wfq_ops = {
+	.op_policy_start	= nrs_wfq_start,
+	.op_policy_stop		= nrs_wfq_stop,
+	.op_policy_ctl		= nrs_wfq_ctl,
+	.op_res_get		= nrs_wfq_res_get,
+	.op_res_put		= nrs_wfq_res_put,
+	.op_req_get		= nrs_wfq_req_get,
+	.op_req_enqueue		= nrs_wfq_req_add,
+	.op_req_dequeue		= nrs_wfq_req_del,
+	.op_req_stop		= nrs_wfq_req_stop,
+	.op_lprocfs_init	= nrs_wfq_lprocfs_init,
+};
+
+/**
+ * WFQ policy configuration
+ */
+struct ptlrpc_nrs_pol_conf nrs_conf_wfq = {
+	.nc_name		= NRS_POL_NAME_WFQ,
+	.nc_ops			= &nrs_wfq_ops,
+	.nc_compat		= nrs_policy_compat_all,
+};
+
+/** @} WFQ policy */
+
+/** @} nrs */
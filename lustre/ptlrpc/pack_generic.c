@@ -551,6 +551,15 @@ void lustre_free_reply_state(struct ptlrpc_reply_state *rs)
 	LASSERT(list_empty(&rs->rs_exp_list));
 	LASSERT(list_empty(&rs->rs_obd_list));
 
+	if (rs->rs_kiov) {
+		int i;
+
+		for (i = 0; i < rs->rs_kiov_count; i++)
+			put_page(rs->rs_kiov[i].bv_page);
+		OBD_FREE_PTR_ARRAY_LARGE(rs->rs_kiov, rs->rs_kiov_count);
+		rs->rs_kiov = NULL;
+	}
+
 	sptlrpc_svc_free_rs(rs);
 }
 
@@ -1899,7 +1908,7 @@ void lustre_swab_obdo(struct obdo *o)
 	__swab32s(&o->o_gid_h);
 	__swab64s(&o->o_data_version);
 	__swab32s(&o->o_projid);
-	BUILD_BUG_ON(offsetof(typeof(*o), o_padding_4) == 0);
+	__swab32s(&o->o_compr_nob);
 	BUILD_BUG_ON(offsetof(typeof(*o), o_padding_5) == 0);
 	BUILD_BUG_ON(offsetof(typeof(*o), o_padding_6) == 0);
 
@@ -1999,7 +2008,7 @@ void lustre_swab_ost_lvb(struct ost_lvb *lvb)
 	__swab32s(&lvb->lvb_mtime_ns);
 	__swab32s(&lvb->lvb_atime_ns);
 	__swab32s(&lvb->lvb_ctime_ns);
-	__swab32s(&lvb->lvb_padding);
+	__swab32s(&lvb->lvb_data_version);
 }
 EXPORT_SYMBOL(lustre_swab_ost_lvb);
 
@@ -2055,8 +2064,8 @@ void lustre_swab_mdt_body(struct mdt_body *b)
 	__swab64s(&b->mbo_dom_size);
 	__swab64s(&b->mbo_dom_blocks);
 	__swab64s(&b->mbo_btime);
-	BUILD_BUG_ON(offsetof(typeof(*b), mbo_padding_9) == 0);
-	BUILD_BUG_ON(offsetof(typeof(*b), mbo_padding_10) == 0);
+	__swab64s(&b->mbo_pre_versions[0]);
+	__swab64s(&b->mbo_pre_versions[1]);
 }
 
 void lustre_swab_mdt_ioepoch(struct mdt_ioepoch *b)
@@ -52,6 +52,11 @@ extern struct ptlrpc_nrs_pol_conf nrs_conf_crrn;
 extern struct ptlrpc_nrs_pol_conf nrs_conf_orr;
 extern struct ptlrpc_nrs_pol_conf nrs_conf_trr;
 extern struct ptlrpc_nrs_pol_conf nrs_conf_tbf;
+extern struct ptlrpc_nrs_pol_conf nrs_conf_wfq;
+
+/* nrs_tbf.c */
+int nrs_tbf_id_cli_set(struct ptlrpc_request *req, struct tbf_id *id,
+		       enum nrs_tbf_flag ti_type);
 #endif /* HAVE_SERVER_SUPPORT */
 
 /**
@@ -84,6 +89,7 @@ void ptlrpc_request_cache_free(struct ptlrpc_request *req);
 void ptlrpc_init_xid(void);
 void ptlrpc_set_add_new_req(struct ptlrpcd_ctl *pc,
 			    struct ptlrpc_request *req);
+int ptlrpcd_check_work(struct ptlrpc_request *req);
 void ptlrpc_expired_set(struct ptlrpc_request_set *set);
 time64_t ptlrpc_set_next_timeout(struct ptlrpc_request_set *);
 void ptlrpc_resend_req(struct ptlrpc_request *request);
@@ -95,6 +101,8 @@ void ptlrpc_add_unreplied(struct ptlrpc_request *req);
 /* events.c */
 int ptlrpc_init_portals(void);
 void ptlrpc_exit_portals(void);
+void ptlrpc_req_add_history(struct ptlrpc_service_part *svcpt,
+			    struct ptlrpc_request *req);
 
 void ptlrpc_request_handle_notconn(struct ptlrpc_request *);
 void lustre_assert_wire_constants(void);
@@ -154,6 +162,8 @@ void ptlrpc_nrs_req_finalize(struct ptlrpc_request *req);
 void ptlrpc_nrs_req_stop_nolock(struct ptlrpc_request *req);
 void ptlrpc_nrs_req_add(struct ptlrpc_service_part *svcpt,
 			struct ptlrpc_request *req, bool hp);
+void ptlrpc_nrs_req_add_list(struct ptlrpc_service_part *svcpt,
+			     struct list_head *reqs, bool hp);
 
 struct ptlrpc_request *
 ptlrpc_nrs_req_get_nolock0(struct ptlrpc_service_part *svcpt, bool hp,
@@ -263,6 +273,10 @@ struct ptlrpc_nrs_policy *nrs_request_policy(struct ptlrpc_nrs_request *nrq)
 
 int ptlrpc_expire_one_request(struct ptlrpc_request *req, int async_unlink);
 
+/* niobuf.c */
+int ptlrpc_rs_kiov_set(struct ptlrpc_reply_state *rs, int headlen,
+		       struct bio_vec *kiov, int count, int len);
+
 /* pers.c */
 void ptlrpc_fill_bulk_md(struct lnet_md *md, struct ptlrpc_bulk_desc *desc,
 			 int mdcnt);
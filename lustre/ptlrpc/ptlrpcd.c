@@ -137,6 +137,17 @@ module_param(ptlrpcd_cpts, charp, 0644);
 MODULE_PARM_DESC(ptlrpcd_cpts,
 		 "CPU partitions ptlrpcd threads should run in");
 
+/*
+ * ptlrpcd_dev_cpt: Send bulk RPCs and run the I/O work of an import, such
+ * as building BRW RPCs, on the ptlrpcd threads of the CPT of the network
+ * device used to reach the target, rather than on the CPT of the caller,
+ * so that bulk buffers and the device are on the same NUMA node.
+ */
+static int ptlrpcd_dev_cpt = 1;
+module_param(ptlrpcd_dev_cpt, int, 0644);
+MODULE_PARM_DESC(ptlrpcd_dev_cpt,
+		 "Run bulk RPCs on the CPT of the network device");
+
 /* ptlrpcds_cpt_idx maps cpt numbers to an index in the ptlrpcds array. */
 static int		*ptlrpcds_cpt_idx;
 
@@ -175,7 +186,12 @@ ptlrpcd_select_pc(struct ptlrpc_request *req)
 	if (req != NULL && req->rq_send_state != LUSTRE_IMP_FULL)
 		return &ptlrpcd_rcv;
 
-	cpt = cfs_cpt_current(cfs_cpt_tab, 1);
+	if (req != NULL && ptlrpcd_dev_cpt && req->rq_import != NULL &&
+	    req->rq_import->imp_dev_cpt != CFS_CPT_ANY &&
+	    (req->rq_bulk != NULL || ptlrpcd_check_work(req)))
+		cpt = req->rq_import->imp_dev_cpt;
+	else
+		cpt = cfs_cpt_current(cfs_cpt_tab, 1);
 	if (ptlrpcds_cpt_idx == NULL)
 		idx = cpt;
 	else
@@ -82,7 +82,7 @@ ptlrpc_alloc_rqbd(struct ptlrpc_service_part *svcpt)
 		return NULL;
 
 	rqbd->rqbd_svcpt = svcpt;
-	rqbd->rqbd_refcount = 0;
+	atomic_set(&rqbd->rqbd_refcount, 0);
 	rqbd->rqbd_cbid.cbid_fn = request_in_callback;
 	rqbd->rqbd_cbid.cbid_arg = rqbd;
 	INIT_LIST_HEAD(&rqbd->rqbd_reqs);
@@ -105,7 +105,7 @@ static void ptlrpc_free_rqbd(struct ptlrpc_request_buffer_desc *rqbd)
 {
 	struct ptlrpc_service_part *svcpt = rqbd->rqbd_svcpt;
 
-	LASSERT(rqbd->rqbd_refcount == 0);
+	LASSERT(atomic_read(&rqbd->rqbd_refcount) == 0);
 	LASSERT(list_empty(&rqbd->rqbd_reqs));
 
 	spin_lock(&svcpt->scp_lock);
@@ -622,7 +622,6 @@ static int ptlrpc_service_part_init(struct ptlrpc_service *svc,
 	mutex_init(&svcpt->scp_mutex);
 	INIT_LIST_HEAD(&svcpt->scp_rqbd_idle);
 	INIT_LIST_HEAD(&svcpt->scp_rqbd_posted);
-	INIT_LIST_HEAD(&svcpt->scp_req_incoming);
 	init_waitqueue_head(&svcpt->scp_waitq);
 	/* history request & rqbd list */
 	INIT_LIST_HEAD(&svcpt->scp_hist_reqs);
@@ -661,6 +660,9 @@ static int ptlrpc_service_part_init(struct ptlrpc_service *svc,
 	if (array->paa_reqs_count == NULL)
 		goto failed;
 
+	if (ptlrpc_intake_init(&svcpt->scp_intake, svc->srv_cptable, cpt))
+		goto failed;
+
 	cfs_timer_setup(&svcpt->scp_at_timer, ptlrpc_at_timer,
 			(unsigned long)svcpt, 0);
 
@@ -684,6 +686,8 @@ static int ptlrpc_service_part_init(struct ptlrpc_service *svc,
 	return 0;
 
  failed:
+	ptlrpc_intake_fini(&svcpt->scp_intake);
+
 	if (array->paa_reqs_count != NULL) {
 		OBD_FREE_PTR_ARRAY(array->paa_reqs_count, size);
 		array->paa_reqs_count = NULL;
@@ -938,7 +942,7 @@ void ptlrpc_server_drop_request(struct ptlrpc_request *req)
 
 	list_add(&req->rq_list, &rqbd->rqbd_reqs);
 
-	refcount = --(rqbd->rqbd_refcount);
+	refcount = atomic_dec_return(&rqbd->rqbd_refcount);
 	if (refcount == 0) {
 		/* request buffer is now idle: add to history */
 		list_move_tail(&rqbd->rqbd_list, &svcpt->scp_hist_rqbds);
@@ -1633,7 +1637,7 @@ static int ptlrpc_at_check_timed(struct ptlrpc_service_part *svcpt)
 					   &svcpt->scp_at_estimate);
 		LCONSOLE_WARN("'%s' is processing requests too slowly, client may timeout. Late by %ds, missed %d early replies (reqs waiting=%d active=%d, at_estimate=%d, delay=%lldms)\n",
 			      svcpt->scp_service->srv_name, -first, counter,
-			      svcpt->scp_nreqs_incoming,
+			      ptlrpc_intake_count(&svcpt->scp_intake),
 			      svcpt->scp_nreqs_active,
 			      atg,
 			      delay_ms);
@@ -1826,6 +1830,14 @@ int ptlrpc_hpreq_handler(struct ptlrpc_request *req)
 }
 EXPORT_SYMBOL(ptlrpc_hpreq_handler);
 
+/**
+ * Prepare \a req to be enqueued to NRS, which is left to the caller so that
+ * it can enqueue several requests at once.
+ *
+ * \retval	0 for a normal request
+ * \retval	1 for a high priority request
+ * \retval	negative errno if the request should be dropped
+ */
 static int ptlrpc_server_request_add(struct ptlrpc_service_part *svcpt,
 				     struct ptlrpc_request *req)
 {
@@ -1909,9 +1921,7 @@ static int ptlrpc_server_request_add(struct ptlrpc_service_part *svcpt,
 	req->rq_svc_thread = NULL;
 	req->rq_session.lc_thread = NULL;
 
-	ptlrpc_nrs_req_add(svcpt, req, hp);
-
-	RETURN(0);
+	RETURN(hp);
 }
 
 /**
@@ -2065,38 +2075,24 @@ got_request:
 }
 
 /**
- * Handle freshly incoming reqs, add to timed early reply list,
- * pass on to regular request queue.
- * All incoming requests pass through here before getting into
- * ptlrpc_server_handle_req later on.
+ * Preprocess a freshly incoming request, add it to timed early reply list
+ * and prepare it for the regular request queue.
+ *
+ * \retval	0 for a normal request to enqueue
+ * \retval	1 for a high priority request to enqueue
+ * \retval	negative errno if the request was finished
  */
-static int ptlrpc_server_handle_req_in(struct ptlrpc_service_part *svcpt,
-				       struct ptlrpc_thread *thread)
+static int ptlrpc_server_req_in_prep(struct ptlrpc_service_part *svcpt,
+				     struct ptlrpc_thread *thread,
+				     struct ptlrpc_request *req)
 {
 	struct ptlrpc_service *svc = svcpt->scp_service;
-	struct ptlrpc_request *req;
 	__u32 deadline;
 	__u32 opc;
 	int rc;
 
 	ENTRY;
 
-	spin_lock(&svcpt->scp_lock);
-	if (list_empty(&svcpt->scp_req_incoming)) {
-		spin_unlock(&svcpt->scp_lock);
-		RETURN(0);
-	}
-
-	req = list_first_entry(&svcpt->scp_req_incoming,
-			       struct ptlrpc_request, rq_list);
-	list_del_init(&req->rq_list);
-	svcpt->scp_nreqs_incoming--;
-	/*
-	 * Consider this still a "queued" request as far as stats are
-	 * concerned
-	 */
-	spin_unlock(&svcpt->scp_lock);
-
 	/* go through security check/transform */
 	rc = sptlrpc_svc_unwrap_request(req);
 	switch (rc) {
@@ -2234,18 +2230,91 @@ static int ptlrpc_server_handle_req_in(struct ptlrpc_service_part *svcpt,
 			req->rq_rep_mbits = lustre_msg_get_mbits(req->rq_reqmsg);
 	}
 
-	/* Move it over to the request processing queue */
 	rc = ptlrpc_server_request_add(svcpt, req);
-	if (rc)
+	if (rc < 0)
 		GOTO(err_req, rc);
 
-	wake_up(&svcpt->scp_waitq);
-	RETURN(1);
+	RETURN(rc);
 
 err_req:
 	ptlrpc_server_finish_request(svcpt, req);
 
-	RETURN(1);
+	RETURN(rc < 0 ? rc : -EPROTO);
+}
+
+/**
+ * Handle freshly incoming reqs, add to timed early reply list,
+ * pass on to regular request queue.
+ * All incoming requests pass through here before getting into
+ * ptlrpc_server_handle_req later on.
+ *
+ * Up to PTLRPC_REQ_IN_BATCH requests of the intake queues are taken at once
+ * and added to the request history under a single scp_lock hold. They are
+ * then moved over to the request processing queue under a single
+ * scp_req_lock hold. The requests left are preprocessed by other threads.
+ *
+ * \retval	number of requests handled
+ */
+static int ptlrpc_server_handle_req_in(struct ptlrpc_service_part *svcpt,
+				       struct ptlrpc_thread *thread)
+{
+	struct ptlrpc_request *req, *next;
+	struct llist_node *first;
+	LIST_HEAD(hpreqs);
+	LIST_HEAD(reqs);
+	int batch = 0;
+	int count = 0;
+	int rc;
+
+	ENTRY;
+
+	first = ptlrpc_intake_take(&svcpt->scp_intake, PTLRPC_REQ_IN_BATCH);
+	if (first == NULL)
+		RETURN(0);
+
+	/* have another thread preprocess the next batch meanwhile */
+	if (ptlrpc_intake_count(&svcpt->scp_intake) > 0)
+		wake_up(&svcpt->scp_waitq);
+
+	spin_lock(&svcpt->scp_lock);
+	llist_for_each_entry(req, first, rq_srv.sr_intake)
+		ptlrpc_req_add_history(svcpt, req);
+	spin_unlock(&svcpt->scp_lock);
+
+	llist_for_each_entry_safe(req, next, first, rq_srv.sr_intake) {
+		count++;
+
+		rc = ptlrpc_server_req_in_prep(svcpt, thread, req);
+		if (rc >= 0) {
+			list_add_tail(&req->rq_list, rc > 0 ? &hpreqs : &reqs);
+			batch++;
+		}
+	}
+
+	if (batch > 0) {
+		/* Move them over to the request processing queue */
+		ptlrpc_nrs_req_add_list(svcpt, &hpreqs, true);
+		ptlrpc_nrs_req_add_list(svcpt, &reqs, false);
+		wake_up_nr(&svcpt->scp_waitq, batch);
+	}
+
+	RETURN(count);
+}
+
+/* finish the requests never preprocessed, the service threads are gone */
+static void ptlrpc_server_purge_incoming(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_request *req, *next;
+	struct llist_node *first;
+
+	first = ptlrpc_intake_take(&svcpt->scp_intake, INT_MAX);
+	llist_for_each_entry_safe(req, next, first, rq_srv.sr_intake) {
+		spin_lock(&svcpt->scp_lock);
+		ptlrpc_req_add_history(svcpt, req);
+		spin_unlock(&svcpt->scp_lock);
+
+		ptlrpc_server_finish_request(svcpt, req);
+	}
 }
 
 /**
@@ -2296,7 +2365,7 @@ static int ptlrpc_server_handle_request(struct ptlrpc_service_part *svcpt,
 		lprocfs_counter_add(svc->srv_stats, PTLRPC_REQWAIT_CNTR,
 				    timediff_usecs);
 		lprocfs_counter_add(svc->srv_stats, PTLRPC_REQQDEPTH_CNTR,
-				    svcpt->scp_nreqs_incoming);
+				    ptlrpc_intake_count(&svcpt->scp_intake));
 		lprocfs_counter_add(svc->srv_stats, PTLRPC_REQACTIVE_CNTR,
 				    svcpt->scp_nreqs_active);
 		lprocfs_counter_add(svc->srv_stats, PTLRPC_TIMEOUT,
@@ -2674,13 +2743,11 @@ void ptlrpc_watchdog_touch(struct delayed_work *work, timeout_t timeout)
 
 /**
  * requests wait on preprocessing
- * user can call it w/o any lock but need to hold
- * ptlrpc_service_part::scp_lock to get reliable result
  */
 static inline int
 ptlrpc_server_request_incoming(struct ptlrpc_service_part *svcpt)
 {
-	return !list_empty(&svcpt->scp_req_incoming);
+	return ptlrpc_intake_count(&svcpt->scp_intake) > 0;
 }
 
 static __attribute__((__noinline__)) int
@@ -2865,11 +2932,16 @@ static int ptlrpc_main(void *arg)
 		/* Process all incoming reqs before handling any */
 		if (ptlrpc_server_request_incoming(svcpt)) {
 			lu_context_enter(&env->le_ctx);
-			ptlrpc_server_handle_req_in(svcpt, thread);
+			counter += max(ptlrpc_server_handle_req_in(svcpt,
+								   thread), 1);
 			lu_context_exit(&env->le_ctx);
 
-			/* but limit ourselves in case of flood */
-			if (counter++ < 100)
+			/*
+			 * but limit ourselves in case of flood, to about 100
+			 * requests however many each call preprocessed, and
+			 * count a call that found none as one
+			 */
+			if (counter < 100)
 				continue;
 			counter = 0;
 			idle = false;
@@ -3501,13 +3573,7 @@ ptlrpc_service_purge_all(struct ptlrpc_service *svc)
 		 * all unlinked) and no service threads, so I'm the only
 		 * thread noodling the request queue now
 		 */
-		while ((req = list_first_entry_or_null(&svcpt->scp_req_incoming,
-						       struct ptlrpc_request,
-						       rq_list)) != NULL) {
-			list_del(&req->rq_list);
-			svcpt->scp_nreqs_incoming--;
-			ptlrpc_server_finish_request(svcpt, req);
-		}
+		ptlrpc_server_purge_incoming(svcpt);
 
 		while (ptlrpc_server_request_pending(svcpt, true)) {
 			req = ptlrpc_server_request_get(svcpt, true);
@@ -3532,7 +3598,7 @@ ptlrpc_service_purge_all(struct ptlrpc_service *svc)
 		}
 		spin_unlock(&svcpt->scp_lock);
 
-		LASSERT(svcpt->scp_nreqs_incoming == 0);
+		LASSERT(!ptlrpc_server_request_incoming(svcpt));
 		LASSERT(svcpt->scp_nreqs_active == 0);
 		/*
 		 * history should have been culled by
@@ -3586,6 +3652,8 @@ ptlrpc_service_free(struct ptlrpc_service *svc)
 					   array->paa_size);
 			array->paa_reqs_count = NULL;
 		}
+
+		ptlrpc_intake_fini(&svcpt->scp_intake);
 	}
 
 	ptlrpc_service_for_each_part(svcpt, i, svc)
@@ -1459,6 +1459,10 @@ void lustre_assert_wire_constants(void)
 		 OBD_CONNECT2_COMPRESS);
 	LASSERTF(OBD_CONNECT2_UNALIGNED_DIO == 0x400000000ULL, "found 0x%.16llxULL\n",
 		 OBD_CONNECT2_UNALIGNED_DIO);
+	LASSERTF(OBD_CONNECT2_BATCH_REINT == 0x800000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_BATCH_REINT);
+	LASSERTF(OBD_CONNECT2_XATTR_PREFETCH == 0x1000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_XATTR_PREFETCH);
 
 	LASSERTF(OBD_CKSUM_CRC32 == 0x00000001UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_CRC32);
@@ -1590,10 +1594,10 @@ void lustre_assert_wire_constants(void)
 		 (long long)(int)offsetof(struct obdo, o_projid));
 	LASSERTF((int)sizeof(((struct obdo *)0)->o_projid) == 4, "found %lld\n",
 		 (long long)(int)sizeof(((struct obdo *)0)->o_projid));
-	LASSERTF((int)offsetof(struct obdo, o_padding_4) == 188, "found %lld\n",
-		 (long long)(int)offsetof(struct obdo, o_padding_4));
-	LASSERTF((int)sizeof(((struct obdo *)0)->o_padding_4) == 4, "found %lld\n",
-		 (long long)(int)sizeof(((struct obdo *)0)->o_padding_4));
+	LASSERTF((int)offsetof(struct obdo, o_compr_nob) == 188, "found %lld\n",
+		 (long long)(int)offsetof(struct obdo, o_compr_nob));
+	LASSERTF((int)sizeof(((struct obdo *)0)->o_compr_nob) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct obdo *)0)->o_compr_nob));
 	LASSERTF((int)offsetof(struct obdo, o_padding_5) == 192, "found %lld\n",
 		 (long long)(int)offsetof(struct obdo, o_padding_5));
 	LASSERTF((int)sizeof(((struct obdo *)0)->o_padding_5) == 8, "found %lld\n",
@@ -2411,6 +2415,46 @@ void lustre_assert_wire_constants(void)
 	LASSERTF(OBD_BRW_COMPRESSED == 0x80000, "found 0x%.8x\n",
 		OBD_BRW_COMPRESSED);
 
+	/* Checks for struct ll_compr_hdr */
+	LASSERTF((int)sizeof(struct ll_compr_hdr) == 16, "found %lld\n",
+		 (long long)(int)sizeof(struct ll_compr_hdr));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_magic) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_magic));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_magic) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_magic));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_compr_type) == 4, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_compr_type));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_compr_type) == 1, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_compr_type));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_compr_lvl) == 5, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_compr_lvl));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_compr_lvl) == 1, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_compr_lvl));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_chunk_bits) == 6, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_chunk_bits));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_chunk_bits) == 1, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_chunk_bits));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_hdr_size) == 7, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_hdr_size));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_hdr_size) == 1, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_hdr_size));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_compr_size) == 8, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_compr_size));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_compr_size) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_compr_size));
+	LASSERTF((int)offsetof(struct ll_compr_hdr, llch_bulk_size) == 12, "found %lld\n",
+		 (long long)(int)offsetof(struct ll_compr_hdr, llch_bulk_size));
+	LASSERTF((int)sizeof(((struct ll_compr_hdr *)0)->llch_bulk_size) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct ll_compr_hdr *)0)->llch_bulk_size));
+	LASSERTF(LLCH_MAGIC == 0x4c4c4348UL, "found 0x%.8xUL\n",
+		(unsigned)LLCH_MAGIC);
+	LASSERTF(LL_COMPR_TYPE_NONE == 0, "found %lld\n",
+		 (long long)LL_COMPR_TYPE_NONE);
+	LASSERTF(LL_COMPR_TYPE_LZ4 == 1, "found %lld\n",
+		 (long long)LL_COMPR_TYPE_LZ4);
+	LASSERTF(LL_COMPR_TYPE_ZSTD == 2, "found %lld\n",
+		 (long long)LL_COMPR_TYPE_ZSTD);
+
 	/* Checks for struct ost_body */
 	LASSERTF((int)sizeof(struct ost_body) == 208, "found %lld\n",
 		 (long long)(int)sizeof(struct ost_body));
@@ -2609,14 +2653,10 @@ void lustre_assert_wire_constants(void)
 		 (long long)(int)offsetof(struct mdt_body, mbo_btime));
 	LASSERTF((int)sizeof(((struct mdt_body *)0)->mbo_btime) == 8, "found %lld\n",
 		 (long long)(int)sizeof(((struct mdt_body *)0)->mbo_btime));
-	LASSERTF((int)offsetof(struct mdt_body, mbo_padding_9) == 200, "found %lld\n",
-		 (long long)(int)offsetof(struct mdt_body, mbo_padding_9));
-	LASSERTF((int)sizeof(((struct mdt_body *)0)->mbo_padding_9) == 8, "found %lld\n",
-		 (long long)(int)sizeof(((struct mdt_body *)0)->mbo_padding_9));
-	LASSERTF((int)offsetof(struct mdt_body, mbo_padding_10) == 208, "found %lld\n",
-		 (long long)(int)offsetof(struct mdt_body, mbo_padding_10));
-	LASSERTF((int)sizeof(((struct mdt_body *)0)->mbo_padding_10) == 8, "found %lld\n",
-		 (long long)(int)sizeof(((struct mdt_body *)0)->mbo_padding_10));
+	LASSERTF((int)offsetof(struct mdt_body, mbo_pre_versions) == 200, "found %lld\n",
+		 (long long)(int)offsetof(struct mdt_body, mbo_pre_versions));
+	LASSERTF((int)sizeof(((struct mdt_body *)0)->mbo_pre_versions) == 16, "found %lld\n",
+		 (long long)(int)sizeof(((struct mdt_body *)0)->mbo_pre_versions));
 	LASSERTF(MDS_FMODE_CLOSED == 000000000000UL, "found 0%.11oUL\n",
 		MDS_FMODE_CLOSED);
 	LASSERTF(MDS_FMODE_EXEC == 000000000004UL, "found 0%.11oUL\n",
@@ -2663,6 +2703,8 @@ void lustre_assert_wire_constants(void)
 			(long long)MDS_OPEN_PCC);
 	LASSERTF(MDS_OPEN_DEFAULT_LMV == 00000000040000000000000ULL, "found 0%.22lloULL\n",
 			(long long)MDS_OPEN_DEFAULT_LMV);
+	LASSERTF(MDS_OPEN_XATTRS == 00000000100000000000000ULL, "found 0%.22lloULL\n",
+			(long long)MDS_OPEN_XATTRS);
 	LASSERTF(LUSTRE_SYNC_FL == 0x00000008UL, "found 0x%.8xUL\n",
 		(unsigned)LUSTRE_SYNC_FL);
 	LASSERTF(LUSTRE_IMMUTABLE_FL == 0x00000010UL, "found 0x%.8xUL\n",
@@ -3077,14 +3119,10 @@ void lustre_assert_wire_constants(void)
 		 (long long)(int)offsetof(struct mdt_rec_unlink, ul_time));
 	LASSERTF((int)sizeof(((struct mdt_rec_unlink *)0)->ul_time) == 8, "found %lld\n",
 		 (long long)(int)sizeof(((struct mdt_rec_unlink *)0)->ul_time));
-	LASSERTF((int)offsetof(struct mdt_rec_unlink, ul_padding_2) == 80, "found %lld\n",
-		 (long long)(int)offsetof(struct mdt_rec_unlink, ul_padding_2));
-	LASSERTF((int)sizeof(((struct mdt_rec_unlink *)0)->ul_padding_2) == 8, "found %lld\n",
-		 (long long)(int)sizeof(((struct mdt_rec_unlink *)0)->ul_padding_2));
-	LASSERTF((int)offsetof(struct mdt_rec_unlink, ul_padding_3) == 88, "found %lld\n",
-		 (long long)(int)offsetof(struct mdt_rec_unlink, ul_padding_3));
-	LASSERTF((int)sizeof(((struct mdt_rec_unlink *)0)->ul_padding_3) == 8, "found %lld\n",
-		 (long long)(int)sizeof(((struct mdt_rec_unlink *)0)->ul_padding_3));
+	LASSERTF((int)offsetof(struct mdt_rec_unlink, ul_pre_versions) == 80, "found %lld\n",
+		 (long long)(int)offsetof(struct mdt_rec_unlink, ul_pre_versions));
+	LASSERTF((int)sizeof(((struct mdt_rec_unlink *)0)->ul_pre_versions) == 16, "found %lld\n",
+		 (long long)(int)sizeof(((struct mdt_rec_unlink *)0)->ul_pre_versions));
 	LASSERTF((int)offsetof(struct mdt_rec_unlink, ul_padding_4) == 96, "found %lld\n",
 		 (long long)(int)offsetof(struct mdt_rec_unlink, ul_padding_4));
 	LASSERTF((int)sizeof(((struct mdt_rec_unlink *)0)->ul_padding_4) == 8, "found %lld\n",
@@ -3857,10 +3895,10 @@ void lustre_assert_wire_constants(void)
 		 (long long)(int)offsetof(struct ost_lvb, lvb_ctime_ns));
 	LASSERTF((int)sizeof(((struct ost_lvb *)0)->lvb_ctime_ns) == 4, "found %lld\n",
 		 (long long)(int)sizeof(((struct ost_lvb *)0)->lvb_ctime_ns));
-	LASSERTF((int)offsetof(struct ost_lvb, lvb_padding) == 52, "found %lld\n",
-		 (long long)(int)offsetof(struct ost_lvb, lvb_padding));
-	LASSERTF((int)sizeof(((struct ost_lvb *)0)->lvb_padding) == 4, "found %lld\n",
-		 (long long)(int)sizeof(((struct ost_lvb *)0)->lvb_padding));
+	LASSERTF((int)offsetof(struct ost_lvb, lvb_data_version) == 52, "found %lld\n",
+		 (long long)(int)offsetof(struct ost_lvb, lvb_data_version));
+	LASSERTF((int)sizeof(((struct ost_lvb *)0)->lvb_data_version) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct ost_lvb *)0)->lvb_data_version));
 
 	/* Checks for struct lquota_lvb */
 	LASSERTF((int)sizeof(struct lquota_lvb) == 40, "found %lld\n",
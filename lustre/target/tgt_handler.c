@@ -37,11 +37,13 @@
 #include <linux/user_namespace.h>
 #include <linux/delay.h>
 #include <linux/uidgid.h>
+#include <linux/vmalloc.h>
 
 #include <libcfs/linux/linux-mem.h>
 #include <obd.h>
 #include <obd_class.h>
 #include <obd_cksum.h>
+#include <lustre_compr.h>
 #include <lustre_lfsck.h>
 #include <lustre_nodemap.h>
 #include <lustre_acl.h>
@@ -2640,6 +2642,168 @@ static void tgt_warn_on_cksum(struct ptlrpc_request *req,
 			   client_cksum, server_cksum);
 }
 
+/**
+ * Prepare pages to receive the bulk of a write with OBD_BRW_COMPRESSED
+ * niobufs, i.e. the \a nob bytes of the raw and compressed data, which are
+ * later given to tgt_brw_decompress(). The pages are laid out as on the
+ * client, so the checksum of the bulk can be verified on \a lnbp.
+ */
+static int tgt_brw_compr_prep(struct niobuf_remote *rnb, unsigned int nob,
+			      struct page ***pap, struct niobuf_local **lnbp,
+			      int *npagesp)
+{
+	struct niobuf_local *lnb = NULL;
+	struct page **pa = NULL;
+	unsigned int off = 0;
+	int npages;
+	int i, rc;
+
+	/* the bulk starts like the first niobuf if it is not compressed */
+	if (!(rnb[0].rnb_flags & OBD_BRW_COMPRESSED))
+		off = rnb[0].rnb_offset & ~PAGE_MASK;
+	npages = DIV_ROUND_UP(off + nob, PAGE_SIZE);
+	if (nob == 0 || npages > PTLRPC_MAX_BRW_PAGES)
+		return -EPROTO;
+
+	OBD_ALLOC_PTR_ARRAY_LARGE(pa, npages);
+	OBD_ALLOC_PTR_ARRAY_LARGE(lnb, npages);
+	if (!pa || !lnb)
+		GOTO(out, rc = -ENOMEM);
+
+	rc = sptlrpc_enc_pool_get_pages_array(pa, npages);
+	if (rc)
+		GOTO(out, rc);
+
+	for (i = 0; i < npages; i++) {
+		lnb[i].lnb_page = pa[i];
+		lnb[i].lnb_page_offset = i == 0 ? off : 0;
+		lnb[i].lnb_len = min_t(unsigned int, nob,
+				       PAGE_SIZE - lnb[i].lnb_page_offset);
+		nob -= lnb[i].lnb_len;
+	}
+	*pap = pa;
+	*lnbp = lnb;
+	*npagesp = npages;
+out:
+	if (rc) {
+		if (pa)
+			OBD_FREE_PTR_ARRAY_LARGE(pa, npages);
+		if (lnb)
+			OBD_FREE_PTR_ARRAY_LARGE(lnb, npages);
+	}
+
+	return rc;
+}
+
+static void tgt_brw_compr_fini(struct page **pa, struct niobuf_local *lnb,
+			       int npages)
+{
+	sptlrpc_enc_pool_put_pages_array(pa, npages);
+	OBD_FREE_PTR_ARRAY_LARGE(pa, npages);
+	OBD_FREE_PTR_ARRAY_LARGE(lnb, npages);
+}
+
+/**
+ * Copy the bulk received in the \a npages pages of \a lnb to the pages of
+ * \a local_nb prepared for \a rnb by obd_preprw(). The data of niobufs
+ * without OBD_BRW_COMPRESSED is copied as is, the chunks of the others are
+ * decompressed, see struct ll_compr_hdr. The data is written uncompressed,
+ * so reads need no decompression and tgt_brw_read() sends it as it is.
+ */
+static int tgt_brw_decompress(struct lu_target *tgt, struct niobuf_remote *rnb,
+			      int niocount, struct niobuf_local *local_nb,
+			      int local_npages, struct page **pa,
+			      struct niobuf_local *lnb, int npages)
+{
+	struct page **dst = NULL;
+	unsigned int nob = 0;
+	unsigned int pos;
+	void *stream;
+	int i, j, k;
+	int rc = 0;
+
+	ENTRY;
+	for (i = 0; i < npages; i++)
+		nob += lnb[i].lnb_len;
+
+	stream = vmap(pa, npages, VM_MAP, PAGE_KERNEL);
+	if (!stream)
+		RETURN(-ENOMEM);
+	stream += lnb[0].lnb_page_offset;
+
+	OBD_ALLOC_PTR_ARRAY_LARGE(dst, 1U << (COMPR_CHUNK_MAX_BITS - PAGE_SHIFT));
+	if (!dst)
+		GOTO(out, rc = -ENOMEM);
+
+	for (i = j = 0, pos = 0; i < niocount; i++) {
+		unsigned int len = rnb[i].rnb_len;
+
+		if (!(rnb[i].rnb_flags & OBD_BRW_COMPRESSED)) {
+			while (len > 0) {
+				struct niobuf_local *l = &local_nb[j];
+				char *ptr;
+
+				if (j >= local_npages || l->lnb_len > len ||
+				    l->lnb_len > nob - pos)
+					GOTO(out, rc = -EPROTO);
+
+				ptr = kmap(l->lnb_page);
+				memcpy(ptr + (l->lnb_page_offset & ~PAGE_MASK),
+				       stream + pos, l->lnb_len);
+				kunmap(l->lnb_page);
+				pos += l->lnb_len;
+				len -= l->lnb_len;
+				j++;
+			}
+			continue;
+		}
+
+		while (len > 0) {
+			const struct ll_compr_hdr *hdr = stream + pos;
+			unsigned int chunk_pages;
+
+			if (nob - pos < sizeof(*hdr) ||
+			    hdr->llch_chunk_bits < COMPR_CHUNK_MIN_BITS ||
+			    hdr->llch_chunk_bits > COMPR_CHUNK_MAX_BITS ||
+			    (1U << hdr->llch_chunk_bits) > len)
+				GOTO(out, rc = -EPROTO);
+
+			chunk_pages = 1U << (hdr->llch_chunk_bits - PAGE_SHIFT);
+			if (j + chunk_pages > local_npages)
+				GOTO(out, rc = -EPROTO);
+
+			for (k = 0; k < chunk_pages; k++, j++) {
+				if (local_nb[j].lnb_len != PAGE_SIZE ||
+				    local_nb[j].lnb_page_offset & ~PAGE_MASK)
+					GOTO(out, rc = -EPROTO);
+				dst[k] = local_nb[j].lnb_page;
+			}
+
+			rc = lustre_decompr_chunk(hdr, nob - pos, dst,
+						  chunk_pages);
+			if (rc < 0) {
+				CERROR("%s: cannot decompress chunk at %llu: rc = %d\n",
+				       tgt_name(tgt),
+				       local_nb[j - chunk_pages].lnb_file_offset,
+				       rc);
+				GOTO(out, rc);
+			}
+			pos += rc;
+			len -= 1U << hdr->llch_chunk_bits;
+			rc = 0;
+		}
+	}
+	if (j != local_npages || pos != nob)
+		rc = -EPROTO;
+out:
+	if (dst)
+		OBD_FREE_PTR_ARRAY_LARGE(dst,
+				1U << (COMPR_CHUNK_MAX_BITS - PAGE_SHIFT));
+	vunmap(stream - lnb[0].lnb_page_offset);
+
+	RETURN(rc);
+}
+
 int tgt_brw_write(struct tgt_session_info *tsi)
 {
 	struct ptlrpc_request	*req = tgt_ses_req(tsi);
@@ -2647,11 +2811,16 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 	struct obd_export	*exp = req->rq_export;
 	struct niobuf_remote	*remote_nb;
 	struct niobuf_local	*local_nb;
+	struct niobuf_local	*bulk_nb;
+	struct niobuf_local	*compr_nb = NULL;
+	struct page		**compr_pages = NULL;
 	struct obd_ioobj	*ioo;
 	struct ost_body		*body, *repbody;
 	struct lustre_handle	 lockh = {0};
 	__u32			*rcs;
 	int			 objcount, niocount, npages;
+	int			 bulk_npages = 0;
+	bool			 compressed = false;
 	int			 rc = 0;
 	int			 i, j;
 	enum cksum_types cksum_type = OBD_CKSUM_CRC32;
@@ -2740,6 +2909,17 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 			sizeof(*remote_nb))
 		RETURN(err_serious(-EPROTO));
 
+	for (i = 0; i < niocount && !compressed; i++)
+		compressed = remote_nb[i].rnb_flags & OBD_BRW_COMPRESSED;
+	if (compressed &&
+	    (!exp_connect_compress(exp) ||
+	     (body->oa.o_valid & OBD_MD_FLFLAGS &&
+	      body->oa.o_flags & OBD_FL_SHORT_IO))) {
+		CERROR("%s: unexpected compressed write from %s\n",
+		       obd_name, obd_export_nid2str(exp));
+		RETURN(err_serious(-EPROTO));
+	}
+
 	if ((remote_nb[0].rnb_flags & OBD_BRW_MEMALLOC) &&
 	    ptlrpc_connection_is_local(exp->exp_connection))
 		mpflags = memalloc_noreclaim_save();
@@ -2794,6 +2974,9 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 			objcount, ioo, remote_nb, &npages, local_nb);
 	if (rc < 0)
 		GOTO(out_lock, rc);
+	/* the bulk is received into local_nb unless it is compressed */
+	bulk_nb = local_nb;
+	bulk_npages = npages;
 	if (body->oa.o_valid & OBD_MD_FLFLAGS &&
 	    body->oa.o_flags & OBD_FL_SHORT_IO) {
 		unsigned int short_io_size;
@@ -2812,7 +2995,18 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 				       short_io_size);
 		desc = NULL;
 	} else {
-		desc = ptlrpc_prep_bulk_exp(req, npages, ioobj_max_brw_get(ioo),
+		if (compressed) {
+			rc = tgt_brw_compr_prep(remote_nb,
+						body->oa.o_compr_nob,
+						&compr_pages, &compr_nb,
+						&bulk_npages);
+			if (rc != 0)
+				GOTO(skip_transfer, rc);
+			bulk_nb = compr_nb;
+		}
+
+		desc = ptlrpc_prep_bulk_exp(req, bulk_npages,
+					    ioobj_max_brw_get(ioo),
 					    PTLRPC_BULK_GET_SINK,
 					    OST_BULK_PORTAL,
 					    &ptlrpc_bulk_kiov_nopin_ops);
@@ -2820,11 +3014,11 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 			GOTO(skip_transfer, rc = -ENOMEM);
 
 		/* NB Having prepped, we must commit... */
-		for (i = 0; i < npages; i++)
+		for (i = 0; i < bulk_npages; i++)
 			desc->bd_frag_ops->add_kiov_frag(desc,
-					local_nb[i].lnb_page,
-					local_nb[i].lnb_page_offset & ~PAGE_MASK,
-					local_nb[i].lnb_len);
+					bulk_nb[i].lnb_page,
+					bulk_nb[i].lnb_page_offset & ~PAGE_MASK,
+					bulk_nb[i].lnb_len);
 
 		rc = sptlrpc_svc_prep_bulk(req, desc);
 		if (rc != 0)
@@ -2848,7 +3042,7 @@ skip_transfer:
 							   cksum_type);
 
 		rc = tgt_checksum_niobuf_rw(tsi->tsi_tgt, cksum_type,
-					    local_nb, npages, OST_WRITE,
+					    bulk_nb, bulk_npages, OST_WRITE,
 					    &repbody->oa.o_cksum, false);
 		if (rc < 0)
 			GOTO(out_commitrw, rc);
@@ -2859,7 +3053,7 @@ skip_transfer:
 			mmap = (body->oa.o_valid & OBD_MD_FLFLAGS &&
 				body->oa.o_flags & OBD_FL_MMAP);
 
-			tgt_warn_on_cksum(req, desc, local_nb, npages,
+			tgt_warn_on_cksum(req, desc, bulk_nb, bulk_npages,
 					  body->oa.o_cksum,
 					  repbody->oa.o_cksum, mmap);
 			cksum_counter = 0;
@@ -2871,6 +3065,18 @@ skip_transfer:
 		}
 	}
 
+	if (compr_nb && rc == 0) {
+		/* do not decompress a corrupted bulk, let the client resend */
+		if (body->oa.o_valid & OBD_MD_FLCKSUM &&
+		    body->oa.o_cksum != repbody->oa.o_cksum)
+			rc = -EAGAIN;
+		else
+			rc = tgt_brw_decompress(tsi->tsi_tgt, remote_nb,
+						niocount, local_nb, npages,
+						compr_pages, compr_nb,
+						bulk_npages);
+	}
+
 	CFS_FAIL_TIMEOUT(OBD_FAIL_OST_BRW_PAUSE_BULK2, cfs_fail_val);
 
 out_commitrw:
@@ -2933,6 +3139,8 @@ out_lock:
 	tgt_brw_unlock(exp, ioo, remote_nb, &lockh, LCK_PW);
 	if (desc)
 		ptlrpc_free_bulk(desc);
+	if (compr_nb)
+		tgt_brw_compr_fini(compr_pages, compr_nb, bulk_npages);
 out:
 	if (unlikely(no_reply || (exp->exp_obd->obd_no_transno && wait_sync))) {
 		req->rq_no_reply = 1;
@@ -1412,7 +1412,8 @@ int tgt_mk_reply_data(const struct lu_env *env,
 	lrd = &trd->trd_reply;
 	lrd->lrd_transno = transno;
 	if (tsi && tsi->tsi_batch_env) {
-		if (tsi->tsi_batch_idx == 0) {
+		/* the first modifying sub request need not be the first one */
+		if (tsi->tsi_batch_trd == NULL) {
 			LASSERT(req != NULL);
 			tsi->tsi_batch_trd = trd;
 			trd->trd_index = -1;
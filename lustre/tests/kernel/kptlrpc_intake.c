@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * Microbenchmark of the intake queues of ptlrpc service partitions.
+ *
+ * One consumer thread bound to the first online CPU takes entries the way
+ * ptlrpc_server_handle_req_in() does, and producer threads bound to the
+ * other CPUs, one per CPU by default, add them the way request_in_callback()
+ * adds incoming requests. With lock=1 a single list under a spinlock is used
+ * instead, like the former scp_req_incoming list, for comparison.
+ *
+ * The benchmark runs while the module is loaded by sanity test_441, and the
+ * result is printed in requests/s/core. The init function then fails on
+ * purpose, so that the module does not stay loaded.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/completion.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <lustre_net.h>
+
+/* Random ID passed by userspace, and printed in messages, used to
+ * separate different runs of that module. */
+static int run_id;
+module_param(run_id, int, 0644);
+MODULE_PARM_DESC(run_id, "run ID");
+
+static int nthreads;
+module_param(nthreads, int, 0644);
+MODULE_PARM_DESC(nthreads, "producer threads, one per CPU other than the consumer's by default");
+
+static int count = 1 << 20;
+module_param(count, int, 0644);
+MODULE_PARM_DESC(count, "requests added by each producer");
+
+static int lock;
+module_param(lock, int, 0644);
+MODULE_PARM_DESC(lock, "use a single list under a spinlock");
+
+#define PREFIX "lustre_kptlrpc_intake_%u:"
+
+/* entries of a producer in flight at most, reused once consumed */
+#define KPI_RING	256
+
+struct kpi_entry {
+	struct llist_node	ke_node;
+	struct list_head	ke_list;
+	int			ke_busy;
+};
+
+struct kpi_producer {
+	struct kpi_entry	kp_ring[KPI_RING];
+	struct task_struct	*kp_task;
+};
+
+static struct ptlrpc_intake kpi_intake;
+static LIST_HEAD(kpi_list);
+static DEFINE_SPINLOCK(kpi_lock);
+static DECLARE_COMPLETION(kpi_start);
+static DECLARE_COMPLETION(kpi_done);
+/* entries added by all the producers, and time taken to consume them */
+static long kpi_total;
+static s64 kpi_usecs;
+
+static void kpi_add(struct kpi_entry *ke)
+{
+	if (!lock) {
+		ptlrpc_intake_add(&kpi_intake, &ke->ke_node);
+		return;
+	}
+
+	spin_lock(&kpi_lock);
+	list_add_tail(&ke->ke_list, &kpi_list);
+	spin_unlock(&kpi_lock);
+}
+
+/* consume the available entries, return how many */
+static long kpi_take(void)
+{
+	struct kpi_entry *ke, *next;
+	struct llist_node *first;
+	long taken = 0;
+
+	if (lock) {
+		spin_lock(&kpi_lock);
+		ke = list_first_entry_or_null(&kpi_list, struct kpi_entry,
+					      ke_list);
+		if (ke != NULL)
+			list_del(&ke->ke_list);
+		spin_unlock(&kpi_lock);
+		if (ke == NULL)
+			return 0;
+
+		smp_store_release(&ke->ke_busy, 0);
+		return 1;
+	}
+
+	first = ptlrpc_intake_take(&kpi_intake, PTLRPC_REQ_IN_BATCH);
+	llist_for_each_entry_safe(ke, next, first, ke_node) {
+		smp_store_release(&ke->ke_busy, 0);
+		taken++;
+	}
+
+	return taken;
+}
+
+static int kpi_producer_main(void *data)
+{
+	struct kpi_producer *kp = data;
+	struct kpi_entry *ke;
+	int i;
+
+	wait_for_completion(&kpi_start);
+
+	for (i = 0; i < count; i++) {
+		ke = &kp->kp_ring[i % KPI_RING];
+		/* the consumer may share this CPU */
+		while (smp_load_acquire(&ke->ke_busy))
+			cond_resched();
+		ke->ke_busy = 1;
+		kpi_add(ke);
+	}
+
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(1);
+
+	return 0;
+}
+
+static int kpi_consumer_main(void *data)
+{
+	long done = 0;
+	long idle = 0;
+	ktime_t start;
+
+	start = ktime_get();
+	complete_all(&kpi_start);
+	while (done < kpi_total) {
+		long taken = kpi_take();
+
+		done += taken;
+		if (taken == 0 && ++idle % 1024 == 0)
+			cond_resched();
+	}
+	kpi_usecs = max_t(s64, ktime_us_delta(ktime_get(), start), 1);
+	complete(&kpi_done);
+
+	while (!kthread_should_stop())
+		schedule_timeout_interruptible(1);
+
+	return 0;
+}
+
+static int __init kptlrpc_intake_init(void)
+{
+	struct kpi_producer *producers;
+	struct task_struct *consumer;
+	int consumer_cpu;
+	int started = 0;
+	int cpu;
+	int rc;
+
+	/* the producers share the consumer's CPU only if it is the only one */
+	consumer_cpu = cpumask_first(cpu_online_mask);
+	if (nthreads <= 0)
+		nthreads = max_t(int, num_online_cpus() - 1, 1);
+	if (count <= 0) {
+		pr_err(PREFIX " invalid count %d\n", run_id, count);
+		goto out;
+	}
+	kpi_total = (long)nthreads * count;
+
+	rc = ptlrpc_intake_init(&kpi_intake, cfs_cpt_tab, CFS_CPT_ANY);
+	if (rc) {
+		pr_err(PREFIX " cannot init intake: rc = %d\n", run_id, rc);
+		goto out;
+	}
+
+	producers = kvzalloc(nthreads * sizeof(*producers), GFP_KERNEL);
+	if (producers == NULL)
+		goto out_intake;
+
+	/* the single consumer, created first so that the producers, blocked
+	 * once their ring is full, always have one
+	 */
+	consumer = kthread_create(kpi_consumer_main, NULL, "kpi_%u_c", run_id);
+	if (IS_ERR(consumer)) {
+		pr_err(PREFIX " cannot create consumer: rc = %ld\n",
+		       run_id, PTR_ERR(consumer));
+		kvfree(producers);
+		goto out_intake;
+	}
+	kthread_bind(consumer, consumer_cpu);
+
+	for_each_online_cpu(cpu) {
+		struct kpi_producer *kp;
+
+		if (started == nthreads)
+			break;
+		if (cpu == consumer_cpu && num_online_cpus() > 1)
+			continue;
+
+		kp = &producers[started];
+		kp->kp_task = kthread_create(kpi_producer_main, kp,
+					     "kpi_%u_%d", run_id, started);
+		if (IS_ERR(kp->kp_task)) {
+			pr_err(PREFIX " cannot create producer: rc = %ld\n",
+			       run_id, PTR_ERR(kp->kp_task));
+			kp->kp_task = NULL;
+			break;
+		}
+		kthread_bind(kp->kp_task, cpu);
+		wake_up_process(kp->kp_task);
+		started++;
+	}
+
+	if (started < nthreads) {
+		/* let the started producers run, and report nothing */
+		kpi_total = (long)started * count;
+		nthreads = 0;
+	}
+
+	/* the consumer starts the producers */
+	wake_up_process(consumer);
+	wait_for_completion(&kpi_done);
+	kthread_stop(consumer);
+
+	for (cpu = 0; cpu < started; cpu++)
+		kthread_stop(producers[cpu].kp_task);
+	kvfree(producers);
+
+	if (nthreads > 0)
+		/* below message is checked in sanity.sh test_441 */
+		pr_err(PREFIX " %s: %d producers, %ld requests in %lld usec, %lld requests/s/core\n",
+		       run_id, lock ? "lock" : "intake", nthreads, kpi_total,
+		       kpi_usecs, div64_s64((s64)kpi_total * USEC_PER_SEC,
+					    kpi_usecs * (nthreads + 1)));
+
+out_intake:
+	ptlrpc_intake_fini(&kpi_intake);
+out:
+	/* Don't load. */
+	return -EINVAL;
+}
+
+static void __exit kptlrpc_intake_exit(void)
+{
+}
+
+MODULE_AUTHOR("OpenSFS, Inc. <http://www.lustre.org/>");
+MODULE_DESCRIPTION("Lustre ptlrpc intake queue microbenchmark");
+MODULE_VERSION(LUSTRE_VERSION_STRING);
+MODULE_LICENSE("GPL");
+
+module_init(kptlrpc_intake_init);
+module_exit(kptlrpc_intake_exit);
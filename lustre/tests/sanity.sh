@@ -1497,6 +1497,57 @@ test_24H() {
 }
 run_test 24H "repeat FLD_QUERY rpc"
 
+test_24I() {
+	local dir=$DIR/$tdir
+	local index_max
+	local index_mb
+	local setting
+	local max
+	local mb
+	local rpcs
+	local i
+
+	index_max=$($LCTL get_param -n llite.*.dir_index_max | head -n 1)
+	[[ -n "$index_max" ]] || error "no dir_index_max parameter"
+	stack_trap "$LCTL set_param llite.*.dir_index_max=$index_max"
+	index_mb=$($LCTL get_param -n llite.*.dir_index_max_mb | head -n 1)
+	[[ -n "$index_mb" ]] || error "no dir_index_max_mb parameter"
+	stack_trap "$LCTL set_param llite.*.dir_index_max_mb=$index_mb"
+
+	test_mkdir -c 1 $dir || error "mkdir $dir failed"
+	createmany -o $dir/$tfile- 20 || error "createmany failed"
+
+	# no memory for indexes acts as no index
+	for setting in 16384:64 0:64 16384:0; do
+		max=${setting%:*}
+		mb=${setting#*:}
+		$LCTL set_param llite.*.dir_index_max=$max \
+			llite.*.dir_index_max_mb=$mb
+		cancel_lru_locks mdc
+		ls $dir > /dev/null || error "ls $dir failed"
+		# the index is built in the background after the first miss
+		stat $dir/nonexistent.$setting &> /dev/null &&
+			error "stat nonexistent.$setting succeeded"
+		sleep 1
+		$LCTL set_param mdc.*.stats=clear > /dev/null
+		for ((i = 0; i < 100; i++)); do
+			stat $dir/nonexistent.$setting.$i &> /dev/null &&
+				error "stat nonexistent.$setting.$i succeeded"
+		done
+		stat $dir/$tfile-10 > /dev/null || error "stat $tfile-10 failed"
+		rpcs=$(calc_stats mdc.*.stats ldlm_ibits_enqueue)
+		echo "dir_index_max=$max, max_mb=$mb: $rpcs enqueue RPCs"
+		if (( max > 0 && mb > 0 )); then
+			(( rpcs < 10 )) ||
+				error "$rpcs RPCs for lookups with dir index"
+		else
+			(( rpcs >= 100 )) ||
+				error "$rpcs RPCs for lookups without dir index"
+		fi
+	done
+}
+run_test 24I "negative lookups are answered from the dir pages"
+
 test_25a() {
 	echo '== symlink sanity ============================================='
 
@@ -3549,6 +3600,70 @@ test_27V() {
 }
 run_test 27V "creating widely striped file races with deactivating OST"
 
+test_27X() {
+	(( $MDS1_VERSION >= $(version_code 2.15.59) )) ||
+		skip "Need MDS version at least 2.15.59 for compressed layout"
+
+	local file=$DIR/$tdir/$tfile
+
+	test_mkdir $DIR/$tdir
+	$LFS setstripe --compress lz4 $file.plain &&
+		error "compressed layout without component should fail"
+	$LFS setstripe -E EOF --compress lz4:99 $file.bad &&
+		error "compression level 99 should fail"
+	$LFS setstripe -E EOF --compress lz4 --compress-chunk 48K $file.bad &&
+		error "compression chunk 48K should fail"
+
+	$LFS setstripe -E 1M -c 1 -E EOF --compress lz4:3 \
+		--compress-chunk 128K $file || error "setstripe compress failed"
+	$LFS getstripe $file
+
+	$LFS getstripe -I2 $file | grep -q "raid0,compress" ||
+		error "compress pattern not set"
+	$LFS getstripe -v -I2 $file | grep -q "lcme_compr_type: *lz4" ||
+		error "compression type not set"
+	$LFS getstripe -v -I2 $file | grep -q "lcme_compr_chunk_kb: *128" ||
+		error "compression chunk size not set"
+
+	local wire=true
+	local written
+	local sent
+
+	$LCTL get_param -n osc.$FSNAME-OST*-osc-[^M]*.import |
+		grep -q compressed_file || {
+		echo "OSTs do not support compression, data is sent as is"
+		wire=false
+	}
+	$LCTL set_param osc.*.osc_stats=clear
+
+	# compressible data, followed by random data which is sent as is
+	yes "compressible data" | dd of=$file.src bs=1M count=6 iflag=fullblock ||
+		error "dd src failed"
+	dd if=/dev/urandom of=$file.src bs=1M count=2 seek=6 conv=notrunc ||
+		error "dd random failed"
+	# unaligned write, which is not compressed
+	dd if=/dev/urandom of=$file.src bs=1000 count=3 seek=3000 conv=notrunc ||
+		error "dd unaligned failed"
+
+	cp $file.src $file || error "cp to compressed file failed"
+	dd if=$file.src of=$file bs=1000 count=3 skip=3000 seek=3000 \
+		conv=notrunc || error "unaligned write failed"
+	cancel_lru_locks osc
+	cmp $file.src $file || error "compressed file data mismatch"
+
+	written=$($LCTL get_param -n osc.*.osc_stats |
+		  awk '/compr_write_bytes/ { sum += $2 } END { print sum + 0 }')
+	sent=$($LCTL get_param -n osc.*.osc_stats |
+	       awk '/compr_bulk_bytes/ { sum += $2 } END { print sum + 0 }')
+	echo "compressed BRW: $written bytes written, $sent bytes sent"
+	if $wire; then
+		(( written > 0 )) || error "no data written compressed"
+		(( sent < written )) ||
+			error "$sent bytes sent for $written bytes written"
+	fi
+}
+run_test 27X "wire compression of writes to a compressed component"
+
 # createtest also checks that device nodes are created and
 # then visible correctly (#2091)
 test_28() { # bug 2091
@@ -8983,6 +9098,47 @@ test_56ef() {
 }
 run_test 56ef "lfs find with multiple paths"
 
+test_56eg() {
+	local dir=$DIR/$tdir
+	local serial=$TMP/$tfile.serial
+	local parallel=$TMP/$tfile.parallel
+	local d
+
+	stack_trap "rm -f $serial $parallel"
+
+	test_mkdir -p $dir
+	for d in {1..4}; do
+		if (( MDSCOUNT > 1 )); then
+			$LFS mkdir -c $MDSCOUNT $dir/d$d ||
+				error "mkdir $dir/d$d failed"
+		else
+			mkdir $dir/d$d || error "mkdir $dir/d$d failed"
+		fi
+		mkdir -p $dir/d$d/{a,b}/{c,d} || error "mkdir subdirs failed"
+		createmany -o $dir/d$d/a/c/f 20 > /dev/null ||
+			error "create files failed"
+		touch $dir/d$d/b/d/f
+	done
+
+	$LFS find $dir | sort > $serial
+	$LFS find -j 4 $dir | sort > $parallel
+	diff $serial $parallel || error "lfs find -j 4 output differs"
+
+	$LFS find --threads 3 -type f --maxdepth 3 $dir | sort > $parallel
+	$LFS find -type f --maxdepth 3 $dir | sort > $serial
+	diff $serial $parallel || error "lfs find -j 3 --maxdepth differs"
+
+	# a directory is printed before the paths under it
+	$LFS find -j 4 $dir | awk '
+		{ seen[$0] = 1; p = $0; sub("/[^/]*$", "", p) }
+		NR > 1 && !(p in seen) { print "parent not printed:", $0; bad = 1 }
+		END { exit bad }' || error "lfs find -j printed a path too early"
+
+	$LFS find -j 0 $dir && error "lfs find -j 0 should fail"
+	return 0
+}
+run_test 56eg "lfs find --threads|-j"
+
 test_57a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	# note test will not do anything if MDS is not local
@@ -11762,6 +11918,37 @@ test_101m()
 }
 run_test 101m "read ahead for small file and last stripe of the file"
 
+test_101n() {
+	local ops=""
+	local streams
+	local miss
+	local i
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile
+	stack_trap "rm -f $DIR/$tfile"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=128 ||
+		error "dd 128M file failed"
+	cancel_lru_locks osc
+	$LCTL set_param llite.*.read_ahead_stats=0
+
+	# two sequential streams interleaved on one file descriptor
+	for ((i = 0; i < 32; i++)); do
+		ops+="z$((i * 1048576))r1048576"
+		ops+="z$(((i + 64) * 1048576))r1048576"
+	done
+	$MULTIOP $DIR/$tfile o${ops}c || error "multiop read failed"
+
+	$LCTL get_param llite.*.read_ahead_stats
+	streams=$($LCTL get_param -n llite.*.read_ahead_stats |
+		  awk '/new_read_stream/ { s += $2 } END { print s + 0 }')
+	miss=$($LCTL get_param -n llite.*.read_ahead_stats |
+	       awk '/^misses/ { s += $2 } END { print s + 0 }')
+	(( streams >= 1 && streams <= 4 )) ||
+		error "expected a few read streams, got $streams"
+	(( miss < 32 )) || error "streams reset each other, $miss misses"
+}
+run_test 101n "readahead follows interleaved streams of one descriptor"
+
 setup_test102() {
 	test_mkdir $DIR/$tdir
 	chown $RUNAS_ID $DIR/$tdir
@@ -12352,6 +12539,82 @@ test_102t() {
 }
 run_test 102t "zero length xattr values handled correctly"
 
+test_102u() {
+	local file=$DIR/$tfile
+	local prefetch
+	local rpcs
+	local i
+
+	[[ -n "$(lctl get_param -n llite.*.xattr_prefetch 2>/dev/null)" ]] ||
+		error "no xattr_prefetch parameter"
+	$LCTL get_param -n mdc.$FSNAME-MDT0000-mdc-*.connect_flags |
+		grep -q xattr_prefetch || skip "MDS has no xattr prefetch"
+
+	save_lustre_params client "llite.*.xattr_cache" > $TMP/$tfile.param
+	save_lustre_params client "llite.*.xattr_prefetch" >> \
+		$TMP/$tfile.param
+	stack_trap "restore_lustre_params < $TMP/$tfile.param; \
+		    rm -f $TMP/$tfile.param"
+	$LCTL set_param llite.*.xattr_cache=1
+
+	touch $file || error "touch $file failed"
+	for ((i = 0; i < 4; i++)); do
+		setfattr -n user.u102.$i -v value$i $file ||
+			error "setfattr user.u102.$i failed"
+	done
+
+	for prefetch in 1 0; do
+		$LCTL set_param llite.*.xattr_prefetch=$prefetch
+		cancel_lru_locks mdc
+		stat $file > /dev/null || error "stat $file failed"
+		$LCTL set_param mdc.*.stats=clear > /dev/null
+		for ((i = 0; i < 4; i++)); do
+			getfattr --only-values -n user.u102.$i $file |
+				grep -q "^value$i$" ||
+				error "wrong user.u102.$i (prefetch=$prefetch)"
+		done
+		rpcs=$(calc_stats mdc.*.stats ldlm_ibits_enqueue)
+		echo "xattr_prefetch=$prefetch: $rpcs enqueue RPCs"
+		if (( prefetch )); then
+			(( rpcs == 0 )) ||
+				error "$rpcs RPCs for getxattr after stat"
+		else
+			(( rpcs > 0 )) ||
+				error "no RPC for getxattr without prefetch"
+		fi
+	done
+}
+run_test 102u "stat prefetches xattrs into the xattr cache"
+
+test_102v() {
+	local page_size=$(get_page_size $SINGLEMDS)
+	local file=$DIR/$tfile
+	local value
+	local xsize
+
+	large_xattr_enabled || skip_env "ea_inode feature disabled"
+
+	save_lustre_params client "llite.*.xattr_cache" > $TMP/$tfile.param
+	stack_trap "restore_lustre_params < $TMP/$tfile.param; \
+		    rm -f $TMP/$tfile.param"
+	# getxattr RPCs rather than intents, so that values over one page
+	# are sent from pages by the MDS
+	$LCTL set_param llite.*.xattr_cache=0
+
+	touch $file || error "touch $file failed"
+	for xsize in $((page_size + 1)) $((page_size * 3 - 5)) \
+		     $(max_xattr_size); do
+		# no repeating pattern, to catch misordered pages
+		value=$(seq -w 1 $xsize | tr -d '\n' | head -c $xsize)
+		setfattr -n trusted.big -v $value $file ||
+			error "setfattr of $xsize bytes failed"
+		cancel_lru_locks mdc
+		[[ "$(get_xattr_value trusted.big $file)" == "$value" ]] ||
+			error "wrong value of $xsize bytes"
+	done
+}
+run_test 102v "getxattr of values larger than one page"
+
 run_acl_subtest()
 {
 	local test=$LUSTRE/tests/acl/$1.test
@@ -13843,6 +14106,115 @@ test_119i()
 }
 run_test 119i "test unaligned aio at varying sizes"
 
+test_119j()
+{
+	local bs=$((PAGE_SIZE * 4 + 1024))
+	local ops
+	local access
+	local missing
+	local i
+
+	$LCTL get_param -n dio_page_pools | grep -q "^cpt" ||
+		error "no unaligned DIO page pool"
+
+	stack_trap "rm -f $DIR/$tfile*"
+	$LFS setstripe -c 1 $DIR/$tfile.1
+
+	ops=$(printf "wu${bs}%.0s" {1..20})
+	# the first writes fill the pool, the next ones reuse its pages
+	for i in 1 2; do
+		$MULTIOP $DIR/$tfile.$i oO_CREAT:O_RDWR:O_DIRECT:$ops ||
+			error "multiop unaligned write $i failed"
+	done
+	$LCTL get_param dio_page_pools
+
+	access=$($LCTL get_param -n dio_page_pools |
+		awk '/^[0-9]/ { s += $4 } END { print s }')
+	missing=$($LCTL get_param -n dio_page_pools |
+		awk '/^[0-9]/ { s += $5 } END { print s }')
+	(( access > 0 )) || error "unaligned DIO did not use the pool"
+	(( missing < access )) ||
+		error "no page reused, access $access missing $missing"
+
+	$MULTIOP $DIR/$tfile.3 oO_CREAT:O_RDWR:O_DIRECT:${ops//wu/w} ||
+		error "multiop aligned write failed"
+	cmp $DIR/$tfile.1 $DIR/$tfile.3 || error "unaligned data differs"
+}
+run_test 119j "unaligned DIO reuses bounce pages from the pool"
+
+test_119k()
+{
+	local rthresh
+	local wthresh
+	local switches
+	local used
+
+	$LCTL get_param -n llite.*.hybrid_io_read_threshold_bytes ||
+		error "no hybrid_io_read_threshold_bytes parameter"
+
+	rthresh=$($LCTL get_param -n llite.*.hybrid_io_read_threshold_bytes |
+		  head -n1)
+	wthresh=$($LCTL get_param -n llite.*.hybrid_io_write_threshold_bytes |
+		  head -n1)
+	stack_trap "$LCTL set_param llite.*.hybrid_io_read_threshold_bytes=$rthresh llite.*.hybrid_io_write_threshold_bytes=$wthresh"
+	$LCTL set_param llite.*.hybrid_io_read_threshold_bytes=1M \
+		llite.*.hybrid_io_write_threshold_bytes=1M
+
+	stack_trap "rm -f $DIR/$tfile $TMP/$tfile"
+	dd if=/dev/urandom of=$TMP/$tfile bs=1M count=32 ||
+		error "dd to $TMP/$tfile failed"
+	cancel_lru_locks osc
+	$LCTL set_param llite.*.stats=clear
+
+	# the first write has no previous I/O to continue and stays buffered
+	dd if=$TMP/$tfile of=$DIR/$tfile bs=4M || error "write failed"
+	switches=$($LCTL get_param -n llite.*.stats |
+		   awk '/hybrid_write_switch/ { s += $2 } END { print s + 0 }')
+	(( switches == 7 )) ||
+		error "expected 7 writes as direct I/O, got $switches"
+	used=$($LCTL get_param -n llite.*.max_cached_mb |
+	       awk '/used_mb/ { s += $2 } END { print s + 0 }')
+	(( used < 32 )) || error "streaming write cached $used MiB"
+
+	dd if=$DIR/$tfile of=/dev/null bs=4M || error "read failed"
+	switches=$($LCTL get_param -n llite.*.stats |
+		   awk '/hybrid_read_switch/ { s += $2 } END { print s + 0 }')
+	(( switches > 0 )) || error "no read done as direct I/O"
+
+	cmp $TMP/$tfile $DIR/$tfile || error "data differs"
+}
+run_test 119k "large streaming I/O is switched to direct I/O"
+
+test_119l()
+{
+	local bs=$((PAGE_SIZE * 97))
+
+	stack_trap "rm -f $DIR/$tfile $TMP/$tfile"
+	$LFS setstripe -c $OSTCOUNT -S 256K $DIR/$tfile ||
+		error "setstripe $DIR/$tfile failed"
+	dd if=/dev/urandom of=$TMP/$tfile bs=$bs count=13 ||
+		error "dd to $TMP/$tfile failed"
+
+	# odd sized DIO spanning stripes uses partially filled page batches
+	dd if=$TMP/$tfile of=$DIR/$tfile bs=$bs oflag=direct ||
+		error "direct write failed"
+	cancel_lru_locks osc
+	cmp $TMP/$tfile $DIR/$tfile || error "data differs after write"
+
+	dd if=$DIR/$tfile of=$TMP/$tfile.2 bs=$((bs * 3)) iflag=direct ||
+		error "direct read failed"
+	stack_trap "rm -f $TMP/$tfile.2"
+	cmp $TMP/$tfile $TMP/$tfile.2 || error "data differs after read"
+
+	# buffered write and readahead take cl_pages from the same batches
+	rm -f $DIR/$tfile
+	dd if=$TMP/$tfile of=$DIR/$tfile bs=$bs conv=fsync ||
+		error "buffered write failed"
+	cancel_lru_locks osc
+	cmp $TMP/$tfile $DIR/$tfile || error "data differs after buffered I/O"
+}
+run_test 119l "large I/O with bulk slab allocation of cl_pages"
+
 test_120a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	remote_mds_nodsh && skip "remote MDS with nodsh"
@@ -14443,6 +14815,150 @@ test_123f() {
 }
 run_test 123f "Retry mechanism with large wide striping files"
 
+test_123g() {
+	local dir=$DIR/$tdir
+	local batch_max
+	local batch_rpcs
+	local reint_rpcs
+	local nproc=8
+	local count=100
+	local pids=()
+	local i
+
+	$LCTL get_param mdc.*.import | grep -q 'connect_flags:.*batch_reint' ||
+		skip "MDS does not support batched modifications"
+
+	batch_max=$($LCTL get_param -n llite.*.unlink_batch_max | head -n 1)
+	stack_trap "$LCTL set_param llite.*.unlink_batch_max=$batch_max"
+
+	# unlinks in one directory are serialized by the VFS
+	test_mkdir -i 0 -c 1 $dir
+	for ((i = 0; i < nproc; i++)); do
+		test_mkdir -i 0 -c 1 $dir/d$i
+		createmany -o $dir/d$i/$tfile- $count ||
+			error "createmany in $dir/d$i failed"
+	done
+	touch $dir/d0/$tfile.keep
+
+	$LCTL set_param llite.*.unlink_batch_max=64
+	$LCTL set_param mdc.*.stats=clear > /dev/null
+	for ((i = 0; i < nproc; i++)); do
+		unlinkmany $dir/d$i/$tfile- $count &
+		pids+=($!)
+	done
+	for i in ${pids[@]}; do
+		wait $i || error "unlinkmany failed"
+	done
+
+	# each unlink returned once it was done on the MDT
+	for ((i = 0; i < nproc; i++)); do
+		(( $(ls $dir/d$i | wc -l) == (i == 0 ? 1 : 0) )) ||
+			error "files left in $dir/d$i: $(ls $dir/d$i)"
+	done
+	[[ -f $dir/d0/$tfile.keep ]] || error "$dir/d0/$tfile.keep is missing"
+
+	batch_rpcs=$(calc_stats mdc.*.stats mds_batch)
+	reint_rpcs=$(calc_stats mdc.*.stats mds_reint)
+	echo "batched RPCs: $batch_rpcs, reint RPCs: $reint_rpcs"
+	(( batch_rpcs > 0 )) || error "unlinks were not batched"
+	(( batch_rpcs + reint_rpcs < nproc * count )) ||
+		error "concurrent unlinks were not sent together"
+
+	# a name freed by a batched unlink can be used at once
+	touch $dir/d0/$tfile-0 || error "recreate $dir/d0/$tfile-0 failed"
+	rm -rf $dir || error "rm -rf $dir failed"
+}
+run_test 123g "concurrent unlinks are batched"
+
+test_123h() {
+	(( MDSCOUNT >= 2 )) || skip "needs >= 2 MDTs"
+
+	local dir=$DIR/$tdir
+	local shard_max
+	local count=1000
+	local stripes
+	local hit
+	local nr
+
+	shard_max=$($LCTL get_param -n llite.*.statahead_shard_max |
+		    head -n 1)
+	[[ -n "$shard_max" ]] || error "no statahead_shard_max parameter"
+	stack_trap "$LCTL set_param llite.*.statahead_shard_max=$shard_max"
+
+	test_mkdir -c $MDSCOUNT $dir ||
+		error "mkdir striped $dir failed"
+	createmany -o $dir/$tfile- $count || error "createmany failed"
+	stack_trap "rm -rf $dir"
+
+	for shard_max in 1 $MDSCOUNT 0; do
+		$LCTL set_param llite.*.statahead_shard_max=$shard_max
+		cancel_lru_locks mdc
+		$LCTL set_param llite.*.statahead_stats=clear
+		nr=$(ls -l $dir | grep -c $tfile-)
+		(( nr == count )) ||
+			error "ls -l found $nr entries with $shard_max workers"
+		# wait for statahead thread to update hit/miss stats
+		sleep 1
+		hit=$($LCTL get_param -n llite.*.statahead_stats |
+		      awk '/hit.total:/ { sum += $NF } END { print sum + 0 }')
+		stripes=$($LCTL get_param -n llite.*.statahead_stats |
+			  awk '/stripe_total:/ { sum += $NF }
+			       END { print sum + 0 }')
+		echo "$shard_max workers: $hit statahead hits, $stripes stripes"
+		(( hit > 0 )) || error "no statahead hit with $shard_max workers"
+		# the entries of every stripe are prefetched by the workers
+		if (( shard_max > 0 )); then
+			(( stripes > 1 )) ||
+				error "$stripes stripes with $shard_max workers"
+		else
+			(( stripes == 0 )) ||
+				error "$stripes stripes without workers"
+		fi
+	done
+}
+run_test 123h "statahead on striped directories with stripe workers"
+
+test_123i() {
+	local dir=$DIR/$tdir
+	local fname_hits
+	local count=500
+	local hit
+	local i
+
+	fname_hits=$($LCTL get_param -n llite.*.statahead_fname_hits |
+		     head -n 1)
+	[[ -n "$fname_hits" ]] || error "no statahead_fname_hits parameter"
+	stack_trap "$LCTL set_param llite.*.statahead_fname_hits=$fname_hits"
+
+	test_mkdir $dir || error "mkdir $dir failed"
+	stack_trap "rm -rf $dir"
+	for ((i = 0; i < count; i++)); do
+		printf "$dir/out.%05d\n" $i
+	done | xargs touch || error "create files failed"
+
+	for fname_hits in 4 0; do
+		$LCTL set_param llite.*.statahead_fname_hits=$fname_hits
+		cancel_lru_locks mdc
+		$LCTL set_param llite.*.statahead_stats=clear
+		for ((i = 0; i < count; i++)); do
+			stat -c %n $(printf "$dir/out.%05d" $i) > /dev/null ||
+				error "stat out.$i failed"
+		done
+		# statahead by name pattern stops after 5s without lookup
+		sleep 7
+		hit=$($LCTL get_param -n llite.*.statahead_stats |
+		      awk '/hit.total:/ { sum += $NF } END { print sum + 0 }')
+		echo "statahead_fname_hits=$fname_hits: $hit statahead hits"
+		if (( fname_hits > 0 )); then
+			(( hit > count / 2 )) ||
+				error "$hit statahead hits for $count files"
+		else
+			(( hit == 0 )) || error "$hit hits with detection off"
+		fi
+	done
+}
+run_test 123i "statahead on numeric file name sequences without readdir"
+
 test_124a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	$LCTL get_param -n mdc.*.connect_flags | grep -q lru_resize ||
@@ -22859,6 +23375,33 @@ test_236() {
 }
 run_test 236 "Layout swap on open unlinked file"
 
+test_237() {
+	(( MDSCOUNT >= 2 )) || skip "needs >= 2 MDTs"
+
+	local stats="fld.*clilmv*.cache_stats"
+	local hits
+	local lookups
+
+	$LCTL get_param -n $stats > /dev/null 2>&1 ||
+		error "no FLD cache statistics"
+
+	test_mkdir -i 1 -c 1 $DIR/$tdir
+	createmany -o $DIR/$tdir/$tfile- 100 > /dev/null ||
+		error "createmany failed"
+	cancel_lru_locks mdc
+
+	ls -l $DIR/$tdir > /dev/null || error "ls -l $DIR/$tdir failed"
+	$LCTL get_param $stats
+
+	lookups=$($LCTL get_param -n $stats | awk '/^lookups:/ { s += $2 }
+						    END { print s }')
+	hits=$($LCTL get_param -n $stats | awk '/^hits:/ { s += $2 }
+						 END { print s }')
+	(( lookups > 0 && hits > 0 )) ||
+		error "FLD cache not used, lookups $lookups hits $hits"
+}
+run_test 237 "FLD client cache lookups are counted"
+
 # LU-4659 linkea consistency
 test_238() {
 	[[ $MDS1_VERSION -gt $(version_code 2.5.57) ]] ||
@@ -27082,6 +27625,43 @@ test_398q()
 }
 run_test 398q "race dio with buffered i/o"
 
+test_398r() {
+	(( $OSTCOUNT >= 2 )) || skip "needs >= 2 OSTs"
+
+	local stripe_size=$((1024 * 1024))
+	local stripe_count=$((OSTCOUNT > 4 ? 4 : OSTCOUNT))
+	local file_size=$((stripe_size * stripe_count * 3 + PAGE_SIZE))
+	local bs
+
+	stack_trap "rm -f $DIR/$tfile* $TMP/$tfile"
+	dd if=/dev/urandom of=$TMP/$tfile bs=$file_size count=1 ||
+		error "create $TMP/$tfile failed"
+
+	$LFS setstripe -c $stripe_count -S $stripe_size $DIR/$tfile ||
+		error "setstripe $DIR/$tfile failed"
+
+	# a single I/O covers several stripe rounds
+	for bs in $((stripe_size * stripe_count)) $file_size; do
+		echo "bs: $bs"
+		dd if=$TMP/$tfile of=$DIR/$tfile bs=$bs oflag=direct \
+			conv=notrunc || error "dio write bs=$bs failed"
+		cmp $TMP/$tfile $DIR/$tfile || error "data differs, bs=$bs"
+
+		cancel_lru_locks osc
+		dd if=$DIR/$tfile of=$DIR/$tfile.2 bs=$bs iflag=direct \
+			oflag=direct || error "dio copy bs=$bs failed"
+		cmp $TMP/$tfile $DIR/$tfile.2 || error "copy differs, bs=$bs"
+		rm -f $DIR/$tfile.2
+	done
+
+	which aiocp > /dev/null || return 0
+
+	aiocp -b $file_size -s $file_size -f O_DIRECT $TMP/$tfile \
+		$DIR/$tfile.aio || error "aio write failed"
+	cmp $TMP/$tfile $DIR/$tfile.aio || error "aio data differs"
+}
+run_test 398r "direct and async i/o across all stripes"
+
 test_fake_rw() {
 	local read_write=$1
 	if [ "$read_write" = "write" ]; then
@@ -29636,6 +30216,144 @@ test_434() {
 }
 run_test 434 "Client should not send RPCs for security.selinux with SElinux disabled"
 
+test_435() {
+	local ncpus=$(nproc)
+	local osc=$($LCTL list_param osc.$FSNAME-OST0000-osc-[^M]* |
+		    head -n 1)
+	local used
+	local cpu
+
+	(( ncpus > 1 )) || skip "need more than one CPU"
+	which taskset > /dev/null 2>&1 || skip "no taskset"
+
+	test_mkdir $DIR/$tdir
+	$LFS setstripe -c 1 -i 0 $DIR/$tdir
+	stack_trap "rm -rf $DIR/$tdir"
+	cancel_lru_locks osc
+
+	# cache pages from every CPU, so they are spread on all LRU sublists
+	for ((cpu = 0; cpu < ncpus && cpu < 16; cpu++)); do
+		taskset -c $cpu dd if=/dev/zero of=$DIR/$tdir/$tfile.$cpu \
+			bs=1M count=4 conv=fsync 2>/dev/null &
+	done
+	wait
+	$LCTL get_param $osc.osc_cached_mb
+	used=$($LCTL get_param -n $osc.osc_cached_mb |
+	       awk '/used_mb/ { print $2 }')
+	(( used > 0 )) || error "no page cached"
+
+	$LCTL set_param $osc.osc_cached_mb=0
+	$LCTL get_param $osc.osc_cached_mb
+	used=$($LCTL get_param -n $osc.osc_cached_mb |
+	       awk '/used_mb/ { print $2 }')
+	(( used == 0 )) || error "$used MiB left after shrinking the LRU"
+}
+run_test 435 "OSC LRU shrink reclaims pages of all CPU partitions"
+
+test_436() {
+	local osc=$($LCTL list_param osc.$FSNAME-OST0000-osc-[^M]* |
+		    head -n 1)
+	local mppr=$($LCTL get_param -n $osc.max_pages_per_rpc)
+	local pages
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile
+	stack_trap "rm -f $DIR/$tfile $TMP/$tfile"
+	stack_trap "$LCTL set_param $osc.max_pages_per_rpc=$mppr"
+	dd if=/dev/urandom of=$TMP/$tfile bs=1M count=16 ||
+		error "dd to $TMP/$tfile failed"
+
+	# RPC buffers cached for one RPC size must not be reused for larger
+	# RPCs after max_pages_per_rpc grows
+	for pages in 16 256 64 1024; do
+		$LCTL set_param $osc.max_pages_per_rpc=$pages ||
+			error "set max_pages_per_rpc=$pages failed"
+		cancel_lru_locks osc
+		dd if=$TMP/$tfile of=$DIR/$tfile bs=4M conv=fsync ||
+			error "write with $pages pages per RPC failed"
+		cancel_lru_locks osc
+		cmp $TMP/$tfile $DIR/$tfile ||
+			error "data differs with $pages pages per RPC"
+	done
+}
+run_test 436 "BRW RPCs with changing max_pages_per_rpc"
+
+test_437() {
+	local osc=$($LCTL list_param osc.$FSNAME-OST0000-osc-[^M]* |
+		    head -n 1)
+	local max
+	local limit
+
+	$LCTL get_param $osc.max_rpcs_in_flight_auto ||
+		error "no max_rpcs_in_flight_auto parameter"
+
+	max=$($LCTL get_param -n $osc.max_rpcs_in_flight)
+	stack_trap "$LCTL set_param $osc.max_rpcs_in_flight_auto=0"
+	$LCTL set_param $osc.max_rpcs_in_flight_auto=1
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile
+	stack_trap "rm -f $DIR/$tfile"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=256 conv=fsync ||
+		error "write failed"
+	cancel_lru_locks osc
+	dd if=$DIR/$tfile of=/dev/null bs=1M || error "read failed"
+
+	limit=$($LCTL get_param -n $osc.cur_rpcs_in_flight_limit)
+	echo "RPCs in flight limit $limit, max $max"
+	(( limit >= 1 && limit <= max )) ||
+		error "limit $limit out of [1, $max]"
+
+	$LCTL set_param $osc.max_rpcs_in_flight_auto=0
+	limit=$($LCTL get_param -n $osc.cur_rpcs_in_flight_limit)
+	(( limit == max )) || error "limit $limit != $max when disabled"
+}
+run_test 437 "adaptive RPCs in flight stays within max_rpcs_in_flight"
+
+test_439() {
+	local osc=$($LCTL list_param osc.$FSNAME-OST0000-osc-[^M]* |
+		    head -n 1)
+	local nr
+
+	$LCTL get_param $osc.keep_stale_pages ||
+		error "no keep_stale_pages parameter"
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile
+	stack_trap "rm -f $DIR/$tfile $TMP/$tfile $TMP/$tfile.blk"
+	dd if=/dev/urandom of=$TMP/$tfile bs=1M count=4 ||
+		error "cannot create $TMP/$tfile"
+	cp $TMP/$tfile $DIR/$tfile || error "cannot copy $tfile"
+	cancel_lru_locks osc
+
+	stack_trap "$LCTL set_param $osc.keep_stale_pages=0"
+	$LCTL set_param $osc.keep_stale_pages=1
+	cat $DIR/$tfile > /dev/null || error "read failed"
+	$LCTL set_param $osc.stats=clear
+	cancel_lru_locks osc
+
+	# unchanged data is revalidated instead of being read again, with the
+	# data version of the lock, neither the cancel nor the read asks for it
+	cmp $TMP/$tfile $DIR/$tfile || error "data mismatch after revalidation"
+	$LCTL get_param $osc.stats
+	nr=$($LCTL get_param -n $osc.stats | awk '/ost_read/ { print $2 }')
+	(( ${nr:-0} == 0 )) || error "$nr read RPCs for unchanged data"
+	nr=$($LCTL get_param -n $osc.stats | awk '/ost_getattr/ { print $2 }')
+	(( ${nr:-0} == 0 )) || error "$nr getattr RPCs to keep pages"
+	cancel_lru_locks osc
+
+	# modified data is read again
+	dd if=/dev/urandom of=$TMP/$tfile.blk bs=4k count=1 ||
+		error "cannot create $TMP/$tfile.blk"
+	dd if=$TMP/$tfile.blk of=$TMP/$tfile bs=4k seek=2 conv=notrunc ||
+		error "cannot update $TMP/$tfile"
+	dd if=$TMP/$tfile.blk of=$DIR/$tfile bs=4k seek=2 conv=notrunc \
+		oflag=direct || error "cannot update $DIR/$tfile"
+	cancel_lru_locks osc
+	$LCTL set_param $osc.stats=clear
+	cmp $TMP/$tfile $DIR/$tfile || error "stale data after modification"
+	nr=$($LCTL get_param -n $osc.stats | awk '/ost_read/ { print $2 }')
+	(( ${nr:-0} > 0 )) || error "modified data not read again"
+}
+run_test 439 "clean pages are revalidated after lock cancel"
+
 test_440() {
 	if [[ -f $LUSTRE/scripts/bash-completion/lustre ]]; then
 		source $LUSTRE/scripts/bash-completion/lustre
@@ -29660,6 +30378,29 @@ test_440() {
 }
 run_test 440 "bash completion for lfs, lctl"
 
+test_441() {
+	local module=$LUSTRE/tests/kernel/kptlrpc_intake.ko
+	local run_id
+	local rate
+	local mode
+	local lock
+
+	[[ -f $module ]] || skip "Need MODULES build"
+
+	for lock in 0 1; do
+		run_id=$RANDOM
+		# the module always fails to load once the benchmark is done
+		insmod $module run_id=$run_id count=100000 lock=$lock \
+			&> /dev/null
+		rate=$(dmesg | grep "lustre_kptlrpc_intake_$run_id:" |
+		       grep -o "[0-9]* requests/s/core")
+		[[ -n "$rate" ]] || error "no result for lock=$lock"
+		(( lock )) && mode="spinlock list" || mode="intake queues"
+		echo "$mode: $rate"
+	done
+}
+run_test 441 "ptlrpc request intake queues microbenchmark"
+
 prep_801() {
 	[[ $MDS1_VERSION -lt $(version_code 2.9.55) ]] ||
 	[[ $OST1_VERSION -lt $(version_code 2.9.55) ]] &&
@@ -5047,6 +5047,194 @@ test_77r() { #LU-14976
 }
 run_test 77r "Change type of tbf policy at run time"
 
+# samples of write RPCs of job $1 in the job_stats of OST0000
+wfq_write_samples() {
+	do_facet ost1 $LCTL get_param -n \
+		obdfilter.$FSNAME-OST0000.job_stats |
+		awk -v job=$1 '$1 == "-" && $2 == "job_id:" { f = ($3 == job) }
+			       f && $1 == "write_bytes:" { sub(",", "", $4);
+							   n = $4 }
+			       END { print n + 0 }'
+}
+
+# check that backlogged job classes get ost_io in proportion to their weights
+wfq_verify_share() {
+	local oss=$(comma_list $(osts_nodes))
+	local np=$(check_cpt_number ost1)
+	local dir=$DIR/$tdir
+	local tmin
+	local tmax
+	local pids=""
+	local root
+	local user
+	local i
+
+	(( np > 0 )) || error "CPU partitions should not be $np."
+	tmin=$(do_facet ost1 $LCTL get_param -n ost.OSS.ost_io.threads_min)
+	tmax=$(do_facet ost1 $LCTL get_param -n ost.OSS.ost_io.threads_max)
+	stack_trap "do_facet ost1 $LCTL set_param \
+		ost.OSS.ost_io.threads_max=$tmax \
+		ost.OSS.ost_io.threads_min=$tmin"
+	# few service threads, so that the requests of both jobs queue up
+	do_facet ost1 $LCTL set_param ost.OSS.ost_io.threads_min=$((np * 2)) \
+		ost.OSS.ost_io.threads_max=$((np * 2)) ||
+		error "failed to limit ost_io threads"
+
+	do_nodes $oss $LCTL set_param \
+		ost.OSS.ost_io.nrs_policies="wfq\ jobid" ||
+		error "failed to set WFQ jobid policy"
+	do_nodes $oss $LCTL set_param \
+		ost.OSS.ost_io.nrs_wfq_weight="dd.$RUNAS_ID\ 4" \
+		ost.OSS.ost_io.nrs_wfq_weight="reg\ default\ 1" ||
+		error "failed to set WFQ weights"
+
+	mkdir $dir || error "mkdir $dir failed"
+	$LFS setstripe -c 1 -i 0 $dir || error "setstripe $dir failed"
+	chmod 777 $dir
+	stack_trap "rm -rf $dir"
+
+	# #define OBD_FAIL_PTLRPC_PAUSE_REQ	0x50a
+	do_facet ost1 $LCTL set_param fail_loc=0x50a fail_val=20
+	stack_trap "do_facet ost1 $LCTL set_param fail_loc=0 fail_val=0"
+	do_facet ost1 $LCTL set_param obdfilter.$FSNAME-OST0000.job_stats=clear
+
+	# each job keeps the RPC slots of its own mount busy
+	for ((i = 0; i < 8; i++)); do
+		dd if=/dev/zero of=$dir/root.$i bs=4k count=100000 \
+			oflag=direct 2>/dev/null &
+		pids+=" $!"
+		$RUNAS dd if=/dev/zero of=$DIR2/$tdir/user.$i bs=4k \
+			count=100000 oflag=direct 2>/dev/null &
+		pids+=" $!"
+	done
+	sleep 20
+	kill $pids
+	wait
+	do_facet ost1 $LCTL set_param fail_loc=0 fail_val=0
+
+	root=$(wfq_write_samples dd.0)
+	user=$(wfq_write_samples dd.$RUNAS_ID)
+	echo "write RPCs: dd.0 (weight 1) $root, dd.$RUNAS_ID (weight 4) $user"
+	(( root > 0 )) || error "job dd.0 starved"
+	# allow for the RPCs sent before the queues filled up and after
+	(( user >= root * 2 && user <= root * 8 )) ||
+		error "share $user/$root of dd.$RUNAS_ID/dd.0 is not about 4"
+}
+
+test_77s() {
+	(( $OST1_VERSION >= $(version_code 2.15.59) )) ||
+		skip "Need OST version at least 2.15.59 for WFQ"
+
+	local oss=$(comma_list $(osts_nodes))
+	local policy
+	local weights
+
+	# Configure jobid_var
+	local saved_jobid_var=$($LCTL get_param -n jobid_var)
+	if [ $saved_jobid_var != procname_uid ]; then
+		set_persistent_param_and_check client \
+			"jobid_var" "$FSNAME.sys.jobid_var" procname_uid
+		stack_trap "set_persistent_param_and_check client \
+			jobid_var $FSNAME.sys.jobid_var $saved_jobid_var"
+	fi
+	stack_trap "do_nodes $oss $LCTL set_param \
+		ost.OSS.ost_io.nrs_policies=fifo"
+
+	for policy in "jobid dd.$RUNAS_ID" "uid $RUNAS_ID" "gid $RUNAS_GID"; do
+		local key=${policy#* }
+
+		do_nodes $oss $LCTL set_param \
+			ost.OSS.ost_io.nrs_policies="wfq\ ${policy% *}" ||
+			error "failed to set WFQ ${policy% *} policy"
+		do_nodes $oss $LCTL set_param \
+			ost.OSS.ost_io.nrs_wfq_weight="$key\ 4" \
+			ost.OSS.ost_io.nrs_wfq_weight="reg\ default\ 2" ||
+			error "failed to set WFQ weights"
+
+		weights=$(do_facet ost1 $LCTL get_param -n \
+			  ost.OSS.ost_io.nrs_wfq_weight)
+		echo "$weights"
+		grep -q "^$key 4$" <<< "$weights" ||
+			error "weight of $key not set"
+		grep -q "^default 2$" <<< "$weights" ||
+			error "default weight not set"
+		nrs_write_read "$RUNAS"
+
+		# a weight of 0 drops the weight of the class
+		do_nodes $oss $LCTL set_param \
+			ost.OSS.ost_io.nrs_wfq_weight="$key\ 0" ||
+			error "failed to drop weight of $key"
+		do_facet ost1 $LCTL get_param -n \
+			ost.OSS.ost_io.nrs_wfq_weight | grep "^$key " &&
+			error "weight of $key not dropped"
+		nrs_write_read "$RUNAS"
+	done
+
+	do_nodes $oss $LCTL set_param \
+		ost.OSS.ost_io.nrs_policies="wfq\ projid" ||
+		error "failed to set WFQ projid policy"
+	nrs_write_read "$RUNAS"
+
+	wfq_verify_share
+
+	do_nodes $oss $LCTL set_param ost.OSS.ost_io.nrs_policies="fifo" ||
+		error "failed to set policy back to fifo"
+}
+run_test 77s "check WFQ NRS policy"
+
+test_77t() {
+	(( $OST1_VERSION >= $(version_code 2.15.58) )) ||
+		skip "Need OST version at least 2.15.58"
+
+	local oss=$(comma_list $(osts_nodes))
+	local nrules=100
+	local params=""
+	local stats
+	local i
+
+	# Configure jobid_var
+	local saved_jobid_var=$($LCTL get_param -n jobid_var)
+	if [ $saved_jobid_var != procname_uid ]; then
+		set_persistent_param_and_check client \
+			"jobid_var" "$FSNAME.sys.jobid_var" procname_uid
+		stack_trap "set_persistent_param_and_check client \
+			jobid_var $FSNAME.sys.jobid_var $saved_jobid_var"
+	fi
+	stack_trap "do_nodes $oss $LCTL set_param \
+		ost.OSS.ost_io.nrs_policies=fifo"
+
+	do_nodes $oss $LCTL set_param ost.OSS.ost_io.nrs_policies="tbf" ||
+		error "failed to set TBF policy"
+
+	# Only operate rules on ost1 since OSTs might run on the same OSS
+	for ((i = 0; i < nrules; i++)); do
+		params+=" ost.OSS.ost_io.nrs_tbf_rule=start\\ job$i\\ jobid={job$i.0}\\ rate=$((1000 + i))"
+	done
+	do_facet ost1 $LCTL set_param $params ||
+		error "failed to start $nrules TBF rules"
+	tbf_rule_operate ost1 "start\ uid\ uid={$RUNAS_ID}\&opcode={ost_write}\ rate=500"
+	tbf_rule_operate ost1 "start\ nid\ nid={*.*.*.*@$NETTYPE}\ rate=400"
+	# wildcards cannot be indexed, the rule is checked for every client
+	tbf_rule_operate ost1 "start\ wildcard\ jobid={dd.*}\ rate=300"
+	# the newest matching rules are still the ones selected
+	tbf_rule_operate ost1 "start\ ext_w\ jobid={dd.$RUNAS_ID}\&opcode={ost_write}\ rate=20"
+	tbf_rule_operate ost1 "start\ ext_r\ jobid={dd.$RUNAS_ID}\&opcode={ost_read}\ rate=10"
+	nrs_write_read "$RUNAS"
+	tbf_verify 20 10 "$RUNAS"
+
+	stats=$(do_facet ost1 $LCTL get_param -n \
+		ost.OSS.ost_io.nrs_tbf_index_stats)
+	echo "$stats"
+	awk '/^CPT/ { lookups += $4; checks += $6; unindexed = $8 }
+	     END { if (lookups == 0 || unindexed != 1 || checks > 8 * lookups)
+			exit 1 }' <<< "$stats" ||
+		error "clients not classified by the rule index"
+
+	do_nodes $oss $LCTL set_param ost.OSS.ost_io.nrs_policies="fifo" ||
+		error "failed to set policy back to fifo"
+}
+run_test 77t "check TBF rules are indexed"
+
 test_78() { #LU-6673
 	local rc
 
@@ -197,6 +197,8 @@ static inline int lfs_mirror_delete(int argc, char **argv)
 #define SSM_CMD_COMMON(cmd) \
 	"usage: "cmd" [--component-end|-E COMP_END]\n"			\
 	"                 [--copy=LUSTRE_SRC]\n"			\
+	"                 [--compress TYPE[:LEVEL]]\n"			\
+	"                 [--compress-chunk CHUNK_SIZE]\n"		\
 	"                 [--extension-size|--ext-size|-z SIZE]\n"	\
 	"                 [--help|-h] [--layout|-L PATTERN]\n"		\
 	"                 [--layout|-L PATTERN]\n"			\
@@ -425,8 +427,8 @@ command_t cmdlist[] = {
 	 "     [[!] --projid <projid>] [[!] --size|-s [+-]N[bkMGTPE]]\n"
 	 "     [[!] --stripe-count|-c [+-]<stripes>]\n"
 	 "     [[!] --stripe-index|-i <index,...>]\n"
-	 "     [[!] --stripe-size|-S [+-]N[kMGT]] [[!] --type|-t <filetype>]\n"
-	 "     [[!] --uid|-u|--user|-U <uid>|<uname>]\n"
+	 "     [[!] --stripe-size|-S [+-]N[kMGT]] [--threads|-j N]\n"
+	 "     [[!] --type|-t <filetype>] [[!] --uid|-u|--user|-U <uid>|<uname>]\n"
 	 "\t !: used before an option indicates 'NOT' requested attribute\n"
 	 "\t -: used before a value indicates less than requested value\n"
 	 "\t +: used before a value indicates more than requested value\n"
@@ -2699,6 +2701,9 @@ struct lfs_setstripe_args {
 	__u32			 lsa_comp_flags;
 	__u32			 lsa_comp_neg_flags;
 	unsigned long long	 lsa_pattern;
+	unsigned int		 lsa_compr_type;
+	unsigned int		 lsa_compr_lvl;
+	unsigned long long	 lsa_compr_chunk;
 	unsigned int		 lsa_mirror_count;
 	int			 lsa_nr_tgts;
 	bool			 lsa_first_comp;
@@ -2756,6 +2761,7 @@ static inline bool setstripe_args_specified(struct lfs_setstripe_args *lsa)
 		lsa->lsa_stripe_count != LLAPI_LAYOUT_DEFAULT ||
 		lsa->lsa_stripe_off != LLAPI_LAYOUT_DEFAULT ||
 		lsa->lsa_pattern != LLAPI_LAYOUT_RAID0 ||
+		lsa->lsa_compr_type != LL_COMPR_TYPE_NONE ||
 		lsa->lsa_comp_end != 0);
 }
 
@@ -2943,6 +2949,20 @@ new_comp:
 		}
 	}
 
+	if (lsa->lsa_compr_type != LL_COMPR_TYPE_NONE) {
+		rc = llapi_layout_compress_set(layout, lsa->lsa_compr_type,
+					       lsa->lsa_compr_lvl,
+					       lsa->lsa_compr_chunk);
+		if (rc) {
+			fprintf(stderr,
+				"Set compression %s:%u chunk %llu failed. %s\n",
+				llapi_compress_type2name(lsa->lsa_compr_type),
+				lsa->lsa_compr_lvl, lsa->lsa_compr_chunk,
+				strerror(errno));
+			return rc;
+		}
+	}
+
 	size = lsa->lsa_comp_flags & LCME_FL_EXTENSION ?
 		lsa->lsa_extension_size : lsa->lsa_stripe_size;
 
@@ -3524,7 +3544,9 @@ enum {
 	LFS_STATS_OPT,
 	LFS_STATS_INTERVAL_OPT,
 	LFS_LINKS_OPT,
-	LFS_ATTRS_OPT
+	LFS_ATTRS_OPT,
+	LFS_COMPRESS_OPT,
+	LFS_COMPRESS_CHUNK_OPT,
 };
 
 #ifndef LCME_USER_MIRROR_FLAGS
@@ -3608,6 +3630,11 @@ static int lfs_setstripe_internal(int argc, char **argv,
 						.has_arg = no_argument},
 	{ .val = LFS_COMP_NO_VERIFY_OPT,
 			.name = "no-verify",	.has_arg = no_argument},
+	{ .val = LFS_COMPRESS_OPT,
+			.name = "compress",	.has_arg = required_argument},
+	{ .val = LFS_COMPRESS_CHUNK_OPT,
+			.name = "compress-chunk",
+						.has_arg = required_argument},
 	{ .val = LFS_LAYOUT_FLAGS_OPT,
 			.name = "flags",	.has_arg = required_argument},
 	{ .val = LFS_LAYOUT_FOREIGN_OPT,
@@ -3724,6 +3751,52 @@ static int lfs_setstripe_internal(int argc, char **argv,
 		case LFS_COMP_NO_VERIFY_OPT:
 			mirror_flags |= MF_NO_VERIFY;
 			break;
+		case LFS_COMPRESS_OPT: {
+			char *lvl = strchr(optarg, ':');
+			int type;
+
+			if (lvl)
+				*lvl++ = '\0';
+			type = llapi_compress_name2type(optarg);
+			if (type <= LL_COMPR_TYPE_NONE) {
+				fprintf(stderr,
+					"%s %s: invalid compression type '%s', expect lz4 or zstd\n",
+					progname, argv[0], optarg);
+				goto usage_error;
+			}
+			lsa.lsa_compr_type = type;
+			lsa.lsa_compr_lvl = 0;
+			if (lvl) {
+				errno = 0;
+				lsa.lsa_compr_lvl = strtoul(lvl, &end, 0);
+				if (errno != 0 || *end != '\0' || end == lvl ||
+				    lsa.lsa_compr_lvl > COMPR_LEVEL_MAX) {
+					fprintf(stderr,
+						"%s %s: invalid compression level '%s', expect 0-%u\n",
+						progname, argv[0], lvl,
+						COMPR_LEVEL_MAX);
+					goto usage_error;
+				}
+			}
+			break;
+		}
+		case LFS_COMPRESS_CHUNK_OPT:
+			size_units = 1;
+			result = llapi_parse_size(optarg, &lsa.lsa_compr_chunk,
+						  &size_units, 0);
+			/* assume units of KB if too small to be valid */
+			if (lsa.lsa_compr_chunk < 4096)
+				lsa.lsa_compr_chunk *= 1024;
+			if (result ||
+			    lsa.lsa_compr_chunk < 1ULL << COMPR_CHUNK_MIN_BITS ||
+			    lsa.lsa_compr_chunk > 1ULL << COMPR_CHUNK_MAX_BITS ||
+			    lsa.lsa_compr_chunk & (lsa.lsa_compr_chunk - 1)) {
+				fprintf(stderr,
+					"%s %s: invalid compression chunk size '%s', expect a power of two from 64KiB to 4MiB\n",
+					progname, argv[0], optarg);
+				goto usage_error;
+			}
+			break;
 		case LFS_MIRROR_ID_OPT: {
 			unsigned long int id;
 
@@ -4439,6 +4512,13 @@ static int lfs_setstripe_internal(int argc, char **argv,
 		if (lsa_args_stripe_count_check(&lsa))
 			goto usage_error;
 
+		if (lsa.lsa_compr_type != LL_COMPR_TYPE_NONE) {
+			fprintf(stderr,
+				"%s %s: --compress needs a composite layout, use -E\n",
+				progname, argv[0]);
+			goto usage_error;
+		}
+
 		/* initialize stripe parameters */
 		param = calloc(1, offsetof(typeof(*param),
 			       lsp_osts[lsa.lsa_nr_tgts]));
@@ -5191,6 +5271,7 @@ static int lfs_find(int argc, char **argv)
 	{ .val = 'i',	.name = "stripe-index",	.has_arg = required_argument },
 	{ .val = 'i',	.name = "stripe_index",	.has_arg = required_argument },
 /* getstripe { .val = 'I', .name = "comp-id",	.has_arg = required_argument }*/
+	{ .val = 'j',	.name = "threads",	.has_arg = required_argument },
 	{ .val = 'l',	.name = "lazy",		.has_arg = no_argument },
 	{ .val = 'L',	.name = "layout",	.has_arg = required_argument },
 	{ .val = LFS_LINKS_OPT,
@@ -5246,7 +5327,7 @@ static int lfs_find(int argc, char **argv)
 
 	/* when getopt_long_only() hits '!' it returns 1, puts "!" in optarg */
 	while ((c = getopt_long_only(argc, argv,
-		"-0A:b:B:c:C:D:E:g:G:hH:i:lL:m:M:n:N:O:Ppqrs:S:t:T:u:U:z:",
+		"-0A:b:B:c:C:D:E:g:G:hH:i:j:lL:m:M:n:N:O:Ppqrs:S:t:T:u:U:z:",
 		long_opts, &optidx)) >= 0) {
 		xtime = NULL;
 		xsign = NULL;
@@ -5693,6 +5774,19 @@ static int lfs_find(int argc, char **argv)
 				param.fp_check_hash_flag = 1;
 			param.fp_exclude_hash_type = !!neg_opt;
 			break;
+		case 'j':
+			errno = 0;
+			param.fp_thread_count = strtoul(optarg, &endptr, 0);
+			if (errno != 0 || *endptr != '\0' ||
+			    param.fp_thread_count < 1 ||
+			    param.fp_thread_count > 1024) {
+				fprintf(stderr,
+					"error: bad thread count '%s'\n",
+					optarg);
+				ret = -1;
+				goto err;
+			}
+			break;
 		case 'l':
 			param.fp_lazy = 1;
 			break;
@@ -74,6 +74,7 @@
 #include <pthread.h>
 
 #include <libcfs/util/ioctl.h>
+#include <libcfs/util/list.h>
 #include <libcfs/util/param.h>
 #include <libcfs/util/string.h>
 #include <linux/lnet/lnetctl.h>
@@ -179,6 +180,64 @@ static void info_callback_default(enum llapi_message_level level, int err,
 static llapi_log_callback_t llapi_error_callback = error_callback_default;
 static llapi_log_callback_t llapi_info_callback = info_callback_default;
 
+/*
+ * Output of llapi_printf() kept by the calling thread, so that the threads
+ * of a parallel llapi_find() write their output in large blocks instead of
+ * interleaving single lines, see find_work_flush().
+ */
+struct llapi_outbuf {
+	char	*ob_buf;
+	size_t	 ob_len;
+	size_t	 ob_size;
+};
+
+#define LLAPI_OUTBUF_FLUSH	(1024 * 1024)
+
+static __thread struct llapi_outbuf *llapi_thread_outbuf;
+
+static void llapi_outbuf_flush(struct llapi_outbuf *ob)
+{
+	if (ob->ob_len == 0)
+		return;
+
+	/* stdio locks the stream for the whole write */
+	fwrite(ob->ob_buf, 1, ob->ob_len, stdout);
+	ob->ob_len = 0;
+}
+
+static void llapi_outbuf_vprintf(struct llapi_outbuf *ob, const char *fmt,
+				 va_list ap)
+{
+	va_list aq;
+	int len;
+
+	va_copy(aq, ap);
+	len = vsnprintf(ob->ob_buf + ob->ob_len, ob->ob_size - ob->ob_len,
+			fmt, aq);
+	va_end(aq);
+	if (len < 0)
+		return;
+
+	if (ob->ob_len + len >= ob->ob_size) {
+		size_t size = max(2 * ob->ob_size, ob->ob_len + len + 1);
+		char *buf = realloc(ob->ob_buf, size);
+
+		if (buf == NULL) {
+			llapi_outbuf_flush(ob);
+			vfprintf(stdout, fmt, ap);
+			return;
+		}
+		ob->ob_buf = buf;
+		ob->ob_size = size;
+		vsnprintf(ob->ob_buf + ob->ob_len, ob->ob_size - ob->ob_len,
+			  fmt, ap);
+	}
+	ob->ob_len += len;
+
+	if (ob->ob_len >= LLAPI_OUTBUF_FLUSH)
+		llapi_outbuf_flush(ob);
+}
+
 
 /* llapi_error will preserve errno */
 void llapi_error(enum llapi_message_level level, int err, const char *fmt, ...)
@@ -205,7 +264,11 @@ void llapi_printf(enum llapi_message_level level, const char *fmt, ...)
 		return;
 
 	va_start(args, fmt);
-	llapi_info_callback(level, 0, fmt, args);
+	if (llapi_thread_outbuf != NULL &&
+	    llapi_info_callback == info_callback_default)
+		llapi_outbuf_vprintf(llapi_thread_outbuf, fmt, args);
+	else
+		llapi_info_callback(level, 0, fmt, args);
 	va_end(args);
 	errno = tmp_errno;
 }
@@ -1844,6 +1907,131 @@ retry_getfileinfo:
 	return ret;
 }
 
+/*
+ * Parallel walk of the directory tree for llapi_find(), see find_parallel().
+ *
+ * Each directory to walk is a work item, queued on the queue of the MDT
+ * holding its entries, and every thread has a home queue it takes the newest
+ * item of, so that it keeps walking down the same subtree, before taking the
+ * oldest item of another queue, i.e. the largest subtree left over there.
+ * The subdirectories found while walking a directory are only queued once
+ * the output of that directory has been written, so that the path of a
+ * directory is always printed before the paths under it.
+ */
+struct find_work_item {
+	struct list_head	fwi_list;
+	int			fwi_queue;
+	int			fwi_depth;
+	unsigned char		fwi_type;	/* d_type from readdir */
+	char			fwi_path[];
+};
+
+struct find_work {
+	pthread_mutex_t		 fw_lock;
+	pthread_cond_t		 fw_cond;
+	struct list_head	*fw_queues;	/* one per MDT */
+	int			 fw_queue_count;
+	int			 fw_busy;	/* threads walking a directory */
+	bool			 fw_stop;
+	int			 fw_rc;		/* first error */
+};
+
+struct find_worker {
+	struct find_param	 fwr_param;
+	struct find_work	*fwr_work;
+	pthread_t		 fwr_thread;
+	bool			 fwr_started;
+	int			 fwr_home;	/* queue looked at first */
+	int			 fwr_queue;	/* queue of the directory */
+	struct lmv_user_md	*fwr_lmv;	/* stripes of the directory */
+	int			 fwr_next_stripe;
+	struct list_head	 fwr_pending;	/* subdirectories found */
+	int			 fwr_pending_count;
+	struct llapi_outbuf	 fwr_out;
+	char			*fwr_path;
+};
+
+/* stripes of a directory looked at to spread its subdirectories */
+#define FIND_WORK_STRIPES	256
+/* subdirectories found before the output of a large directory is flushed */
+#define FIND_WORK_PENDING	1024
+
+static void find_work_flush(struct find_worker *fwr)
+{
+	struct find_work *fw = fwr->fwr_work;
+	struct find_work_item *item, *tmp;
+
+	llapi_outbuf_flush(&fwr->fwr_out);
+	if (list_empty(&fwr->fwr_pending))
+		return;
+
+	pthread_mutex_lock(&fw->fw_lock);
+	list_for_each_entry_safe(item, tmp, &fwr->fwr_pending, fwi_list)
+		list_move(&item->fwi_list, &fw->fw_queues[item->fwi_queue]);
+	pthread_cond_broadcast(&fw->fw_cond);
+	pthread_mutex_unlock(&fw->fw_lock);
+	fwr->fwr_pending_count = 0;
+}
+
+/* the directory @d is about to be read, find the MDTs of its entries */
+static void find_work_dir(struct find_param *param, int d)
+{
+	struct find_worker *fwr = container_of(param, struct find_worker,
+					       fwr_param);
+	struct find_work *fw = fwr->fwr_work;
+	struct lmv_user_md *lmv = fwr->fwr_lmv;
+	int tmp_errno = errno;
+	int mdt;
+
+	lmv->lum_stripe_count = 0;
+	fwr->fwr_next_stripe = 0;
+	if (fw->fw_queue_count == 1)
+		return;
+
+	if (llapi_file_fget_mdtidx(d, &mdt) == 0)
+		fwr->fwr_queue = mdt % fw->fw_queue_count;
+
+	lmv->lum_magic = LMV_MAGIC_V1;
+	lmv->lum_stripe_count = FIND_WORK_STRIPES;
+	if (ioctl(d, LL_IOC_LMV_GETSTRIPE, lmv) < 0 ||
+	    lmv_is_foreign(lmv->lum_magic) ||
+	    lmv->lum_stripe_count > FIND_WORK_STRIPES)
+		lmv->lum_stripe_count = 0;
+	errno = tmp_errno;
+}
+
+/* queue the subdirectory @path of the directory being walked */
+static int find_work_add(struct find_param *param, const char *path,
+			 unsigned char type)
+{
+	struct find_worker *fwr = container_of(param, struct find_worker,
+					       fwr_param);
+	struct lmv_user_md *lmv = fwr->fwr_lmv;
+	struct find_work_item *item;
+	size_t len = strlen(path) + 1;
+
+	item = malloc(sizeof(*item) + len);
+	if (item == NULL)
+		return -ENOMEM;
+
+	/* the entries of a striped directory are spread over its stripes */
+	if (lmv->lum_stripe_count > 1)
+		item->fwi_queue = lmv->lum_objects[fwr->fwr_next_stripe++ %
+						   lmv->lum_stripe_count].lum_mds %
+				  fwr->fwr_work->fw_queue_count;
+	else
+		item->fwi_queue = fwr->fwr_queue;
+	item->fwi_depth = param->fp_depth;
+	item->fwi_type = type;
+	memcpy(item->fwi_path, path, len);
+	list_add_tail(&item->fwi_list, &fwr->fwr_pending);
+
+	if (++fwr->fwr_pending_count >= FIND_WORK_PENDING)
+		find_work_flush(fwr);
+
+	return 0;
+}
+
 static int llapi_semantic_traverse(char *path, int size, int parent,
 				   semantic_func_t sem_init,
 				   semantic_func_t sem_fini, void *data,
@@ -1928,6 +2116,9 @@ static int llapi_semantic_traverse(char *path, int size, int parent,
 	if (d == -1)
 		goto out;
 
+	if (param->fp_parallel)
+		find_work_dir(param, d);
+
 	dir = fdopendir(d);
 	if (dir == NULL) {
 		/* ENOTDIR if fake symlink, do not consider it as an error */
@@ -1977,6 +2168,12 @@ static int llapi_semantic_traverse(char *path, int size, int parent,
 					  __func__, dent->d_name, dent->d_type);
 			break;
 		case DT_DIR:
+			if (param->fp_parallel) {
+				rc = find_work_add(param, path, dent->d_type);
+				if (rc != 0 && ret == 0)
+					ret = rc;
+				break;
+			}
 			rc = llapi_semantic_traverse(path, size, d, sem_init,
 						     sem_fini, data, dent);
 			if (rc != 0 && ret == 0)
@@ -2582,6 +2779,12 @@ static char *layout2name(__u32 layout_pattern)
 	else if (layout_pattern ==
 			(LOV_PATTERN_RAID0 | LOV_PATTERN_OVERSTRIPING))
 		return "raid0,overstriped";
+	else if (layout_pattern == (LOV_PATTERN_RAID0 | LOV_PATTERN_COMPRESS))
+		return "raid0,compress";
+	else if (layout_pattern == (LOV_PATTERN_RAID0 |
+				    LOV_PATTERN_OVERSTRIPING |
+				    LOV_PATTERN_COMPRESS))
+		return "raid0,overstriped,compress";
 	else
 		return "unknown";
 }
@@ -3189,6 +3392,9 @@ static void lov_dump_comp_v1_entry(struct find_param *param,
 	char *separator = "";
 	enum llapi_layout_verbose verbose = param->fp_verbose;
 	bool yaml = flags & LDF_YAML;
+	/* fields only shown with the whole layout, not for a single option */
+	bool full = yaml || verbose & VERBOSE_DETAIL ||
+		    (verbose & VERBOSE_DEFAULT) == VERBOSE_DEFAULT;
 
 	entry = &comp_v1->lcm_entries[index];
 
@@ -3274,6 +3480,22 @@ static void lov_dump_comp_v1_entry(struct find_param *param,
 		separator = "\n";
 	}
 
+	/* print compression parameters if this is a compressed comp, not
+	 * with "-L" alone so that it still prints only the pattern
+	 */
+	if (full && entry->lcme_compr_type) {
+		llapi_printf(LLAPI_MSG_NORMAL, "%s", separator);
+		llapi_printf(LLAPI_MSG_NORMAL, "%4slcme_compr_type:     %s\n",
+			     " ",
+			     llapi_compress_type2name(entry->lcme_compr_type));
+		llapi_printf(LLAPI_MSG_NORMAL, "%4slcme_compr_lvl:      %u\n",
+			     " ", entry->lcme_compr_lvl);
+		llapi_printf(LLAPI_MSG_NORMAL, "%4slcme_compr_chunk_kb: %u",
+			     " ", 1U << (COMPR_CHUNK_MIN_BITS - 10 +
+					 entry->lcme_compr_chunk_log_bits));
+		separator = "\n";
+	}
+
 	if (yaml) {
 		llapi_printf(LLAPI_MSG_NORMAL, "%s", separator);
 		llapi_printf(LLAPI_MSG_NORMAL, "%4ssub_layout:\n", " ");
@@ -6092,10 +6314,238 @@ void validate_printf_str(struct find_param *param)
 	}
 }
 
+static struct find_work_item *find_work_get(struct find_worker *fwr)
+{
+	struct find_work *fw = fwr->fwr_work;
+	struct find_work_item *item = NULL;
+	int i;
+
+	pthread_mutex_lock(&fw->fw_lock);
+	while (!fw->fw_stop) {
+		for (i = 0; i < fw->fw_queue_count; i++) {
+			struct list_head *queue;
+
+			queue = &fw->fw_queues[(fwr->fwr_home + i) %
+					       fw->fw_queue_count];
+			if (list_empty(queue))
+				continue;
+
+			if (i == 0)
+				item = list_first_entry(queue,
+							struct find_work_item,
+							fwi_list);
+			else
+				item = list_last_entry(queue,
+						       struct find_work_item,
+						       fwi_list);
+			list_del(&item->fwi_list);
+			break;
+		}
+
+		if (item != NULL) {
+			fw->fw_busy++;
+			break;
+		}
+
+		/* nothing queued and nobody left to queue anything */
+		if (fw->fw_busy == 0) {
+			fw->fw_stop = true;
+			pthread_cond_broadcast(&fw->fw_cond);
+			break;
+		}
+		pthread_cond_wait(&fw->fw_cond, &fw->fw_lock);
+	}
+	pthread_mutex_unlock(&fw->fw_lock);
+
+	return item;
+}
+
+static void find_work_put(struct find_worker *fwr, int rc)
+{
+	struct find_work *fw = fwr->fwr_work;
+
+	find_work_flush(fwr);
+
+	pthread_mutex_lock(&fw->fw_lock);
+	fw->fw_busy--;
+	if (rc < 0 && fw->fw_rc == 0)
+		fw->fw_rc = rc;
+	if (rc < 0 && rc != -EALREADY && fwr->fwr_param.fp_stop_on_error)
+		fw->fw_stop = true;
+	if (fw->fw_busy == 0 || fw->fw_stop)
+		pthread_cond_broadcast(&fw->fw_cond);
+	pthread_mutex_unlock(&fw->fw_lock);
+}
+
+static void *find_worker_main(void *arg)
+{
+	struct find_worker *fwr = arg;
+	struct find_work_item *item;
+	int rc;
+
+	llapi_thread_outbuf = &fwr->fwr_out;
+	while ((item = find_work_get(fwr)) != NULL) {
+		struct dirent64 de = { .d_type = item->fwi_type };
+
+		fwr->fwr_queue = item->fwi_queue;
+		fwr->fwr_lmv->lum_stripe_count = 0;
+		fwr->fwr_param.fp_depth = item->fwi_depth;
+		snprintf(fwr->fwr_path, 2 * PATH_MAX, "%s", item->fwi_path);
+
+		/* the starting path has no dirent, as in param_callback() */
+		rc = llapi_semantic_traverse(fwr->fwr_path, 2 * PATH_MAX, -1,
+					     cb_find_init, cb_common_fini,
+					     &fwr->fwr_param,
+					     item->fwi_depth > 0 ? &de : NULL);
+		free(item);
+		find_work_put(fwr, rc);
+	}
+	llapi_thread_outbuf = NULL;
+
+	return NULL;
+}
+
+static void find_worker_fini(struct find_worker *fwr)
+{
+	find_param_fini(&fwr->fwr_param);
+	free(fwr->fwr_lmv);
+	free(fwr->fwr_path);
+	free(fwr->fwr_out.ob_buf);
+}
+
+static int find_worker_init(struct find_worker *fwr, struct find_param *param,
+			    struct find_work *fw, int index, char *path)
+{
+	int rc;
+
+	fwr->fwr_param = *param;
+	fwr->fwr_param.fp_parallel = 1;
+	/* allocated for every thread by common_param_init() */
+	fwr->fwr_param.fp_lmd = NULL;
+	fwr->fwr_param.fp_lmv_md = NULL;
+	fwr->fwr_param.fp_obd_indexes = NULL;
+	fwr->fwr_work = fw;
+	fwr->fwr_home = index % fw->fw_queue_count;
+	INIT_LIST_HEAD(&fwr->fwr_pending);
+
+	fwr->fwr_out.ob_size = 64 * 1024;
+	fwr->fwr_out.ob_buf = malloc(fwr->fwr_out.ob_size);
+	fwr->fwr_path = malloc(2 * PATH_MAX);
+	fwr->fwr_lmv = calloc(1, lmv_user_md_size(FIND_WORK_STRIPES,
+						  LMV_USER_MAGIC_SPECIFIC));
+	if (fwr->fwr_out.ob_buf == NULL || fwr->fwr_path == NULL ||
+	    fwr->fwr_lmv == NULL) {
+		find_worker_fini(fwr);
+		return -ENOMEM;
+	}
+
+	rc = common_param_init(&fwr->fwr_param, path);
+	if (rc != 0)
+		find_worker_fini(fwr);
+
+	return rc;
+}
+
+/*
+ * Walk the tree under @path with param->fp_thread_count threads, falling back
+ * to fewer threads, down to a serial walk, if they cannot all be started.
+ */
+static int find_parallel(char *path, struct find_param *param)
+{
+	struct find_work fw = {
+		.fw_lock = PTHREAD_MUTEX_INITIALIZER,
+		.fw_cond = PTHREAD_COND_INITIALIZER,
+	};
+	struct find_worker *workers = NULL;
+	struct find_work_item *item, *tmp;
+	size_t len = strlen(path);
+	int started = 0;
+	int i, rc;
+
+	if (len > PATH_MAX) {
+		rc = -EINVAL;
+		llapi_error(LLAPI_MSG_ERROR, rc,
+			    "Path name '%s' is too long", path);
+		return rc;
+	}
+
+	if (llapi_get_obd_count(path, &fw.fw_queue_count, 1) != 0 ||
+	    fw.fw_queue_count < 1)
+		fw.fw_queue_count = 1;
+
+	fw.fw_queues = calloc(fw.fw_queue_count, sizeof(*fw.fw_queues));
+	workers = calloc(param->fp_thread_count, sizeof(*workers));
+	item = malloc(sizeof(*item) + len + 1);
+	if (fw.fw_queues == NULL || workers == NULL || item == NULL) {
+		free(item);
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < fw.fw_queue_count; i++)
+		INIT_LIST_HEAD(&fw.fw_queues[i]);
+
+	item->fwi_queue = 0;
+	item->fwi_depth = 0;
+	item->fwi_type = DT_UNKNOWN;
+	memcpy(item->fwi_path, path, len + 1);
+	list_add(&item->fwi_list, &fw.fw_queues[0]);
+
+	for (i = 0; i < param->fp_thread_count; i++) {
+		struct find_worker *fwr = &workers[i];
+
+		rc = find_worker_init(fwr, param, &fw, i, path);
+		if (rc != 0)
+			break;
+
+		rc = pthread_create(&fwr->fwr_thread, NULL, find_worker_main,
+				    fwr);
+		if (rc != 0) {
+			rc = -rc;
+			find_worker_fini(fwr);
+			break;
+		}
+		fwr->fwr_started = true;
+		started++;
+	}
+
+	if (started == 0) {
+		list_del(&item->fwi_list);
+		free(item);
+		llapi_error(LLAPI_MSG_WARN, rc,
+			    "cannot start find threads, searching serially");
+		rc = param_callback(path, cb_find_init, cb_common_fini, param);
+		goto out;
+	}
+
+	for (i = 0; i < param->fp_thread_count; i++) {
+		if (!workers[i].fwr_started)
+			continue;
+		pthread_join(workers[i].fwr_thread, NULL);
+		find_worker_fini(&workers[i]);
+	}
+
+	/* left over when stopped on error */
+	for (i = 0; i < fw.fw_queue_count; i++) {
+		list_for_each_entry_safe(item, tmp, &fw.fw_queues[i],
+					 fwi_list) {
+			list_del(&item->fwi_list);
+			free(item);
+		}
+	}
+	rc = fw.fw_rc;
+out:
+	free(workers);
+	free(fw.fw_queues);
+	return rc < 0 ? rc : 0;
+}
+
 int llapi_find(char *path, struct find_param *param)
 {
 	if (param->fp_format_printf_str)
 		validate_printf_str(param);
+	if (param->fp_thread_count > 1)
+		return find_parallel(path, param);
 	return param_callback(path, cb_find_init, cb_common_fini, param);
 }
 
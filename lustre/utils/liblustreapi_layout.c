@@ -63,6 +63,9 @@ struct llapi_layout_comp {
 	uint32_t		llc_id;		/* unique ID of component */
 	uint32_t		llc_flags;	/* LCME_FL_* flags */
 	uint64_t		llc_timestamp;	/* snapshot timestamp */
+	uint8_t			llc_compr_type;	/* ll_compr_type */
+	uint8_t			llc_compr_lvl;	/* compression level */
+	uint8_t			llc_compr_chunk_log_bits; /* chunk size */
 	struct list_head	llc_list;	/* linked to the llapi_layout
 						   components list */
 	bool		llc_ondisk;
@@ -452,6 +455,7 @@ struct llapi_layout *llapi_layout_get_by_xattr(void *lov_xattr,
 	struct llapi_layout *layout = NULL;
 	struct llapi_layout_comp *comp;
 	int i, ent_count = 0, obj_count;
+	__u32 pattern;
 
 	if (lov_xattr == NULL || lov_xattr_size <= 0) {
 		errno = EINVAL;
@@ -544,6 +548,12 @@ struct llapi_layout *llapi_layout_get_by_xattr(void *lov_xattr,
 			comp->llc_flags = ent->lcme_flags;
 			if (comp->llc_flags & LCME_FL_NOSYNC)
 				comp->llc_timestamp = ent->lcme_timestamp;
+			if (v1->lmm_pattern & LOV_PATTERN_COMPRESS) {
+				comp->llc_compr_type = ent->lcme_compr_type;
+				comp->llc_compr_lvl = ent->lcme_compr_lvl;
+				comp->llc_compr_chunk_log_bits =
+					ent->lcme_compr_chunk_log_bits;
+			}
 		} else {
 			comp->llc_extent.e_start = 0;
 			comp->llc_extent.e_end = LUSTRE_EOF;
@@ -551,12 +561,14 @@ struct llapi_layout *llapi_layout_get_by_xattr(void *lov_xattr,
 			comp->llc_flags = 0;
 		}
 
-		if (v1->lmm_pattern == LOV_PATTERN_RAID0)
+		/* compression is kept apart from the striping pattern */
+		pattern = v1->lmm_pattern & ~LOV_PATTERN_COMPRESS;
+		if (pattern == LOV_PATTERN_RAID0)
 			comp->llc_pattern = LLAPI_LAYOUT_RAID0;
-		else if (v1->lmm_pattern == (LOV_PATTERN_RAID0 |
-					 LOV_PATTERN_OVERSTRIPING))
+		else if (pattern == (LOV_PATTERN_RAID0 |
+				     LOV_PATTERN_OVERSTRIPING))
 			comp->llc_pattern = LLAPI_LAYOUT_OVERSTRIPING;
-		else if (v1->lmm_pattern & LOV_PATTERN_MDT)
+		else if (pattern & LOV_PATTERN_MDT)
 			comp->llc_pattern = LLAPI_LAYOUT_MDT;
 		else
 			/* Lustre only supports RAID0, overstripping
@@ -739,6 +751,8 @@ llapi_layout_to_lum(const struct llapi_layout *layout)
 			errno = EINVAL;
 			goto error;
 		}
+		if (comp->llc_compr_type != LL_COMPR_TYPE_NONE)
+			blob->lmm_pattern |= LOV_PATTERN_COMPRESS;
 
 		if (comp->llc_stripe_size == LLAPI_LAYOUT_DEFAULT)
 			blob->lmm_stripe_size = 0;
@@ -785,6 +799,12 @@ llapi_layout_to_lum(const struct llapi_layout *layout)
 			ent->lcme_flags = comp->llc_flags;
 			if (ent->lcme_flags & LCME_FL_NOSYNC)
 				ent->lcme_timestamp = comp->llc_timestamp;
+			if (comp->llc_compr_type != LL_COMPR_TYPE_NONE) {
+				ent->lcme_compr_type = comp->llc_compr_type;
+				ent->lcme_compr_lvl = comp->llc_compr_lvl;
+				ent->lcme_compr_chunk_log_bits =
+					comp->llc_compr_chunk_log_bits;
+			}
 			ent->lcme_extent.e_start = comp->llc_extent.e_start;
 			ent->lcme_extent.e_end = comp->llc_extent.e_end;
 			ent->lcme_size = blob_size;
@@ -1389,6 +1409,130 @@ int llapi_layout_pattern_set(struct llapi_layout *layout, uint64_t pattern)
 	return 0;
 }
 
+static const char *const llapi_compr_type_names[LL_COMPR_TYPE_MAX] = {
+	[LL_COMPR_TYPE_NONE]	= "none",
+	[LL_COMPR_TYPE_LZ4]	= "lz4",
+	[LL_COMPR_TYPE_ZSTD]	= "zstd",
+};
+
+/**
+ * Convert a compression algorithm name to its ll_compr_type.
+ *
+ * \param[in] name	algorithm name, e.g. "lz4"
+ *
+ * \retval	ll_compr_type on success
+ * \retval	-EINVAL if \a name is not a known algorithm
+ */
+int llapi_compress_name2type(const char *name)
+{
+	int i;
+
+	for (i = 0; i < LL_COMPR_TYPE_MAX; i++)
+		if (strcmp(name, llapi_compr_type_names[i]) == 0)
+			return i;
+
+	return -EINVAL;
+}
+
+/**
+ * Return the name of compression algorithm \a type, "unknown" if \a type
+ * is not valid.
+ */
+const char *llapi_compress_type2name(unsigned int type)
+{
+	if (type >= LL_COMPR_TYPE_MAX)
+		return "unknown";
+
+	return llapi_compr_type_names[type];
+}
+
+/**
+ * Get the compression parameters of the current component of \a layout.
+ *
+ * \param[in] layout		layout to get the parameters from
+ * \param[out] type		compression algorithm, LL_COMPR_TYPE_NONE if
+ *				the component is not compressed
+ * \param[out] level		compression level
+ * \param[out] chunk_size	compression chunk size in bytes
+ *
+ * \retval	0 on success
+ * \retval	-1 if arguments are invalid
+ */
+int llapi_layout_compress_get(const struct llapi_layout *layout,
+			      unsigned int *type, unsigned int *level,
+			      uint32_t *chunk_size)
+{
+	struct llapi_layout_comp *comp;
+
+	comp = __llapi_layout_cur_comp(layout);
+	if (comp == NULL)
+		return -1;
+
+	if (type == NULL || level == NULL || chunk_size == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	*type = comp->llc_compr_type;
+	*level = comp->llc_compr_lvl;
+	*chunk_size = 1U << (COMPR_CHUNK_MIN_BITS +
+			     comp->llc_compr_chunk_log_bits);
+
+	return 0;
+}
+
+/**
+ * Compress the data of the current component of \a layout with algorithm
+ * \a type at \a level, in independent chunks of \a chunk_size bytes.
+ *
+ * \param[in] layout		layout to set the parameters in
+ * \param[in] type		compression algorithm, LL_COMPR_TYPE_NONE
+ *				disables compression
+ * \param[in] level		compression level, 0 is the algorithm default
+ * \param[in] chunk_size	power of two chunk size in bytes, or 0 for the
+ *				minimum of 64KiB
+ *
+ * \retval	0 on success
+ * \retval	-1 if arguments are invalid
+ */
+int llapi_layout_compress_set(struct llapi_layout *layout, unsigned int type,
+			      unsigned int level, uint32_t chunk_size)
+{
+	struct llapi_layout_comp *comp;
+	int bits = COMPR_CHUNK_MIN_BITS;
+
+	comp = __llapi_layout_cur_comp(layout);
+	if (comp == NULL)
+		return -1;
+
+	if (chunk_size != 0) {
+		bits = ffs(chunk_size) - 1;
+		if (chunk_size != 1U << bits || bits < COMPR_CHUNK_MIN_BITS) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+
+	if (type == LL_COMPR_TYPE_NONE) {
+		comp->llc_compr_type = LL_COMPR_TYPE_NONE;
+		comp->llc_compr_lvl = 0;
+		comp->llc_compr_chunk_log_bits = 0;
+		return 0;
+	}
+
+	if (!lov_compr_params_valid(type, level,
+				    bits - COMPR_CHUNK_MIN_BITS)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	comp->llc_compr_type = type;
+	comp->llc_compr_lvl = level;
+	comp->llc_compr_chunk_log_bits = bits - COMPR_CHUNK_MIN_BITS;
+
+	return 0;
+}
+
 static inline int stripe_number_roundup(int stripe_number)
 {
 	unsigned int round_up = (stripe_number + 8) & ~7;
@@ -3300,6 +3444,7 @@ enum llapi_layout_comp_sanity_error {
 	LSE_START_GT_END,
 	LSE_ALIGN_END,
 	LSE_ALIGN_EXT,
+	LSE_COMPRESS,
 	LSE_LAST,
 };
 
@@ -3336,6 +3481,8 @@ const char *const llapi_layout_strerror[] =
 		"The component end must be aligned by the stripe size",
 	[LSE_ALIGN_EXT] =
 		"The extension size must be aligned by the stripe size",
+	[LSE_COMPRESS] =
+		"Compression is only supported on RAID0 components",
 };
 
 struct llapi_layout_sanity_args {
@@ -3447,6 +3594,19 @@ static int llapi_layout_sanity_cb(struct llapi_layout *layout,
 		}
 	}
 
+	/* Compression sanity checks */
+	if (comp->llc_compr_type != LL_COMPR_TYPE_NONE) {
+		uint64_t pattern = comp->llc_pattern & ~LLAPI_LAYOUT_SPECIFIC;
+
+		if (comp->llc_flags & LCME_FL_EXTENSION ||
+		    (pattern != LLAPI_LAYOUT_RAID0 &&
+		     pattern != LLAPI_LAYOUT_OVERSTRIPING &&
+		     pattern != LLAPI_LAYOUT_DEFAULT)) {
+			args->lsa_rc = LSE_COMPRESS;
+			goto out_err;
+		}
+	}
+
 	/* Extent sanity checks */
 	/* Must set previous component extent before adding another */
 	if (prev && prev->llc_extent.e_start == 0 &&
@@ -683,6 +683,8 @@ check_obd_connect_data(void)
 	CHECK_DEFINE_64X(OBD_CONNECT2_LARGE_NID);
 	CHECK_DEFINE_64X(OBD_CONNECT2_COMPRESS);
 	CHECK_DEFINE_64X(OBD_CONNECT2_UNALIGNED_DIO);
+	CHECK_DEFINE_64X(OBD_CONNECT2_BATCH_REINT);
+	CHECK_DEFINE_64X(OBD_CONNECT2_XATTR_PREFETCH);
 
 	BLANK_LINE();
 	CHECK_VALUE_X(OBD_CKSUM_CRC32);
@@ -728,7 +730,7 @@ check_obdo(void)
 	CHECK_MEMBER(obdo, o_gid_h);
 	CHECK_MEMBER(obdo, o_data_version);
 	CHECK_MEMBER(obdo, o_projid);
-	CHECK_MEMBER(obdo, o_padding_4);
+	CHECK_MEMBER(obdo, o_compr_nob);
 	CHECK_MEMBER(obdo, o_padding_5);
 	CHECK_MEMBER(obdo, o_padding_6);
 
@@ -1181,6 +1183,25 @@ check_niobuf_remote(void)
 	CHECK_DEFINE_X(OBD_BRW_COMPRESSED);
 }
 
+static void
+check_ll_compr_hdr(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(ll_compr_hdr);
+	CHECK_MEMBER(ll_compr_hdr, llch_magic);
+	CHECK_MEMBER(ll_compr_hdr, llch_compr_type);
+	CHECK_MEMBER(ll_compr_hdr, llch_compr_lvl);
+	CHECK_MEMBER(ll_compr_hdr, llch_chunk_bits);
+	CHECK_MEMBER(ll_compr_hdr, llch_hdr_size);
+	CHECK_MEMBER(ll_compr_hdr, llch_compr_size);
+	CHECK_MEMBER(ll_compr_hdr, llch_bulk_size);
+	CHECK_VALUE_X(LLCH_MAGIC);
+
+	CHECK_VALUE(LL_COMPR_TYPE_NONE);
+	CHECK_VALUE(LL_COMPR_TYPE_LZ4);
+	CHECK_VALUE(LL_COMPR_TYPE_ZSTD);
+}
+
 static void
 check_ost_body(void)
 {
@@ -1263,8 +1284,7 @@ check_mdt_body(void)
 	CHECK_MEMBER(mdt_body, mbo_dom_size);
 	CHECK_MEMBER(mdt_body, mbo_dom_blocks);
 	CHECK_MEMBER(mdt_body, mbo_btime);
-	CHECK_MEMBER(mdt_body, mbo_padding_9);
-	CHECK_MEMBER(mdt_body, mbo_padding_10);
+	CHECK_MEMBER(mdt_body, mbo_pre_versions);
 
 	CHECK_VALUE_O(MDS_FMODE_CLOSED);
 	CHECK_VALUE_O(MDS_FMODE_EXEC);
@@ -1290,6 +1310,7 @@ check_mdt_body(void)
 	CHECK_VALUE_64O(MDS_OPEN_RESYNC);
 	CHECK_VALUE_64O(MDS_OPEN_PCC);
 	CHECK_VALUE_64O(MDS_OPEN_DEFAULT_LMV);
+	CHECK_VALUE_64O(MDS_OPEN_XATTRS);
 
 	/* these should be identical to their EXT3_*_FL counterparts, and
 	 * are redefined only to avoid dragging in ext3_fs.h */
@@ -1444,8 +1465,7 @@ check_mdt_rec_unlink(void)
 	CHECK_MEMBER(mdt_rec_unlink, ul_fid1);
 	CHECK_MEMBER(mdt_rec_unlink, ul_fid2);
 	CHECK_MEMBER(mdt_rec_unlink, ul_time);
-	CHECK_MEMBER(mdt_rec_unlink, ul_padding_2);
-	CHECK_MEMBER(mdt_rec_unlink, ul_padding_3);
+	CHECK_MEMBER(mdt_rec_unlink, ul_pre_versions);
 	CHECK_MEMBER(mdt_rec_unlink, ul_padding_4);
 	CHECK_MEMBER(mdt_rec_unlink, ul_padding_5);
 	CHECK_MEMBER(mdt_rec_unlink, ul_bias);
@@ -1758,7 +1778,7 @@ check_ldlm_ost_lvb(void)
 	CHECK_MEMBER(ost_lvb, lvb_mtime_ns);
 	CHECK_MEMBER(ost_lvb, lvb_atime_ns);
 	CHECK_MEMBER(ost_lvb, lvb_ctime_ns);
-	CHECK_MEMBER(ost_lvb, lvb_padding);
+	CHECK_MEMBER(ost_lvb, lvb_data_version);
 }
 
 static void
@@ -3532,6 +3552,7 @@ main(int argc, char **argv)
 	CHECK_COND_FINISH(HAVE_SERVER_SUPPORT);
 #endif /* !HAVE_NATIVE_LINUX_CLIENT */
 	check_niobuf_remote();
+	check_ll_compr_hdr();
 	check_ost_body();
 	check_ll_fid();
 	check_mds_op_bias();